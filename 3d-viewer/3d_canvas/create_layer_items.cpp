@@ -52,9 +52,9 @@
 #include <trigo.h>
 #include <utility>
 #include <vector>
-#include <thread>
 #include <algorithm>
 #include <atomic>
+#include <thread_pool.h>
 
 #include <profile.h>
 
@@ -792,37 +792,32 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         // Add zones objects
         // /////////////////////////////////////////////////////////////////////
         std::atomic<size_t> nextZone( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
 
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&]()
-            {
-                for( size_t areaId = nextZone.fetch_add( 1 );
-                            areaId < static_cast<size_t>( m_board->GetAreaCount() );
-                            areaId = nextZone.fetch_add( 1 ) )
-                {
-                    const ZONE_CONTAINER* zone = m_board->GetArea( areaId );
+        THREAD_POOL& pool = THREAD_POOL::GetInstance();
+        size_t parallelThreadCount = pool.GetThreadCount();
 
-                    if( zone == nullptr )
-                        break;
+        TASK_GROUP tasks( pool );
 
-                    auto layerContainer = m_layers_container2D.find( zone->GetLayer() );
+        tasks.Run( [&]()
+        {
+            for( size_t areaId = nextZone.fetch_add( 1 );
+                        areaId < static_cast<size_t>( m_board->GetAreaCount() );
+                        areaId = nextZone.fetch_add( 1 ) )
+            {
+                const ZONE_CONTAINER* zone = m_board->GetArea( areaId );
 
-                    if( layerContainer != m_layers_container2D.end() )
-                        AddSolidAreasShapesToContainer( zone, layerContainer->second,
-                                                        zone->GetLayer() );
-                }
+                if( zone == nullptr )
+                    break;
 
-                threadsFinished++;
-            } );
+                auto layerContainer = m_layers_container2D.find( zone->GetLayer() );
 
-            t.detach();
-        }
+                if( layerContainer != m_layers_container2D.end() )
+                    AddSolidAreasShapesToContainer( zone, layerContainer->second,
+                                                    zone->GetLayer() );
+            }
+        }, parallelThreadCount );
 
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        tasks.Wait();
 
     }
 
@@ -865,34 +860,27 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
     {
         std::atomic<size_t> nextItem( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
 
-        size_t parallelThreadCount = std::min<size_t>(
-                std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-                layer_id.size() );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            std::thread t = std::thread( [&nextItem, &threadsFinished, &layer_id, this]()
-            {
-                for( size_t i = nextItem.fetch_add( 1 );
-                            i < layer_id.size();
-                            i = nextItem.fetch_add( 1 ) )
-                {
-                    auto layerPoly = m_layers_poly.find( layer_id[i] );
+        THREAD_POOL& pool = THREAD_POOL::GetInstance();
+        size_t parallelThreadCount = pool.GetTaskCount( layer_id.size() );
 
-                    if( layerPoly != m_layers_poly.end() )
-                        // This will make a union of all added contours
-                        layerPoly->second->Simplify( SHAPE_POLY_SET::PM_FAST );
-                }
+        TASK_GROUP tasks( pool );
 
-                threadsFinished++;
-            } );
+        tasks.Run( [&]()
+        {
+            for( size_t i = nextItem.fetch_add( 1 );
+                        i < layer_id.size();
+                        i = nextItem.fetch_add( 1 ) )
+            {
+                auto layerPoly = m_layers_poly.find( layer_id[i] );
 
-            t.detach();
-        }
+                if( layerPoly != m_layers_poly.end() )
+                    // This will make a union of all added contours
+                    layerPoly->second->Simplify( SHAPE_POLY_SET::PM_FAST );
+            }
+        }, parallelThreadCount );
 
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        tasks.Wait();
     }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
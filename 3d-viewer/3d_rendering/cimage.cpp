@@ -32,8 +32,8 @@
 #include <string.h> // For memcpy
 
 #include <atomic>
-#include <thread>
 #include <chrono>
+#include <thread_pool.h>
 
 #ifndef CLAMP
 #define CLAMP(n, min, max) {if( n < min ) n=min; else if( n > max ) n = max;}
@@ -474,50 +474,44 @@ void CIMAGE::EfxFilter( CIMAGE *aInImg, E_FILTER aFilterType )
     m_wraping = WRAP_CLAMP;
 
     std::atomic<size_t> nextRow( 0 );
-    std::atomic<size_t> threadsFinished( 0 );
 
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    size_t parallelThreadCount = pool.GetThreadCount();
 
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    TASK_GROUP tasks( pool );
+
+    tasks.Run( [&]()
     {
-        std::thread t = std::thread( [&]()
+        for( size_t iy = nextRow.fetch_add( 1 );
+                    iy < m_height;
+                    iy = nextRow.fetch_add( 1 ) )
         {
-            for( size_t iy = nextRow.fetch_add( 1 );
-                        iy < m_height;
-                        iy = nextRow.fetch_add( 1 ) )
+            for( size_t ix = 0; ix < m_width; ix++ )
             {
-                for( size_t ix = 0; ix < m_width; ix++ )
-                {
-                    int v = 0;
+                int v = 0;
 
-                    for( size_t sy = 0; sy < 5; sy++ )
+                for( size_t sy = 0; sy < 5; sy++ )
+                {
+                    for( size_t sx = 0; sx < 5; sx++ )
                     {
-                        for( size_t sx = 0; sx < 5; sx++ )
-                        {
-                            int factor = filter.kernel[sx][sy];
-                            unsigned char pixelv = aInImg->Getpixel( ix + sx - 2,
-                                                                     iy + sy - 2 );
-
-                            v += pixelv * factor;
-                        }
-                    }
+                        int factor = filter.kernel[sx][sy];
+                        unsigned char pixelv = aInImg->Getpixel( ix + sx - 2,
+                                                                 iy + sy - 2 );
 
-                    v /= filter.div;
-                    v += filter.offset;
-                    CLAMP(v, 0, 255);
-                    //TODO: This needs to write to a separate buffer
-                    m_pixels[ix + iy * m_width] = v;
+                        v += pixelv * factor;
+                    }
                 }
-            }
-
-            threadsFinished++;
-        } );
 
-        t.detach();
-    }
+                v /= filter.div;
+                v += filter.offset;
+                CLAMP(v, 0, 255);
+                //TODO: This needs to write to a separate buffer
+                m_pixels[ix + iy * m_width] = v;
+            }
+        }
+    }, parallelThreadCount );
 
-    while( threadsFinished < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    tasks.Wait();
 }
 
 
@@ -33,6 +33,10 @@
 # source and header files will not be generated and a build error will
 # occur.
 #
+# Besides the keyword table, the generated cpp file holds a lookup function for the
+# keywords (a switch on the length and first letter of the token), which the lexer
+# uses instead of hashing each token.
+#
 # Valid tokens:    a a1 foo_1 foo_bar2
 # Invalid tokens:  1 A _foo bar_ foO
 #
@@ -150,6 +154,8 @@ set( sourceFileHeader
  * your DSN lexer.
  */
 
+#include <cstring>
+
 #include <${result}_lexer.h>
 
 using namespace ${enum};
@@ -240,6 +246,9 @@ class ${LEXERCLASS} : public DSNLEXER
     static const KEYWORD  keywords[];
     static const unsigned keyword_count;
 
+    /// Auto generated keyword lookup, see KEYWORD_FINDER
+    static int findKeyword( const char* aToken, size_t aLength );
+
 public:
     /**
      * Constructor ( const std::string&, const wxString& )
@@ -248,7 +257,7 @@ public:
      *   If left empty, then _(\"clipboard\") is used.
      */
     ${LEXERCLASS}( const std::string& aSExpression, const wxString& aSource = wxEmptyString ) :
-        DSNLEXER( keywords, keyword_count, aSExpression, aSource )
+        DSNLEXER( keywords, keyword_count, aSExpression, aSource, findKeyword )
     {
     }
 
@@ -262,7 +271,7 @@ public:
      * @param aFilename is the name of the opened file, needed for error reporting.
      */
     ${LEXERCLASS}( FILE* aFile, const wxString& aFilename ) :
-        DSNLEXER( keywords, keyword_count, aFile, aFilename )
+        DSNLEXER( keywords, keyword_count, aFile, aFilename, findKeyword )
     {
     }
 
@@ -278,7 +287,7 @@ public:
      *  STRING_LINE_READER or FILE_LINE_READER.  No ownership is taken of aLineReader.
      */
     ${LEXERCLASS}( LINE_READER* aLineReader ) :
-        DSNLEXER( keywords, keyword_count, aLineReader )
+        DSNLEXER( keywords, keyword_count, aLineReader, findKeyword )
     {
     }
 
@@ -385,3 +394,67 @@ const char* ${LEXERCLASS}::TokenName( T aTok )
 }
 "
 )
+
+# Generate the keyword lookup used by DSNLEXER::findToken(): a switch on the token
+# length, then on its first letter, then a memcmp() for each remaining keyword.
+# The tokens are sorted, so for a given length the ones sharing a first letter
+# come one after the other.
+set( lengths "" )
+
+foreach( token ${tokens} )
+    string( LENGTH "${token}" tokenLength )
+    list( APPEND lengths ${tokenLength} )
+endforeach()
+
+if( lengths )
+    list( REMOVE_DUPLICATES lengths )
+endif()
+
+file( APPEND "${outCppFile}"
+"
+
+int ${LEXERCLASS}::findKeyword( const char* aToken, size_t aLength )
+{
+    switch( aLength )
+    {
+"
+)
+
+foreach( length ${lengths} )
+    file( APPEND "${outCppFile}" "    case ${length}:\n        switch( aToken[0] )\n        {\n" )
+
+    set( prevLetter "" )
+
+    foreach( token ${tokens} )
+        string( LENGTH "${token}" tokenLength )
+
+        if( tokenLength EQUAL length )
+            string( SUBSTRING "${token}" 0 1 letter )
+
+            if( NOT letter STREQUAL prevLetter )
+                if( NOT prevLetter STREQUAL "" )
+                    file( APPEND "${outCppFile}" "            break;\n" )
+                endif()
+
+                file( APPEND "${outCppFile}" "        case '${letter}':\n" )
+                set( prevLetter "${letter}" )
+            endif()
+
+            file( APPEND "${outCppFile}"
+                  "            if( !memcmp( aToken, \"${token}\", ${length} ) )\n"
+                  "                return T_${token};\n" )
+        endif()
+    endforeach()
+
+    file( APPEND "${outCppFile}" "            break;\n        }\n        break;\n\n" )
+endforeach()
+
+file( APPEND "${outCppFile}"
+"    default:
+        break;
+    }
+
+    return DSN_SYMBOL;      // not a keyword, some arbitrary symbol.
+}
+"
+)
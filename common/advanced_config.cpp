@@ -72,6 +72,30 @@ static const wxChar RealtimeConnectivity[] = wxT( "RealtimeConnectivity" );
  */
 static const wxChar AllowLegacyCanvasInGtk3[] = wxT( "AllowLegacyCanvasInGtk3" );
 
+/**
+ * Limit the number of threads used by parallel jobs (zone fill, connectivity, 3D
+ * rendering...).  The default, 0, uses one thread per core.  Useful to keep some cores
+ * free for other programs, or to profile with a given number of threads.
+ */
+static const wxChar MaxWorkerThreads[] = wxT( "MaxWorkerThreads" );
+
+/**
+ * Save a "<board>.kicad_pcb-snapshot" file next to each board loaded, holding the
+ * pre-lexed content of the board.  Boards are loaded from their snapshot while their file
+ * does not change, which is faster when the same large board is opened repeatedly (by
+ * scripts, for instance).
+ */
+static const wxChar EnableBoardSnapshots[] = wxT( "EnableBoardSnapshots" );
+
+/**
+ * Record the interactive routing sessions in this directory: a snapshot of the board,
+ * taken each time the router reads it, and the routing settings and mouse events that
+ * followed.  The sessions can then be replayed and timed with the "pns_replay" QA tool,
+ * e.g. to reproduce a slow drag.  Saving the board snapshot takes a moment each time the
+ * router starts on a large board.
+ */
+static const wxChar RouterSessionLogDir[] = wxT( "RouterSessionLogDir" );
+
 } // namespace KEYS
 
 
@@ -151,6 +175,9 @@ ADVANCED_CFG::ADVANCED_CFG()
     // then the values will remain as set here.
     m_enableSvgImport = false;
     m_allowLegacyCanvasInGtk3 = false;
+    m_maxWorkerThreads = 0;
+    m_enableBoardSnapshots = false;
+    m_routerSessionLogDir = wxEmptyString;
 
     loadFromConfigFile();
 }
@@ -193,6 +220,15 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
     configParams.push_back(
             new PARAM_CFG_BOOL( true, AC_KEYS::RealtimeConnectivity, &m_realTimeConnectivity, false ) );
 
+    configParams.push_back( new PARAM_CFG_INT(
+            true, AC_KEYS::MaxWorkerThreads, &m_maxWorkerThreads, 0, 0, 1024 ) );
+
+    configParams.push_back( new PARAM_CFG_BOOL(
+            true, AC_KEYS::EnableBoardSnapshots, &m_enableBoardSnapshots, false ) );
+
+    configParams.push_back( new PARAM_CFG_WXSTRING(
+            true, AC_KEYS::RouterSessionLogDir, &m_routerSessionLogDir, wxEmptyString ) );
+
     wxConfigLoadSetups( &aCfg, configParams );
 
     dumpCfg( configParams );
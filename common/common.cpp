@@ -41,6 +41,8 @@
 #include <wx/stdpaths.h>
 #include <wx/url.h>
 
+#include <mutex>
+
 #include <pgm_base.h>
 
 using KIGFX::COLOR4D;
@@ -215,9 +217,13 @@ int ProcessExecute( const wxString& aCommandLine, int aFlags, wxProcess *callbac
 
 timestamp_t GetNewTimeStamp()
 {
+    // Schematic sheets are loaded by several threads
+    static std::mutex  timeStampLock;
     static timestamp_t oldTimeStamp;
     timestamp_t newTimeStamp;
 
+    std::lock_guard<std::mutex> lock( timeStampLock );
+
     newTimeStamp = time( NULL );
 
     if( newTimeStamp <= oldTimeStamp )
@@ -54,6 +54,10 @@ void DSNLEXER::init()
 
     curOffset = 0;
 
+    // The generated lookup does not need the hashtable
+    if( keywordFinder )
+        return;
+
 #if 1
     if( keywordCount > 11 )
     {
@@ -74,14 +78,18 @@ void DSNLEXER::init()
 
 
 DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-                    FILE* aFile, const wxString& aFilename ) :
+                    FILE* aFile, const wxString& aFilename,
+                    KEYWORD_FINDER aKeywordFinder ) :
     iOwnReaders( true ),
     start( NULL ),
     next( NULL ),
     limit( NULL ),
+    tokenNext( NULL ),
+    tokenEnd( NULL ),
     reader( NULL ),
     keywords( aKeywordTable ),
-    keywordCount( aKeywordCount )
+    keywordCount( aKeywordCount ),
+    keywordFinder( aKeywordFinder )
 {
     FILE_LINE_READER* fileReader = new FILE_LINE_READER( aFile, aFilename );
     PushReader( fileReader );
@@ -90,14 +98,18 @@ DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
 
 
 DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-                    const std::string& aClipboardTxt, const wxString& aSource ) :
+                    const std::string& aClipboardTxt, const wxString& aSource,
+                    KEYWORD_FINDER aKeywordFinder ) :
     iOwnReaders( true ),
     start( NULL ),
     next( NULL ),
     limit( NULL ),
+    tokenNext( NULL ),
+    tokenEnd( NULL ),
     reader( NULL ),
     keywords( aKeywordTable ),
-    keywordCount( aKeywordCount )
+    keywordCount( aKeywordCount ),
+    keywordFinder( aKeywordFinder )
 {
     STRING_LINE_READER* stringReader = new STRING_LINE_READER( aClipboardTxt, aSource.IsEmpty() ?
                                         wxString( FMT_CLIPBOARD ) : aSource );
@@ -107,14 +119,17 @@ DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
 
 
 DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-                    LINE_READER* aLineReader ) :
+                    LINE_READER* aLineReader, KEYWORD_FINDER aKeywordFinder ) :
     iOwnReaders( false ),
     start( NULL ),
     next( NULL ),
     limit( NULL ),
+    tokenNext( NULL ),
+    tokenEnd( NULL ),
     reader( NULL ),
     keywords( aKeywordTable ),
-    keywordCount( aKeywordCount )
+    keywordCount( aKeywordCount ),
+    keywordFinder( aKeywordFinder )
 {
     if( aLineReader )
         PushReader( aLineReader );
@@ -129,9 +144,12 @@ DSNLEXER::DSNLEXER( const std::string& aSExpression, const wxString& aSource ) :
     start( NULL ),
     next( NULL ),
     limit( NULL ),
+    tokenNext( NULL ),
+    tokenEnd( NULL ),
     reader( NULL ),
     keywords( empty_keywords ),
-    keywordCount( 0 )
+    keywordCount( 0 ),
+    keywordFinder( NULL )
 {
     STRING_LINE_READER* stringReader = new STRING_LINE_READER( aSExpression, aSource.IsEmpty() ?
                                         wxString( FMT_CLIPBOARD ) : aSource );
@@ -185,6 +203,9 @@ bool DSNLEXER::SyncLineReaderWith( DSNLEXER& aLexer )
     curText = aLexer.curText;
     curOffset = aLexer.curOffset;
 
+    tokenNext = aLexer.tokenNext;
+    tokenEnd = aLexer.tokenEnd;
+
     return true;
 }
 
@@ -259,6 +280,9 @@ int DSNLEXER::findToken( const std::string& tok )
 
 inline int DSNLEXER::findToken( const std::string& tok )
 {
+    if( keywordFinder )
+        return keywordFinder( tok.c_str(), tok.size() );
+
     KEYWORD_MAP::const_iterator it = keyword_hash.find( tok.c_str() );
     if( it != keyword_hash.end() )
         return it->second;
@@ -544,6 +568,9 @@ int DSNLEXER::NextTok()
 
     prevTok = curTok;
 
+    if( tokenNext )
+        return readStreamTok();
+
     if( curTok == DSN_EOF )
         goto exit;
 
@@ -808,6 +835,123 @@ exit:   // single point of exit, no returns elsewhere please.
 }
 
 
+/*
+ * A token stream is a sequence of tokens, each one made of its type (one byte) followed,
+ * for tokens having a text, by the length of the text (7 bits per byte, low bits first,
+ * the high bit set on all bytes but the last) and the text itself.  Keywords are written
+ * as symbols and looked up again when read: the stream does not depend on the token
+ * numbering of a lexer.
+ */
+
+void DSNLEXER::WriteToken( std::string& aStream, int aTok, const std::string& aText )
+{
+    if( aTok >= 0 )
+        aTok = DSN_SYMBOL;
+
+    aStream += (char) aTok;
+
+    if( aTok == DSN_LEFT || aTok == DSN_RIGHT )
+        return;
+
+    size_t len = aText.size();
+
+    while( len >= 0x80 )
+    {
+        aStream += (char) ( ( len & 0x7F ) | 0x80 );
+        len >>= 7;
+    }
+
+    aStream += (char) len;
+    aStream += aText;
+}
+
+
+void DSNLEXER::WriteTokens( std::string& aStream )
+{
+    wxCHECK_RET( !specctraMode, "Token streams do not support specctra mode" );
+
+    int tok;
+
+    while( ( tok = NextTok() ) != DSN_EOF )
+    {
+        if( tok < 0 && tok != DSN_LEFT && tok != DSN_RIGHT && tok != DSN_NUMBER
+                && tok != DSN_STRING && tok != DSN_SYMBOL )
+        {
+            THROW_IO_ERROR( wxString::Format( "Token %s cannot be written to a token stream",
+                                              Syntax( tok ) ) );
+        }
+
+        WriteToken( aStream, tok, curText );
+    }
+}
+
+
+int DSNLEXER::readStreamTok()
+{
+    static const char damaged[] = "Damaged token stream";
+
+    curOffset = 0;
+
+    if( tokenNext >= tokenEnd )
+    {
+        curText.clear();
+        curTok = DSN_EOF;
+        return curTok;
+    }
+
+    int tok = (signed char) *tokenNext++;
+
+    switch( tok )
+    {
+    case DSN_LEFT:
+        curText = '(';
+        break;
+
+    case DSN_RIGHT:
+        curText = ')';
+        break;
+
+    case DSN_NUMBER:
+    case DSN_STRING:
+    case DSN_SYMBOL:
+        {
+            size_t len = 0;
+
+            for( int shift = 0; ; shift += 7 )
+            {
+                if( tokenNext >= tokenEnd || shift > 28 )
+                    THROW_PARSE_ERROR( damaged, CurSource(), CurLine(), CurLineNumber(),
+                                       CurOffset() );
+
+                unsigned char cc = *tokenNext++;
+                len |= size_t( cc & 0x7F ) << shift;
+
+                if( !( cc & 0x80 ) )
+                    break;
+            }
+
+            if( len > size_t( tokenEnd - tokenNext ) )
+                THROW_PARSE_ERROR( damaged, CurSource(), CurLine(), CurLineNumber(),
+                                   CurOffset() );
+
+            curText.assign( tokenNext, len );
+            tokenNext += len;
+
+            if( tok == DSN_SYMBOL )
+                tok = findToken( curText );
+        }
+        break;
+
+    default:
+        THROW_PARSE_ERROR( damaged, CurSource(), CurLine(), CurLineNumber(),
+                           CurOffset() );
+    }
+
+    curTok = tok;
+    return curTok;
+}
+
+
 wxArrayString* DSNLEXER::ReadCommentLines()
 {
     wxArrayString*  ret = 0;
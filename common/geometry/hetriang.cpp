@@ -297,24 +297,15 @@ bool TRIANGULATION::removeLeadingEdgeFromList( EDGE_PTR& aLeadingEdge )
     // Remove the edge from the list of leading edges,
     // but don't delete it.
     // Also set flag for leading edge to false.
-    // Must search from start of list. Since edges are added to the
-    // start of the list during triangulation, this operation will
-    // normally be fast (when used in the triangulation algorithm)
-    std::list<EDGE_PTR>::iterator it;
-    for( it = m_leadingEdges.begin(); it != m_leadingEdges.end(); ++it )
-    {
-        EDGE_PTR edge = *it;
+    // Each leading edge knows its position in the list, so that removing triangles
+    // far from the last inserted node does not search the whole list.
+    if( !aLeadingEdge || !aLeadingEdge->IsLeadingEdge() )
+        return false;
 
-        if( edge == aLeadingEdge )
-        {
-            edge->SetAsLeadingEdge( false );
-            it = m_leadingEdges.erase( it );
-
-            return true;
-        }
-    }
+    aLeadingEdge->SetAsLeadingEdge( false );
+    m_leadingEdges.erase( aLeadingEdge->m_leadingEdgeIt );
 
-    return false;
+    return true;
 }
 
 
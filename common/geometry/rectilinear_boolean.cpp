@@ -0,0 +1,632 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <geometry/rectilinear_boolean.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+
+namespace RECTILINEAR_BOOLEAN
+{
+
+static std::atomic<bool>   s_enabled( true );
+static std::atomic<size_t> s_calls( 0 );
+static std::atomic<size_t> s_fallbacks( 0 );
+
+
+///> A vertical edge of an operand
+struct INPUT_EDGE
+{
+    int x;
+    int yLow;
+    int yHigh;
+    int winding;    ///< change of the winding number when crossing the edge eastwards
+    int operand;
+};
+
+
+///> A vertical edge of the result, oriented with the inside of the result on its left
+struct OUTPUT_EDGE
+{
+    int  x;
+    int  yLow;
+    int  yHigh;
+    bool down;      ///< the inside is east of the edge
+
+    int startY() const { return down ? yHigh : yLow; }
+    int endY() const { return down ? yLow : yHigh; }
+};
+
+
+///> An end of an output edge, to link the edges through the horizontal ones
+struct EDGE_END
+{
+    int  y;
+    int  x;
+    bool terminal;  ///< the edge ends here, else it starts here
+    bool above;     ///< the edge lies above y
+    int  edge;
+
+    /**
+     * When two edges meet at a point, the regions on both sides only touch there: the ends
+     * are ordered so that each loop turns left at the point.  This keeps the inside regions
+     * apart, but joins the outside ones: loops touching themselves there are split later.
+     */
+    int tieKey() const { return terminal ? above : !above; }
+
+    bool operator<( const EDGE_END& aOther ) const
+    {
+        if( y != aOther.y )
+            return y < aOther.y;
+
+        if( x != aOther.x )
+            return x < aOther.x;
+
+        return tieKey() < aOther.tieKey();
+    }
+};
+
+
+///> A closed boundary of the result
+struct LOOP
+{
+    SHAPE_LINE_CHAIN chain;
+    double           area;
+    BOX2I            bbox;
+    int              owner;     ///< for holes, the index of the outline around them
+};
+
+
+static bool isSlantedEdge( const SHAPE_LINE_CHAIN& aChain, int aIndex )
+{
+    const VECTOR2I& a = aChain.CPoint( aIndex );
+    const VECTOR2I& b = aChain.CPoint( ( aIndex + 1 ) % aChain.PointCount() );
+
+    return a.x != b.x && a.y != b.y;
+}
+
+
+/**
+ * Checks every aStep-th edge of the chains of aSet, or all of them if aStep is 0
+ */
+static bool areEdgesRectilinear( const SHAPE_POLY_SET& aSet, int aStep )
+{
+    for( int i = 0; i < aSet.OutlineCount(); i++ )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : aSet.CPolygon( i ) )
+        {
+            int count = chain.PointCount();
+            int step = aStep ? std::max( 1, count / aStep ) : 1;
+
+            for( int j = 0; j < count; j += step )
+            {
+                if( isSlantedEdge( chain, j ) )
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool IsRectilinear( const SHAPE_POLY_SET& aSet )
+{
+    return areEdgesRectilinear( aSet, 0 );
+}
+
+
+// Same as Clipper's Area(): positive for the outlines of its results
+static double signedArea( const SHAPE_LINE_CHAIN& aChain )
+{
+    int    count = aChain.PointCount();
+    double area = 0.0;
+
+    for( int i = 0, j = count - 1; i < count; j = i++ )
+    {
+        const VECTOR2I& prev = aChain.CPoint( j );
+        const VECTOR2I& curr = aChain.CPoint( i );
+
+        area += ( (double) prev.x + curr.x ) * ( (double) prev.y - curr.y );
+    }
+
+    return -area * 0.5;
+}
+
+
+static void collectEdges( const SHAPE_POLY_SET& aSet, int aOperand,
+                          std::vector<INPUT_EDGE>& aEdges )
+{
+    for( int i = 0; i < aSet.OutlineCount(); i++ )
+    {
+        const SHAPE_POLY_SET::POLYGON& poly = aSet.CPolygon( i );
+
+        for( size_t j = 0; j < poly.size(); j++ )
+        {
+            const SHAPE_LINE_CHAIN& chain = poly[j];
+            int                     count = chain.PointCount();
+
+            // Like Clipper, orient the outlines positively and the holes negatively
+            bool positive = signedArea( chain ) >= 0.0;
+            int  sign = ( positive == ( j == 0 ) ) ? 1 : -1;
+
+            for( int k = 0; k < count; k++ )
+            {
+                const VECTOR2I& a = chain.CPoint( k );
+                const VECTOR2I& b = chain.CPoint( ( k + 1 ) % count );
+
+                if( a.x != b.x || a.y == b.y )
+                    continue;
+
+                // Going down a positive outline, its inside is east of the edge
+                if( a.y > b.y )
+                    aEdges.push_back( { a.x, b.y, a.y, sign, aOperand } );
+                else
+                    aEdges.push_back( { a.x, a.y, b.y, -sign, aOperand } );
+            }
+        }
+    }
+}
+
+
+static bool isInside( ClipperLib::ClipType aType, int aWindingA, int aWindingB )
+{
+    bool a = aWindingA != 0;
+    bool b = aWindingB != 0;
+
+    switch( aType )
+    {
+    case ClipperLib::ctIntersection: return a && b;
+    case ClipperLib::ctUnion:        return a || b;
+    case ClipperLib::ctDifference:   return a && !b;
+    case ClipperLib::ctXor:          return a != b;
+    }
+
+    return false;
+}
+
+
+/**
+ * Sweeps the input edges from west to east, and returns the vertical edges of the result,
+ * each as long as possible.
+ */
+static void sweep( ClipperLib::ClipType aType, std::vector<INPUT_EDGE>& aEdges,
+                   std::vector<OUTPUT_EDGE>& aResult )
+{
+    std::vector<int> ys;
+
+    ys.reserve( aEdges.size() * 2 );
+
+    for( const INPUT_EDGE& edge : aEdges )
+    {
+        ys.push_back( edge.yLow );
+        ys.push_back( edge.yHigh );
+    }
+
+    std::sort( ys.begin(), ys.end() );
+    ys.erase( std::unique( ys.begin(), ys.end() ), ys.end() );
+
+    std::sort( aEdges.begin(), aEdges.end(),
+            []( const INPUT_EDGE& a, const INPUT_EDGE& b ) { return a.x < b.x; } );
+
+    // Winding numbers and state of each band between two consecutive ys, west of the sweep
+    size_t            bands = ys.empty() ? 0 : ys.size() - 1;
+    std::vector<int>  winding[2] = { std::vector<int>( bands, 0 ), std::vector<int>( bands, 0 ) };
+    std::vector<char> inside( bands, 0 );
+
+    std::vector<std::pair<int, int>> ranges;
+
+    auto bandOf = [&]( int y ) -> int
+    {
+        return std::lower_bound( ys.begin(), ys.end(), y ) - ys.begin();
+    };
+
+    for( size_t first = 0; first < aEdges.size(); )
+    {
+        int    x = aEdges[first].x;
+        size_t last = first;
+
+        ranges.clear();
+
+        for( ; last < aEdges.size() && aEdges[last].x == x; last++ )
+        {
+            const INPUT_EDGE& edge = aEdges[last];
+            int               lo = bandOf( edge.yLow );
+            int               hi = bandOf( edge.yHigh );
+            std::vector<int>& w = winding[edge.operand];
+
+            for( int band = lo; band < hi; band++ )
+                w[band] += edge.winding;
+
+            ranges.emplace_back( lo, hi );
+        }
+
+        first = last;
+
+        // Merge the touching ranges, so that the result edges crossing several input
+        // edges come out in one piece
+        std::sort( ranges.begin(), ranges.end() );
+
+        size_t merged = 0;
+
+        for( size_t i = 1; i < ranges.size(); i++ )
+        {
+            if( ranges[i].first <= ranges[merged].second )
+                ranges[merged].second = std::max( ranges[merged].second, ranges[i].second );
+            else
+                ranges[++merged] = ranges[i];
+        }
+
+        ranges.resize( ranges.empty() ? 0 : merged + 1 );
+
+        for( const std::pair<int, int>& range : ranges )
+        {
+            int runStart = -1;
+            int runDir = 0;     // +1: entering the result, -1: leaving it, 0: no change
+
+            for( int band = range.first; band <= range.second; band++ )
+            {
+                int dir = 0;
+
+                if( band < range.second )
+                {
+                    bool now = isInside( aType, winding[0][band], winding[1][band] );
+
+                    if( now != (bool) inside[band] )
+                        dir = now ? 1 : -1;
+
+                    inside[band] = now;
+                }
+
+                if( dir == runDir )
+                    continue;
+
+                if( runDir )
+                    aResult.push_back( { x, ys[runStart], ys[band], runDir > 0 } );
+
+                runStart = band;
+                runDir = dir;
+            }
+        }
+    }
+}
+
+
+/**
+ * Splits a closed path at the points it goes through several times, e.g. two holes touching
+ * at a corner, so that each loop is simple.  Each part is a closed path made of segments of
+ * the original one.
+ */
+static void splitAtTouchingPoints( const std::vector<VECTOR2I>& aPath, std::vector<LOOP>& aLoops )
+{
+    typedef std::pair<int, int> POINT_KEY;      // VECTOR2I's operator< compares lengths
+
+    std::vector<VECTOR2I>    stack;
+    std::map<POINT_KEY, int> indexOf;
+
+    auto addLoop = [&]( std::vector<VECTOR2I>::const_iterator aBegin,
+                        std::vector<VECTOR2I>::const_iterator aEnd )
+    {
+        aLoops.emplace_back();
+
+        LOOP& loop = aLoops.back();
+
+        loop.owner = -1;
+
+        for( auto it = aBegin; it != aEnd; ++it )
+            loop.chain.Append( *it, true );
+
+        loop.chain.SetClosed( true );
+        loop.area = signedArea( loop.chain );
+        loop.bbox = loop.chain.BBox();
+    };
+
+    for( const VECTOR2I& point : aPath )
+    {
+        if( !stack.empty() && stack.back() == point )
+            continue;
+
+        auto it = indexOf.find( POINT_KEY( point.x, point.y ) );
+
+        if( it == indexOf.end() )
+        {
+            indexOf[POINT_KEY( point.x, point.y )] = stack.size();
+            stack.push_back( point );
+            continue;
+        }
+
+        // Back to an earlier point: the path since then is a loop of its own
+        size_t first = it->second;
+
+        addLoop( stack.begin() + first, stack.end() );
+
+        for( size_t i = first + 1; i < stack.size(); i++ )
+            indexOf.erase( POINT_KEY( stack[i].x, stack[i].y ) );
+
+        stack.resize( first + 1 );
+    }
+
+    if( stack.size() > 1 && stack.back() == stack.front() )
+        stack.pop_back();
+
+    addLoop( stack.begin(), stack.end() );
+}
+
+
+/**
+ * Links the vertical edges of the result through the horizontal ones into simple loops.
+ * @return false if the edges do not form closed loops, which should not happen.
+ */
+static bool buildLoops( const std::vector<OUTPUT_EDGE>& aEdges, std::vector<LOOP>& aLoops )
+{
+    std::vector<EDGE_END> ends;
+
+    ends.reserve( aEdges.size() * 2 );
+
+    for( size_t i = 0; i < aEdges.size(); i++ )
+    {
+        const OUTPUT_EDGE& edge = aEdges[i];
+
+        ends.push_back( { edge.startY(), edge.x, false, !edge.down, (int) i } );
+        ends.push_back( { edge.endY(), edge.x, true, edge.down, (int) i } );
+    }
+
+    std::sort( ends.begin(), ends.end() );
+
+    // Along a horizontal line, the boundary of the result alternates between inside and
+    // outside: the ends pair up from west to east, each pair being a horizontal edge
+    std::vector<int> next( aEdges.size(), -1 );
+
+    for( size_t i = 0; i < ends.size(); i += 2 )
+    {
+        const EDGE_END& a = ends[i];
+        const EDGE_END& b = ends[i + 1];
+
+        if( a.y != b.y || a.terminal == b.terminal )
+            return false;
+
+        if( a.terminal )
+            next[a.edge] = b.edge;
+        else
+            next[b.edge] = a.edge;
+    }
+
+    std::vector<char>     visited( aEdges.size(), 0 );
+    std::vector<VECTOR2I> path;
+
+    for( size_t i = 0; i < aEdges.size(); i++ )
+    {
+        if( visited[i] )
+            continue;
+
+        path.clear();
+
+        for( int e = i; !visited[e]; e = next[e] )
+        {
+            const OUTPUT_EDGE& edge = aEdges[e];
+
+            if( next[e] < 0 )
+                return false;
+
+            visited[e] = 1;
+
+            path.emplace_back( edge.x, edge.startY() );
+            path.emplace_back( edge.x, edge.endY() );
+        }
+
+        splitAtTouchingPoints( path, aLoops );
+    }
+
+    return true;
+}
+
+
+/**
+ * Tests a point against the vertical edges of a rectilinear loop, in doubled coordinates
+ * so that the point can lie between two integer coordinates.
+ */
+static bool containsDoubled( const SHAPE_LINE_CHAIN& aChain, int64_t aX, int64_t aY )
+{
+    int  count = aChain.PointCount();
+    bool inside = false;
+
+    for( int i = 0; i < count; i++ )
+    {
+        const VECTOR2I& a = aChain.CPoint( i );
+        const VECTOR2I& b = aChain.CPoint( ( i + 1 ) % count );
+
+        if( a.x != b.x || 2 * (int64_t) a.x < aX )
+            continue;
+
+        int64_t yLow = 2 * (int64_t) std::min( a.y, b.y );
+        int64_t yHigh = 2 * (int64_t) std::max( a.y, b.y );
+
+        if( aY >= yLow && aY < yHigh )
+            inside = !inside;
+    }
+
+    return inside;
+}
+
+
+/**
+ * Finds the outline around each hole: the smallest one containing a point just west of the
+ * westernmost edge of the hole, which lies inside the result.
+ */
+static bool assignHoles( std::vector<LOOP>& aLoops )
+{
+    std::vector<int> outlines;
+
+    for( size_t i = 0; i < aLoops.size(); i++ )
+    {
+        if( aLoops[i].area > 0.0 )
+            outlines.push_back( i );
+    }
+
+    std::sort( outlines.begin(), outlines.end(),
+            [&]( int a, int b ) { return aLoops[a].area < aLoops[b].area; } );
+
+    for( LOOP& hole : aLoops )
+    {
+        if( hole.area > 0.0 )
+            continue;
+
+        const SHAPE_LINE_CHAIN& chain = hole.chain;
+        int                     count = chain.PointCount();
+        int                     x = hole.bbox.GetX();
+        int                     yLow = 0;
+        int                     yHigh = 0;
+
+        for( int i = 0; i < count; i++ )
+        {
+            const VECTOR2I& a = chain.CPoint( i );
+            const VECTOR2I& b = chain.CPoint( ( i + 1 ) % count );
+
+            if( a.x == x && b.x == x && a.y != b.y )
+            {
+                yLow = std::min( a.y, b.y );
+                yHigh = std::max( a.y, b.y );
+                break;
+            }
+        }
+
+        int64_t px = 2 * (int64_t) x - 1;
+        int64_t py = (int64_t) yLow + yHigh;
+
+        for( int index : outlines )
+        {
+            const LOOP& outline = aLoops[index];
+
+            if( x <= outline.bbox.GetX() || x > outline.bbox.GetRight()
+                    || yLow < outline.bbox.GetY() || yHigh > outline.bbox.GetBottom() )
+            {
+                continue;
+            }
+
+            if( containsDoubled( outline.chain, px, py ) )
+            {
+                hole.owner = index;
+                break;
+            }
+        }
+
+        if( hole.owner < 0 )
+            return false;
+    }
+
+    return true;
+}
+
+
+bool Execute( ClipperLib::ClipType aType, const SHAPE_POLY_SET& aA, const SHAPE_POLY_SET& aB,
+              SHAPE_POLY_SET& aResult )
+{
+    // Rounded clearances and tracks at an angle have slanted edges all along their outlines:
+    // a few edges of each chain of both operands are checked before scanning all of them, so
+    // the operations left to Clipper barely pay for the check.
+    const int sampledEdges = 4;
+
+    if( !s_enabled
+            || !areEdgesRectilinear( aA, sampledEdges ) || !areEdgesRectilinear( aB, sampledEdges )
+            || !IsRectilinear( aA ) || !IsRectilinear( aB ) )
+    {
+        s_fallbacks++;
+        return false;
+    }
+
+    std::vector<INPUT_EDGE>  inputEdges;
+    std::vector<OUTPUT_EDGE> outputEdges;
+    std::vector<LOOP>        loops;
+
+    collectEdges( aA, 0, inputEdges );
+    collectEdges( aB, 1, inputEdges );
+
+    sweep( aType, inputEdges, outputEdges );
+
+    if( !buildLoops( outputEdges, loops ) || !assignHoles( loops ) )
+    {
+        s_fallbacks++;
+        return false;
+    }
+
+    // The operands are not needed anymore, aResult may be one of them
+    std::vector<int> polygonOf( loops.size(), -1 );
+
+    aResult.RemoveAllContours();
+
+    for( size_t i = 0; i < loops.size(); i++ )
+    {
+        if( loops[i].area > 0.0 )
+            polygonOf[i] = aResult.AddOutline( loops[i].chain );
+    }
+
+    for( const LOOP& loop : loops )
+    {
+        if( loop.area <= 0.0 )
+            aResult.AddHole( loop.chain, polygonOf[loop.owner] );
+    }
+
+    s_calls++;
+
+    return true;
+}
+
+
+void SetEnabled( bool aEnabled )
+{
+    s_enabled = aEnabled;
+}
+
+
+bool IsEnabled()
+{
+    return s_enabled;
+}
+
+
+STATS GetStats()
+{
+    STATS stats;
+
+    stats.m_calls = s_calls;
+    stats.m_fallbacks = s_fallbacks;
+
+    return stats;
+}
+
+
+void ResetStats()
+{
+    s_calls = 0;
+    s_fallbacks = 0;
+}
+
+}
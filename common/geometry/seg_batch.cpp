@@ -0,0 +1,329 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <geometry/seg_batch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+
+#include "seg_batch_kernels.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SEG_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#endif
+
+
+static_assert( sizeof( VECTOR2I ) == 2 * sizeof( int ),
+               "the kernels read the points as an array of coordinates" );
+
+
+/**
+ * Margin added to the distances searched for.  It covers the rounding of the exact SEG
+ * methods to integer coordinates, and the floating point errors of the kernels.
+ */
+static const double MARGIN = 4.0;
+
+
+static const SEG_BATCH_KERNELS scalarKernels =
+{
+    scalarFindCandidate,
+    []( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aCount )
+    {
+        return scalarMinDistanceSq( aQuery, aCoords, 0, aCount, 1e300 );
+    }
+};
+
+
+#ifdef SEG_BATCH_SSE2
+
+namespace
+{
+
+/**
+ * Two doubles, with the operations used by the kernel templates
+ */
+struct VEC2
+{
+    VEC2( __m128d aV ) : v( aV ) {}
+    VEC2( double aV ) : v( _mm_set1_pd( aV ) ) {}
+
+    __m128d v;
+};
+
+
+inline VEC2 operator+( VEC2 aA, VEC2 aB ) { return _mm_add_pd( aA.v, aB.v ); }
+inline VEC2 operator-( VEC2 aA, VEC2 aB ) { return _mm_sub_pd( aA.v, aB.v ); }
+inline VEC2 operator*( VEC2 aA, VEC2 aB ) { return _mm_mul_pd( aA.v, aB.v ); }
+inline VEC2 vecMin( VEC2 aA, VEC2 aB )    { return _mm_min_pd( aA.v, aB.v ); }
+inline VEC2 vecMax( VEC2 aA, VEC2 aB )    { return _mm_max_pd( aA.v, aB.v ); }
+
+
+inline VEC2 vecRecipOrZero( VEC2 aA )
+{
+    __m128d positive = _mm_cmpgt_pd( aA.v, _mm_setzero_pd() );
+
+    return _mm_and_pd( _mm_div_pd( _mm_set1_pd( 1.0 ), aA.v ), positive );
+}
+
+
+inline VEC2 vecZeroIfNegative( VEC2 aA, VEC2 aB, VEC2 aValue )
+{
+    __m128d zero = _mm_setzero_pd();
+    __m128d both = _mm_and_pd( _mm_cmplt_pd( aA.v, zero ), _mm_cmplt_pd( aB.v, zero ) );
+
+    return _mm_andnot_pd( both, aValue.v );
+}
+
+
+/**
+ * Computes the distances to the segments aIndex and aIndex + 1
+ */
+inline VEC2 segDistSq2( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aIndex )
+{
+    const int* p = aCoords + 2 * aIndex;
+    __m128i    a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+    __m128i    b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p + 2 ) );
+
+    // x0 y0 x1 y1 -> x0 x1 y0 y1
+    a = _mm_shuffle_epi32( a, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+    b = _mm_shuffle_epi32( b, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+    VEC2 ax = _mm_cvtepi32_pd( a );
+    VEC2 ay = _mm_cvtepi32_pd( _mm_srli_si128( a, 8 ) );
+    VEC2 bx = _mm_cvtepi32_pd( b );
+    VEC2 by = _mm_cvtepi32_pd( _mm_srli_si128( b, 8 ) );
+
+    if( aQuery.isPoint )
+        return pointDistSq<VEC2>( ax, ay, bx, by, aQuery.ax, aQuery.ay );
+
+    return segDistSq<VEC2>( ax, ay, bx, by, aQuery.ax, aQuery.ay, aQuery.dx, aQuery.dy,
+                            aQuery.invLenSq );
+}
+
+
+int sse2FindCandidate( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aStart,
+                       int aCount )
+{
+    const __m128d maxDistSq = _mm_set1_pd( aQuery.maxDistSq );
+    int           i = aStart;
+
+    for( ; i + 2 <= aCount; i += 2 )
+    {
+        VEC2 dist = segDistSq2( aQuery, aCoords, i );
+        int  mask = _mm_movemask_pd( _mm_cmplt_pd( dist.v, maxDistSq ) );
+
+        if( mask )
+            return ( mask & 1 ) ? i : i + 1;
+    }
+
+    return scalarFindCandidate( aQuery, aCoords, i, aCount );
+}
+
+
+double sse2MinDistanceSq( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aCount )
+{
+    __m128d minDist = _mm_set1_pd( 1e300 );
+    int     i = 0;
+
+    for( ; i + 2 <= aCount; i += 2 )
+        minDist = _mm_min_pd( minDist, segDistSq2( aQuery, aCoords, i ).v );
+
+    minDist = _mm_min_sd( minDist, _mm_unpackhi_pd( minDist, minDist ) );
+
+    return scalarMinDistanceSq( aQuery, aCoords, i, aCount, _mm_cvtsd_f64( minDist ) );
+}
+
+
+const SEG_BATCH_KERNELS sse2Kernels = { sse2FindCandidate, sse2MinDistanceSq };
+
+}
+
+#endif
+
+
+static bool cpuSupportsAvx2()
+{
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+    int info[4];
+
+    __cpuid( info, 0 );
+
+    if( info[0] < 7 )
+        return false;
+
+    // The OS must save the AVX registers too
+    __cpuid( info, 1 );
+
+    const int osxsave = 1 << 27;
+    const int avx = 1 << 28;
+
+    if( ( info[2] & ( osxsave | avx ) ) != ( osxsave | avx ) || ( _xgetbv( 0 ) & 6 ) != 6 )
+        return false;
+
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+    return false;
+#endif
+}
+
+
+static const SEG_BATCH_KERNELS* getKernels( SEG_BATCH_ISA aIsa )
+{
+    if( aIsa == SEG_BATCH_ISA::AVX2 && SegBatchAvx2Kernels() && cpuSupportsAvx2() )
+        return SegBatchAvx2Kernels();
+
+#ifdef SEG_BATCH_SSE2
+    if( aIsa != SEG_BATCH_ISA::SCALAR )
+        return &sse2Kernels;
+#endif
+
+    return &scalarKernels;
+}
+
+
+static SEG_BATCH_ISA isaOf( const SEG_BATCH_KERNELS* aKernels )
+{
+    if( aKernels == &scalarKernels )
+        return SEG_BATCH_ISA::SCALAR;
+    else if( aKernels == SegBatchAvx2Kernels() )
+        return SEG_BATCH_ISA::AVX2;
+    else
+        return SEG_BATCH_ISA::SSE2;
+}
+
+
+static std::atomic<const SEG_BATCH_KERNELS*>& currentKernels()
+{
+    static std::atomic<const SEG_BATCH_KERNELS*> kernels( getKernels( SEG_BATCH_ISA::AVX2 ) );
+
+    return kernels;
+}
+
+
+static SEG_BATCH_QUERY makeQuery( const SEG& aSeg, double aDist )
+{
+    SEG_BATCH_QUERY query;
+
+    query.ax = aSeg.A.x;
+    query.ay = aSeg.A.y;
+    query.dx = (double) aSeg.B.x - aSeg.A.x;
+    query.dy = (double) aSeg.B.y - aSeg.A.y;
+
+    double lenSq = query.dx * query.dx + query.dy * query.dy;
+
+    query.minX = std::min( aSeg.A.x, aSeg.B.x );
+    query.minY = std::min( aSeg.A.y, aSeg.B.y );
+    query.maxX = std::max( aSeg.A.x, aSeg.B.x );
+    query.maxY = std::max( aSeg.A.y, aSeg.B.y );
+
+    query.invLenSq = lenSq > 0.0 ? 1.0 / lenSq : 0.0;
+    query.isPoint = aSeg.A == aSeg.B;
+    query.maxDistSq = ( aDist + MARGIN ) * ( aDist + MARGIN );
+
+    return query;
+}
+
+
+namespace SEG_BATCH
+{
+
+SEG_BATCH_ISA GetIsa()
+{
+    return isaOf( currentKernels() );
+}
+
+
+SEG_BATCH_ISA SetIsa( SEG_BATCH_ISA aIsa )
+{
+    currentKernels() = getKernels( aIsa );
+
+    return GetIsa();
+}
+
+
+SEG_BATCH_ISA GetBestIsa()
+{
+    return isaOf( getKernels( SEG_BATCH_ISA::AVX2 ) );
+}
+
+
+int FindCandidate( const SEG& aSeg, const VECTOR2I* aPoints, int aSegCount, int aStart,
+                   int aDist )
+{
+    if( aStart >= aSegCount )
+        return -1;
+
+    // SEG::Collide() takes the absolute value of negative clearances
+    SEG_BATCH_QUERY query = makeQuery( aSeg, std::abs( (double) aDist ) );
+
+    return currentKernels().load()->findCandidate( query, &aPoints[0].x, aStart, aSegCount );
+}
+
+
+int Distance( const VECTOR2I& aP, const VECTOR2I* aPoints, int aSegCount )
+{
+    const SEG_BATCH_KERNELS* kernels = currentKernels();
+    int                      d = INT_MAX;
+
+    // Two passes only pay off when the first one is vectorized
+    if( kernels == &scalarKernels )
+    {
+        for( int s = 0; s < aSegCount; s++ )
+            d = std::min( d, SEG( aPoints[s], aPoints[s + 1] ).Distance( aP ) );
+
+        return d;
+    }
+
+    if( aSegCount <= 0 )
+        return d;
+
+    // Find the distance roughly, then check exactly the segments about as close
+    SEG             point( aP, aP );
+    SEG_BATCH_QUERY query = makeQuery( point, 0.0 );
+    double          approx = sqrt( kernels->minDistanceSq( query, &aPoints[0].x, aSegCount ) );
+
+    query = makeQuery( point, std::min<double>( approx + 2.0, INT_MAX ) );
+
+    for( int s = kernels->findCandidate( query, &aPoints[0].x, 0, aSegCount );
+         s >= 0;
+         s = kernels->findCandidate( query, &aPoints[0].x, s + 1, aSegCount ) )
+    {
+        d = std::min( d, SEG( aPoints[s], aPoints[s + 1] ).Distance( aP ) );
+    }
+
+    return d;
+}
+
+}
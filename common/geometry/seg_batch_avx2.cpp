@@ -0,0 +1,163 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file seg_batch_avx2.cpp
+ * AVX2 SEG_BATCH kernels.  This file is built with AVX2 enabled and only runs on processors
+ * supporting it, so it must only contain the kernels (see seg_batch_kernels.h).
+ */
+
+#include "seg_batch_kernels.h"
+
+#if defined( __AVX2__ )
+
+#include <immintrin.h>
+
+namespace
+{
+
+/**
+ * Four doubles, with the operations used by the kernel templates
+ */
+struct VEC4
+{
+    VEC4( __m256d aV ) : v( aV ) {}
+    VEC4( double aV ) : v( _mm256_set1_pd( aV ) ) {}
+
+    __m256d v;
+};
+
+
+inline VEC4 operator+( VEC4 aA, VEC4 aB ) { return _mm256_add_pd( aA.v, aB.v ); }
+inline VEC4 operator-( VEC4 aA, VEC4 aB ) { return _mm256_sub_pd( aA.v, aB.v ); }
+inline VEC4 operator*( VEC4 aA, VEC4 aB ) { return _mm256_mul_pd( aA.v, aB.v ); }
+inline VEC4 vecMin( VEC4 aA, VEC4 aB )    { return _mm256_min_pd( aA.v, aB.v ); }
+inline VEC4 vecMax( VEC4 aA, VEC4 aB )    { return _mm256_max_pd( aA.v, aB.v ); }
+
+
+inline VEC4 vecRecipOrZero( VEC4 aA )
+{
+    __m256d positive = _mm256_cmp_pd( aA.v, _mm256_setzero_pd(), _CMP_GT_OQ );
+
+    return _mm256_and_pd( _mm256_div_pd( _mm256_set1_pd( 1.0 ), aA.v ), positive );
+}
+
+
+inline VEC4 vecZeroIfNegative( VEC4 aA, VEC4 aB, VEC4 aValue )
+{
+    __m256d zero = _mm256_setzero_pd();
+    __m256d both = _mm256_and_pd( _mm256_cmp_pd( aA.v, zero, _CMP_LT_OQ ),
+                                  _mm256_cmp_pd( aB.v, zero, _CMP_LT_OQ ) );
+
+    return _mm256_andnot_pd( both, aValue.v );
+}
+
+
+/**
+ * Computes the distances to the segments aIndex to aIndex + 3
+ */
+inline VEC4 segDistSq4( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aIndex )
+{
+    // x0 y0 x1 y1 x2 y2 x3 y3 -> x0 x1 x2 x3 y0 y1 y2 y3
+    const __m256i deinterleave = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+
+    const int* p = aCoords + 2 * aIndex;
+    __m256i    a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+    __m256i    b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + 2 ) );
+
+    a = _mm256_permutevar8x32_epi32( a, deinterleave );
+    b = _mm256_permutevar8x32_epi32( b, deinterleave );
+
+    VEC4 ax = _mm256_cvtepi32_pd( _mm256_castsi256_si128( a ) );
+    VEC4 ay = _mm256_cvtepi32_pd( _mm256_extracti128_si256( a, 1 ) );
+    VEC4 bx = _mm256_cvtepi32_pd( _mm256_castsi256_si128( b ) );
+    VEC4 by = _mm256_cvtepi32_pd( _mm256_extracti128_si256( b, 1 ) );
+
+    if( aQuery.isPoint )
+        return pointDistSq<VEC4>( ax, ay, bx, by, aQuery.ax, aQuery.ay );
+
+    return segDistSq<VEC4>( ax, ay, bx, by, aQuery.ax, aQuery.ay, aQuery.dx, aQuery.dy,
+                            aQuery.invLenSq );
+}
+
+
+int avx2FindCandidate( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aStart,
+                       int aCount )
+{
+    const __m256d maxDistSq = _mm256_set1_pd( aQuery.maxDistSq );
+    int           i = aStart;
+
+    for( ; i + 4 <= aCount; i += 4 )
+    {
+        VEC4 dist = segDistSq4( aQuery, aCoords, i );
+        int  mask = _mm256_movemask_pd( _mm256_cmp_pd( dist.v, maxDistSq, _CMP_LT_OQ ) );
+
+        if( mask )
+        {
+            for( int k = 0; ; k++ )
+            {
+                if( mask & ( 1 << k ) )
+                    return i + k;
+            }
+        }
+    }
+
+    return scalarFindCandidate( aQuery, aCoords, i, aCount );
+}
+
+
+double avx2MinDistanceSq( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aCount )
+{
+    __m256d minDist = _mm256_set1_pd( 1e300 );
+    int     i = 0;
+
+    for( ; i + 4 <= aCount; i += 4 )
+        minDist = _mm256_min_pd( minDist, segDistSq4( aQuery, aCoords, i ).v );
+
+    __m128d half = _mm_min_pd( _mm256_castpd256_pd128( minDist ),
+                               _mm256_extractf128_pd( minDist, 1 ) );
+
+    half = _mm_min_sd( half, _mm_unpackhi_pd( half, half ) );
+
+    return scalarMinDistanceSq( aQuery, aCoords, i, aCount, _mm_cvtsd_f64( half ) );
+}
+
+
+const SEG_BATCH_KERNELS avx2Kernels = { avx2FindCandidate, avx2MinDistanceSq };
+
+}
+
+
+const SEG_BATCH_KERNELS* SegBatchAvx2Kernels()
+{
+    return &avx2Kernels;
+}
+
+#else
+
+const SEG_BATCH_KERNELS* SegBatchAvx2Kernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file seg_batch_kernels.h
+ * Internals of the SEG_BATCH kernels, shared by the files built for each instruction set.
+ *
+ * This header must not include anything: the AVX2 kernels are built with different
+ * compiler flags, and an inline function of a common header compiled there could be
+ * picked by the linker for the whole program.
+ */
+
+#ifndef __SEG_BATCH_KERNELS_H
+#define __SEG_BATCH_KERNELS_H
+
+/**
+ * The segment tested against a polyline, and the squared distance searched for.
+ */
+struct SEG_BATCH_QUERY
+{
+    double ax, ay;      ///< start of the segment
+    double dx, dy;      ///< end - start
+    double invLenSq;    ///< 1 / squared length, 0 for a point
+    double minX, minY;  ///< bounding box of the segment
+    double maxX, maxY;
+    double maxDistSq;   ///< FindCandidate() threshold
+    bool   isPoint;     ///< both ends of the segment are equal
+};
+
+
+/**
+ * The kernels built for one instruction set.  aCoords holds the interleaved x, y
+ * coordinates of aCount + 1 points.
+ */
+struct SEG_BATCH_KERNELS
+{
+    int ( *findCandidate )( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aStart,
+                            int aCount );
+
+    double ( *minDistanceSq )( const SEG_BATCH_QUERY& aQuery, const int* aCoords,
+                               int aCount );
+};
+
+
+/**
+ * @return the AVX2 kernels, or nullptr when the compiler could not build them.
+ */
+const SEG_BATCH_KERNELS* SegBatchAvx2Kernels();
+
+
+namespace
+{
+
+// Operations on double for the templates below, the vector types overload them
+inline double vecMin( double aA, double aB )
+{
+    return aA < aB ? aA : aB;
+}
+
+
+inline double vecMax( double aA, double aB )
+{
+    return aA > aB ? aA : aB;
+}
+
+
+inline double vecRecipOrZero( double aA )
+{
+    return aA > 0.0 ? 1.0 / aA : 0.0;
+}
+
+
+inline double vecZeroIfNegative( double aA, double aB, double aValue )
+{
+    return ( aA < 0.0 && aB < 0.0 ) ? 0.0 : aValue;
+}
+
+
+/**
+ * Squared distance between a point and a segment, given by its start, its direction and
+ * the inverse of its squared length.  V is double or a vector of doubles.
+ */
+template <typename V>
+inline V pointSegDistSq( V aPx, V aPy, V aAx, V aAy, V aDx, V aDy, V aInvLenSq )
+{
+    V ex = aPx - aAx;
+    V ey = aPy - aAy;
+    V t = ( ex * aDx + ey * aDy ) * aInvLenSq;
+
+    t = vecMin( vecMax( t, V( 0.0 ) ), V( 1.0 ) );
+    ex = ex - t * aDx;
+    ey = ey - t * aDy;
+
+    return ex * ex + ey * ey;
+}
+
+
+/**
+ * Squared distance between the query point (broadcast in aQ*) and the segments from aA
+ * to aB.
+ */
+template <typename V>
+inline V pointDistSq( V aAx, V aAy, V aBx, V aBy, V aQx, V aQy )
+{
+    V dx = aBx - aAx;
+    V dy = aBy - aAy;
+
+    return pointSegDistSq( aQx, aQy, aAx, aAy, dx, dy, vecRecipOrZero( dx * dx + dy * dy ) );
+}
+
+
+/**
+ * Squared distance between the query segment (broadcast in aQ*) and the segments from
+ * aA to aB.  Touching or crossing segments are at distance 0.  Rounding errors can make
+ * nearly collinear segments cross, never a point and a segment.
+ */
+template <typename V>
+inline V segDistSq( V aAx, V aAy, V aBx, V aBy,
+                    V aQax, V aQay, V aQdx, V aQdy, V aQinvLenSq )
+{
+    V dx = aBx - aAx;
+    V dy = aBy - aAy;
+    V invLenSq = vecRecipOrZero( dx * dx + dy * dy );
+    V qbx = aQax + aQdx;
+    V qby = aQay + aQdy;
+
+    V dist = vecMin( vecMin( pointSegDistSq( aQax, aQay, aAx, aAy, dx, dy, invLenSq ),
+                             pointSegDistSq( qbx, qby, aAx, aAy, dx, dy, invLenSq ) ),
+                     vecMin( pointSegDistSq( aAx, aAy, aQax, aQay, aQdx, aQdy, aQinvLenSq ),
+                             pointSegDistSq( aBx, aBy, aQax, aQay, aQdx, aQdy, aQinvLenSq ) ) );
+
+    // The ends of each segment strictly on both sides of the other one mean a crossing.  An
+    // end touching the other segment is already at distance 0 above.
+    V side1 = dx * ( aQay - aAy ) - dy * ( aQax - aAx );
+    V side2 = dx * ( qby - aAy ) - dy * ( qbx - aAx );
+    V side3 = aQdx * ( aAy - aQay ) - aQdy * ( aAx - aQax );
+    V side4 = aQdx * ( aBy - aQay ) - aQdy * ( aBx - aQax );
+
+    return vecZeroIfNegative( side1 * side2, side3 * side4, dist );
+}
+
+
+/**
+ * Scalar kernels, also used for the segments left after the vector loops.
+ */
+inline double scalarSegDistSq( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aIndex )
+{
+    const int* p = aCoords + 2 * aIndex;
+
+    if( aQuery.isPoint )
+        return pointDistSq<double>( p[0], p[1], p[2], p[3], aQuery.ax, aQuery.ay );
+
+    return segDistSq<double>( p[0], p[1], p[2], p[3], aQuery.ax, aQuery.ay, aQuery.dx,
+                              aQuery.dy, aQuery.invLenSq );
+}
+
+
+/**
+ * Squared distance between the bounding boxes of the query segment and of the segment
+ * aIndex: a cheap lower bound of their distance for the scalar kernels.
+ */
+inline double scalarBoxDistSq( const SEG_BATCH_QUERY& aQuery, const int* aCoords, int aIndex )
+{
+    const int* p = aCoords + 2 * aIndex;
+    double     ax = p[0], ay = p[1], bx = p[2], by = p[3];
+
+    double gapX = vecMax( vecMax( vecMin( ax, bx ) - aQuery.maxX,
+                                  aQuery.minX - vecMax( ax, bx ) ), 0.0 );
+    double gapY = vecMax( vecMax( vecMin( ay, by ) - aQuery.maxY,
+                                  aQuery.minY - vecMax( ay, by ) ), 0.0 );
+
+    return gapX * gapX + gapY * gapY;
+}
+
+
+inline int scalarFindCandidate( const SEG_BATCH_QUERY& aQuery, const int* aCoords,
+                                int aStart, int aCount )
+{
+    for( int i = aStart; i < aCount; i++ )
+    {
+        if( scalarBoxDistSq( aQuery, aCoords, i ) < aQuery.maxDistSq
+                && scalarSegDistSq( aQuery, aCoords, i ) < aQuery.maxDistSq )
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+inline double scalarMinDistanceSq( const SEG_BATCH_QUERY& aQuery, const int* aCoords,
+                                   int aStart, int aCount, double aMin )
+{
+    for( int i = aStart; i < aCount; i++ )
+    {
+        if( scalarBoxDistSq( aQuery, aCoords, i ) < aMin )
+            aMin = vecMin( aMin, scalarSegDistSq( aQuery, aCoords, i ) );
+    }
+
+    return aMin;
+}
+
+}
+
+#endif // __SEG_BATCH_KERNELS_H
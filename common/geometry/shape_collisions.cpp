@@ -25,6 +25,7 @@
 #include <math/vector2d.h>
 #include <math.h>
 
+#include <geometry/seg_batch.h>
 #include <geometry/shape.h>
 #include <geometry/shape_arc.h>
 #include <geometry/shape_line_chain.h>
@@ -152,7 +153,15 @@ static inline bool Collide( const SHAPE_CIRCLE& aA, const SHAPE_LINE_CHAIN& aB,
 {
     bool found = false;
 
-    for( int s = 0; s < aB.SegmentCount(); s++ )
+    // The batched search skips the segments which are certainly too far away
+    const std::vector<VECTOR2I>& pts = aB.CPoints();
+    SEG center( aA.GetCenter(), aA.GetCenter() );
+    int dist = aClearance + aA.GetRadius();
+    int openCount = std::max( 0, aB.PointCount() - 1 );
+
+    for( int s = SEG_BATCH::FindCandidate( center, pts.data(), openCount, 0, dist );
+         s >= 0;
+         s = SEG_BATCH::FindCandidate( center, pts.data(), openCount, s + 1, dist ) )
     {
         if( aA.Collide( aB.CSegment( s ), aClearance ) )
         {
@@ -161,6 +170,9 @@ static inline bool Collide( const SHAPE_CIRCLE& aA, const SHAPE_LINE_CHAIN& aB,
         }
     }
 
+    if( !found && aB.IsClosed() && aB.PointCount() > 0 )
+        found = aA.Collide( aB.CSegment( aB.PointCount() - 1 ), aClearance );
+
     if( !aNeedMTV || !found )
         return found;
 
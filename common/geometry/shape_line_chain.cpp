@@ -24,6 +24,7 @@
 
 #include <algorithm>
 
+#include <geometry/seg_batch.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_circle.h>
 #include "clipper.hpp"
@@ -70,20 +71,29 @@ bool SHAPE_LINE_CHAIN::Collide( const SEG& aSeg, int aClearance ) const
     BOX2I box_a( aSeg.A, aSeg.B - aSeg.A );
     BOX2I::ecoord_type dist_sq = (BOX2I::ecoord_type) aClearance * aClearance;
 
-    for( int i = 0; i < SegmentCount(); i++ )
+    auto collide = [&]( const SEG& s )
     {
-        const SEG& s = CSegment( i );
         BOX2I box_b( s.A, s.B - s.A );
 
         BOX2I::ecoord_type d = box_a.SquaredDistance( box_b );
 
-        if( d < dist_sq )
-        {
-            if( s.Collide( aSeg, aClearance ) )
-                return true;
-        }
+        return d < dist_sq && s.Collide( aSeg, aClearance );
+    };
+
+    // The batched search skips the segments which are certainly too far away
+    int openCount = std::max( 0, PointCount() - 1 );
+
+    for( int i = SEG_BATCH::FindCandidate( aSeg, m_points.data(), openCount, 0, aClearance );
+         i >= 0;
+         i = SEG_BATCH::FindCandidate( aSeg, m_points.data(), openCount, i + 1, aClearance ) )
+    {
+        if( collide( CSegment( i ) ) )
+            return true;
     }
 
+    if( m_closed && PointCount() > 0 && collide( CSegment( PointCount() - 1 ) ) )
+        return true;
+
     return false;
 }
 
@@ -155,13 +165,13 @@ void SHAPE_LINE_CHAIN::Remove( int aStartIndex, int aEndIndex )
 
 int SHAPE_LINE_CHAIN::Distance( const VECTOR2I& aP, bool aOutlineOnly ) const
 {
-    int d = INT_MAX;
-
     if( IsClosed() && PointInside( aP ) && !aOutlineOnly )
         return 0;
 
-    for( int s = 0; s < SegmentCount(); s++ )
-        d = std::min( d, CSegment( s ).Distance( aP ) );
+    int d = SEG_BATCH::Distance( aP, m_points.data(), std::max( 0, PointCount() - 1 ) );
+
+    if( m_closed && PointCount() > 0 )
+        d = std::min( d, CSegment( PointCount() - 1 ).Distance( aP ) );
 
     return d;
 }
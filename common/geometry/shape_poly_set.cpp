@@ -44,7 +44,9 @@
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_poly_set.h>
+#include <geometry/shape_poly_set_cache.h>
 #include <geometry/polygon_triangulation.h>
+#include <geometry/rectilinear_boolean.h>
 
 using namespace ClipperLib;
 
@@ -57,12 +59,10 @@ SHAPE_POLY_SET::SHAPE_POLY_SET() :
 SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther, bool aDeepCopy ) :
     SHAPE( SH_POLY_SET ), m_polys( aOther.m_polys )
 {
+    // The triangulated polygons are never modified, the copy can share them
     if( aOther.IsTriangulationUpToDate() )
     {
-        for( unsigned i = 0; i < aOther.TriangulatedPolyCount(); i++ )
-            m_triangulatedPolys.push_back(
-                    std::make_unique<TRIANGULATED_POLYGON>( *aOther.TriangulatedPolygon( i ) ) );
-
+        m_triangulatedPolys = aOther.m_triangulatedPolys;
         m_hash = aOther.GetHash();
         m_triangulationValid = true;
     }
@@ -478,6 +478,11 @@ void SHAPE_POLY_SET::booleanOp( ClipperLib::ClipType aType,
         const SHAPE_POLY_SET& aOtherShape,
         POLYGON_MODE aFastMode )
 {
+    // Rectilinear sets do not need the general algorithm.  Its results are strictly simple,
+    // loops touching themselves being split at the touching points, so they suit both modes.
+    if( RECTILINEAR_BOOLEAN::Execute( aType, aShape, aOtherShape, *this ) )
+        return;
+
     Clipper c;
 
     c.StrictlySimple( aFastMode == PM_STRICTLY_SIMPLE );
@@ -830,12 +835,27 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 
 void SHAPE_POLY_SET::Fracture( POLYGON_MODE aFastMode )
 {
+    SHAPE_POLY_SET_CACHE& cache = SHAPE_POLY_SET_CACHE::Instance();
+    bool                  useCache = TotalVertices() >= SHAPE_POLY_SET_CACHE::MIN_VERTICES;
+    MD5_HASH              hash;
+
+    if( useCache )
+    {
+        hash = checksum();
+
+        if( cache.FindFracture( hash, aFastMode, m_polys ) )
+            return;
+    }
+
     Simplify( aFastMode );    // remove overlapping holes/degeneracy
 
     for( POLYGON& paths : m_polys )
     {
         fractureSingle( paths );
     }
+
+    if( useCache )
+        cache.StoreFracture( hash, aFastMode, m_polys );
 }
 
 
@@ -1811,10 +1831,20 @@ SHAPE_POLY_SET &SHAPE_POLY_SET::operator=( const SHAPE_POLY_SET& aOther )
     static_cast<SHAPE&>(*this) = aOther;
     m_polys = aOther.m_polys;
 
-    // reset poly cache:
-    m_hash = MD5_HASH{};
-    m_triangulationValid = false;
-    m_triangulatedPolys.clear();
+    // share the triangulation, like the copy constructor, or reset poly cache:
+    if( aOther.IsTriangulationUpToDate() )
+    {
+        m_triangulatedPolys = aOther.m_triangulatedPolys;
+        m_hash = aOther.GetHash();
+        m_triangulationValid = true;
+    }
+    else
+    {
+        m_hash = MD5_HASH{};
+        m_triangulationValid = false;
+        m_triangulatedPolys.clear();
+    }
+
     return *this;
 }
 
@@ -1843,25 +1873,22 @@ bool SHAPE_POLY_SET::IsTriangulationUpToDate() const
 
 void SHAPE_POLY_SET::CacheTriangulation()
 {
-    bool recalculate = !m_hash.IsValid();
-    MD5_HASH hash;
+    MD5_HASH hash = checksum();
 
-    if( !m_triangulationValid )
-        recalculate = true;
+    if( m_triangulationValid && m_hash.IsValid() && m_hash == hash )
+        return;
 
-    if( !recalculate )
-    {
-        hash = checksum();
+    SHAPE_POLY_SET_CACHE& cache = SHAPE_POLY_SET_CACHE::Instance();
+    bool                  useCache = TotalVertices() >= SHAPE_POLY_SET_CACHE::MIN_VERTICES;
 
-        if( m_hash != hash )
-        {
-            m_hash = hash;
-            recalculate = true;
-        }
-    }
+    m_hash = hash;
+    m_triangulationValid = false;
 
-    if( !recalculate )
+    if( useCache && cache.FindTriangulation( hash, m_triangulatedPolys ) )
+    {
+        m_triangulationValid = true;
         return;
+    }
 
     SHAPE_POLY_SET tmpSet = *this;
 
@@ -1873,8 +1900,9 @@ void SHAPE_POLY_SET::CacheTriangulation()
 
     while( tmpSet.OutlineCount() > 0 )
     {
-        m_triangulatedPolys.push_back( std::make_unique<TRIANGULATED_POLYGON>() );
-        PolygonTriangulation tess( *m_triangulatedPolys.back() );
+        auto triPoly = std::make_shared<TRIANGULATED_POLYGON>();
+        m_triangulatedPolys.push_back( triPoly );
+        PolygonTriangulation tess( *triPoly );
 
         // If the tesselation fails, we re-fracture the polygon, which will
         // first simplify the system before fracturing and removing the holes
@@ -1890,8 +1918,8 @@ void SHAPE_POLY_SET::CacheTriangulation()
         m_triangulationValid = true;
     }
 
-    if( m_triangulationValid )
-        m_hash = checksum();
+    if( m_triangulationValid && useCache )
+        cache.StoreTriangulation( hash, m_triangulatedPolys );
 }
 
 
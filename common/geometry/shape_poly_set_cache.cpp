@@ -0,0 +1,211 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <geometry/shape_poly_set_cache.h>
+
+
+// Rough sizes, enough to keep the cache within its budget
+static size_t triangulationBytes( const SHAPE_POLY_SET_CACHE::TRIANGULATION& aTriangulation )
+{
+    size_t bytes = 0;
+
+    for( const auto& tri : aTriangulation )
+    {
+        bytes += sizeof( SHAPE_POLY_SET::TRIANGULATED_POLYGON );
+        bytes += tri->GetVertexCount() * sizeof( VECTOR2I );
+        bytes += tri->GetTriangleCount() * sizeof( SHAPE_POLY_SET::TRIANGULATED_POLYGON::TRI );
+    }
+
+    return bytes;
+}
+
+
+static size_t polygonsBytes( const SHAPE_POLY_SET_CACHE::POLYGONS& aPolygons )
+{
+    size_t bytes = 0;
+
+    for( const SHAPE_POLY_SET::POLYGON& poly : aPolygons )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : poly )
+            bytes += sizeof( SHAPE_LINE_CHAIN ) + chain.PointCount() * sizeof( VECTOR2I );
+    }
+
+    return bytes;
+}
+
+
+SHAPE_POLY_SET_CACHE::SHAPE_POLY_SET_CACHE() :
+    m_maxBytes( DEFAULT_MAX_BYTES )
+{
+}
+
+
+SHAPE_POLY_SET_CACHE& SHAPE_POLY_SET_CACHE::Instance()
+{
+    static SHAPE_POLY_SET_CACHE cache;
+
+    return cache;
+}
+
+
+bool SHAPE_POLY_SET_CACHE::FindTriangulation( const MD5_HASH& aHash, TRIANGULATION& aResult )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    ENTRY* entry = find( KEY( aHash, TRIANGULATED ) );
+
+    if( !entry )
+        return false;
+
+    aResult = entry->m_triangulation;
+    return true;
+}
+
+
+void SHAPE_POLY_SET_CACHE::StoreTriangulation( const MD5_HASH& aHash,
+                                               const TRIANGULATION& aTriangulation )
+{
+    ENTRY entry;
+
+    entry.m_key = KEY( aHash, TRIANGULATED );
+    entry.m_triangulation = aTriangulation;
+    entry.m_bytes = triangulationBytes( aTriangulation );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    store( std::move( entry ) );
+}
+
+
+bool SHAPE_POLY_SET_CACHE::FindFracture( const MD5_HASH& aHash,
+                                         SHAPE_POLY_SET::POLYGON_MODE aMode, POLYGONS& aResult )
+{
+    KIND kind = ( aMode == SHAPE_POLY_SET::PM_FAST ) ? FRACTURED_FAST : FRACTURED_STRICTLY_SIMPLE;
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    ENTRY* entry = find( KEY( aHash, kind ) );
+
+    if( !entry )
+        return false;
+
+    aResult = entry->m_polygons;
+    return true;
+}
+
+
+void SHAPE_POLY_SET_CACHE::StoreFracture( const MD5_HASH& aHash,
+                                          SHAPE_POLY_SET::POLYGON_MODE aMode,
+                                          const POLYGONS& aPolygons )
+{
+    KIND  kind = ( aMode == SHAPE_POLY_SET::PM_FAST ) ? FRACTURED_FAST : FRACTURED_STRICTLY_SIMPLE;
+    ENTRY entry;
+
+    entry.m_key = KEY( aHash, kind );
+    entry.m_polygons = aPolygons;
+    entry.m_bytes = polygonsBytes( aPolygons );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    store( std::move( entry ) );
+}
+
+
+void SHAPE_POLY_SET_CACHE::SetMaxBytes( size_t aMaxBytes )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_maxBytes = aMaxBytes;
+    trim();
+}
+
+
+void SHAPE_POLY_SET_CACHE::Clear()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_entries.clear();
+    m_index.clear();
+    m_stats = STATS();
+}
+
+
+SHAPE_POLY_SET_CACHE::STATS SHAPE_POLY_SET_CACHE::GetStats() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return m_stats;
+}
+
+
+SHAPE_POLY_SET_CACHE::ENTRY* SHAPE_POLY_SET_CACHE::find( const KEY& aKey )
+{
+    auto it = m_index.find( aKey );
+
+    if( it == m_index.end() )
+    {
+        m_stats.m_misses++;
+        return nullptr;
+    }
+
+    m_entries.splice( m_entries.begin(), m_entries, it->second );
+    m_stats.m_hits++;
+
+    return &m_entries.front();
+}
+
+
+void SHAPE_POLY_SET_CACHE::store( ENTRY&& aEntry )
+{
+    auto it = m_index.find( aEntry.m_key );
+
+    // Another thread may have processed the same set meanwhile: the results are the same
+    if( it != m_index.end() )
+    {
+        m_entries.splice( m_entries.begin(), m_entries, it->second );
+        return;
+    }
+
+    m_stats.m_bytes += aEntry.m_bytes;
+    m_stats.m_entries++;
+
+    m_entries.push_front( std::move( aEntry ) );
+    m_index[m_entries.front().m_key] = m_entries.begin();
+
+    trim();
+}
+
+
+void SHAPE_POLY_SET_CACHE::trim()
+{
+    while( !m_entries.empty() && m_stats.m_bytes > m_maxBytes )
+    {
+        const ENTRY& oldest = m_entries.back();
+
+        m_stats.m_bytes -= oldest.m_bytes;
+        m_stats.m_entries--;
+
+        m_index.erase( oldest.m_key );
+        m_entries.pop_back();
+    }
+}
@@ -28,6 +28,9 @@
 #include <class_text_mod.h>
 #include <class_edge_mod.h>
 #include <class_pad.h>
+#include <class_track.h>
+#include <class_drawsegment.h>
+#include <class_pcb_text.h>
 
 #include <functional>
 
@@ -180,6 +183,107 @@ size_t hash_eda( const EDA_ITEM* aItem, int aFlags )
         }
         break;
 
+    case PCB_TRACE_T:
+        {
+            const TRACK* track = static_cast<const TRACK*>( aItem );
+            ret ^= hash_board_item( track, aFlags );
+            ret ^= hash<int>{}( track->GetWidth() );
+
+            if( aFlags & POSITION )
+            {
+                ret ^= hash<int>{}( track->GetStart().x );
+                ret ^= hash<int>{}( track->GetStart().y << 1 );
+                ret ^= hash<int>{}( track->GetEnd().x << 2 );
+                ret ^= hash<int>{}( track->GetEnd().y << 3 );
+            }
+
+            if( aFlags & NET )
+                ret ^= hash<int>{}( track->GetNetCode() << 6 );
+        }
+        break;
+
+    case PCB_VIA_T:
+        {
+            const VIA* via = static_cast<const VIA*>( aItem );
+            ret ^= hash_board_item( via, aFlags );
+            ret ^= hash<int>{}( via->GetWidth() );
+            ret ^= hash<int>{}( via->GetDrill() << 2 );
+            ret ^= hash<int>{}( via->GetViaType() << 16 );
+
+            if( aFlags & POSITION )
+            {
+                ret ^= hash<int>{}( via->GetStart().x );
+                ret ^= hash<int>{}( via->GetStart().y << 1 );
+            }
+
+            if( aFlags & NET )
+                ret ^= hash<int>{}( via->GetNetCode() << 6 );
+        }
+        break;
+
+    case PCB_LINE_T:
+        {
+            const DRAWSEGMENT* segment = static_cast<const DRAWSEGMENT*>( aItem );
+            ret ^= hash_board_item( segment, aFlags );
+            ret ^= hash<int>{}( segment->GetShape() );
+            ret ^= hash<int>{}( segment->GetWidth() );
+
+            if( aFlags & POSITION )
+            {
+                ret ^= hash<int>{}( segment->GetStart().x );
+                ret ^= hash<int>{}( segment->GetStart().y << 1 );
+                ret ^= hash<int>{}( segment->GetEnd().x << 2 );
+                ret ^= hash<int>{}( segment->GetEnd().y << 3 );
+
+                if( segment->GetShape() == S_CURVE )
+                {
+                    ret ^= hash<int>{}( segment->GetBezControl1().x << 4 );
+                    ret ^= hash<int>{}( segment->GetBezControl1().y << 5 );
+                    ret ^= hash<int>{}( segment->GetBezControl2().x << 6 );
+                    ret ^= hash<int>{}( segment->GetBezControl2().y << 7 );
+                }
+                else if( segment->GetShape() == S_POLYGON )
+                {
+                    int shift = 0;
+
+                    for( auto it = segment->GetPolyShape().CIterate(); it; it++ )
+                    {
+                        ret ^= hash<int>{}( it->x << ( shift & 7 ) );
+                        ret ^= hash<int>{}( it->y << ( ++shift & 7 ) );
+                    }
+                }
+            }
+
+            if( aFlags & ROTATION )
+                ret ^= hash<double>{}( segment->GetAngle() );
+        }
+        break;
+
+    case PCB_TEXT_T:
+        {
+            const TEXTE_PCB* text = static_cast<const TEXTE_PCB*>( aItem );
+            ret ^= hash_board_item( text, aFlags );
+            ret ^= hash<string>{}( text->GetText().ToStdString() );
+            ret ^= hash<bool>{}( text->IsItalic() );
+            ret ^= hash<bool>{}( text->IsBold() );
+            ret ^= hash<bool>{}( text->IsMirrored() );
+            ret ^= hash<int>{}( text->GetTextWidth() );
+            ret ^= hash<int>{}( text->GetTextHeight() );
+            ret ^= hash<int>{}( text->GetThickness() );
+            ret ^= hash<int>{}( text->GetHorizJustify() );
+            ret ^= hash<int>{}( text->GetVertJustify() );
+
+            if( aFlags & POSITION )
+            {
+                ret ^= hash<int>{}( text->GetTextPos().x );
+                ret ^= hash<int>{}( text->GetTextPos().y );
+            }
+
+            if( aFlags & ROTATION )
+                ret ^= hash<double>{}( text->GetTextAngle() );
+        }
+        break;
+
     default:
         wxASSERT_MSG( false, "Unhandled type in function hashModItem() (exporter_gencad.cpp)" );
     }
@@ -91,6 +91,11 @@ bool MD5_HASH::operator!=( const MD5_HASH& aOther ) const
     return ( memcmp( m_hash, aOther.m_hash, 16 ) != 0 );
 }
 
+bool MD5_HASH::operator<( const MD5_HASH& aOther ) const
+{
+    return ( memcmp( m_hash, aOther.m_hash, 16 ) < 0 );
+}
+
 
 std::string MD5_HASH::Format()
 {
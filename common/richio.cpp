@@ -24,10 +24,22 @@
 
 
 #include <cstdarg>
+#include <cstring>
 #include <config.h> // HAVE_FGETC_NOLOCK
 
 #include <richio.h>
 
+#include <wx/filename.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -225,13 +237,197 @@ char* FILE_LINE_READER::ReadLine()
 }
 
 
-STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ):
+MAPPED_FILE_LINE_READER::MAPPED_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber, unsigned aMaxLineLength ) :
+    LINE_READER( aMaxLineLength ),
+    m_data( NULL ),
+    m_size( 0 )
+{
+    bool mapped = false;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW( aFileName.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+    if( file != INVALID_HANDLE_VALUE )
+    {
+        LARGE_INTEGER size;
+
+        if( GetFileSizeEx( file, &size ) )
+        {
+            m_size = (size_t) size.QuadPart;
+            mapped = true;
+
+            if( m_size > 0 )
+            {
+                // The view keeps the file and the mapping open: the handles are not needed
+                HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+                if( mapping )
+                {
+                    m_data = (const char*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+                    CloseHandle( mapping );
+                }
+
+                mapped = m_data != NULL;
+            }
+        }
+
+        CloseHandle( file );
+    }
+#else
+    int fd = open( aFileName.fn_str(), O_RDONLY );
+
+    if( fd >= 0 )
+    {
+        struct stat st;
+
+        if( fstat( fd, &st ) == 0 )
+        {
+            m_size = (size_t) st.st_size;
+            mapped = true;
+
+            if( m_size > 0 )
+            {
+                void* data = mmap( NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+                if( data != MAP_FAILED )
+                {
+                    madvise( data, m_size, MADV_SEQUENTIAL );
+                    m_data = (const char*) data;
+                }
+
+                mapped = m_data != NULL;
+            }
+        }
+
+        close( fd );
+    }
+#endif
+
+    if( !mapped )
+    {
+        wxString msg = wxString::Format(
+            _( "Unable to open filename \"%s\" for reading" ), aFileName.GetData() );
+        THROW_IO_ERROR( msg );
+    }
+
+    m_next    = m_data;
+    m_source  = aFileName;
+    m_lineNum = aStartingLineNumber;
+}
+
+
+MAPPED_FILE_LINE_READER::~MAPPED_FILE_LINE_READER()
+{
+    if( m_data )
+    {
+#ifdef _WIN32
+        UnmapViewOfFile( m_data );
+#else
+        munmap( (void*) m_data, m_size );
+#endif
+    }
+}
+
+
+const char* MAPPED_FILE_LINE_READER::nextLine()
+{
+    const char* end = m_data + m_size;
+    const char* line = m_next;
+
+    if( line == end )
+    {
+        m_length = 0;
+        return NULL;
+    }
+
+    const char* eol = (const char*) memchr( line, '\n', end - line );
+
+    m_next = eol ? eol + 1 : end;     // include the newline
+    m_length = m_next - line;
+
+    if( m_length >= m_maxLineLength )
+        THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+    return line;
+}
+
+
+char* MAPPED_FILE_LINE_READER::ReadLine()
+{
+    const char* line = nextLine();
+
+    if( line )
+    {
+        if( m_length + 1 > m_capacity )   // +1 for terminating nul
+            expandCapacity( m_length + 1 );
+
+        memcpy( m_line, line, m_length );
+
+#ifdef _WIN32
+        // Give the same lines as a FILE_LINE_READER, which reads in text mode
+        if( m_length >= 2 && m_line[m_length - 2] == '\r' && m_line[m_length - 1] == '\n' )
+            m_line[--m_length - 1] = '\n';
+#endif
+    }
+
+    // m_lineNum is incremented even if there was no line read, because this
+    // leads to better error reporting when we hit an end of file.
+    ++m_lineNum;
+    m_line[m_length] = 0;
+
+    return m_length ? m_line : NULL;
+}
+
+
+const char* MAPPED_FILE_LINE_READER::ReadLineView()
+{
+    const char* next = m_next;
+    const char* line = nextLine();
+
+    // The last line, when it has no newline, is copied to be safely terminated
+    if( line && line[m_length - 1] != '\n' )
+    {
+        m_next = next;
+        return ReadLine();
+    }
+
+    ++m_lineNum;
+    return line;
+}
+
+
+LINE_READER* OpenFileLineReader( const wxString& aFileName )
+{
+    wxULongLong size = wxFileName::GetSize( aFileName );
+
+    if( size != wxInvalidSize && size >= LINE_READER_MAPPING_THRESHOLD )
+    {
+        try
+        {
+            return new MAPPED_FILE_LINE_READER( aFileName );
+        }
+        catch( const IO_ERROR& )
+        {
+            // Some file systems (FUSE, virtual machine shares...) cannot map files: read
+            // them the usual way, which also reports the error if the file cannot be opened
+        }
+    }
+
+    return new FILE_LINE_READER( aFileName );
+}
+
+
+STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource,
+                                        unsigned aStartingLineNumber ):
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     m_lines( aString ), m_ndx( 0 )
 {
     // Clipboard text should be nice and _use multiple lines_ so that
     // we can report _line number_ oriented error messages when parsing.
     m_source = aSource;
+    m_lineNum = aStartingLineNumber;
 }
 
 
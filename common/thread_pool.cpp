@@ -0,0 +1,371 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <advanced_config.h>
+#include <widgets/progress_reporter.h>
+
+
+// The pool and index of the worker running on the current thread, if any
+static thread_local THREAD_POOL* s_workerPool = nullptr;
+static thread_local int          s_workerIndex = -1;
+
+
+THREAD_POOL::THREAD_POOL( size_t aThreadCount ) :
+        m_pendingCount( 0 ),
+        m_nextQueue( 0 ),
+        m_quit( false )
+{
+    if( aThreadCount == 0 )
+        aThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+
+    for( size_t ii = 0; ii < aThreadCount; ++ii )
+        m_queues.emplace_back( new TASK_QUEUE );
+
+    for( size_t ii = 0; ii < aThreadCount; ++ii )
+        m_workers.emplace_back( &THREAD_POOL::workerLoop, this, (int) ii );
+}
+
+
+THREAD_POOL::~THREAD_POOL()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_wakeLock );
+        m_quit = true;
+    }
+
+    m_wake.notify_all();
+
+    for( std::thread& worker : m_workers )
+        worker.join();
+}
+
+
+THREAD_POOL& THREAD_POOL::GetInstance()
+{
+    // Never deleted: joining threads while unloading a module at exit is not safe on
+    // all platforms, and the workers are idle by then anyway.
+    static THREAD_POOL* pool = nullptr;
+    static std::once_flag initialized;
+
+    std::call_once( initialized, []()
+    {
+        size_t threadCount = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+        int    maxThreads = ADVANCED_CFG::GetCfg().m_maxWorkerThreads;
+
+        if( maxThreads > 0 )
+            threadCount = std::min<size_t>( threadCount, maxThreads );
+
+        pool = new THREAD_POOL( threadCount );
+    } );
+
+    return *pool;
+}
+
+
+size_t THREAD_POOL::GetTaskCount( size_t aItemCount, size_t aMinItemsPerTask ) const
+{
+    aMinItemsPerTask = std::max<size_t>( aMinItemsPerTask, 1 );
+
+    size_t count = ( aItemCount + aMinItemsPerTask - 1 ) / aMinItemsPerTask;
+
+    return std::max<size_t>( std::min( count, GetThreadCount() ), 1 );
+}
+
+
+void THREAD_POOL::submit( TASK&& aTask )
+{
+    size_t queue;
+
+    if( s_workerPool == this )
+        queue = s_workerIndex;
+    else
+        queue = m_nextQueue++ % m_queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock( m_queues[queue]->m_lock );
+        m_queues[queue]->m_tasks.push_back( std::move( aTask ) );
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( m_wakeLock );
+        m_pendingCount++;
+    }
+
+    m_wake.notify_one();
+}
+
+
+bool THREAD_POOL::popTask( int aWorker, TASK& aTask )
+{
+    // Newest task of our own queue first: its data is most likely still in cache
+    if( aWorker >= 0 )
+    {
+        TASK_QUEUE& queue = *m_queues[aWorker];
+        std::lock_guard<std::mutex> lock( queue.m_lock );
+
+        if( !queue.m_tasks.empty() )
+        {
+            aTask = std::move( queue.m_tasks.back() );
+            queue.m_tasks.pop_back();
+            m_pendingCount--;
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another queue
+    size_t start = aWorker >= 0 ? aWorker + 1 : m_nextQueue.load();
+
+    for( size_t ii = 0; ii < m_queues.size(); ++ii )
+    {
+        TASK_QUEUE& queue = *m_queues[( start + ii ) % m_queues.size()];
+        std::lock_guard<std::mutex> lock( queue.m_lock );
+
+        if( !queue.m_tasks.empty() )
+        {
+            aTask = std::move( queue.m_tasks.front() );
+            queue.m_tasks.pop_front();
+            m_pendingCount--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool THREAD_POOL::popGroupTask( TASK_GROUP* aGroup, TASK& aTask )
+{
+    for( std::unique_ptr<TASK_QUEUE>& queue : m_queues )
+    {
+        std::lock_guard<std::mutex> lock( queue->m_lock );
+
+        auto it = std::find_if( queue->m_tasks.begin(), queue->m_tasks.end(),
+                                [aGroup]( const TASK& aQueued )
+                                {
+                                    return aQueued.m_group == aGroup;
+                                } );
+
+        if( it != queue->m_tasks.end() )
+        {
+            aTask = std::move( *it );
+            queue->m_tasks.erase( it );
+            m_pendingCount--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool THREAD_POOL::runPendingTask( TASK_GROUP* aGroup )
+{
+    TASK task;
+
+    if( !popGroupTask( aGroup, task ) )
+        return false;
+
+    runTask( task );
+    return true;
+}
+
+
+void THREAD_POOL::runTask( TASK& aTask )
+{
+    TASK_GROUP* group = aTask.m_group;
+
+    if( !group->IsCancelled() )
+    {
+        try
+        {
+            aTask.m_func();
+        }
+        catch( ... )
+        {
+            std::lock_guard<std::mutex> lock( group->m_lock );
+
+            if( !group->m_exception )
+                group->m_exception = std::current_exception();
+
+            group->Cancel();
+        }
+    }
+
+    // Release what the task captured before the group can be destroyed
+    aTask.m_func = nullptr;
+    group->taskDone();
+}
+
+
+void THREAD_POOL::workerLoop( int aWorker )
+{
+    s_workerPool = this;
+    s_workerIndex = aWorker;
+
+    while( true )
+    {
+        TASK task;
+
+        if( popTask( aWorker, task ) )
+        {
+            runTask( task );
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( m_wakeLock );
+
+        m_wake.wait( lock, [&]() { return m_quit || m_pendingCount > 0; } );
+
+        if( m_quit && m_pendingCount <= 0 )
+            return;
+    }
+}
+
+
+TASK_GROUP::TASK_GROUP( THREAD_POOL& aPool ) :
+        m_pool( aPool ),
+        m_pendingCount( 0 ),
+        m_cancelled( false )
+{
+}
+
+
+TASK_GROUP::~TASK_GROUP()
+{
+    // Only reached with pending tasks when unwinding: do not start new ones
+    if( m_pendingCount > 0 )
+        Cancel();
+
+    while( m_pendingCount > 0 )
+    {
+        if( m_pool.runPendingTask( this ) )
+            continue;
+
+        std::unique_lock<std::mutex> lock( m_lock );
+        m_done.wait_for( lock, std::chrono::milliseconds( 10 ),
+                         [&]() { return m_pendingCount == 0; } );
+    }
+
+    // Wait for the last taskDone() to release the lock
+    std::lock_guard<std::mutex> lock( m_lock );
+}
+
+
+void TASK_GROUP::Run( std::function<void()> aTask )
+{
+    m_pendingCount++;
+    m_pool.submit( { std::move( aTask ), this } );
+}
+
+
+void TASK_GROUP::Run( std::function<void()> aTask, size_t aCount )
+{
+    for( size_t ii = 0; ii < aCount; ++ii )
+        Run( aTask );
+}
+
+
+void TASK_GROUP::taskDone()
+{
+    std::lock_guard<std::mutex> lock( m_lock );
+
+    if( --m_pendingCount == 0 )
+        m_done.notify_all();
+}
+
+
+void TASK_GROUP::rethrow()
+{
+    std::exception_ptr exception;
+
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        std::swap( exception, m_exception );
+    }
+
+    if( exception )
+        std::rethrow_exception( exception );
+}
+
+
+bool TASK_GROUP::Wait()
+{
+    while( m_pendingCount > 0 )
+    {
+        // Help running our own tasks rather than blocking a worker
+        if( m_pool.runPendingTask( this ) )
+            continue;
+
+        // Wake up from time to time, to take our tasks queued meanwhile
+        std::unique_lock<std::mutex> lock( m_lock );
+        m_done.wait_for( lock, std::chrono::milliseconds( 10 ),
+                         [&]() { return m_pendingCount == 0; } );
+    }
+
+    rethrow();
+
+    return !m_cancelled;
+}
+
+
+bool TASK_GROUP::WaitAndPoll( const std::function<bool()>& aPoll )
+{
+    // A worker must not block: the tasks it waits for could be queued behind it
+    if( s_workerPool == &m_pool )
+        return Wait();
+
+    while( true )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_lock );
+
+            if( m_done.wait_for( lock, std::chrono::milliseconds( 100 ),
+                                 [&]() { return m_pendingCount == 0; } ) )
+                break;
+        }
+
+        if( !m_cancelled && !aPoll() )
+            Cancel();
+    }
+
+    rethrow();
+
+    return !m_cancelled;
+}
+
+
+bool TASK_GROUP::WaitAndRefresh( PROGRESS_REPORTER* aReporter, bool aAllowCancel )
+{
+    if( !aReporter )
+        return Wait();
+
+    return WaitAndPoll( [aReporter, aAllowCancel]()
+                        {
+                            return aReporter->KeepRefreshing() || !aAllowCancel;
+                        } );
+}
@@ -54,22 +54,11 @@ void SCH_EDIT_FRAME::GetSchematicConnections( std::vector< wxPoint >& aConnectio
 
 bool SCH_EDIT_FRAME::TestDanglingEnds()
 {
-    std::vector<DANGLING_END_ITEM> endPoints;
-    bool hasStateChanged = false;
-
-    for( SCH_ITEM* item = GetScreen()->GetDrawList().begin(); item; item = item->Next() )
-        item->GetEndPoints( endPoints );
-
-    for( SCH_ITEM* item = GetScreen()->GetDrawList().begin(); item; item = item->Next() )
-    {
-        if( item->UpdateDanglingState( endPoints ) )
-        {
-            GetCanvas()->GetView()->Update( item, KIGFX::REPAINT );
-            hasStateChanged = true;
-        }
-    }
-
-    return hasStateChanged;
+    return GetScreen()->TestDanglingEnds( [this]( SCH_ITEM* aItem )
+                                          {
+                                              GetCanvas()->GetView()->Update( aItem,
+                                                                              KIGFX::REPAINT );
+                                          } );
 }
 
 
@@ -148,6 +137,10 @@ bool SCH_EDIT_FRAME::SchematicCleanUp( bool aUndo, SCH_SCREEN* aScreen )
 
     BreakSegmentsOnJunctions( true, aScreen );
 
+    // Only deletion flags and new merged lines until the end of the loop: the junction
+    // tests can use the item index
+    SCH_SCREEN_INDEX_SCOPE indexScope( aScreen );
+
     for( item = aScreen->GetDrawItems(); item; item = item->Next() )
     {
         if( ( item->Type() != SCH_LINE_T )
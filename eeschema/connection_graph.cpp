@@ -19,15 +19,16 @@
  */
 
 #include <list>
-#include <thread>
+#include <map>
+#include <set>
 #include <algorithm>
-#include <future>
 #include <vector>
 #include <unordered_map>
 #include <profile.h>
 
 #include <common.h>
 #include <erc.h>
+#include <thread_pool.h>
 #include <sch_edit_frame.h>
 #include <sch_bus_entry.h>
 #include <sch_component.h>
@@ -346,6 +347,18 @@ void CONNECTION_SUBGRAPH::UpdateItemConnections()
 
 
 void CONNECTION_GRAPH::Reset()
+{
+    resetSubgraphs();
+
+    m_sheet_cache.clear();
+    m_net_name_to_code_map.clear();
+    m_bus_name_to_code_map.clear();
+    m_last_net_code = 1;
+    m_last_bus_code = 1;
+}
+
+
+void CONNECTION_GRAPH::resetSubgraphs()
 {
     for( auto subgraph : m_subgraphs )
         delete subgraph;
@@ -355,50 +368,126 @@ void CONNECTION_GRAPH::Reset()
     m_driver_subgraphs.clear();
     m_invisible_power_pins.clear();
     m_bus_alias_cache.clear();
-    m_net_name_to_code_map.clear();
-    m_bus_name_to_code_map.clear();
     m_net_code_to_subgraphs_map.clear();
     m_net_name_to_subgraphs_map.clear();
+    m_sheet_to_port_subgraphs_map.clear();
     m_local_label_cache.clear();
     m_global_label_cache.clear();
-    m_last_net_code = 1;
-    m_last_bus_code = 1;
     m_last_subgraph_code = 1;
 }
 
 
+std::vector<const void*> CONNECTION_GRAPH::sheetSignature( const SCH_SHEET_PATH& aSheet,
+                                                           std::vector<SCH_ITEM*>& aItems )
+{
+    std::vector<const void*> signature;
+
+    for( auto item = aSheet.LastScreen()->GetDrawItems(); item; item = item->Next() )
+    {
+        if( !item->IsConnectable() )
+            continue;
+
+        aItems.push_back( item );
+        signature.push_back( item );
+
+        // The pins are the items of the graph, and they are rebuilt by UpdatePins().  When
+        // it rebuilds them in place, it marks the component dirty.
+        if( item->Type() == SCH_SHEET_T )
+        {
+            for( auto& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+                signature.push_back( &pin );
+        }
+        else if( item->Type() == SCH_COMPONENT_T )
+        {
+            SCH_PINS& pins = static_cast<SCH_COMPONENT*>( item )->GetPins();
+
+            signature.push_back( pins.data() );
+            signature.push_back( reinterpret_cast<const void*>( pins.size() ) );
+        }
+    }
+
+    return signature;
+}
+
+
 void CONNECTION_GRAPH::Recalculate( SCH_SHEET_LIST aSheetList, bool aUnconditional )
 {
     PROF_COUNTER phase1;
 
-    if( aUnconditional )
+    if( aUnconditional || m_sheet_cache.empty() )
+    {
+        aUnconditional = true;
         Reset();
+    }
+    else
+    {
+        resetSubgraphs();
+    }
+
+    // A screen is processed again for all its sheet paths if any of its items changed
+    std::unordered_set<SCH_SCREEN*> dirty_screens;
 
     for( const auto& sheet : aSheetList )
     {
-        std::vector<SCH_ITEM*> items;
-
-        for( auto item = sheet.LastScreen()->GetDrawItems();
-             item; item = item->Next() )
+        for( auto item = sheet.LastScreen()->GetDrawItems(); item; item = item->Next() )
         {
-            if( item->IsConnectable() &&
-                ( aUnconditional || item->IsConnectivityDirty() ) )
+            if( item->IsConnectable() && ( aUnconditional || item->IsConnectivityDirty() ) )
             {
-                items.push_back( item );
+                dirty_screens.insert( sheet.LastScreen() );
+                break;
             }
         }
+    }
+
+    std::unordered_map<SCH_SHEET_PATH, SHEET_CACHE> sheet_cache;
+    int dirty_sheets = 0;
+
+    for( const auto& sheet : aSheetList )
+    {
+        SHEET_CACHE& cache = sheet_cache[ sheet ];
+        auto         it = m_sheet_cache.find( sheet );
+
+        cache.m_signature = sheetSignature( sheet, cache.m_items );
+        cache.m_dirty = dirty_screens.count( sheet.LastScreen() )
+                        || it == m_sheet_cache.end()
+                        || it->second.m_signature != cache.m_signature;
+
+        if( cache.m_dirty )
+        {
+            dirty_screens.insert( sheet.LastScreen() );
+            updateItemConnectivity( sheet, cache.m_items );
+            dirty_sheets++;
+        }
+        else
+        {
+            // The graphical connectivity did not change: only the connections are reset
+            cache.m_subgraphs = std::move( it->second.m_subgraphs );
+            checkSheetCache( sheet, cache );
 
-        updateItemConnectivity( sheet, items );
+            for( SCH_ITEM* item : cache.m_items )
+                initializeItemConnection( sheet, item );
+        }
     }
 
+    // Sheets which are no longer in the list are forgotten here
+    m_sheet_cache = std::move( sheet_cache );
+
     phase1.Stop();
-    wxLogTrace( "CONN_PROFILE", "UpdateItemConnectivity() %0.4f ms", phase1.msecs() );
+    wxLogTrace( "CONN_PROFILE", "UpdateItemConnectivity() %0.4f ms (%d of %zu sheets)",
+                phase1.msecs(), dirty_sheets, aSheetList.size() );
 
     PROF_COUNTER tde;
 
-    // IsDanglingStateChanged() also adds connected items for things like SCH_TEXT
-    SCH_SCREENS schematic;
-    schematic.TestDanglingEnds();
+    if( aUnconditional )
+    {
+        SCH_SCREENS schematic;
+        schematic.TestDanglingEnds();
+    }
+    else
+    {
+        for( SCH_SCREEN* screen : dirty_screens )
+            screen->TestDanglingEnds();
+    }
 
     tde.Stop();
     wxLogTrace( "CONN_PROFILE", "TestDanglingEnds() %0.4f ms", tde.msecs() );
@@ -407,6 +496,69 @@ void CONNECTION_GRAPH::Recalculate( SCH_SHEET_LIST aSheetList, bool aUncondition
 }
 
 
+void CONNECTION_GRAPH::initializeItemConnection( const SCH_SHEET_PATH& aSheet, SCH_ITEM* aItem )
+{
+    if( aItem->Type() == SCH_SHEET_T )
+    {
+        for( auto& pin : static_cast<SCH_SHEET*>( aItem )->GetPins() )
+        {
+            if( !pin.Connection( aSheet ) )
+            {
+                pin.InitializeConnection( aSheet );
+            }
+
+            pin.Connection( aSheet )->Reset();
+            m_items.insert( &pin );
+        }
+    }
+    else if( aItem->Type() == SCH_COMPONENT_T )
+    {
+        // Assumption: we don't need to call UpdatePins() here because anything
+        // that would change the pins of the component will have called it already
+
+        for( SCH_PIN& pin : static_cast<SCH_COMPONENT*>( aItem )->GetPins() )
+        {
+            pin.InitializeConnection( aSheet );
+
+            // because calling the first time is not thread-safe
+            pin.GetDefaultNetName( aSheet );
+
+            // Invisible power pins need to be post-processed later
+
+            if( pin.IsPowerConnection() && !pin.IsVisible() )
+                m_invisible_power_pins.push_back( std::make_pair( aSheet, &pin ) );
+
+            m_items.insert( &pin );
+        }
+    }
+    else
+    {
+        m_items.insert( aItem );
+        auto conn = aItem->InitializeConnection( aSheet );
+
+        // Set bus/net property here so that the propagation code uses it
+        switch( aItem->Type() )
+        {
+        case SCH_LINE_T:
+            conn->SetType( aItem->GetLayer() == LAYER_BUS ? CONNECTION_BUS : CONNECTION_NET );
+            break;
+
+        case SCH_BUS_BUS_ENTRY_T:
+            conn->SetType( CONNECTION_BUS );
+            break;
+
+        case SCH_PIN_T:
+        case SCH_BUS_WIRE_ENTRY_T:
+            conn->SetType( CONNECTION_NET );
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+
 void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
                                                std::vector<SCH_ITEM*> aItemList )
 {
@@ -418,20 +570,14 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
         item->GetConnectionPoints( points );
         item->ConnectedItems().clear();
 
+        initializeItemConnection( aSheet, item );
+
         if( item->Type() == SCH_SHEET_T )
         {
             for( auto& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
             {
-                if( !pin.Connection( aSheet ) )
-                {
-                    pin.InitializeConnection( aSheet );
-                }
-
                 pin.ConnectedItems().clear();
-                pin.Connection( aSheet )->Reset();
-
                 connection_map[ pin.GetTextPos() ].push_back( &pin );
-                m_items.insert( &pin );
             }
         }
         else if( item->Type() == SCH_COMPONENT_T )
@@ -439,53 +585,16 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
             SCH_COMPONENT* component = static_cast<SCH_COMPONENT*>( item );
             TRANSFORM t = component->GetTransform();
 
-            // Assumption: we don't need to call UpdatePins() here because anything
-            // that would change the pins of the component will have called it already
-
             for( SCH_PIN& pin : component->GetPins() )
             {
-                pin.InitializeConnection( aSheet );
-
                 wxPoint pos = t.TransformCoordinate( pin.GetPosition() ) + component->GetPosition();
 
-                // because calling the first time is not thread-safe
-                pin.GetDefaultNetName( aSheet );
                 pin.ConnectedItems().clear();
-
-                // Invisible power pins need to be post-processed later
-
-                if( pin.IsPowerConnection() && !pin.IsVisible() )
-                    m_invisible_power_pins.push_back( std::make_pair( aSheet, &pin ) );
-
                 connection_map[ pos ].push_back( &pin );
-                m_items.insert( &pin );
             }
         }
         else
         {
-            m_items.insert( item );
-            auto conn = item->InitializeConnection( aSheet );
-
-            // Set bus/net property here so that the propagation code uses it
-            switch( item->Type() )
-            {
-            case SCH_LINE_T:
-                conn->SetType( item->GetLayer() == LAYER_BUS ? CONNECTION_BUS : CONNECTION_NET );
-                break;
-
-            case SCH_BUS_BUS_ENTRY_T:
-                conn->SetType( CONNECTION_BUS );
-                break;
-
-            case SCH_PIN_T:
-            case SCH_BUS_WIRE_ENTRY_T:
-                conn->SetType( CONNECTION_NET );
-                break;
-
-            default:
-                break;
-            }
-
             for( auto point : points )
             {
                 connection_map[ point ].push_back( item );
@@ -610,6 +719,134 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
 }
 
 
+void CONNECTION_GRAPH::checkSheetCache( const SCH_SHEET_PATH& aSheet,
+                                        const SHEET_CACHE& aCache ) const
+{
+#ifdef DEBUG
+    // Groups the items as updateItemConnectivity() links them, without touching them.  The
+    // order of the items at a point matters, because of the way junctions are linked.
+    std::unordered_map< wxPoint, std::vector<SCH_ITEM*> > connection_map;
+    std::unordered_map<SCH_ITEM*, SCH_ITEM*> parent;
+
+    auto find = [&]( SCH_ITEM* aItem )
+    {
+        parent.emplace( aItem, aItem );
+
+        while( parent[ aItem ] != aItem )
+        {
+            parent[ aItem ] = parent[ parent[ aItem ] ];
+            aItem = parent[ aItem ];
+        }
+
+        return aItem;
+    };
+
+    auto unite = [&]( SCH_ITEM* aFirst, SCH_ITEM* aSecond )
+    {
+        SCH_ITEM* first = find( aFirst );
+        SCH_ITEM* second = find( aSecond );
+
+        parent[ first ] = second;
+    };
+
+    for( SCH_ITEM* item : aCache.m_items )
+    {
+        if( item->Type() == SCH_SHEET_T )
+        {
+            for( auto& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+            {
+                find( &pin );
+                connection_map[ pin.GetTextPos() ].push_back( &pin );
+            }
+        }
+        else if( item->Type() == SCH_COMPONENT_T )
+        {
+            SCH_COMPONENT* component = static_cast<SCH_COMPONENT*>( item );
+            TRANSFORM t = component->GetTransform();
+
+            for( SCH_PIN& pin : component->GetPins() )
+            {
+                wxPoint pos = t.TransformCoordinate( pin.GetPosition() ) + component->GetPosition();
+
+                find( &pin );
+                connection_map[ pos ].push_back( &pin );
+            }
+        }
+        else
+        {
+            std::vector< wxPoint > points;
+            item->GetConnectionPoints( points );
+
+            find( item );
+
+            for( auto point : points )
+                connection_map[ point ].push_back( item );
+        }
+    }
+
+    for( const auto& it : connection_map )
+    {
+        const auto& connection_vec = it.second;
+        SCH_ITEM* junction = nullptr;
+
+        for( auto primary_it = connection_vec.begin(); primary_it != connection_vec.end(); primary_it++ )
+        {
+            auto connected_item = *primary_it;
+
+            if( connected_item->Type() == SCH_JUNCTION_T )
+                junction = connected_item;
+
+            if( connected_item->Type() == SCH_BUS_BUS_ENTRY_T && connection_vec.size() < 2 )
+            {
+                if( auto bus = aSheet.LastScreen()->GetBus( it.first ) )
+                    unite( connected_item, bus );
+            }
+
+            for( auto test_it = primary_it + 1; test_it != connection_vec.end(); test_it++ )
+            {
+                auto test_item = *test_it;
+
+                if( !junction && test_item->Type() == SCH_JUNCTION_T )
+                    junction = test_item;
+
+                if( connected_item != test_item &&
+                    connected_item != junction &&
+                    connected_item->ConnectionPropagatesTo( test_item ) &&
+                    test_item->ConnectionPropagatesTo( connected_item ) )
+                {
+                    unite( connected_item, test_item );
+                }
+            }
+        }
+    }
+
+    std::map< SCH_ITEM*, std::vector<SCH_ITEM*> > groups;
+
+    for( const auto& kv : parent )
+        groups[ find( kv.first ) ].push_back( kv.first );
+
+    std::set< std::vector<SCH_ITEM*> > fresh, cached;
+
+    for( auto& kv : groups )
+    {
+        std::sort( kv.second.begin(), kv.second.end() );
+        fresh.insert( kv.second );
+    }
+
+    for( auto members : aCache.m_subgraphs )
+    {
+        std::sort( members.begin(), members.end() );
+        cached.insert( members );
+    }
+
+    wxASSERT_MSG( fresh == cached,
+                  wxString::Format( "Stale connectivity reused for sheet %s: an item was "
+                                    "edited without being marked connectivity-dirty",
+                                    aSheet.PathHumanReadable() ) );
+#endif
+}
+
+
 // TODO(JE) This won't give the same subgraph IDs (and eventually net/graph codes)
 // to the same subgraph necessarily if it runs over and over again on the same
 // sheet.  We need:
@@ -638,6 +875,39 @@ void CONNECTION_GRAPH::buildConnectionGraph()
         }
     }
 
+    // The sheets which did not change get back their subgraphs as they were built last time
+
+    for( auto& kv : m_sheet_cache )
+    {
+        const SCH_SHEET_PATH& sheet = kv.first;
+        SHEET_CACHE&          cache = kv.second;
+
+        if( cache.m_dirty )
+            continue;
+
+        for( const auto& members : cache.m_subgraphs )
+        {
+            auto subgraph = new CONNECTION_SUBGRAPH( m_frame );
+
+            subgraph->m_code = m_last_subgraph_code++;
+            subgraph->m_sheet = sheet;
+
+            for( SCH_ITEM* item : members )
+            {
+                if( item->Type() == SCH_NO_CONNECT_T )
+                    subgraph->m_no_connect = item;
+
+                item->Connection( sheet )->SetSubgraphCode( subgraph->m_code );
+                subgraph->AddItem( item );
+            }
+
+            subgraph->m_dirty = true;
+            m_subgraphs.push_back( subgraph );
+        }
+    }
+
+    size_t first_new_subgraph = m_subgraphs.size();
+
     // Build subgraphs from items (on a per-sheet basis)
 
     for( SCH_ITEM* item : m_items )
@@ -700,6 +970,16 @@ void CONNECTION_GRAPH::buildConnectionGraph()
         }
     }
 
+    // Keep the subgraphs of the sheets processed again for the next recalculation
+
+    for( size_t i = first_new_subgraph; i < m_subgraphs.size(); i++ )
+    {
+        auto it = m_sheet_cache.find( m_subgraphs[i]->m_sheet );
+
+        if( it != m_sheet_cache.end() && it->second.m_dirty )
+            it->second.m_subgraphs.push_back( m_subgraphs[i]->m_items );
+    }
+
     /**
      * TODO(JE)
      *
@@ -723,11 +1003,10 @@ void CONNECTION_GRAPH::buildConnectionGraph()
     // Resolve drivers for subgraphs and propagate connectivity info
 
     // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( m_subgraphs.size() + 3 ) / 4 );
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    size_t parallelThreadCount = pool.GetTaskCount( m_subgraphs.size(), 4 );
 
     std::atomic<size_t> nextSubgraph( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
     std::vector<CONNECTION_SUBGRAPH*> dirty_graphs;
 
     std::copy_if( m_subgraphs.begin(), m_subgraphs.end(), std::back_inserter( dirty_graphs ),
@@ -828,12 +1107,12 @@ void CONNECTION_GRAPH::buildConnectionGraph()
         update_lambda();
     else
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
+        TASK_GROUP tasks( pool );
 
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
+        tasks.Run( update_lambda, parallelThreadCount );
+
+        // Finalize the tasks
+        tasks.Wait();
     }
 
     // Now discard any non-driven subgraphs from further consideration
@@ -954,6 +1233,17 @@ void CONNECTION_GRAPH::buildConnectionGraph()
 
     std::unordered_set<CONNECTION_SUBGRAPH*> invalidated_subgraphs;
 
+    // Only strongly driven subgraphs of the same sheet can be merged together, so they are
+    // looked up per sheet rather than by going through all the subgraphs each time.
+
+    std::unordered_map<SCH_SHEET_PATH, std::vector<CONNECTION_SUBGRAPH*>> strong_subgraphs;
+
+    for( auto subgraph : m_driver_subgraphs )
+    {
+        if( subgraph->m_strong_driver )
+            strong_subgraphs[ subgraph->m_sheet ].push_back( subgraph );
+    }
+
     for( auto subgraph_it = m_driver_subgraphs.begin();
          subgraph_it != m_driver_subgraphs.end(); subgraph_it++ )
     {
@@ -1043,13 +1333,12 @@ void CONNECTION_GRAPH::buildConnectionGraph()
         // form neighbor links.
 
         std::vector<CONNECTION_SUBGRAPH*> candidate_subgraphs;
-        std::copy_if( m_driver_subgraphs.begin(), m_driver_subgraphs.end(),
+        const auto& sheet_subgraphs = strong_subgraphs[ sheet ];
+
+        std::copy_if( sheet_subgraphs.begin(), sheet_subgraphs.end(),
                       std::back_inserter( candidate_subgraphs ),
                       [&] ( const CONNECTION_SUBGRAPH* candidate )
-                      { return ( !candidate->m_absorbed &&
-                                 candidate->m_strong_driver &&
-                                 candidate != subgraph &&
-                                 candidate->m_sheet == sheet );
+                      { return ( !candidate->m_absorbed && candidate != subgraph );
                       } );
 
         // This is a list of connections on the current subgraph to compare to the
@@ -1217,6 +1506,13 @@ void CONNECTION_GRAPH::buildConnectionGraph()
                                 return candidate->m_absorbed;
                             } ), m_driver_subgraphs.end() );
 
+    // Subgraphs which may be children of a sheet pin, for propagateToNeighbors()
+    for( auto subgraph : m_driver_subgraphs )
+    {
+        if( subgraph->m_strong_driver && !subgraph->m_hier_ports.empty() )
+            m_sheet_to_port_subgraphs_map[ subgraph->m_sheet ].push_back( subgraph );
+    }
+
     // Store global subgraphs for later reference
     std::vector<CONNECTION_SUBGRAPH*> global_subgraphs;
     std::copy_if( m_driver_subgraphs.begin(), m_driver_subgraphs.end(),
@@ -1352,12 +1648,14 @@ void CONNECTION_GRAPH::propagateToNeighbors( CONNECTION_SUBGRAPH* aSubgraph )
             SCH_SHEET_PATH path = aParent->m_sheet;
             path.push_back( sheet_pin->GetParent() );
 
-            for( auto candidate : m_driver_subgraphs )
+            auto it = m_sheet_to_port_subgraphs_map.find( path );
+
+            if( it == m_sheet_to_port_subgraphs_map.end() )
+                continue;
+
+            for( auto candidate : it->second )
             {
-                if( candidate->m_absorbed ||
-                    !candidate->m_strong_driver ||
-                    candidate->m_sheet != path ||
-                    candidate->m_hier_ports.empty() )
+                if( candidate->m_absorbed )
                     continue;
 
                 for( SCH_HIERLABEL* label : candidate->m_hier_ports )
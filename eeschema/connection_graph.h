@@ -167,7 +167,13 @@ public:
     /**
      * Updates the connection graph for the given list of sheets.
      *
-     * @param aSheetList is the list of possibly modified sheets
+     * Without \a aUnconditional, the graphical connectivity and the subgraphs of the sheets
+     * which did not change since the last call are reused: only the sheets with new, removed
+     * or connectivity-dirty items are processed again.  The drivers, the merging of the
+     * subgraphs and the propagation through the hierarchy are always computed again, but
+     * the net and bus codes of the names already known are kept.
+     *
+     * @param aSheetList is the list of all the sheets of the schematic
      * @param aUnconditional is true if an unconditional full recalculation should be done
      */
     void Recalculate( SCH_SHEET_LIST aSheetList, bool aUnconditional = false );
@@ -214,6 +220,24 @@ public:
 
 private:
 
+    /// What is kept of a sheet between two incremental recalculations
+    struct SHEET_CACHE
+    {
+        /// The connectable items of the sheet, and the addresses of their pins
+        std::vector<const void*> m_signature;
+
+        /// The connectable items of the sheet
+        std::vector<SCH_ITEM*> m_items;
+
+        /// The items of each subgraph built from the graphical connectivity of the sheet
+        std::vector< std::vector<SCH_ITEM*> > m_subgraphs;
+
+        /// True if the sheet is processed again by the current recalculation
+        bool m_dirty = true;
+    };
+
+    std::unordered_map<SCH_SHEET_PATH, SHEET_CACHE> m_sheet_cache;
+
     std::unordered_set<SCH_ITEM*> m_items;
 
     std::vector<CONNECTION_SUBGRAPH*> m_subgraphs;
@@ -236,6 +260,10 @@ private:
     std::unordered_map<wxString,
                        std::vector<const CONNECTION_SUBGRAPH*>> m_net_name_to_subgraphs_map;
 
+    /// Strongly driven subgraphs with hierarchical ports, for the propagation to subsheets
+    std::unordered_map<SCH_SHEET_PATH,
+                       std::vector<CONNECTION_SUBGRAPH*>> m_sheet_to_port_subgraphs_map;
+
     int m_last_net_code;
 
     int m_last_bus_code;
@@ -247,6 +275,27 @@ private:
     // Needed for m_UserUnits for now; maybe refactor later
     SCH_EDIT_FRAME* m_frame;
 
+    /**
+     * Deletes the subgraphs and everything derived from them, but keeps the net and bus
+     * codes, and the sheet caches.
+     */
+    void resetSubgraphs();
+
+    /**
+     * Builds the signature of the connectable items of a sheet, used to find out whether
+     * items were added, removed or had their pins rebuilt since the last recalculation.
+     *
+     * @param aItems receives the connectable items of the sheet.
+     */
+    static std::vector<const void*> sheetSignature( const SCH_SHEET_PATH& aSheet,
+                                                    std::vector<SCH_ITEM*>& aItems );
+
+    /**
+     * Initializes the connection of \a aItem on \a aSheet, or of its pins for components
+     * and sheets, and loads them into m_items.  The graphical connectivity is left alone.
+     */
+    void initializeItemConnection( const SCH_SHEET_PATH& aSheet, SCH_ITEM* aItem );
+
     /**
      * Updates the graphical connectivity between items (i.e. where they touch)
      * The items passed in must be on the same sheet.
@@ -277,6 +326,13 @@ private:
     void updateItemConnectivity( SCH_SHEET_PATH aSheet,
                                  std::vector<SCH_ITEM*> aItemList );
 
+    /**
+     * In debug builds, checks that the subgraphs reused for a sheet which is not processed
+     * again are still the groups of items found from their connection points.  An item
+     * edited in place without being marked connectivity-dirty fails this check.
+     */
+    void checkSheetCache( const SCH_SHEET_PATH& aSheet, const SHEET_CACHE& aCache ) const;
+
     /**
      * Generates the connection graph (after all item connectivity has been updated)
      *
@@ -390,6 +390,10 @@ void SCH_COMPONENT::ResolveAll( const SCH_COLLECTOR& aComponents, SYMBOL_LIB_TAB
         cmp->Resolve( aLibTable, aCacheLib );
         cmp->UpdatePins();
 
+        // The library symbol may have changed even if its pins were allocated again at the
+        // same addresses
+        cmp->SetConnectivityDirty();
+
         // Propagate the m_part pointer to other members using the same lib_id
         for( unsigned jj = ii+1; jj < cmp_list.size (); ++jj )
         {
@@ -401,6 +405,7 @@ void SCH_COMPONENT::ResolveAll( const SCH_COLLECTOR& aComponents, SYMBOL_LIB_TAB
             next_cmp->m_part = cmp->m_part;
 
             next_cmp->UpdatePins();
+            next_cmp->SetConnectivityDirty();
 
             ii = jj;
         }
@@ -426,6 +431,7 @@ void SCH_COMPONENT::UpdatePins( SCH_SHEET_PATH* aSheet )
     {
         m_pinMap.clear();
         unsigned i = 0;
+        bool changed = false;
 
         for( LIB_PIN* libPin = part->GetNextPin(); libPin; libPin = part->GetNextPin( libPin ) )
         {
@@ -443,6 +449,7 @@ void SCH_COMPONENT::UpdatePins( SCH_SHEET_PATH* aSheet )
                     m_pins.erase( m_pins.begin() + i, m_pins.end() );
 
                 m_pins.emplace_back( SCH_PIN( libPin, this ) );
+                changed = true;
             }
 
             m_pinMap[ libPin ] = i;
@@ -452,6 +459,11 @@ void SCH_COMPONENT::UpdatePins( SCH_SHEET_PATH* aSheet )
 
             ++i;
         }
+
+        // The connection graph only sees the pins vector, which is reused: it is told here
+        // that the pins changed
+        if( changed )
+            SetConnectivityDirty();
     }
 }
 
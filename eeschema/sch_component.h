@@ -209,7 +209,8 @@ public:
     static void UpdatePins( const SCH_COLLECTOR& aComponents );
 
     /**
-     * Updates the local cache of SCH_PIN_CONNECTION objects for each pin
+     * Updates the local cache of SCH_PIN_CONNECTION objects for each pin.
+     * The connectivity of the component is marked dirty if its pins are replaced.
      */
     void UpdatePins( SCH_SHEET_PATH* aSheet = nullptr );
 
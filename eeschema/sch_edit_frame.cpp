@@ -1452,7 +1452,9 @@ void SCH_EDIT_FRAME::RecalculateConnections( bool aDoCleanup )
     timer.Stop();
     wxLogTrace( "CONN_PROFILE", "SchematicCleanUp() %0.4f ms", timer.msecs() );
 
-    g_ConnectionGraph->Recalculate( list, true );
+    // Without the clean up, only the sheets which changed since the last time are processed
+    // again: this is the real-time connectivity update done after each edit.
+    g_ConnectionGraph->Recalculate( list, aDoCleanup );
 }
 
 
@@ -0,0 +1,116 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+
+#include <sch_item_struct.h>
+#include <sch_sheet.h>
+
+#include <sch_item_index.h>
+
+
+EDA_RECT SCH_ITEM_INDEX::indexBox( SCH_ITEM* aItem )
+{
+    EDA_RECT               box = aItem->GetBoundingBox();
+    std::vector<wxPoint>   points;
+
+    box.Normalize();
+
+    // Sheet pins stick out of the sheet box
+    if( aItem->Type() == SCH_SHEET_T )
+    {
+        for( SCH_SHEET_PIN& pin : static_cast<SCH_SHEET*>( aItem )->GetPins() )
+            box.Merge( pin.GetBoundingBox() );
+    }
+
+    aItem->GetConnectionPoints( points );
+
+    for( const wxPoint& point : points )
+        box.Merge( point );
+
+    // The hit tests include the border of the boxes
+    box.Inflate( std::max( aItem->GetPenSize(), 1 ) );
+
+    return box;
+}
+
+
+void SCH_ITEM_INDEX::Insert( SCH_ITEM* aItem )
+{
+    if( m_entries.count( aItem ) )
+        return;
+
+    ENTRY     entry = { indexBox( aItem ), m_nextOrder++ };
+    const int mmin[2] = { entry.m_box.GetX(), entry.m_box.GetY() };
+    const int mmax[2] = { entry.m_box.GetRight(), entry.m_box.GetBottom() };
+
+    m_tree.Insert( mmin, mmax, aItem );
+    m_entries[ aItem ] = entry;
+}
+
+
+void SCH_ITEM_INDEX::Remove( SCH_ITEM* aItem )
+{
+    auto it = m_entries.find( aItem );
+
+    if( it == m_entries.end() )
+        return;
+
+    // Use the box the item was inserted with: it may have moved since
+    const EDA_RECT& box = it->second.m_box;
+    const int       mmin[2] = { box.GetX(), box.GetY() };
+    const int       mmax[2] = { box.GetRight(), box.GetBottom() };
+
+    m_tree.Remove( mmin, mmax, aItem );
+    m_entries.erase( it );
+}
+
+
+void SCH_ITEM_INDEX::RemoveAll()
+{
+    m_tree.RemoveAll();
+    m_entries.clear();
+    m_nextOrder = 0;
+}
+
+
+void SCH_ITEM_INDEX::Query( const wxPoint& aPosition, int aAccuracy,
+                            std::vector<SCH_ITEM*>& aItems ) const
+{
+    const int mmin[2] = { aPosition.x - aAccuracy, aPosition.y - aAccuracy };
+    const int mmax[2] = { aPosition.x + aAccuracy, aPosition.y + aAccuracy };
+
+    aItems.clear();
+
+    m_tree.Search( mmin, mmax, [&aItems]( SCH_ITEM* const& aItem )
+                                        {
+                                            aItems.push_back( aItem );
+                                            return true;
+                                        } );
+
+    std::sort( aItems.begin(), aItems.end(),
+               [this]( SCH_ITEM* aFirst, SCH_ITEM* aSecond )
+               {
+                   return m_entries.at( aFirst ).m_order < m_entries.at( aSecond ).m_order;
+               } );
+}
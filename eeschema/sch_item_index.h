@@ -0,0 +1,93 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef SCH_ITEM_INDEX_H
+#define SCH_ITEM_INDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <eda_rect.h>
+#include <geometry/rtree.h>
+
+class SCH_ITEM;
+
+/**
+ * Class SCH_ITEM_INDEX
+ * is an R-tree of the items of a #SCH_SCREEN, used to answer the position queries of
+ * the screen without going through its whole draw list.  Non-owning.
+ *
+ * An item is indexed with a box holding everything its hit tests and connection tests
+ * look at: its bounding box, its connection points and, for sheets, the sheet pins.
+ * The index does not follow the items when they are moved: they must be removed and
+ * inserted again.
+ *
+ * The items are returned in the order they were inserted, which is the draw list order
+ * when they are inserted as they are appended to the list, so the queries return the
+ * same items as a scan of the list would.
+ */
+class SCH_ITEM_INDEX
+{
+public:
+    SCH_ITEM_INDEX() :
+        m_nextOrder( 0 )
+    {
+    }
+
+    /**
+     * Inserts \a aItem after the items already in the index.
+     */
+    void Insert( SCH_ITEM* aItem );
+
+    /**
+     * Removes \a aItem from the index.  Nothing is done if it is not indexed.
+     */
+    void Remove( SCH_ITEM* aItem );
+
+    void RemoveAll();
+
+    /**
+     * Collects the items which may be hit at \a aPosition within \a aAccuracy, in
+     * insertion order.
+     *
+     * @param aItems receives the items.  It is cleared first.
+     */
+    void Query( const wxPoint& aPosition, int aAccuracy, std::vector<SCH_ITEM*>& aItems ) const;
+
+    size_t Size() const { return m_entries.size(); }
+
+private:
+    struct ENTRY
+    {
+        EDA_RECT m_box;     ///< box the item was indexed with
+        size_t   m_order;   ///< insertion rank
+    };
+
+    static EDA_RECT indexBox( SCH_ITEM* aItem );
+
+    RTree<SCH_ITEM*, int, 2, double>         m_tree;
+    std::unordered_map<SCH_ITEM*, ENTRY>     m_entries;
+    size_t                                   m_nextOrder;
+};
+
+#endif    // SCH_ITEM_INDEX_H
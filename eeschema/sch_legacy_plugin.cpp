@@ -22,11 +22,15 @@
 
 #include <ctype.h>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <unordered_map>
 #include <boost/algorithm/string/join.hpp>
 
 #include <wx/mstream.h>
 #include <wx/filename.h>
 #include <wx/tokenzr.h>
+#include <wx/thread.h>
 #include <pgm_base.h>
 #include <draw_graphic_text.h>
 #include <kiway.h>
@@ -35,6 +39,7 @@
 #include <core/typeinfo.h>
 #include <properties.h>
 #include <trace_helpers.h>
+#include <thread_pool.h>
 
 #include <general.h>
 #include <sch_bitmap.h>
@@ -467,23 +472,35 @@ static void parseQuotedString( wxString& aString, LINE_READER& aReader,
  */
 class SCH_LEGACY_PLUGIN_CACHE
 {
+    /// The DRAW section of a part whose draw items are not loaded yet
+    struct PENDING_DRAW_ITEMS
+    {
+        std::string        m_entries;          ///< The text of the section
+        unsigned           m_lineNumber = 0;   ///< The line of the DRAW keyword in the file
+        std::exception_ptr m_error;            ///< Set when the section failed to load
+    };
+
     static int      m_modHash;      // Keep track of the modification status of the library.
 
     wxString        m_fileName;     // Absolute path and file name.
     wxFileName      m_libFileName;  // Absolute path and file name is required here.
     wxDateTime      m_fileModTime;
     LIB_ALIAS_MAP   m_aliases;      // Map of names of LIB_ALIAS pointers.
+
+    // The DRAW sections of the parts whose draw items are not loaded yet.
+    std::unordered_map< LIB_PART*, PENDING_DRAW_ITEMS > m_pendingDrawItems;
     bool            m_isWritable;
     bool            m_isModified;
     int             m_versionMajor;
     int             m_versionMinor;
     int             m_libType;      // Is this cache a component or symbol library.
 
-    void            loadHeader( FILE_LINE_READER& aReader );
+    void            loadHeader( LINE_READER& aReader );
     static void     loadAliases( std::unique_ptr< LIB_PART >& aPart, LINE_READER& aReader );
     static void     loadField( std::unique_ptr< LIB_PART >& aPart, LINE_READER& aReader );
     static void     loadDrawEntries( std::unique_ptr< LIB_PART >& aPart, LINE_READER& aReader,
                                      int aMajorVersion, int aMinorVersion );
+    static void     copyDrawEntries( LINE_READER& aReader, PENDING_DRAW_ITEMS& aDrawEntries );
     static void     loadFootprintFilters( std::unique_ptr< LIB_PART >& aPart,
                                           LINE_READER& aReader );
     void            loadDocs();
@@ -527,8 +544,21 @@ public:
     /// Save the entire library to file m_libFileName;
     void Save( bool aSaveDocFile = true );
 
+    /**
+     * Load the library file.  The draw items of the parts are not parsed: they are loaded
+     * by LoadDrawItems() when a part is actually used.
+     */
     void Load();
 
+    /**
+     * Load the draw items of \a aPart if they were not loaded yet.
+     *
+     * @throw IO_ERROR if the draw items can not be parsed, on every call for that part.
+     */
+    void LoadDrawItems( LIB_PART* aPart );
+
+    void LoadAllDrawItems();
+
     void AddSymbol( const LIB_PART* aPart );
 
     void DeleteAlias( const wxString& aAliasName );
@@ -552,7 +582,14 @@ public:
 
     wxString GetFileName() const { return m_libFileName.GetFullPath(); }
 
-    static LIB_PART* LoadPart( LINE_READER& aReader, int aMajorVersion, int aMinorVersion );
+    /**
+     * Load the DEF/ENDDEF part entry of \a aReader.
+     *
+     * @param aDrawEntries when not NULL, receives the DRAW section of the part instead of it
+     *                     being parsed into draw items.
+     */
+    static LIB_PART* LoadPart( LINE_READER& aReader, int aMajorVersion, int aMinorVersion,
+                               PENDING_DRAW_ITEMS* aDrawEntries = NULL );
     static void      SaveSymbol( LIB_PART* aSymbol, OUTPUTFORMATTER& aFormatter );
 };
 
@@ -646,92 +683,176 @@ SCH_SHEET* SCH_LEGACY_PLUGIN::Load( const wxString& aFileName, KIWAY* aKiway,
 }
 
 
-// Everything below this comment is recursive.  Modify with care.
-
 void SCH_LEGACY_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
 {
-    SCH_SCREEN* screen = NULL;
+    // The hierarchy is loaded one level at a time: the files of the sheets found in the
+    // previous level are read and parsed in parallel, each by its own parser, then the
+    // sub-sheets they contain are collected for the next level on this thread.  The
+    // file names of the sheets are relative to the path of the file they were found in.
+    std::vector< std::pair<SCH_SHEET*, wxString> > sheets = { { aSheet, m_currentPath.top() } };
 
-    if( !aSheet->GetScreen() )
+    // The default field names are cached on first use: do it before the components are
+    // created by several threads.
+    TEMPLATE_FIELDNAME::GetDefaultFieldName( REFERENCE );
+
+    struct LOAD_JOB
     {
-        // SCH_SCREEN objects store the full path and file name where the SCH_SHEET object only
-        // stores the file name and extension.  Add the project path to the file name and
-        // extension to compare when calling SCH_SHEET::SearchHierarchy().
-        wxFileName fileName = aSheet->GetFileName();
+        SCH_SHEET*                           m_sheet;
+        wxString                             m_fileName;
+        std::unique_ptr< SCH_LEGACY_PLUGIN > m_parser;
+        std::exception_ptr                   m_error;
+    };
 
-        if( !fileName.IsAbsolute() )
-            fileName.MakeAbsolute( m_currentPath.top() );
+    while( !sheets.empty() )
+    {
+        std::vector<LOAD_JOB> jobs;
 
-        // Save the current path so that it gets restored when decending and ascending the
-        // sheet hierarchy which allows for sheet schematic files to be nested in folders
-        // relative to the last path a schematic was loaded from.
-        wxLogTrace( traceSchLegacyPlugin, "Saving path    \"%s\"", m_currentPath.top() );
-        m_currentPath.push( fileName.GetPath() );
-        wxLogTrace( traceSchLegacyPlugin, "Current path   \"%s\"", m_currentPath.top() );
-        wxLogTrace( traceSchLegacyPlugin, "Loading        \"%s\"", fileName.GetFullPath() );
+        for( const auto& entry : sheets )
+        {
+            SCH_SHEET* sheet = entry.first;
 
-        m_rootSheet->SearchHierarchy( fileName.GetFullPath(), &screen );
+            if( sheet->GetScreen() )
+                continue;
 
-        if( screen )
-        {
-            aSheet->SetScreen( screen );
+            // SCH_SCREEN objects store the full path and file name where the SCH_SHEET object
+            // only stores the file name and extension.  Add the path to the file name and
+            // extension to compare when calling SCH_SHEET::SearchHierarchy().
+            wxFileName fileName = sheet->GetFileName();
+
+            if( !fileName.IsAbsolute() )
+                fileName.MakeAbsolute( entry.second );
+
+            wxLogTrace( traceSchLegacyPlugin, "Loading        \"%s\"", fileName.GetFullPath() );
+
+            SCH_SCREEN* screen = NULL;
+
+            m_rootSheet->SearchHierarchy( fileName.GetFullPath(), &screen );
+
+            if( screen )
+            {
+                sheet->SetScreen( screen );
+
+                // Do not need to load the sub-sheets - this is done for the first instance.
+                continue;
+            }
+
+            sheet->SetScreen( new SCH_SCREEN( m_kiway ) );
+            sheet->GetScreen()->SetFileName( fileName.GetFullPath() );
+
+            LOAD_JOB job;
+
+            job.m_sheet = sheet;
+            job.m_fileName = fileName.GetFullPath();
+            job.m_parser.reset( new SCH_LEGACY_PLUGIN );
+            job.m_parser->init( m_kiway, m_props );
+
+            // The fixes made while parsing mark the screen being loaded as modified
+            job.m_parser->m_rootSheet = sheet;
 
-            // Do not need to load the sub-sheets - this has already been done.
+            jobs.push_back( std::move( job ) );
         }
+
+        if( jobs.empty() )
+            break;
+
+        THREAD_POOL&        pool = THREAD_POOL::GetInstance();
+        size_t              parallelThreadCount = pool.GetTaskCount( jobs.size() );
+        std::atomic<size_t> nextJob( 0 );
+
+        auto load_lambda = [&jobs, &nextJob]()
+        {
+            for( size_t i = nextJob++; i < jobs.size(); i = nextJob++ )
+            {
+                LOAD_JOB& job = jobs[i];
+
+                try
+                {
+                    job.m_parser->loadFile( job.m_fileName, job.m_sheet->GetScreen() );
+                }
+                catch( const IO_ERROR& )
+                {
+                    job.m_error = std::current_exception();
+                }
+            }
+        };
+
+        if( parallelThreadCount <= 1 )
+            load_lambda();
         else
         {
-            aSheet->SetScreen( new SCH_SCREEN( m_kiway ) );
-            aSheet->GetScreen()->SetFileName( fileName.GetFullPath() );
+            TASK_GROUP tasks( pool );
 
-            try
+            tasks.Run( load_lambda, parallelThreadCount );
+            tasks.Wait();
+        }
+
+        std::vector< std::pair<SCH_SHEET*, wxString> > subSheets;
+
+        for( LOAD_JOB& job : jobs )
+        {
+            SCH_SCREEN* screen = job.m_sheet->GetScreen();
+
+            for( SCH_BITMAP* bitmap : job.m_parser->m_pendingBitmaps )
             {
-                loadFile( fileName.GetFullPath(), aSheet->GetScreen() );
+                BITMAP_BASE* image = bitmap->GetImage();
+                image->SetBitmap( new wxBitmap( *image->GetImageData() ) );
+            }
 
-                EDA_ITEM* item = aSheet->GetScreen()->GetDrawItems();
+            // Set the file as modified so the user can be warned.
+            if( screen->IsModify() && m_rootSheet->GetScreen() )
+                m_rootSheet->GetScreen()->SetModify();
 
-                while( item )
+            if( job.m_error )
+            {
+                try
                 {
-                    if( item->Type() == SCH_SHEET_T )
-                    {
-                        SCH_SHEET* sheet = (SCH_SHEET*) item;
-
-                        // Set the parent to aSheet.  This effectively creates a method to find
-                        // the root sheet from any sheet so a pointer to the root sheet does not
-                        // need to be stored globally.  Note: this is not the same as a hierarchy.
-                        // Complex hierarchies can have multiple copies of a sheet.  This only
-                        // provides a simple tree to find the root sheet.
-                        sheet->SetParent( aSheet );
+                    std::rethrow_exception( job.m_error );
+                }
+                catch( const IO_ERROR& ioe )
+                {
+                    // If there is a problem loading the root sheet, there is no recovery.
+                    if( job.m_sheet == m_rootSheet )
+                        throw;
 
-                        // Recursion starts here.
-                        loadHierarchy( sheet );
-                    }
+                    // For all subsheets, queue up the error message for the caller.
+                    if( !m_error.IsEmpty() )
+                        m_error += "\n";
 
-                    item = item->Next();
+                    m_error += ioe.What();
                 }
+
+                continue;
             }
-            catch( const IO_ERROR& ioe )
+
+            wxString path = wxFileName( job.m_fileName ).GetPath();
+
+            for( EDA_ITEM* item = screen->GetDrawItems(); item; item = item->Next() )
             {
-                // If there is a problem loading the root sheet, there is no recovery.
-                if( aSheet == m_rootSheet )
-                    throw( ioe );
+                if( item->Type() == SCH_SHEET_T )
+                {
+                    SCH_SHEET* sheet = (SCH_SHEET*) item;
 
-                // For all subsheets, queue up the error message for the caller.
-                if( !m_error.IsEmpty() )
-                    m_error += "\n";
+                    // Set the parent to the loaded sheet.  This effectively creates a method
+                    // to find the root sheet from any sheet so a pointer to the root sheet
+                    // does not need to be stored globally.  Note: this is not the same as a
+                    // hierarchy.  Complex hierarchies can have multiple copies of a sheet.
+                    // This only provides a simple tree to find the root sheet.
+                    sheet->SetParent( job.m_sheet );
 
-                m_error += ioe.What();
+                    subSheets.emplace_back( sheet, path );
+                }
             }
         }
 
-        m_currentPath.pop();
-        wxLogTrace( traceSchLegacyPlugin, "Restoring path \"%s\"", m_currentPath.top() );
+        sheets = std::move( subSheets );
     }
 }
 
 
 void SCH_LEGACY_PLUGIN::loadFile( const wxString& aFileName, SCH_SCREEN* aScreen )
 {
-    FILE_LINE_READER reader( aFileName );
+    std::unique_ptr<LINE_READER> readerPtr( OpenFileLineReader( aFileName ) );
+    LINE_READER&                 reader = *readerPtr;
 
     loadHeader( reader, aScreen );
 
@@ -775,7 +896,7 @@ void SCH_LEGACY_PLUGIN::loadFile( const wxString& aFileName, SCH_SCREEN* aScreen
 }
 
 
-void SCH_LEGACY_PLUGIN::loadHeader( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen )
+void SCH_LEGACY_PLUGIN::loadHeader( LINE_READER& aReader, SCH_SCREEN* aScreen )
 {
     const char* line = aReader.ReadLine();
 
@@ -813,7 +934,7 @@ void SCH_LEGACY_PLUGIN::loadHeader( FILE_LINE_READER& aReader, SCH_SCREEN* aScre
 }
 
 
-void SCH_LEGACY_PLUGIN::loadPageSettings( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen )
+void SCH_LEGACY_PLUGIN::loadPageSettings( LINE_READER& aReader, SCH_SCREEN* aScreen )
 {
     wxASSERT( aScreen != NULL );
 
@@ -917,7 +1038,7 @@ void SCH_LEGACY_PLUGIN::loadPageSettings( FILE_LINE_READER& aReader, SCH_SCREEN*
 }
 
 
-SCH_SHEET* SCH_LEGACY_PLUGIN::loadSheet( FILE_LINE_READER& aReader )
+SCH_SHEET* SCH_LEGACY_PLUGIN::loadSheet( LINE_READER& aReader )
 {
     std::unique_ptr< SCH_SHEET > sheet( new SCH_SHEET() );
 
@@ -1054,9 +1175,10 @@ SCH_SHEET* SCH_LEGACY_PLUGIN::loadSheet( FILE_LINE_READER& aReader )
 }
 
 
-SCH_BITMAP* SCH_LEGACY_PLUGIN::loadBitmap( FILE_LINE_READER& aReader )
+SCH_BITMAP* SCH_LEGACY_PLUGIN::loadBitmap( LINE_READER& aReader )
 {
     std::unique_ptr< SCH_BITMAP > bitmap( new SCH_BITMAP );
+    bool                          pendingBitmap = false;
 
     const char* line = aReader.Line();
 
@@ -1106,7 +1228,14 @@ SCH_BITMAP* SCH_LEGACY_PLUGIN::loadBitmap( FILE_LINE_READER& aReader )
                     wxMemoryInputStream istream( stream );
                     image->LoadFile( istream, wxBITMAP_TYPE_PNG );
                     bitmap->GetImage()->SetImage( image );
-                    bitmap->GetImage()->SetBitmap( new wxBitmap( *image ) );
+
+                    // wxBitmap objects can only be created by the main thread: the files
+                    // loaded in parallel by loadHierarchy() get them once they are parsed.
+                    if( wxThread::IsMain() )
+                        bitmap->GetImage()->SetBitmap( new wxBitmap( *image ) );
+                    else
+                        pendingBitmap = true;
+
                     break;
                 }
 
@@ -1130,7 +1259,12 @@ SCH_BITMAP* SCH_LEGACY_PLUGIN::loadBitmap( FILE_LINE_READER& aReader )
                 THROW_IO_ERROR( _( "unexpected end of file" ) );
         }
         else if( strCompare( "$EndBitmap", line ) )
+        {
+            if( pendingBitmap )
+                m_pendingBitmaps.push_back( bitmap.get() );
+
             return bitmap.release();
+        }
 
         line = aReader.ReadLine();
     }
@@ -1139,7 +1273,7 @@ SCH_BITMAP* SCH_LEGACY_PLUGIN::loadBitmap( FILE_LINE_READER& aReader )
 }
 
 
-SCH_JUNCTION* SCH_LEGACY_PLUGIN::loadJunction( FILE_LINE_READER& aReader )
+SCH_JUNCTION* SCH_LEGACY_PLUGIN::loadJunction( LINE_READER& aReader )
 {
     std::unique_ptr< SCH_JUNCTION > junction( new SCH_JUNCTION );
 
@@ -1161,7 +1295,7 @@ SCH_JUNCTION* SCH_LEGACY_PLUGIN::loadJunction( FILE_LINE_READER& aReader )
 }
 
 
-SCH_NO_CONNECT* SCH_LEGACY_PLUGIN::loadNoConnect( FILE_LINE_READER& aReader )
+SCH_NO_CONNECT* SCH_LEGACY_PLUGIN::loadNoConnect( LINE_READER& aReader )
 {
     std::unique_ptr< SCH_NO_CONNECT > no_connect( new SCH_NO_CONNECT );
 
@@ -1183,7 +1317,7 @@ SCH_NO_CONNECT* SCH_LEGACY_PLUGIN::loadNoConnect( FILE_LINE_READER& aReader )
 }
 
 
-SCH_LINE* SCH_LEGACY_PLUGIN::loadWire( FILE_LINE_READER& aReader )
+SCH_LINE* SCH_LEGACY_PLUGIN::loadWire( LINE_READER& aReader )
 {
     std::unique_ptr< SCH_LINE > wire( new SCH_LINE );
 
@@ -1281,7 +1415,7 @@ SCH_LINE* SCH_LEGACY_PLUGIN::loadWire( FILE_LINE_READER& aReader )
 }
 
 
-SCH_BUS_ENTRY_BASE* SCH_LEGACY_PLUGIN::loadBusEntry( FILE_LINE_READER& aReader )
+SCH_BUS_ENTRY_BASE* SCH_LEGACY_PLUGIN::loadBusEntry( LINE_READER& aReader )
 {
     const char* line = aReader.Line();
 
@@ -1326,7 +1460,7 @@ SCH_BUS_ENTRY_BASE* SCH_LEGACY_PLUGIN::loadBusEntry( FILE_LINE_READER& aReader )
 }
 
 
-SCH_TEXT* SCH_LEGACY_PLUGIN::loadText( FILE_LINE_READER& aReader )
+SCH_TEXT* SCH_LEGACY_PLUGIN::loadText( LINE_READER& aReader )
 {
     const char*   line = aReader.Line();
 
@@ -1426,7 +1560,7 @@ SCH_TEXT* SCH_LEGACY_PLUGIN::loadText( FILE_LINE_READER& aReader )
 }
 
 
-SCH_COMPONENT* SCH_LEGACY_PLUGIN::loadComponent( FILE_LINE_READER& aReader )
+SCH_COMPONENT* SCH_LEGACY_PLUGIN::loadComponent( LINE_READER& aReader )
 {
     const char* line = aReader.Line();
 
@@ -1723,7 +1857,7 @@ SCH_COMPONENT* SCH_LEGACY_PLUGIN::loadComponent( FILE_LINE_READER& aReader )
 }
 
 
-std::shared_ptr< BUS_ALIAS > SCH_LEGACY_PLUGIN::loadBusAlias( FILE_LINE_READER& aReader,
+std::shared_ptr< BUS_ALIAS > SCH_LEGACY_PLUGIN::loadBusAlias( LINE_READER& aReader,
                                                                   SCH_SCREEN* aScreen )
 {
     auto busAlias = std::make_shared< BUS_ALIAS >( aScreen );
@@ -2364,6 +2498,7 @@ LIB_ALIAS* SCH_LEGACY_PLUGIN_CACHE::removeAlias( LIB_ALIAS* aAlias )
 
     if( !alias )
     {
+        m_pendingDrawItems.erase( part );
         delete part;
 
         if( m_aliases.size() > 1 )
@@ -2431,7 +2566,8 @@ void SCH_LEGACY_PLUGIN_CACHE::Load()
     wxLogTrace( traceSchLegacyPlugin, "Loading legacy symbol file \"%s\"",
                 m_libFileName.GetFullPath() );
 
-    FILE_LINE_READER reader( m_libFileName.GetFullPath() );
+    std::unique_ptr<LINE_READER> readerPtr( OpenFileLineReader( m_libFileName.GetFullPath() ) );
+    LINE_READER&                 reader = *readerPtr;
 
     if( !reader.ReadLine() )
         THROW_IO_ERROR( _( "unexpected end of file" ) );
@@ -2485,8 +2621,12 @@ void SCH_LEGACY_PLUGIN_CACHE::Load()
 
         if( strCompare( "DEF", line ) )
         {
-            // Read one DEF/ENDDEF part entry from library:
-            LIB_PART * part = LoadPart( reader, m_versionMajor, m_versionMinor );
+            // Read one DEF/ENDDEF part entry from library, keeping its draw items for later:
+            PENDING_DRAW_ITEMS drawEntries;
+            LIB_PART* part = LoadPart( reader, m_versionMajor, m_versionMinor, &drawEntries );
+
+            if( !drawEntries.m_entries.empty() )
+                m_pendingDrawItems[ part ] = std::move( drawEntries );
 
             // Add aliases to cache
             for( size_t ii = 0; ii < part->GetAliasCount(); ++ii )
@@ -2645,7 +2785,7 @@ void SCH_LEGACY_PLUGIN_CACHE::loadDocs()
 }
 
 
-void SCH_LEGACY_PLUGIN_CACHE::loadHeader( FILE_LINE_READER& aReader )
+void SCH_LEGACY_PLUGIN_CACHE::loadHeader( LINE_READER& aReader )
 {
     const char* line = aReader.Line();
 
@@ -2667,8 +2807,54 @@ void SCH_LEGACY_PLUGIN_CACHE::loadHeader( FILE_LINE_READER& aReader )
 }
 
 
+void SCH_LEGACY_PLUGIN_CACHE::LoadDrawItems( LIB_PART* aPart )
+{
+    auto it = m_pendingDrawItems.find( aPart );
+
+    if( it == m_pendingDrawItems.end() )
+        return;
+
+    PENDING_DRAW_ITEMS& pending = it->second;
+
+    // A part which failed to load is not parsed again, and never returned with only some of
+    // its draw items: its error is reported again.
+    if( pending.m_error )
+        std::rethrow_exception( pending.m_error );
+
+    LOCALE_IO          toggle;     // toggles on, then off, the C locale.
+    STRING_LINE_READER reader( pending.m_entries, m_libFileName.GetFullPath(),
+                               pending.m_lineNumber - 1 );
+
+    reader.ReadLine();
+
+    // The draw entry loaders take the part they are building, which they do not own here.
+    std::unique_ptr< LIB_PART > part( aPart );
+
+    try
+    {
+        loadDrawEntries( part, reader, m_versionMajor, m_versionMinor );
+    }
+    catch( ... )
+    {
+        part.release();
+        pending.m_error = std::current_exception();
+        throw;
+    }
+
+    part.release();
+    m_pendingDrawItems.erase( it );
+}
+
+
+void SCH_LEGACY_PLUGIN_CACHE::LoadAllDrawItems()
+{
+    while( !m_pendingDrawItems.empty() )
+        LoadDrawItems( m_pendingDrawItems.begin()->first );
+}
+
+
 LIB_PART* SCH_LEGACY_PLUGIN_CACHE::LoadPart( LINE_READER& aReader, int aMajorVersion,
-                                             int aMinorVersion )
+                                             int aMinorVersion, PENDING_DRAW_ITEMS* aDrawEntries )
 {
     const char* line = aReader.Line();
 
@@ -2829,7 +3015,12 @@ LIB_PART* SCH_LEGACY_PLUGIN_CACHE::LoadPart( LINE_READER& aReader, int aMajorVer
         else if( *line == 'F' )                          // Fields
             loadField( part, aReader );
         else if( strCompare( "DRAW", line, &line ) )     // Drawing objects.
-            loadDrawEntries( part, aReader, aMajorVersion, aMinorVersion );
+        {
+            if( aDrawEntries )
+                copyDrawEntries( aReader, *aDrawEntries );
+            else
+                loadDrawEntries( part, aReader, aMajorVersion, aMinorVersion );
+        }
         else if( strCompare( "$FPLIST", line, &line ) )  // Footprint filter list
             loadFootprintFilters( part, aReader );
         else if( strCompare( "ENDDEF", line, &line ) )   // End of part description
@@ -3035,6 +3226,29 @@ void SCH_LEGACY_PLUGIN_CACHE::loadField( std::unique_ptr< LIB_PART >& aPart,
 }
 
 
+void SCH_LEGACY_PLUGIN_CACHE::copyDrawEntries( LINE_READER& aReader,
+                                               PENDING_DRAW_ITEMS& aDrawEntries )
+{
+    const char* line = aReader.Line();
+
+    wxCHECK_RET( strCompare( "DRAW", line ), "Invalid DRAW section" );
+
+    aDrawEntries.m_entries = line;
+    aDrawEntries.m_lineNumber = aReader.LineNumber();
+
+    // Only the end of the section is looked for, the entries are checked when parsed.
+    while( ( line = aReader.ReadLine() ) != NULL )
+    {
+        aDrawEntries.m_entries += line;
+
+        if( strCompare( "ENDDRAW", line ) )
+            return;
+    }
+
+    SCH_PARSE_ERROR( "file ended prematurely loading component draw element", aReader, line );
+}
+
+
 void SCH_LEGACY_PLUGIN_CACHE::loadDrawEntries( std::unique_ptr< LIB_PART >& aPart,
                                                LINE_READER&                 aReader,
                                                int                          aMajorVersion,
@@ -3603,6 +3817,8 @@ void SCH_LEGACY_PLUGIN_CACHE::Save( bool aSaveDocFile )
     if( !m_isModified )
         return;
 
+    LoadAllDrawItems();
+
     // Write through symlinks, don't replace them
     wxFileName fn = GetRealFile();
 
@@ -4132,6 +4348,7 @@ void SCH_LEGACY_PLUGIN_CACHE::DeleteAlias( const wxString& aAliasName )
 
     if( !alias )
     {
+        m_pendingDrawItems.erase( part );
         delete part;
 
         if( m_aliases.size() > 1 )
@@ -4264,6 +4481,9 @@ void SCH_LEGACY_PLUGIN::EnumerateSymbolLib( std::vector<LIB_ALIAS*>& aAliasList,
                               aProperties->find( SYMBOL_LIB_TABLE::PropPowerSymsOnly ) != aProperties->end() );
     cacheLib( aLibraryPath );
 
+    if( !aProperties || !aProperties->Exists( SYMBOL_LIB_TABLE::PropLazyLoad ) )
+        m_cache->LoadAllDrawItems();
+
     const LIB_ALIAS_MAP& aliases = m_cache->m_aliases;
 
     for( LIB_ALIAS_MAP::const_iterator it = aliases.begin();  it != aliases.end();  ++it )
@@ -4288,6 +4508,8 @@ LIB_ALIAS* SCH_LEGACY_PLUGIN::LoadSymbol( const wxString& aLibraryPath, const wx
     if( it == m_cache->m_aliases.end() )
         return NULL;
 
+    m_cache->LoadDrawItems( it->second->GetPart() );
+
     return it->second;
 }
 
@@ -26,6 +26,7 @@
 #include <memory>
 #include <sch_io_mgr.h>
 #include <stack>
+#include <vector>
 
 
 class KIWAY;
@@ -136,18 +137,18 @@ public:
 
 private:
     void loadHierarchy( SCH_SHEET* aSheet );
-    void loadHeader( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen );
-    void loadPageSettings( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen );
+    void loadHeader( LINE_READER& aReader, SCH_SCREEN* aScreen );
+    void loadPageSettings( LINE_READER& aReader, SCH_SCREEN* aScreen );
     void loadFile( const wxString& aFileName, SCH_SCREEN* aScreen );
-    SCH_SHEET* loadSheet( FILE_LINE_READER& aReader );
-    SCH_BITMAP* loadBitmap( FILE_LINE_READER& aReader );
-    SCH_JUNCTION* loadJunction( FILE_LINE_READER& aReader );
-    SCH_NO_CONNECT* loadNoConnect( FILE_LINE_READER& aReader );
-    SCH_LINE* loadWire( FILE_LINE_READER& aReader );
-    SCH_BUS_ENTRY_BASE* loadBusEntry( FILE_LINE_READER& aReader );
-    SCH_TEXT* loadText( FILE_LINE_READER& aReader );
-    SCH_COMPONENT* loadComponent( FILE_LINE_READER& aReader );
-    std::shared_ptr< BUS_ALIAS > loadBusAlias( FILE_LINE_READER& aReader, SCH_SCREEN* aScreen );
+    SCH_SHEET* loadSheet( LINE_READER& aReader );
+    SCH_BITMAP* loadBitmap( LINE_READER& aReader );
+    SCH_JUNCTION* loadJunction( LINE_READER& aReader );
+    SCH_NO_CONNECT* loadNoConnect( LINE_READER& aReader );
+    SCH_LINE* loadWire( LINE_READER& aReader );
+    SCH_BUS_ENTRY_BASE* loadBusEntry( LINE_READER& aReader );
+    SCH_TEXT* loadText( LINE_READER& aReader );
+    SCH_COMPONENT* loadComponent( LINE_READER& aReader );
+    std::shared_ptr< BUS_ALIAS > loadBusAlias( LINE_READER& aReader, SCH_SCREEN* aScreen );
 
     void saveComponent( SCH_COMPONENT* aComponent );
     void saveField( SCH_FIELD* aField );
@@ -177,6 +178,7 @@ protected:
     SCH_SHEET*        m_rootSheet;  ///< The root sheet of the schematic being loaded..
     FILE_OUTPUTFORMATTER* m_out;    ///< The output formatter for saving SCH_SCREEN objects.
     SCH_LEGACY_PLUGIN_CACHE* m_cache;
+    std::vector<SCH_BITMAP*> m_pendingBitmaps;  ///< Bitmaps parsed out of the main thread.
 
     /// initialize PLUGIN like a constructor would.
     void init( KIWAY* aKiway, const PROPERTIES* aProperties = NULL );
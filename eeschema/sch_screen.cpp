@@ -53,13 +53,14 @@
 #include <sch_sheet.h>
 #include <sch_component.h>
 #include <sch_text.h>
+#include <sch_item_index.h>
 #include <lib_pin.h>
 #include <symbol_lib_table.h>
 #include <tool/common_tools.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <algorithm>
-#include <future>
+#include <geometry/rtree.h>
 
 // TODO(JE) Debugging only
 #include <profile.h>
@@ -119,6 +120,7 @@ SCH_SCREEN::SCH_SCREEN( KIWAY* aKiway ) :
     SetGrid( wxRealPoint( 50, 50 ) );
 
     m_refCount = 0;
+    m_itemIndexUsers = 0;
 
     // Suitable for schematic only. For libedit and viewlib, must be set to true
     m_Center = false;
@@ -154,10 +156,39 @@ void SCH_SCREEN::DecRefCount()
 }
 
 
+void SCH_SCREEN::Append( SCH_ITEM* aItem )
+{
+    m_drawList.Append( aItem );
+    --m_modification_sync;
+
+    if( m_itemIndex )
+        m_itemIndex->Insert( aItem );
+}
+
+
+void SCH_SCREEN::Append( DLIST< SCH_ITEM >& aList )
+{
+    if( m_itemIndex )
+    {
+        for( SCH_ITEM* item = aList.begin(); item; item = item->Next() )
+            m_itemIndex->Insert( item );
+    }
+
+    m_drawList.Append( aList );
+    --m_modification_sync;
+}
+
+
 void SCH_SCREEN::Append( SCH_SCREEN* aScreen )
 {
     wxCHECK_RET( aScreen, "Invalid screen object." );
 
+    if( m_itemIndex )
+    {
+        for( SCH_ITEM* item = aScreen->m_drawList.begin(); item; item = item->Next() )
+            m_itemIndex->Insert( item );
+    }
+
     // No need to decend the hierarchy.  Once the top level screen is copied, all of it's
     // children are copied as well.
     m_drawList.Append( aScreen->m_drawList );
@@ -181,16 +212,59 @@ void SCH_SCREEN::Clear()
 
 void SCH_SCREEN::FreeDrawList()
 {
+    if( m_itemIndex )
+        m_itemIndex->RemoveAll();
+
     m_drawList.DeleteAll();
 }
 
 
 void SCH_SCREEN::Remove( SCH_ITEM* aItem )
 {
+    if( m_itemIndex )
+        m_itemIndex->Remove( aItem );
+
     m_drawList.Remove( aItem );
 }
 
 
+void SCH_SCREEN::EnableItemIndex()
+{
+    if( m_itemIndexUsers++ )
+        return;
+
+    m_itemIndex.reset( new SCH_ITEM_INDEX );
+
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+        m_itemIndex->Insert( item );
+}
+
+
+void SCH_SCREEN::DisableItemIndex()
+{
+    wxCHECK_RET( m_itemIndexUsers > 0, wxT( "Item index of the screen is not enabled." ) );
+
+    if( --m_itemIndexUsers == 0 )
+        m_itemIndex.reset();
+}
+
+
+void SCH_SCREEN::itemsAt( const wxPoint& aPosition, int aAccuracy,
+                          std::vector< SCH_ITEM* >& aItems ) const
+{
+    if( m_itemIndex )
+    {
+        m_itemIndex->Query( aPosition, aAccuracy, aItems );
+        return;
+    }
+
+    aItems.clear();
+
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+        aItems.push_back( item );
+}
+
+
 void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
 {
     wxCHECK_RET( aItem, wxT( "Cannot delete invalid item from screen." ) );
@@ -211,7 +285,7 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
         if( GetCurItem() == aItem )
             SetCurItem( nullptr );
 
-        m_drawList.Remove( aItem );
+        Remove( aItem );
         delete aItem;
     }
 }
@@ -235,7 +309,11 @@ bool SCH_SCREEN::CheckIfOnDrawList( SCH_ITEM* aItem )
 
 SCH_ITEM* SCH_SCREEN::GetItem( const wxPoint& aPosition, int aAccuracy, KICAD_T aType ) const
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, aAccuracy, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( (aType == SCH_FIELD_T) && (item->Type() == SCH_COMPONENT_T) )
         {
@@ -291,6 +369,12 @@ void SCH_SCREEN::ReplaceWires( DLIST< SCH_ITEM >& aWireList )
         }
     }
 
+    if( m_itemIndex )
+    {
+        for( item = aWireList.begin(); item; item = item->Next() )
+            m_itemIndex->Insert( item );
+    }
+
     m_drawList.Append( aWireList );
 }
 
@@ -344,8 +428,11 @@ bool SCH_SCREEN::IsJunctionNeeded( const wxPoint& aPosition, bool aNew )
     int     pin_count = 0;
 
     std::vector<SCH_LINE*> lines[2];
+    std::vector<SCH_ITEM*> items;
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    itemsAt( aPosition, 0, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( item->GetEditFlags() & STRUCT_DELETED )
             continue;
@@ -601,11 +688,14 @@ void SCH_SCREEN::ClearDrawingState()
 LIB_PIN* SCH_SCREEN::GetPin( const wxPoint& aPosition, SCH_COMPONENT** aComponent,
                              bool aEndPointOnly ) const
 {
-    SCH_ITEM*       item;
     SCH_COMPONENT*  component = NULL;
     LIB_PIN*        pin = NULL;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, 0, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( item->Type() != SCH_COMPONENT_T )
             continue;
@@ -675,7 +765,11 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 {
     SCH_SHEET_PIN* sheetPin = NULL;
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, 0, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( item->Type() != SCH_SHEET_T )
             continue;
@@ -693,10 +787,13 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 
 int SCH_SCREEN::CountConnectedItems( const wxPoint& aPos, bool aTestJunctions ) const
 {
-    SCH_ITEM* item;
     int       count = 0;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPos, 0, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( item->Type() == SCH_JUNCTION_T  && !aTestJunctions )
             continue;
@@ -940,20 +1037,88 @@ int SCH_SCREEN::UpdatePickList()
 }
 
 
-bool SCH_SCREEN::TestDanglingEnds()
+bool SCH_SCREEN::TestDanglingEnds( const std::function<void( SCH_ITEM* )>& aChangedHandler )
 {
-    SCH_ITEM* item;
-    std::vector< DANGLING_END_ITEM > endPoints;
+    std::vector< SCH_ITEM* >          items;
+    std::vector< DANGLING_END_ITEM >  endPoints;
+    std::vector< size_t >             firstEndPoint;    // of each item, and the end
+    RTree< size_t, int, 2, double >   tree;             // end point boxes of the items
     bool hasStateChanged = false;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    {
+        items.push_back( item );
+        firstEndPoint.push_back( endPoints.size() );
         item->GetEndPoints( endPoints );
+    }
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    firstEndPoint.push_back( endPoints.size() );
+
+    std::vector< EDA_RECT > boxes( items.size() );
+
+    for( size_t i = 0; i < items.size(); i++ )
+    {
+        if( firstEndPoint[i] == firstEndPoint[i + 1] )
+            continue;
+
+        // The box of the end points of a wire holds the whole wire, so the items connected
+        // in the middle of it are found too
+        boxes[i] = EDA_RECT( endPoints[ firstEndPoint[i] ].GetPosition(), wxSize( 0, 0 ) );
+
+        for( size_t j = firstEndPoint[i] + 1; j < firstEndPoint[i + 1]; j++ )
+            boxes[i].Merge( endPoints[j].GetPosition() );
+
+        const int mmin[2] = { boxes[i].GetX(), boxes[i].GetY() };
+        const int mmax[2] = { boxes[i].GetRight(), boxes[i].GetBottom() };
+
+        tree.Insert( mmin, mmax, i );
+    }
+
+    std::vector< size_t >            neighbours;
+    std::vector< DANGLING_END_ITEM > nearEndPoints;
+
+    for( size_t i = 0; i < items.size(); i++ )
     {
-        if( item->UpdateDanglingState( endPoints ) )
+        bool changed;
+
+        if( firstEndPoint[i] == firstEndPoint[i + 1] )
+        {
+            // Nothing tells where this item connects
+            changed = items[i]->UpdateDanglingState( endPoints );
+        }
+        else
+        {
+            const int mmin[2] = { boxes[i].GetX(), boxes[i].GetY() };
+            const int mmax[2] = { boxes[i].GetRight(), boxes[i].GetBottom() };
+
+            neighbours.clear();
+            tree.Search( mmin, mmax, [&neighbours]( const size_t& aNeighbour )
+                                             {
+                                                 neighbours.push_back( aNeighbour );
+                                                 return true;
+                                             } );
+
+            // Keep the list order: the wire ends come in pairs, and some items stop at
+            // the first connection they find
+            std::sort( neighbours.begin(), neighbours.end() );
+            nearEndPoints.clear();
+
+            for( size_t neighbour : neighbours )
+            {
+                nearEndPoints.insert( nearEndPoints.end(),
+                                      endPoints.begin() + firstEndPoint[ neighbour ],
+                                      endPoints.begin() + firstEndPoint[ neighbour + 1 ] );
+            }
+
+            changed = items[i]->UpdateDanglingState( nearEndPoints );
+        }
+
+        if( changed )
         {
             hasStateChanged = true;
+
+            if( aChangedHandler )
+                aChangedHandler( items[i] );
         }
     }
 
@@ -963,7 +1128,11 @@ bool SCH_SCREEN::TestDanglingEnds()
 
 int SCH_SCREEN::GetNode( const wxPoint& aPosition, EDA_ITEMS& aList )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, 0, items );
+
+    for( SCH_ITEM* item : items )
     {
         switch( item->Type() )
         {
@@ -999,7 +1168,11 @@ int SCH_SCREEN::GetNode( const wxPoint& aPosition, EDA_ITEMS& aList )
 
 SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, 0, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( (item->Type() == SCH_LINE_T) && item->HitTest( aPosition )
             && (item->GetLayer() == LAYER_BUS || item->GetLayer() == LAYER_WIRE) )
@@ -1015,7 +1188,11 @@ SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLayer,
                                SCH_LINE_TEST_T aSearchType )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, aAccuracy, items );
+
+    for( SCH_ITEM* item : items )
     {
         if( item->Type() != SCH_LINE_T )
             continue;
@@ -1048,7 +1225,11 @@ SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLay
 
 SCH_TEXT* SCH_SCREEN::GetLabel( const wxPoint& aPosition, int aAccuracy )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    std::vector< SCH_ITEM* > items;
+
+    itemsAt( aPosition, aAccuracy, items );
+
+    for( SCH_ITEM* item : items )
     {
         switch( item->Type() )
         {
@@ -1120,6 +1301,9 @@ int SCH_SCREEN::GetConnection( const wxPoint& aPosition, PICKED_ITEMS_LIST& aLis
     EDA_ITEM* tmp;
     EDA_ITEMS list;
 
+    // Nothing is moved here, and the connection is traced with many position queries
+    SCH_SCREEN_INDEX_SCOPE indexScope( this );
+
     // Clear flags member for all items.
     ClearDrawingState();
 
@@ -1570,11 +1754,10 @@ void SCH_SCREENS::TestDanglingEnds()
     for( SCH_SCREEN* screen = GetFirst(); screen; screen = GetNext() )
         screens.push_back( screen );
 
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            screens.size() );
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    size_t parallelThreadCount = pool.GetTaskCount( screens.size() );
 
     std::atomic<size_t> nextScreen( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
 
     auto update_lambda = [&screens, &nextScreen]() -> size_t
     {
@@ -1588,12 +1771,12 @@ void SCH_SCREENS::TestDanglingEnds()
         update_lambda();
     else
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
+        TASK_GROUP tasks( pool );
+
+        tasks.Run( update_lambda, parallelThreadCount );
 
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
+        // Finalize the tasks
+        tasks.Wait();
     }
 
 }
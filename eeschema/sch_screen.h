@@ -30,6 +30,8 @@
 #ifndef SCREEN_H
 #define SCREEN_H
 
+#include <functional>
+#include <memory>
 #include <unordered_set>
 
 #include <macros.h>
@@ -53,6 +55,7 @@ class SCH_SHEET_PATH;
 class SCH_SHEET_PIN;
 class SCH_LINE;
 class SCH_TEXT;
+class SCH_ITEM_INDEX;
 class PLOTTER;
 class SCH_SHEET_LIST;
 
@@ -96,6 +99,10 @@ private:
 
     DLIST< SCH_ITEM > m_drawList;       ///< Object list for the screen.
 
+    /// Spatial index of m_drawList, while EnableItemIndex() is in effect.
+    std::unique_ptr< SCH_ITEM_INDEX > m_itemIndex;
+    int     m_itemIndexUsers;           ///< EnableItemIndex() calls not yet matched
+
     int     m_modification_sync;        ///< inequality with PART_LIBS::GetModificationHash()
                                         ///< will trigger ResolveAll().
 
@@ -114,6 +121,12 @@ private:
      */
     void addConnectedItemsToBlock( const SCH_ITEM* aItem, const wxPoint& aPosition );
 
+    /**
+     * Collect the items which may be hit at \a aPosition within \a aAccuracy, in draw list
+     * order.  Without the item index, this is the whole draw list.
+     */
+    void itemsAt( const wxPoint& aPosition, int aAccuracy, std::vector< SCH_ITEM* >& aItems ) const;
+
 public:
 
     /**
@@ -166,11 +179,7 @@ public:
      */
     SCH_ITEM* GetDrawItems() const                          { return m_drawList.begin(); }
 
-    void Append( SCH_ITEM* aItem )
-    {
-        m_drawList.Append( aItem );
-        --m_modification_sync;
-    }
+    void Append( SCH_ITEM* aItem );
 
     /**
      * Copy the contents of \a aScreen into this #SCH_SCREEN object.
@@ -189,11 +198,20 @@ public:
      *
      * @param aList A reference to a #DLIST containing the #SCH_ITEM to add to the sheet.
      */
-    void Append( DLIST< SCH_ITEM >& aList )
-    {
-        m_drawList.Append( aList );
-        --m_modification_sync;
-    }
+    void Append( DLIST< SCH_ITEM >& aList );
+
+    /**
+     * Index the items of the screen by position, so that the position queries (GetItem(),
+     * GetPin(), IsJunctionNeeded(), CountConnectedItems(), GetNode()...) no longer scan the
+     * whole draw list.  This pays off when many queries are made in a row.
+     *
+     * Append(), Remove(), DeleteItem() and ReplaceWires() keep the index up to date, but it
+     * does not follow items which are moved or changed in place: the caller must not do so
+     * until the matching DisableItemIndex().  The calls can be nested.
+     */
+    void EnableItemIndex();
+
+    void DisableItemIndex();
 
     /**
      * Return the currently selected SCH_ITEM, overriding BASE_SCREEN::GetCurItem().
@@ -293,9 +311,13 @@ public:
 
     /**
      * Test all of the connectable objects in the schematic for unused connection points.
+     *
+     * Each item is only given the end points of the items around it.
+     *
+     * @param aChangedHandler is called with each item whose dangling state changed.
      * @return True if any connection state changes were made.
      */
-    bool TestDanglingEnds();
+    bool TestDanglingEnds( const std::function<void( SCH_ITEM* )>& aChangedHandler = nullptr );
 
     /**
      * Replace all of the wires, buses, and junctions in the screen with \a aWireList.
@@ -551,6 +573,30 @@ public:
 };
 
 
+/**
+ * Keeps the item index of a #SCH_SCREEN enabled for the lifetime of the object.
+ *
+ * @see SCH_SCREEN::EnableItemIndex()
+ */
+class SCH_SCREEN_INDEX_SCOPE
+{
+public:
+    SCH_SCREEN_INDEX_SCOPE( SCH_SCREEN* aScreen ) :
+        m_screen( aScreen )
+    {
+        m_screen->EnableItemIndex();
+    }
+
+    ~SCH_SCREEN_INDEX_SCOPE()
+    {
+        m_screen->DisableItemIndex();
+    }
+
+private:
+    SCH_SCREEN* m_screen;
+};
+
+
 /**
  * Container class that holds multiple #SCH_SCREEN objects in a hierarchy.
  *
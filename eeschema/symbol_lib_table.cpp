@@ -44,6 +44,7 @@ static const wxString global_tbl_name( "sym-lib-table" );
 
 const char* SYMBOL_LIB_TABLE::PropPowerSymsOnly = "pwr_sym_only";
 const char* SYMBOL_LIB_TABLE::PropNonPowerSymsOnly = "non_pwr_sym_only";
+const char* SYMBOL_LIB_TABLE::PropLazyLoad = "lazy_load";
 int SYMBOL_LIB_TABLE::m_modifyHash = 1;     // starts at 1 and goes up
 
 
@@ -313,20 +314,24 @@ SYMBOL_LIB_TABLE_ROW* SYMBOL_LIB_TABLE::FindRow( const wxString& aNickname )
 
 
 void SYMBOL_LIB_TABLE::LoadSymbolLib( std::vector<LIB_ALIAS*>& aAliasList,
-                                      const wxString& aNickname, bool aPowerSymbolsOnly )
+                                      const wxString& aNickname, bool aPowerSymbolsOnly,
+                                      bool aLazyLoad )
 {
     SYMBOL_LIB_TABLE_ROW* row = FindRow( aNickname );
     wxCHECK( row && row->plugin, /* void */  );
 
-    wxString options = row->GetOptions();
+    PROPERTIES properties;
+
+    if( row->GetProperties() )
+        properties = *row->GetProperties();
 
     if( aPowerSymbolsOnly )
-        row->SetOptions( row->GetOptions() + " " + PropPowerSymsOnly );
+        properties[ PropPowerSymsOnly ] = "";
 
-    row->plugin->EnumerateSymbolLib( aAliasList, row->GetFullURI( true ), row->GetProperties() );
+    if( aLazyLoad )
+        properties[ PropLazyLoad ] = "";
 
-    if( aPowerSymbolsOnly )
-        row->SetOptions( options );
+    row->plugin->EnumerateSymbolLib( aAliasList, row->GetFullURI( true ), &properties );
 
     // The library cannot know its own name, because it might have been renamed or moved.
     // Therefore footprints cannot know their own library nickname when residing in
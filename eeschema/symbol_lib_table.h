@@ -112,6 +112,10 @@ public:
     static const char* PropPowerSymsOnly;
     static const char* PropNonPowerSymsOnly;
 
+    /// The symbols may be returned before their draw items are loaded.  They are loaded
+    /// when the symbol is fetched with LoadSymbol().
+    static const char* PropLazyLoad;
+
     virtual void Parse( LIB_TABLE_LEXER* aLexer ) override;
 
     virtual void Format( OUTPUTFORMATTER* aOutput, int aIndentLevel ) const override;
@@ -162,8 +166,18 @@ public:
     void EnumerateSymbolLib( const wxString& aNickname, wxArrayString& aAliasNames,
                              bool aPowerSymbolsOnly = false );
 
+    /**
+     * Return the symbol aliases contained within the library given by @a aNickname.
+     *
+     * @param aPowerSymbolsOnly is a flag to enumerate only power symbols.
+     * @param aLazyLoad is a flag to allow the library to return the symbols without their
+     *                  draw items, for callers which only need the names, fields and unit
+     *                  counts of the symbols.  The draw items are loaded by LoadSymbol().
+     *
+     * @throw IO_ERROR if the library cannot be found or loaded.
+     */
     void LoadSymbolLib( std::vector<LIB_ALIAS*>& aAliasList, const wxString& aNickname,
-                        bool aPowerSymbolsOnly = false );
+                        bool aPowerSymbolsOnly = false, bool aLazyLoad = false );
 
     /**
      * Load a #LIB_ALIAS having @a aAliasName from the library given by @a aNickname.
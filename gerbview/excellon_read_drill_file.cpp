@@ -72,10 +72,12 @@
 #include <gerber_file_image_list.h>
 #include <excellon_image.h>
 #include <kicad_string.h>
+#include <richio.h>
 #include <X2_gerber_attributes.h>
 #include <view/view.h>
 
 #include <cmath>
+#include <memory>
 
 #include <html_messagebox.h>
 
@@ -319,25 +321,29 @@ bool EXCELLON_IMAGE::LoadFile( const wxString & aFullFileName )
     ResetDefaultValues();
     ClearMessageList();
 
-    m_Current_File = wxFopen( aFullFileName, "rt" );
+    std::unique_ptr<LINE_READER> excellonReader;
 
-    if( m_Current_File == NULL )
+    try
+    {
+        // Large drill files are mapped in memory rather than read one char at a time
+        excellonReader.reset( OpenFileLineReader( aFullFileName ) );
+    }
+    catch( const IO_ERROR& )
+    {
         return false;
+    }
 
     wxString msg;
     m_FileName = aFullFileName;
 
     LOCALE_IO toggleIo;
 
-    // FILE_LINE_READER will close the file.
-    FILE_LINE_READER excellonReader( m_Current_File, m_FileName );
-
     while( true )
     {
-        if( excellonReader.ReadLine() == 0 )
+        if( excellonReader->ReadLine() == 0 )
             break;
 
-        char* line = excellonReader.Line();
+        char* line = excellonReader->Line();
         char* text = StrPurge( line );
 
         if( *text == ';' || *text == 0 )       // comment: skip line or empty malformed line
@@ -24,6 +24,8 @@
 #ifndef ADVANCED_CFG__H
 #define ADVANCED_CFG__H
 
+#include <wx/string.h>
+
 class wxConfigBase;
 
 /**
@@ -78,6 +80,23 @@ public:
      */
     bool m_realTimeConnectivity;
 
+    /**
+     * Maximum number of worker threads of the shared thread pool. 0 means one per core.
+     */
+    int m_maxWorkerThreads;
+
+    /**
+     * Keep a binary snapshot of each .kicad_pcb file loaded, next to it, and load from
+     * it while the board file does not change.
+     */
+    bool m_enableBoardSnapshots;
+
+    /**
+     * Directory where the interactive router records its sessions, for replaying them
+     * offline.  Empty (the default) to not record.
+     */
+    wxString m_routerSessionLogDir;
+
     /**
      * Helper to determine if legacy canvas is allowed (according to platform
      * and config)
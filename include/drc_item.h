@@ -175,6 +175,20 @@ public:
     BOARD_ITEM* GetMainItem( BOARD* aBoard ) const;
     BOARD_ITEM* GetAuxiliaryItem( BOARD* aBoard ) const;
 
+    /**
+     * Function GetMainItemRef
+     * @return the address of the main item, to compare it with items without searching
+     * the board.  It may not be a valid item anymore, so it must not be dereferenced.
+     */
+    const void* GetMainItemRef() const { return m_mainItemWeakRef; }
+
+    /**
+     * Function GetAuxiliaryItemRef
+     * @return the address of the auxiliary item, with the same restrictions as
+     * GetMainItemRef().
+     */
+    const void* GetAuxiliaryItemRef() const { return m_auxItemWeakRef; }
+
     /**
      * Function ShowHtml
      * translates this object into a fragment of HTML suitable for the
@@ -44,6 +44,14 @@ struct KEYWORD
 };
 #endif
 
+/**
+ * Type KEYWORD_FINDER
+ * is a function returning the token of the keyword @a aToken of length @a aLength,
+ * or DSN_SYMBOL if it is not a keyword.  The TokenList2DsnLexer CMake script
+ * generates one for each keyword list, as a switch on the length and first letter.
+ */
+typedef int (*KEYWORD_FINDER)( const char* aToken, size_t aLength );
+
 // something like this macro can be used to help initialize a KEYWORD table.
 // see SPECCTRA_DB::keywords[] as an example.
 
@@ -86,6 +94,9 @@ protected:
     const char*         limit;
     char                dummy[1];               ///< when there is no reader.
 
+    const char*         tokenNext;              ///< next token of the replayed stream, or NULL
+    const char*         tokenEnd;               ///< end of the replayed stream
+
     typedef std::vector<LINE_READER*>  READER_STACK;
 
     READER_STACK        readerStack;            ///< all the LINE_READERs by pointer.
@@ -107,9 +118,11 @@ protected:
 
     int                 curTok;                 ///< the current token obtained on last NextTok()
     std::string         curText;                ///< the text of the current token
+    std::string         curLine;                ///< copy of the current line, for error reports
 
     const KEYWORD*      keywords;               ///< table sorted by CMake for bsearch()
     unsigned            keywordCount;           ///< count of keywords table
+    KEYWORD_FINDER      keywordFinder;          ///< generated lookup, NULL to use keyword_hash
     KEYWORD_MAP         keyword_hash;           ///< fast, specialized "C string" hashtable
 
     void init();
@@ -118,13 +131,15 @@ protected:
     {
         if( reader )
         {
-            reader->ReadLine();
+            // The lexer only needs the text and its length: let the reader skip
+            // copying the line if it can.
+            const char* line = reader->ReadLineView();
 
             unsigned len = reader->Length();
 
             // start may have changed in ReadLine(), which can resize and
             // relocate reader's line buffer.
-            start = reader->Line();
+            start = line ? line : reader->Line();
 
             next  = start;
             limit = next + len;
@@ -134,6 +149,13 @@ protected:
         return 0;
     }
 
+    /**
+     * Function readStreamTok
+     * reads the next token of the stream set by SetTokenStream().
+     * @throw PARSE_ERROR if the stream is damaged.
+     */
+    int readStreamTok();
+
     /**
      * Function findToken
      * takes aToken string and looks up the string in the keywords table.
@@ -169,9 +191,10 @@ public:
      * @param aKeywordCount is the count of tokens in aKeywordTable.
      * @param aFile is an open file, which will be closed when this is destructed.
      * @param aFileName is the name of the file
+     * @param aKeywordFinder is the generated lookup function of aKeywordTable, if any.
      */
     DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-              FILE* aFile, const wxString& aFileName );
+              FILE* aFile, const wxString& aFileName, KEYWORD_FINDER aKeywordFinder = NULL );
 
     /**
      * Constructor ( const KEYWORD*, unsigned, const std::string&, const wxString& )
@@ -182,9 +205,11 @@ public:
      * @param aKeywordCount is the count of tokens in aKeywordTable.
      * @param aSExpression is text to feed through a STRING_LINE_READER
      * @param aSource is a description of aSExpression, used for error reporting.
+     * @param aKeywordFinder is the generated lookup function of aKeywordTable, if any.
      */
     DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-              const std::string& aSExpression, const wxString& aSource = wxEmptyString );
+              const std::string& aSExpression, const wxString& aSource = wxEmptyString,
+              KEYWORD_FINDER aKeywordFinder = NULL );
 
     /**
      * Constructor ( const std::string&, const wxString& )
@@ -209,9 +234,11 @@ public:
      *
      * @param aLineReader is any subclassed instance of LINE_READER, such as
      *  STRING_LINE_READER or FILE_LINE_READER.  No ownership is taken.
+     *
+     * @param aKeywordFinder is the generated lookup function of aKeywordTable, if any.
      */
     DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-              LINE_READER* aLineReader = NULL );
+              LINE_READER* aLineReader = NULL, KEYWORD_FINDER aKeywordFinder = NULL );
 
     virtual ~DSNLEXER();
 
@@ -225,6 +252,48 @@ public:
      */
     bool SyncLineReaderWith( DSNLEXER& aLexer );
 
+    /**
+     * Function SetTokenStream
+     * makes NextTok() replay the tokens written by WriteTokens() in @a aBegin .. @a aEnd,
+     * rather than lexing the text of the current LINE_READER, which is then only used
+     * for the source name in error reports.  Keywords are looked up again when read, so
+     * a stream can be replayed by a lexer having other keywords, such as a sub-parser
+     * synchronized with SyncLineReaderWith().
+     * @param aBegin is the beginning of the stream, or NULL to go back to lexing text.
+     */
+    void SetTokenStream( const char* aBegin, const char* aEnd )
+    {
+        tokenNext = aBegin;
+        tokenEnd  = aEnd;
+    }
+
+    /**
+     * Function GetTokenStreamPosition
+     * @return the position of the next token of the stream set by SetTokenStream().
+     */
+    const char* GetTokenStreamPosition() const
+    {
+        return tokenNext;
+    }
+
+    /**
+     * Function WriteTokens
+     * lexes all the remaining tokens of the current LINE_READER, and appends them
+     * to @a aStream in a compact binary form, ready for SetTokenStream().  Comments
+     * are skipped.  Specctra mode is not supported.
+     * @throw IO_ERROR, PARSE_ERROR if the text cannot be lexed.
+     */
+    void WriteTokens( std::string& aStream );
+
+    /**
+     * Function WriteToken
+     * appends a single token to a token stream.
+     * @param aTok is DSN_LEFT, DSN_RIGHT, DSN_NUMBER, DSN_STRING, DSN_SYMBOL or a keyword.
+     * @param aText is the text of the token, unused for brackets.
+     */
+    static void WriteToken( std::string& aStream, int aTok,
+                            const std::string& aText = std::string() );
+
     /**
      * Function SetSpecctraMode
      * changes the behavior of this lexer into or out of "specctra mode".  If
@@ -516,7 +585,9 @@ public:
      */
     const char* CurLine()
     {
-        return (const char*)(*reader);
+        // The line may be a view into the reader storage, not nul terminated
+        curLine.assign( start, limit );
+        return curLine.c_str();
     }
 
     /**
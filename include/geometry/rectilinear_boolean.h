@@ -0,0 +1,89 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __RECTILINEAR_BOOLEAN_H
+#define __RECTILINEAR_BOOLEAN_H
+
+#include <cstddef>
+
+#include <clipper.hpp>
+
+class SHAPE_POLY_SET;
+
+/**
+ * Boolean operations on rectilinear polygon sets, i.e. sets whose edges are all horizontal
+ * or vertical, like rectangular pads, thermal spokes and board outlines.
+ *
+ * A sweep line over the vertical edges keeps the winding numbers of both operands in each
+ * horizontal band, so the result is exact in integer coordinates and needs none of the
+ * intersection handling of the general algorithm.  Holes and outlines follow the same
+ * conventions as the results of Clipper: outlines have a positive area, holes a negative
+ * one, and the nonzero fill rule applies to the inputs.  Like the strictly simple results
+ * of Clipper, no loop touches itself: outlines or holes touching at a corner are separate.
+ *
+ * SHAPE_POLY_SET uses it automatically when both operands of a boolean operation are
+ * rectilinear, and Clipper otherwise.  The benefit is therefore limited to the operations
+ * on rectangular pads, their thermal spokes and rectilinear zone or board outlines: zones
+ * with rounded clearances, round or oval pads and tracks at an angle still go to Clipper,
+ * after a check which usually stops at the first edges of the operands.  The zone_fill_bench
+ * QA tool reports how many operations of the fills of a board take each path.
+ */
+namespace RECTILINEAR_BOOLEAN
+{
+
+struct STATS
+{
+    size_t m_calls = 0;         ///< boolean operations computed by the sweep
+    size_t m_fallbacks = 0;     ///< boolean operations left to Clipper
+};
+
+/**
+ * @return true if all the edges of aSet, outlines and holes, are horizontal or vertical.
+ */
+bool IsRectilinear( const SHAPE_POLY_SET& aSet );
+
+/**
+ * Function Execute()
+ *
+ * Computes aA <aType> aB, if both sets are rectilinear and the engine is enabled.
+ * aResult may be one of the operands.
+ *
+ * @return false if the operation must be done by Clipper.  aResult is then left unchanged.
+ */
+bool Execute( ClipperLib::ClipType aType, const SHAPE_POLY_SET& aA, const SHAPE_POLY_SET& aB,
+              SHAPE_POLY_SET& aResult );
+
+/**
+ * Enables or disables the engine, e.g. to compare it with Clipper.  Enabled by default.
+ */
+void SetEnabled( bool aEnabled );
+
+bool IsEnabled();
+
+STATS GetStats();
+
+void ResetStats();
+
+}
+
+#endif
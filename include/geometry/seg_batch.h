@@ -0,0 +1,97 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEG_BATCH_H
+#define __SEG_BATCH_H
+
+#include <geometry/seg.h>
+
+/**
+ * Instruction sets the batched segment kernels can run on.
+ */
+enum class SEG_BATCH_ISA
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+
+/**
+ * Proximity tests of one segment against a polyline, i.e. the segments joining the
+ * consecutive points of an array, several segments at a time.
+ *
+ * The kernels work in floating point and only filter: a segment they skip is certainly
+ * further than the distance asked for, a segment they return must still be checked with
+ * the exact SEG methods.
+ *
+ * The instruction set is chosen at run time, from what the processor supports.
+ */
+namespace SEG_BATCH
+{
+
+/**
+ * @return the instruction set the kernels currently use.
+ */
+SEG_BATCH_ISA GetIsa();
+
+/**
+ * Forces the instruction set of the kernels, e.g. to compare them.  The best supported one
+ * not above aIsa is used.
+ * @return the instruction set actually used.
+ */
+SEG_BATCH_ISA SetIsa( SEG_BATCH_ISA aIsa );
+
+/**
+ * @return the best instruction set supported by the processor and this build.
+ */
+SEG_BATCH_ISA GetBestIsa();
+
+/**
+ * Finds the first segment of a polyline which may be closer than aDist to aSeg.
+ *
+ * @param aSeg the segment to test (both ends equal to test a point).
+ * @param aPoints the points of the polyline, aSegCount + 1 of them.
+ * @param aSegCount the number of segments of the polyline.
+ * @param aStart the first segment to test.
+ * @param aDist the distance.  A segment closer than aDist, give or take one or two units of
+ * rounding, is never skipped.
+ * @return the index of the segment (from aPoints[index] to aPoints[index + 1]), or -1.
+ */
+int FindCandidate( const SEG& aSeg, const VECTOR2I* aPoints, int aSegCount, int aStart,
+                   int aDist );
+
+/**
+ * Computes the distance between aP and the nearest segment of a polyline, exactly like the
+ * smallest SEG::Distance() to its segments.
+ *
+ * @param aP the point to test.
+ * @param aPoints the points of the polyline, aSegCount + 1 of them.
+ * @param aSegCount the number of segments of the polyline.
+ * @return the distance, or INT_MAX without segments.
+ */
+int Distance( const VECTOR2I& aP, const VECTOR2I* aPoints, int aSegCount );
+
+}
+
+#endif // __SEG_BATCH_H
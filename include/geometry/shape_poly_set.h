@@ -836,6 +836,7 @@ class SHAPE_POLY_SET : public SHAPE
         ///> Converts a set of polygons with holes to a singe outline with "slits"/"fractures" connecting the outer ring
         ///> to the inner holes
         ///> For aFastMode meaning, see function booleanOp
+        ///> Large sets are fractured once, the result is kept in SHAPE_POLY_SET_CACHE
         void Fracture( POLYGON_MODE aFastMode );
 
         ///> Converts a single outline slitted ("fractured") polygon into a set ouf outlines
@@ -1178,6 +1179,8 @@ class SHAPE_POLY_SET : public SHAPE
 
         SHAPE_POLY_SET& operator=( const SHAPE_POLY_SET& );
 
+        ///> Triangulates the set, or takes the triangulation of a set with the same vertices
+        ///> from SHAPE_POLY_SET_CACHE
         void CacheTriangulation();
         bool IsTriangulationUpToDate() const;
 
@@ -1187,7 +1190,8 @@ class SHAPE_POLY_SET : public SHAPE
 
         MD5_HASH checksum() const;
 
-        std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> m_triangulatedPolys;
+        ///> Shared with the copies of the set and with SHAPE_POLY_SET_CACHE, never modified
+        std::vector<std::shared_ptr<const TRIANGULATED_POLYGON>> m_triangulatedPolys;
         bool m_triangulationValid = false;
         MD5_HASH m_hash;
 
@@ -0,0 +1,144 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SHAPE_POLY_SET_CACHE_H
+#define __SHAPE_POLY_SET_CACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <md5_hash.h>
+#include <geometry/shape_poly_set.h>
+
+/**
+ * Class SHAPE_POLY_SET_CACHE
+ *
+ * Process-wide cache of the fractured and triangulated forms of polygon sets, keyed by the
+ * checksum of their vertices.
+ *
+ * The zone filler, the GAL painter, the plotters and the 3D viewer all fracture or
+ * triangulate the same polygons, often on their own copies.  SHAPE_POLY_SET::Fracture()
+ * and SHAPE_POLY_SET::CacheTriangulation() look here first, so each polygon set is only
+ * processed once, whoever asks for it.  Triangulations are immutable once cached and are
+ * shared by all the sets with the same vertices.
+ *
+ * The least recently used results are dropped when the cache is full.  All methods are
+ * thread safe.
+ */
+class SHAPE_POLY_SET_CACHE
+{
+public:
+    typedef std::vector<std::shared_ptr<const SHAPE_POLY_SET::TRIANGULATED_POLYGON>> TRIANGULATION;
+    typedef std::vector<SHAPE_POLY_SET::POLYGON> POLYGONS;
+
+    ///> Sets smaller than this are faster to process again than to look up
+    static const int MIN_VERTICES = 64;
+
+    ///> Default memory budget of the cache
+    static const size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    struct STATS
+    {
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+        size_t m_entries = 0;
+        size_t m_bytes = 0;
+    };
+
+    static SHAPE_POLY_SET_CACHE& Instance();
+
+    /**
+     * Function FindTriangulation()
+     * @param aHash is the checksum of the polygon set.
+     * @param aResult receives the triangulation, if found.
+     * @return true if the triangulation of the set is in the cache.
+     */
+    bool FindTriangulation( const MD5_HASH& aHash, TRIANGULATION& aResult );
+
+    void StoreTriangulation( const MD5_HASH& aHash, const TRIANGULATION& aTriangulation );
+
+    /**
+     * Function FindFracture()
+     * @param aHash is the checksum of the polygon set before fracturing.
+     * @param aMode is the simplification mode of the fracture.
+     * @param aResult receives the fractured polygons, if found.
+     * @return true if the fractured set is in the cache.
+     */
+    bool FindFracture( const MD5_HASH& aHash, SHAPE_POLY_SET::POLYGON_MODE aMode,
+                       POLYGONS& aResult );
+
+    void StoreFracture( const MD5_HASH& aHash, SHAPE_POLY_SET::POLYGON_MODE aMode,
+                        const POLYGONS& aPolygons );
+
+    /**
+     * Sets the memory budget of the cache, dropping the oldest results if needed.  A budget
+     * of 0 disables the cache.
+     */
+    void SetMaxBytes( size_t aMaxBytes );
+
+    void Clear();
+
+    STATS GetStats() const;
+
+private:
+    ///> What a polygon set was turned into; the same set may be cached in each form
+    enum KIND
+    {
+        FRACTURED_FAST,
+        FRACTURED_STRICTLY_SIMPLE,
+        TRIANGULATED
+    };
+
+    typedef std::pair<MD5_HASH, int> KEY;
+
+    struct ENTRY
+    {
+        KEY           m_key;
+        TRIANGULATION m_triangulation;
+        POLYGONS      m_polygons;
+        size_t        m_bytes;
+    };
+
+    typedef std::list<ENTRY> LRU_LIST;
+
+    SHAPE_POLY_SET_CACHE();
+
+    ///> Finds an entry and makes it the most recently used one.  The mutex must be held.
+    ENTRY* find( const KEY& aKey );
+
+    ///> Adds an entry, then drops the oldest ones over the budget.  The mutex must be held.
+    void store( ENTRY&& aEntry );
+
+    void trim();
+
+    mutable std::mutex       m_mutex;
+    LRU_LIST                 m_entries;     ///< most recently used first
+    std::map<KEY, LRU_LIST::iterator> m_index;
+    size_t                   m_maxBytes;
+    STATS                    m_stats;
+};
+
+#endif
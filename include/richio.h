@@ -73,6 +73,9 @@ std::string
 #define LINE_READER_LINE_DEFAULT_MAX        1000000
 #define LINE_READER_LINE_INITIAL_SIZE       5000
 
+/// Files at least this large are read by OpenFileLineReader() through a memory mapping
+#define LINE_READER_MAPPING_THRESHOLD       ( 256 * 1024 )
+
 /**
  * Class LINE_READER
  * is an abstract class from which implementation specific LINE_READERs may
@@ -120,6 +123,20 @@ public:
      */
     virtual char* ReadLine() = 0;
 
+    /**
+     * Function ReadLineView
+     * reads a line of text like ReadLine(), for callers which only use the returned
+     * pointer and Length().  Readers able to do so return the line in place, without
+     * copying it: it is then not nul terminated, Line() is not updated, and the text
+     * is valid until the next read.
+     * @return const char* - The beginning of the read line, or NULL if EOF.
+     * @throw IO_ERROR when a line is too long.
+     */
+    virtual const char* ReadLineView()
+    {
+        return ReadLine();
+    }
+
     /**
      * Function GetSource
      * returns the name of the source of the lines in an abstract sense.
@@ -247,6 +264,84 @@ public:
 };
 
 
+/**
+ * Class MAPPED_FILE_LINE_READER
+ * is a LINE_READER that reads a file mapped in memory.  Lines are located with
+ * memchr() rather than read one character at a time, and ReadLineView() returns
+ * them in place, without copying.
+ */
+class MAPPED_FILE_LINE_READER : public LINE_READER
+{
+public:
+    /**
+     * Constructor MAPPED_FILE_LINE_READER
+     * maps @a aFileName in memory for reading.
+     *
+     * @param aFileName is the name of the file to open.
+     * @param aStartingLineNumber is the initial line number to report on error, and is
+     *  incremented by one after each ReadLine().
+     * @param aMaxLineLength is the maximum length of a line.
+     * @throw IO_ERROR if the file can't be opened or mapped.
+     */
+    MAPPED_FILE_LINE_READER( const wxString& aFileName, unsigned aStartingLineNumber = 0,
+                             unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    ~MAPPED_FILE_LINE_READER();
+
+    char* ReadLine() override;
+
+    const char* ReadLineView() override;
+
+    /**
+     * Function Rewind
+     * goes back to the beginning of the file and resets the line number to zero.
+     */
+    void Rewind()
+    {
+        m_next = m_data;
+        m_lineNum = 0;
+    }
+
+    /**
+     * Function Data
+     * returns the whole content of the file, for parsers able to use it directly.
+     * It is not nul terminated: see Size().
+     */
+    const char* Data() const
+    {
+        return m_data;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+private:
+    /**
+     * Function nextLine
+     * finds the next line, newline included, and advances the reading position.
+     * @return the beginning of the line, or NULL if EOF.
+     */
+    const char* nextLine();
+
+    const char* m_data;     ///< the mapped file, or NULL if empty
+    size_t      m_size;
+    const char* m_next;     ///< the beginning of the next line to read
+};
+
+
+/**
+ * Function OpenFileLineReader
+ * opens @a aFileName for reading lines: large files (see LINE_READER_MAPPING_THRESHOLD)
+ * get a MAPPED_FILE_LINE_READER, others a FILE_LINE_READER.  Files which cannot be
+ * mapped are read with a FILE_LINE_READER as well.
+ * @return LINE_READER* - a new reader, owned by the caller.
+ * @throw IO_ERROR if the file can't be opened.
+ */
+LINE_READER* OpenFileLineReader( const wxString& aFileName );
+
+
 /**
  * Class STRING_LINE_READER
  * is a LINE_READER that reads from a multiline 8 bit wide std::string
@@ -268,8 +363,13 @@ public:
      *
      * @param aSource describes the source of aString for error reporting purposes
      *  can be anything meaninful, such as wxT( "clipboard" ).
+     *
+     * @param aStartingLineNumber is the initial line number to report on error, for the
+     *  case where aString was taken from a larger source.  The first reported line number
+     *  will be one greater than what is provided here.
      */
-    STRING_LINE_READER( const std::string& aString, const wxString& aSource );
+    STRING_LINE_READER( const std::string& aString, const wxString& aSource,
+                        unsigned aStartingLineNumber = 0 );
 
     /**
      * Constructor STRING_LINE_READER( const STRING_LINE_READER& )
@@ -0,0 +1,207 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PROGRESS_REPORTER;
+class TASK_GROUP;
+
+
+/**
+ * A pool of worker threads, shared by the parallel jobs of the application so that
+ * several jobs running at the same time (zone fill, connectivity, 3D rendering...) do
+ * not start more threads than the machine has cores.
+ *
+ * Each worker has its own task queue.  A task submitted from a worker goes to the queue
+ * of this worker, other tasks are spread over all the queues.  A worker runs the newest
+ * task of its own queue first, and when it is empty, steals the oldest task of another
+ * queue.
+ *
+ * Tasks are not submitted directly, but through a #TASK_GROUP.
+ */
+class THREAD_POOL
+{
+public:
+    /**
+     * @param aThreadCount is the number of worker threads. 0 means one per core.
+     */
+    THREAD_POOL( size_t aThreadCount );
+
+    ~THREAD_POOL();
+
+    /**
+     * Get the pool shared by the whole application.  Its size can be limited with the
+     * "MaxWorkerThreads" advanced config.
+     */
+    static THREAD_POOL& GetInstance();
+
+    size_t GetThreadCount() const
+    {
+        return m_workers.size();
+    }
+
+    /**
+     * Get the number of tasks worth starting to process aItemCount items, when a task
+     * should not be started for less than aMinItemsPerTask items (overhead costs).
+     * @return a value between 1 and the number of threads.
+     */
+    size_t GetTaskCount( size_t aItemCount, size_t aMinItemsPerTask = 1 ) const;
+
+private:
+    friend class TASK_GROUP;
+
+    struct TASK
+    {
+        std::function<void()> m_func;
+        TASK_GROUP*           m_group;
+    };
+
+    struct TASK_QUEUE
+    {
+        std::mutex       m_lock;
+        std::deque<TASK> m_tasks;
+    };
+
+    void submit( TASK&& aTask );
+
+    /**
+     * Take a task from the queue of worker aWorker, or steal one from another queue.
+     * @param aWorker is the index of the calling worker, or -1 for other threads.
+     */
+    bool popTask( int aWorker, TASK& aTask );
+
+    /**
+     * Take a pending task of aGroup from any queue.
+     */
+    bool popGroupTask( TASK_GROUP* aGroup, TASK& aTask );
+
+    /**
+     * Run one pending task of aGroup on the calling thread.
+     * @return false if no task of aGroup was pending.
+     */
+    bool runPendingTask( TASK_GROUP* aGroup );
+
+    void runTask( TASK& aTask );
+
+    void workerLoop( int aWorker );
+
+    std::vector<std::unique_ptr<TASK_QUEUE>> m_queues;
+    std::vector<std::thread>                 m_workers;
+
+    std::mutex                               m_wakeLock;
+    std::condition_variable                  m_wake;
+    std::atomic<int>                         m_pendingCount;
+    std::atomic<size_t>                      m_nextQueue;
+    bool                                     m_quit;
+};
+
+
+/**
+ * A set of tasks run on a #THREAD_POOL, which can be waited for, or cancelled, together.
+ *
+ * Cancelling a group skips the tasks which did not start yet.  Running tasks can check
+ * IsCancelled() to stop early.  If a task throws, the first exception is thrown again
+ * by the Wait functions.
+ *
+ * The destructor waits for the tasks still running, as they usually refer to data
+ * of the caller.
+ */
+class TASK_GROUP
+{
+public:
+    TASK_GROUP( THREAD_POOL& aPool = THREAD_POOL::GetInstance() );
+
+    ~TASK_GROUP();
+
+    /**
+     * Queue aTask for running on the pool.  The return value of aTask, if any, is ignored.
+     */
+    void Run( std::function<void()> aTask );
+
+    /**
+     * Run aTask on aCount tasks, the usual way to share a list of items between
+     * workers picking the next item from an atomic counter.
+     */
+    void Run( std::function<void()> aTask, size_t aCount );
+
+    void Cancel()
+    {
+        m_cancelled = true;
+    }
+
+    bool IsCancelled() const
+    {
+        return m_cancelled;
+    }
+
+    /**
+     * Wait for all the tasks of the group.  The calling thread runs the pending tasks of
+     * the group while waiting, but never the tasks of other groups: it may be the UI
+     * thread, which must not be held up by unrelated jobs.
+     * @return false if the group was cancelled.
+     */
+    bool Wait();
+
+    /**
+     * Wait for all the tasks of the group, calling aPoll from the calling thread every
+     * 100ms to allow UI updating.  The group is cancelled when aPoll returns false.
+     * @return false if the group was cancelled.
+     */
+    bool WaitAndPoll( const std::function<bool()>& aPoll );
+
+    /**
+     * Wait for all the tasks of the group, keeping aReporter refreshed.
+     * @param aReporter may be null: the group is then waited for like with Wait().
+     * @param aAllowCancel when true, the group is cancelled if the user aborts aReporter.
+     * @return false if the group was cancelled.
+     */
+    bool WaitAndRefresh( PROGRESS_REPORTER* aReporter, bool aAllowCancel = false );
+
+private:
+    friend class THREAD_POOL;
+
+    void taskDone();
+
+    void rethrow();
+
+    THREAD_POOL&            m_pool;
+    std::atomic<size_t>     m_pendingCount;
+    std::atomic<bool>       m_cancelled;
+
+    std::mutex              m_lock;
+    std::condition_variable m_done;
+    std::exception_ptr      m_exception;
+};
+
+#endif // THREAD_POOL_H
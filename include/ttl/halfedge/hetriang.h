@@ -270,6 +270,11 @@ protected:
     EDGE_WEAK_PTR   m_twinEdge;
     EDGE_PTR        m_nextEdgeInFace;
     bool            m_isLeadingEdge;
+
+    /// Position in the list of leading edges of the triangulation, for leading edges
+    std::list<EDGE_PTR>::iterator m_leadingEdgeIt;
+
+    friend class TRIANGULATION;
 };
 
 class DART; // Forward declaration (class in this namespace)
@@ -290,6 +295,7 @@ protected:
     {
         aEdge->SetAsLeadingEdge();
         m_leadingEdges.push_front( aEdge );
+        aEdge->m_leadingEdgeIt = m_leadingEdges.begin();
     }
 
     bool removeLeadingEdgeFromList( EDGE_PTR& aLeadingEdge );
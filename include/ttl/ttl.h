@@ -410,7 +410,7 @@ template <class TRAITS_TYPE, class DART_TYPE>
 void TRIANGULATION_HELPER::RemoveNode( DART_TYPE& aDart )
 {
 
-    if( isBoundaryNode( aDart ) )
+    if( IsBoundaryNode( aDart ) )
         RemoveBoundaryNode<TRAITS_TYPE>( aDart );
     else
         RemoveInteriorNode<TRAITS_TYPE>( aDart );
@@ -1172,7 +1172,7 @@ bool TRIANGULATION_HELPER::Same0Orbit( const DART_TYPE& aD1, const DART_TYPE& aD
     DART_TYPE d_iter = aD2;
     DART_TYPE d_end = aD2;
 
-    if( isBoundaryNode( d_iter ) )
+    if( IsBoundaryNode( d_iter ) )
     {
         // position at both boundary edges
         PositionAtNextBoundaryEdge( d_iter );
@@ -1338,7 +1338,7 @@ template <class TRAITS_TYPE, class DART_TYPE>
 bool TRIANGULATION_HELPER::ConvexBoundary( const DART_TYPE& aDart )
 {
     std::list<DART_TYPE> blist;
-    getBoundary( aDart, blist );
+    GetBoundary( aDart, blist );
 
     int no;
     no = (int) blist.size();
@@ -1687,7 +1687,7 @@ void TRIANGULATION_HELPER::SwapEdgesAwayFromInteriorNode( DART_TYPE& aDart,
     // infinite loop with degree > 3.
     bool allowDegeneracy = true;
 
-    int degree = getDegreeOfNode( aDart );
+    int degree = GetDegreeOfNode( aDart );
     DART_TYPE d_iter;
 
     while( degree > 3 )
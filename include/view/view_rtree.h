@@ -27,6 +27,14 @@
 
 #include <math/box2.h>
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include <geometry/rtree.h>
 
 namespace KIGFX
@@ -37,6 +45,13 @@ typedef RTree<VIEW_ITEM*, int, 2, double> VIEW_RTREE_BASE;
  * Class VIEW_RTREE -
  * Implements an R-tree for fast spatial indexing of VIEW items.
  * Non-owning.
+ *
+ * Most items are added at once, when a document is loaded.  They are kept in a packed
+ * tree, built in one pass with the Sort-Tile-Recursive method and stored in contiguous
+ * arrays.  Items inserted later go to the dynamic R-tree this class derives from, and
+ * items removed from the packed tree are only flagged.  Inserted items are indexed on
+ * the next query, and the packed tree is built again when the dynamic part has grown
+ * too large compared to it.
  */
 class VIEW_RTREE : public VIEW_RTREE_BASE
 {
@@ -49,10 +64,9 @@ public:
     void Insert( VIEW_ITEM* aItem )
     {
         const BOX2I&    bbox    = aItem->ViewBBox();
-        const int       mmin[2] = { bbox.GetX(), bbox.GetY() };
-        const int       mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
 
-        VIEW_RTREE_BASE::Insert( mmin, mmax, aItem );
+        m_pending.push_back( { { { bbox.GetX(), bbox.GetY() },
+                                 { bbox.GetRight(), bbox.GetBottom() } }, aItem } );
     }
 
     /**
@@ -62,13 +76,36 @@ public:
      */
     void Remove( VIEW_ITEM* aItem )
     {
-        // const BOX2I&    bbox    = aItem->ViewBBox();
+        flush();
 
-        // FIXME: use cached bbox or ptr_map to speed up pointer <-> node lookups.
-        const int       mmin[2] = { INT_MIN, INT_MIN };
-        const int       mmax[2] = { INT_MAX, INT_MAX };
+        auto it = m_dynamic.find( aItem );
 
-        VIEW_RTREE_BASE::Remove( mmin, mmax, aItem );
+        if( it != m_dynamic.end() )
+        {
+            VIEW_RTREE_BASE::Remove( it->second.min, it->second.max, aItem );
+            m_dynamic.erase( it );
+        }
+        else
+        {
+            // Packed items are skipped by the queries until the next rebuild
+            m_removed.insert( aItem );
+        }
+    }
+
+    /**
+     * Function RemoveAll()
+     * Removes all the items from the tree.
+     */
+    void RemoveAll()
+    {
+        VIEW_RTREE_BASE::RemoveAll();
+
+        m_pending.clear();
+        m_dynamic.clear();
+        m_removed.clear();
+        m_packed.clear();
+        m_nodes.clear();
+        m_levels.clear();
     }
 
     /**
@@ -95,10 +132,243 @@ public:
             mmax[0] = mmax[1] = INT_MAX;
         }
 
-        VIEW_RTREE_BASE::Search( mmin, mmax, aVisitor );
+        flush();
+
+        if( !m_levels.empty() && m_nodes.back().Overlaps( mmin, mmax ) )
+        {
+            if( !searchPacked( m_levels.size() - 1, 0, mmin, mmax, aVisitor ) )
+                return;
+        }
+
+        if( !m_dynamic.empty() )
+            VIEW_RTREE_BASE::Search( mmin, mmax, aVisitor );
     }
 
 private:
+    ///> Number of children of the packed tree nodes
+    static constexpr size_t PACKED_NODE_SIZE = 16;
+
+    struct PACKED_BOX
+    {
+        int min[2];
+        int max[2];
+
+        bool Overlaps( const int aMin[2], const int aMax[2] ) const
+        {
+            return min[0] <= aMax[0] && max[0] >= aMin[0]
+                   && min[1] <= aMax[1] && max[1] >= aMin[1];
+        }
+
+        void Merge( const PACKED_BOX& aBox )
+        {
+            for( int i = 0; i < 2; i++ )
+            {
+                min[i] = std::min( min[i], aBox.min[i] );
+                max[i] = std::max( max[i], aBox.max[i] );
+            }
+        }
+
+        int64_t Center( int aAxis ) const
+        {
+            return (int64_t) min[aAxis] + max[aAxis];
+        }
+    };
+
+    struct PACKED_ENTRY
+    {
+        PACKED_BOX box;
+        VIEW_ITEM* item;
+    };
+
+    /**
+     * Indexes the items inserted since the last query, and builds the packed tree
+     * again when it is worth it.
+     */
+    void flush()
+    {
+        if( m_pending.empty() && m_removed.size() * 2 <= m_packed.size() )
+            return;
+
+        size_t packedCount = m_packed.size() - std::min( m_removed.size(), m_packed.size() );
+        size_t dynamicCount = m_dynamic.size() + m_pending.size();
+
+        if( dynamicCount + m_removed.size() > packedCount / 4 )
+        {
+            std::vector<PACKED_ENTRY> entries;
+            entries.reserve( packedCount + dynamicCount );
+
+            for( const PACKED_ENTRY& entry : m_packed )
+            {
+                if( !m_removed.count( entry.item ) )
+                    entries.push_back( entry );
+            }
+
+            for( const auto& dynamic : m_dynamic )
+                entries.push_back( { dynamic.second, dynamic.first } );
+
+            entries.insert( entries.end(), m_pending.begin(), m_pending.end() );
+
+            VIEW_RTREE_BASE::RemoveAll();
+            m_dynamic.clear();
+            m_removed.clear();
+            m_pending.clear();
+
+            buildPacked( entries );
+        }
+        else
+        {
+            for( const PACKED_ENTRY& entry : m_pending )
+            {
+                VIEW_RTREE_BASE::Insert( entry.box.min, entry.box.max, entry.item );
+                m_dynamic[entry.item] = entry.box;
+            }
+
+            m_pending.clear();
+        }
+    }
+
+    /**
+     * Builds the packed tree from aEntries, with the Sort-Tile-Recursive method: the items
+     * are sorted in vertical slices, then each slice from top to bottom, and consecutive
+     * items are grouped into leaf nodes.  The upper levels group consecutive nodes.
+     */
+    void buildPacked( std::vector<PACKED_ENTRY>& aEntries )
+    {
+        m_packed = std::move( aEntries );
+        m_nodes.clear();
+        m_levels.clear();
+
+        if( m_packed.empty() )
+            return;
+
+        size_t leafCount = ( m_packed.size() + PACKED_NODE_SIZE - 1 ) / PACKED_NODE_SIZE;
+        size_t sliceCount = (size_t) std::ceil( std::sqrt( (double) leafCount ) );
+        size_t sliceSize = ( ( leafCount + sliceCount - 1 ) / sliceCount ) * PACKED_NODE_SIZE;
+
+        std::sort( m_packed.begin(), m_packed.end(),
+                []( const PACKED_ENTRY& a, const PACKED_ENTRY& b )
+                {
+                    return a.box.Center( 0 ) < b.box.Center( 0 );
+                } );
+
+        for( size_t first = 0, slice = 0; first < m_packed.size(); first += sliceSize, slice++ )
+        {
+            auto begin = m_packed.begin() + first;
+            auto end = m_packed.begin() + std::min( first + sliceSize, m_packed.size() );
+
+            // Alternate the direction, so that the nodes following each other are close
+            // also at the slice boundaries
+            if( slice % 2 )
+                std::sort( begin, end, []( const PACKED_ENTRY& a, const PACKED_ENTRY& b )
+                        {
+                            return a.box.Center( 1 ) > b.box.Center( 1 );
+                        } );
+            else
+                std::sort( begin, end, []( const PACKED_ENTRY& a, const PACKED_ENTRY& b )
+                        {
+                            return a.box.Center( 1 ) < b.box.Center( 1 );
+                        } );
+        }
+
+        m_levels.push_back( 0 );
+
+        for( size_t first = 0; first < m_packed.size(); first += PACKED_NODE_SIZE )
+        {
+            size_t last = std::min( first + PACKED_NODE_SIZE, m_packed.size() );
+            PACKED_BOX box = m_packed[first].box;
+
+            for( size_t i = first + 1; i < last; i++ )
+                box.Merge( m_packed[i].box );
+
+            m_nodes.push_back( box );
+        }
+
+        while( levelSize( m_levels.size() - 1 ) > 1 )
+        {
+            size_t childStart = m_levels.back();
+            size_t childCount = levelSize( m_levels.size() - 1 );
+
+            m_levels.push_back( m_nodes.size() );
+
+            for( size_t first = 0; first < childCount; first += PACKED_NODE_SIZE )
+            {
+                size_t last = std::min( first + PACKED_NODE_SIZE, childCount );
+                PACKED_BOX box = m_nodes[childStart + first];
+
+                for( size_t i = first + 1; i < last; i++ )
+                    box.Merge( m_nodes[childStart + i] );
+
+                m_nodes.push_back( box );
+            }
+        }
+    }
+
+    size_t levelSize( size_t aLevel ) const
+    {
+        size_t end = aLevel + 1 < m_levels.size() ? m_levels[aLevel + 1] : m_nodes.size();
+
+        return end - m_levels[aLevel];
+    }
+
+    template <class Visitor>
+    bool searchPacked( size_t aLevel, size_t aNode, const int aMin[2], const int aMax[2],
+                       Visitor& aVisitor )
+    {
+        size_t first = aNode * PACKED_NODE_SIZE;
+
+        if( aLevel == 0 )
+        {
+            size_t last = std::min( first + PACKED_NODE_SIZE, m_packed.size() );
+
+            for( size_t i = first; i < last; i++ )
+            {
+                const PACKED_ENTRY& entry = m_packed[i];
+
+                if( !entry.box.Overlaps( aMin, aMax ) )
+                    continue;
+
+                if( !m_removed.empty() && m_removed.count( entry.item ) )
+                    continue;
+
+                if( !aVisitor( entry.item ) )
+                    return false;
+            }
+
+            return true;
+        }
+
+        size_t childStart = m_levels[aLevel - 1];
+        size_t last = std::min( first + PACKED_NODE_SIZE, levelSize( aLevel - 1 ) );
+
+        for( size_t i = first; i < last; i++ )
+        {
+            if( m_nodes[childStart + i].Overlaps( aMin, aMax ) )
+            {
+                if( !searchPacked( aLevel - 1, i, aMin, aMax, aVisitor ) )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    ///> Items inserted since the last query
+    std::vector<PACKED_ENTRY> m_pending;
+
+    ///> Items of the dynamic tree, with the bounding box they were inserted with
+    std::unordered_map<VIEW_ITEM*, PACKED_BOX> m_dynamic;
+
+    ///> Items removed from the packed tree since it was built
+    std::unordered_set<VIEW_ITEM*> m_removed;
+
+    ///> Items of the packed tree, in tree order
+    std::vector<PACKED_ENTRY> m_packed;
+
+    ///> Bounding boxes of the packed tree nodes, level by level from the leaves to the root
+    std::vector<PACKED_BOX> m_nodes;
+
+    ///> Index in m_nodes of the first node of each level
+    std::vector<size_t> m_levels;
 };
 } // namespace KIGFX
 
@@ -31,6 +31,7 @@
 #include <tools/pcb_tool.h>
 #include <tools/pcb_actions.h>
 #include <connectivity/connectivity_data.h>
+#include <drc.h>
 
 #include <functional>
 using namespace std::placeholders;
@@ -66,6 +67,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     auto              connectivity = board->GetConnectivity();
     std::set<EDA_ITEM*>      savedModules;
     std::vector<BOARD_ITEM*> itemsToDeselect;
+    std::vector<BOARD_ITEM*> drcChanged;     // items to give to the online DRC
+    std::vector<BOARD_ITEM*> drcRemoved;
+    std::vector<BOARD_ITEM*> drcPrevious;    // copies of the modified items
 
     if( Empty() )
         return;
@@ -76,6 +80,15 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
         int changeFlags = ent.m_type & CHT_FLAGS;
         BOARD_ITEM* boardItem = static_cast<BOARD_ITEM*>( ent.m_item );
 
+        // Markers are the output of the DRC, not something to test
+        if( !m_editModules && boardItem->Type() != PCB_MARKER_T )
+        {
+            if( changeType == CHT_REMOVE )
+                drcRemoved.push_back( boardItem );
+            else
+                drcChanged.push_back( boardItem );
+        }
+
         // Module items need to be saved in the undo buffer before modification
         if( m_editModules )
         {
@@ -231,15 +244,16 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 }
 
                 if( ent.m_copy )
+                {
                     connectivity->MarkItemNetAsDirty( static_cast<BOARD_ITEM*>( ent.m_copy ) );
 
+                    if( !m_editModules )
+                        drcPrevious.push_back( static_cast<BOARD_ITEM*>( ent.m_copy ) );
+                }
+
                 connectivity->Update( boardItem );
                 view->Update( boardItem );
 
-                // if no undo entry is needed, the copy would create a memory leak
-                if( !aCreateUndoEntry )
-                    delete ent.m_copy;
-
                 break;
             }
 
@@ -267,6 +281,24 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
         connectivity->RecalculateRatsnest();
         connectivity->ClearDynamicRatsnest();
         panel->RedrawRatsnest();
+
+        if( frame->IsType( FRAME_PCB ) && ( drcChanged.size() || drcRemoved.size() ) )
+        {
+            DRC* drc = static_cast<PCB_EDIT_FRAME*>( frame )->GetDrcController();
+
+            if( drc )
+                drc->TestChangedItems( drcChanged, drcRemoved, drcPrevious );
+        }
+    }
+
+    // if no undo entry is needed, the copies would create a memory leak
+    if( !aCreateUndoEntry )
+    {
+        for( COMMIT_LINE& ent : m_changes )
+        {
+            if( ( ent.m_type & CHT_TYPE ) == CHT_MODIFY )
+                delete ent.m_copy;
+        }
     }
 
     if( aSetDirtyBit )
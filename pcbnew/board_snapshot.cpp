@@ -0,0 +1,188 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <board_snapshot.h>
+
+#include <cstring>
+
+#include <fctsys.h>
+#include <wx/filefn.h>
+#include <wx/log.h>
+
+#include <pcb_lexer.h>
+#include <trace_helpers.h>
+
+
+/**
+ * The header of a snapshot file, followed by the token stream
+ */
+struct SNAPSHOT_HEADER
+{
+    char     m_magic[8];
+    uint32_t m_version;         ///< of the snapshot format
+    uint32_t m_reserved;
+    uint64_t m_textSize;        ///< of the board file the snapshot was made from
+    uint64_t m_textHash;
+};
+
+
+static const char SNAPSHOT_MAGIC[8] = { 'K', 'I', 'P', 'C', 'B', 'S', 'N', 'P' };
+
+/// Increment when changing the header or the token stream format
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+
+/**
+ * 64 bits FNV-1a hash.  Not cryptographic, but enough to tell if a file changed.
+ */
+static uint64_t hashText( const char* aText, size_t aSize )
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for( size_t ii = 0; ii < aSize; ++ii )
+    {
+        hash ^= (unsigned char) aText[ii];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+
+BOARD_SNAPSHOT::BOARD_SNAPSHOT( const wxString& aBoardFileName, const char* aText,
+                                size_t aSize ) :
+        m_boardFileName( aBoardFileName ),
+        m_text( aText ),
+        m_size( aSize ),
+        m_hash( hashText( aText, aSize ) )
+{
+}
+
+
+BOARD_SNAPSHOT::~BOARD_SNAPSHOT()
+{
+}
+
+
+wxString BOARD_SNAPSHOT::GetFileName( const wxString& aBoardFileName )
+{
+    return aBoardFileName + wxT( "-snapshot" );
+}
+
+
+bool BOARD_SNAPSHOT::Load()
+{
+    wxString fileName = GetFileName( m_boardFileName );
+
+    if( !wxFileExists( fileName ) )
+        return false;
+
+    try
+    {
+        m_file.reset( new MAPPED_FILE_LINE_READER( fileName ) );
+    }
+    catch( const IO_ERROR& )
+    {
+        return false;
+    }
+
+    SNAPSHOT_HEADER header;
+
+    if( m_file->Size() < sizeof( header ) )
+    {
+        m_file.reset();
+        return false;
+    }
+
+    memcpy( &header, m_file->Data(), sizeof( header ) );
+
+    if( memcmp( header.m_magic, SNAPSHOT_MAGIC, sizeof( header.m_magic ) ) != 0
+            || header.m_version != SNAPSHOT_VERSION
+            || header.m_textSize != m_size
+            || header.m_textHash != m_hash )
+    {
+        wxLogTrace( traceKicadPcbPlugin, "Outdated board snapshot \"%s\"", fileName );
+        m_file.reset();
+        return false;
+    }
+
+    return true;
+}
+
+
+void BOARD_SNAPSHOT::Save()
+{
+    // An outdated snapshot cannot be replaced while mapped, on some platforms
+    m_file.reset();
+
+    SNAPSHOT_HEADER header;
+
+    memcpy( header.m_magic, SNAPSHOT_MAGIC, sizeof( header.m_magic ) );
+    header.m_version = SNAPSHOT_VERSION;
+    header.m_reserved = 0;
+    header.m_textSize = m_size;
+    header.m_textHash = m_hash;
+
+    std::string stream( (const char*) &header, sizeof( header ) );
+
+    STRING_LINE_READER reader( std::string( m_text, m_size ), m_boardFileName );
+    PCB_LEXER          lexer( &reader );
+
+    lexer.WriteTokens( stream );
+
+    // Write a temporary file first, so that a board opened at the same time by another
+    // process never finds a partial snapshot
+    wxString fileName = GetFileName( m_boardFileName );
+    wxString tempName = fileName + wxT( ".tmp" );
+    FILE*    fp = wxFopen( tempName, wxT( "wb" ) );
+
+    if( !fp )
+    {
+        THROW_IO_ERROR( wxString::Format( _( "Unable to open file \"%s\" for writing" ),
+                                          tempName ) );
+    }
+
+    bool written = fwrite( stream.data(), 1, stream.size(), fp ) == stream.size();
+
+    written = ( fclose( fp ) == 0 ) && written;
+
+    if( !written || !wxRenameFile( tempName, fileName, true ) )
+    {
+        wxRemoveFile( tempName );
+        THROW_IO_ERROR( wxString::Format( _( "Unable to write file \"%s\"" ), fileName ) );
+    }
+
+    wxLogTrace( traceKicadPcbPlugin, "Saved board snapshot \"%s\"", fileName );
+}
+
+
+const char* BOARD_SNAPSHOT::GetTokens() const
+{
+    return m_file ? m_file->Data() + sizeof( SNAPSHOT_HEADER ) : NULL;
+}
+
+
+const char* BOARD_SNAPSHOT::GetTokensEnd() const
+{
+    return m_file ? m_file->Data() + m_file->Size() : NULL;
+}
@@ -0,0 +1,85 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef BOARD_SNAPSHOT_H
+#define BOARD_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+
+#include <richio.h>
+
+
+/**
+ * Class BOARD_SNAPSHOT
+ * is the binary sidecar cache of a .kicad_pcb file: the token stream of the file (see
+ * DSNLEXER::WriteTokens()), saved next to it with the size and hash of the text it was
+ * made from.  Parsing the tokens of an up to date snapshot skips lexing the text, which
+ * is most of the time needed to load a board.
+ *
+ * Snapshots are only used when enabled by the "EnableBoardSnapshots" advanced config.
+ */
+class BOARD_SNAPSHOT
+{
+public:
+    /**
+     * @param aBoardFileName is the name of the board file.
+     * @param aText is the content of the board file, of @a aSize bytes.
+     */
+    BOARD_SNAPSHOT( const wxString& aBoardFileName, const char* aText, size_t aSize );
+
+    ~BOARD_SNAPSHOT();
+
+    /**
+     * Function GetFileName
+     * @return the name of the snapshot file of @a aBoardFileName.
+     */
+    static wxString GetFileName( const wxString& aBoardFileName );
+
+    /**
+     * Function Load
+     * maps the snapshot file, if it was made from the current board text.
+     * @return true if GetTokens() is available.
+     */
+    bool Load();
+
+    /**
+     * Function Save
+     * lexes the board text and writes the snapshot file.
+     * @throw IO_ERROR if the text cannot be lexed, or the file cannot be written.
+     */
+    void Save();
+
+    const char* GetTokens() const;
+
+    const char* GetTokensEnd() const;
+
+private:
+    wxString                                 m_boardFileName;
+    const char*                              m_text;
+    size_t                                   m_size;
+    uint64_t                                 m_hash;        ///< of m_text
+    std::unique_ptr<MAPPED_FILE_LINE_READER> m_file;        ///< the loaded snapshot
+};
+
+#endif // BOARD_SNAPSHOT_H
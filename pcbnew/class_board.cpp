@@ -107,6 +107,10 @@ wxPoint BOARD_ITEM::ZeroOffset( 0, 0 );
 // so dummyColorsSettings provide this default initialization
 static COLORS_DESIGN_SETTINGS dummyColorsSettings( FRAME_PCB );
 
+/// The source of the marker generations of all boards
+static unsigned long long s_markersGeneration = 0;
+
+
 BOARD::BOARD() :
     BOARD_ITEM_CONTAINER( (BOARD_ITEM*) NULL, PCB_T ),
         m_paper( PAGE_INFO::A4 ), m_NetInfo( this )
@@ -118,6 +122,7 @@ BOARD::BOARD() :
     m_Status_Pcb    = 0;                    // Status word: bit 1 = calculate.
     m_CurrentZoneContour = NULL;            // This ZONE_CONTAINER handle the
                                             // zone contour currently in progress
+    m_markersGeneration = ++s_markersGeneration;
 
     BuildListOfNets();                      // prepare pad and netlist containers.
 
@@ -881,6 +886,7 @@ void BOARD::Add( BOARD_ITEM* aBoardItem, ADD_MODE aMode )
     // this one uses a vector
     case PCB_MARKER_T:
         m_markers.push_back( (MARKER_PCB*) aBoardItem );
+        m_markersGeneration = ++s_markersGeneration;
         break;
 
     // this one uses a vector
@@ -968,6 +974,7 @@ void BOARD::Remove( BOARD_ITEM* aBoardItem )
             }
         }
 
+        m_markersGeneration = ++s_markersGeneration;
         break;
 
     case PCB_ZONE_AREA_T:    // this one uses a vector
@@ -1020,6 +1027,7 @@ void BOARD::DeleteMARKERs()
         delete marker;
 
     m_markers.clear();
+    m_markersGeneration = ++s_markersGeneration;
 }
 
 
@@ -178,6 +178,9 @@ private:
     /// MARKER_PCBs for clearance problems, owned by pointer.
     MARKERS                 m_markers;
 
+    /// Changed each time m_markers changes, see GetMARKERGeneration()
+    unsigned long long      m_markersGeneration;
+
     /// edge zone descriptors, owned by pointer.
     ZONE_CONTAINERS         m_ZoneDescriptorList;
 
@@ -338,6 +341,17 @@ public:
         return (int) m_markers.size();
     }
 
+    /**
+     * Function GetMARKERGeneration
+     * @return a value which changes each time a marker is added to or removed from the
+     * board.  It is never the same for two different boards, so it tells whether a list
+     * of markers built from a board is still up to date.
+     */
+    unsigned long long GetMARKERGeneration() const
+    {
+        return m_markersGeneration;
+    }
+
     /**
      * Function SetAuxOrigin
      * sets the origin point used for plotting.
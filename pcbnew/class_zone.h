@@ -31,8 +31,10 @@
 #define CLASS_ZONE_H_
 
 
+#include <utility>
 #include <vector>
 #include <gr_basic.h>
+#include <eda_rect.h>
 #include <class_board_item.h>
 #include <board_connected_item.h>
 #include <layers_id_colors_and_visibility.h>
@@ -45,6 +47,26 @@ class LINE_READER;
 class EDA_DRAW_PANEL;
 class PCB_EDIT_FRAME;
 class BOARD;
+
+
+/**
+ * Struct ZONE_FILL_INPUTS
+ * holds what the last fill of a zone depends on, so that the zone filler can skip the
+ * next refill, or limit it to the area around the items which changed.
+ */
+struct ZONE_FILL_INPUTS
+{
+    /// An item which can change the fill: its key, and the area of the fill it can change
+    typedef std::pair<size_t, EDA_RECT> ITEM;
+
+    ZONE_FILL_INPUTS() :
+        m_settingsKey( 0 )
+    {
+    }
+
+    size_t              m_settingsKey;  ///< key of the zone outline and settings, 0 if not filled
+    std::vector<ITEM>   m_items;        ///< sorted by key, then by area
+};
 class ZONE_CONTAINER;
 class MSG_PANEL_ITEM;
 
@@ -721,6 +743,13 @@ public:
      */
     void BuildHashValue() { m_filledPolysHash = m_FilledPolysList.GetHash(); }
 
+    /** @return the inputs used by the zone filler to compute m_RawPolysList.
+     * Their settings key is 0 if the raw filled areas cannot be reused.
+     */
+    const ZONE_FILL_INPUTS& GetFillInputs() const { return m_fillInputs; }
+
+    void SetFillInputs( const ZONE_FILL_INPUTS& aInputs ) { m_fillInputs = aInputs; }
+
 
 
 #if defined(DEBUG)
@@ -825,6 +854,8 @@ private:
     SHAPE_POLY_SET        m_RawPolysList;
     MD5_HASH              m_filledPolysHash;    // A hash value used in zone filling calculations
                                                 // to see if the filled areas are up to date
+    ZONE_FILL_INPUTS      m_fillInputs;         // Inputs of m_RawPolysList, not copied with
+                                                // the zone because m_RawPolysList is not
 
     HATCH_STYLE           m_hatchStyle;     // hatch style, see enum above
     int                   m_hatchPitch;     // for DIAGONAL_EDGE, distance between 2 hatch lines
@@ -25,11 +25,10 @@
 #include <connectivity/connectivity_algo.h>
 #include <widgets/progress_reporter.h>
 #include <geometry/geometry_utils.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <mutex>
 #include <algorithm>
-#include <future>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -198,7 +197,12 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
     m_itemList.RemoveInvalidItems( garbage );
 
     for( auto item : garbage )
+    {
+        // The ratsnest cluster holding the item must not be kept, even if the net of
+        // its parent was changed before the item was removed
+        MarkNetAsDirty( item->ClusterNet() );
         delete item;
+    }
 
 #ifdef PROFILE
     garbage_collection.Show();
@@ -217,11 +221,10 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 
     if( m_itemList.IsDirty() )
     {
-        size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-                ( dirtyItems.size() + 7 ) / 8 );
+        THREAD_POOL& pool = THREAD_POOL::GetInstance();
+        size_t parallelThreadCount = pool.GetTaskCount( dirtyItems.size(), 8 );
 
         std::atomic<size_t> nextItem( 0 );
-        std::vector<std::future<size_t>> returns( parallelThreadCount );
 
         auto conn_lambda = [&nextItem, &dirtyItems]
                             ( CN_LIST* aItemList, PROGRESS_REPORTER* aReporter) -> size_t
@@ -242,22 +245,13 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
             conn_lambda( &m_itemList, m_progressReporter );
         else
         {
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-                returns[ii] = std::async( std::launch::async, conn_lambda,
-                        &m_itemList, m_progressReporter );
+            TASK_GROUP tasks( pool );
 
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            {
-                // Here we balance returns with a 100ms timeout to allow UI updating
-                std::future_status status;
-                do
-                {
-                    if( m_progressReporter )
-                        m_progressReporter->KeepRefreshing();
+            tasks.Run( [&]() { conn_lambda( &m_itemList, m_progressReporter ); },
+                       parallelThreadCount );
 
-                    status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-                } while( status != std::future_status::ready );
-            }
+            // Keep the UI updating while the tasks run
+            tasks.WaitAndRefresh( m_progressReporter );
         }
 
         if( m_progressReporter )
@@ -290,7 +284,7 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
 
 
 const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUSTER_SEARCH_MODE aMode,
-        const KICAD_T aTypes[], int aSingleNet )
+        const KICAD_T aTypes[], int aSingleNet, const std::vector<bool>* aNets )
 {
     bool withinAnyNet = ( aMode != CSM_PROPAGATE );
 
@@ -301,7 +295,7 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
     if( m_itemList.IsDirty() )
         searchConnections();
 
-    auto addToSearchList = [&head, withinAnyNet, aSingleNet, aTypes] ( CN_ITEM *aItem )
+    auto addToSearchList = [&head, withinAnyNet, aSingleNet, aNets, aTypes] ( CN_ITEM *aItem )
     {
         if( withinAnyNet && aItem->Net() <= 0 )
             return;
@@ -312,6 +306,9 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
         if( aSingleNet >=0 && aItem->Net() != aSingleNet )
             return;
 
+        if( aNets && aItem->Net() < (int) aNets->size() && !(*aNets)[ aItem->Net() ] )
+            return;
+
         bool found = false;
 
         for( int i = 0; aTypes[i] != EOT; i++ )
@@ -564,7 +561,52 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLAT
 
 const CN_CONNECTIVITY_ALGO::CLUSTERS& CN_CONNECTIVITY_ALGO::GetClusters()
 {
-    m_ratsnestClusters = SearchClusters( CSM_RATSNEST );
+    constexpr KICAD_T types[] = { PCB_TRACE_T, PCB_PAD_T, PCB_VIA_T, PCB_ZONE_AREA_T, PCB_MODULE_T, EOT };
+
+#ifdef PROFILE
+    PROF_COUNTER clusterUpdate( "update-clusters" );
+#endif
+
+    // Collect the garbage first: it flags the nets of the removed items
+    if( m_itemList.IsDirty() )
+        searchConnections();
+
+    auto isDirty = [this] ( int aNet )
+    {
+        return aNet < 0 || aNet >= (int) m_dirtyClusterNets.size() || m_dirtyClusterNets[aNet];
+    };
+
+    // Ratsnest clusters never span several nets: the clusters of the unchanged nets are
+    // still valid, only the items of the changed nets are searched again
+    CLUSTERS clusters;
+    clusters.reserve( m_ratsnestClusters.size() );
+
+    std::copy_if( m_ratsnestClusters.begin(), m_ratsnestClusters.end(),
+            std::back_inserter( clusters ),
+            [&isDirty] ( const CN_CLUSTER_PTR& aCluster )
+            {
+                return !isDirty( aCluster->OriginNet() );
+            } );
+
+    for( const auto& cluster : SearchClusters( CSM_RATSNEST, types, -1, &m_dirtyClusterNets ) )
+    {
+        for( auto item : *cluster )
+            item->SetClusterNet( cluster->OriginNet() );
+
+        clusters.push_back( cluster );
+    }
+
+    std::sort( clusters.begin(), clusters.end(), []( CN_CLUSTER_PTR a, CN_CLUSTER_PTR b ) {
+        return a->OriginNet() < b->OriginNet();
+    } );
+
+    m_ratsnestClusters = std::move( clusters );
+    std::fill( m_dirtyClusterNets.begin(), m_dirtyClusterNets.end(), false );
+
+#ifdef PROFILE
+    clusterUpdate.Show();
+#endif
+
     return m_ratsnestClusters;
 }
 
@@ -588,6 +630,11 @@ void CN_CONNECTIVITY_ALGO::MarkNetAsDirty( int aNet )
     }
 
     m_dirtyNets[aNet] = true;
+
+    if( (int) m_dirtyClusterNets.size() <= aNet )
+        m_dirtyClusterNets.resize( aNet + 1, true );
+
+    m_dirtyClusterNets[aNet] = true;
 }
 
 
@@ -709,6 +756,7 @@ bool CN_VISITOR::operator()( CN_ITEM* aCandidate )
 void CN_CONNECTIVITY_ALGO::Clear()
 {
     m_ratsnestClusters.clear();
+    m_dirtyClusterNets.clear();
     m_connClusters.clear();
     m_itemMap.clear();
     m_itemList.Clear();
@@ -150,6 +150,9 @@ private:
     CLUSTERS m_connClusters;
     CLUSTERS m_ratsnestClusters;
     std::vector<bool> m_dirtyNets;
+
+    ///> nets whose ratsnest clusters must be searched again by the next GetClusters() call
+    std::vector<bool> m_dirtyClusterNets;
     PROGRESS_REPORTER* m_progressReporter = nullptr;
 
     void    searchConnections();
@@ -220,7 +223,14 @@ public:
     bool    Remove( BOARD_ITEM* aItem );
     bool    Add( BOARD_ITEM* aItem );
 
-    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[], int aSingleNet );
+    /**
+     * Function SearchClusters()
+     * Groups the connected items of types aTypes into clusters.
+     * @param aSingleNet when >= 0, only the items of this net are searched.
+     * @param aNets when not null, only the items of the nets flagged in this list are searched.
+     */
+    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[],
+                                    int aSingleNet, const std::vector<bool>* aNets = nullptr );
     const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode );
 
     void    PropagateNets();
@@ -236,6 +246,12 @@ public:
 
     bool    CheckConnectivity( std::vector<CN_DISJOINT_NET_ENTRY>& aReport );
 
+    /**
+     * Function GetClusters()
+     * Returns the ratsnest clusters of the board.  Only the clusters of the nets changed
+     * since the previous call are searched again, the other ones are kept as they are, so
+     * that moving a few items on a large board does not cluster the whole board.
+     */
     const CLUSTERS& GetClusters();
     int             GetUnconnectedCount();
 
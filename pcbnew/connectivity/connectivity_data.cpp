@@ -27,13 +27,13 @@
 #include <profile.h>
 #endif
 
-#include <thread>
 #include <algorithm>
-#include <future>
+#include <atomic>
 
 #include <connectivity/connectivity_data.h>
 #include <connectivity/connectivity_algo.h>
 #include <ratsnest_data.h>
+#include <thread_pool.h>
 
 CONNECTIVITY_DATA::CONNECTIVITY_DATA()
 {
@@ -106,12 +106,11 @@ void CONNECTIVITY_DATA::updateRatsnest()
     std::copy_if( m_nets.begin() + 1, m_nets.end(), std::back_inserter( dirty_nets ),
             [] ( RN_NET* aNet ) { return aNet->IsDirty() && aNet->GetNodeCount() > 0; } );
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( dirty_nets.size() + 7 ) / 8 );
+    // We don't want to start a new task for fewer than 8 nets (overhead costs)
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    size_t parallelThreadCount = pool.GetTaskCount( dirty_nets.size(), 8 );
 
     std::atomic<size_t> nextNet( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
 
     auto update_lambda = [&nextNet, &dirty_nets]() -> size_t
     {
@@ -125,12 +124,12 @@ void CONNECTIVITY_DATA::updateRatsnest()
         update_lambda();
     else
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
+        TASK_GROUP tasks( pool );
 
-        // Finalize the ratsnest threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
+        tasks.Run( update_lambda, parallelThreadCount );
+
+        // Finalize the ratsnest tasks
+        tasks.Wait();
     }
 
     #ifdef PROFILE
@@ -166,6 +166,9 @@ private:
     ///> visited flag for the BFS scan
     bool m_visited;
 
+    ///> net of the ratsnest cluster holding the item, to invalidate it when the item goes away
+    int m_clusterNet;
+
     ///> can the net propagator modify the netcode?
     bool m_canChangeNet;
 
@@ -193,6 +196,7 @@ public:
         m_parent = aParent;
         m_canChangeNet = aCanChangeNet;
         m_visited = false;
+        m_clusterNet = -1;
         m_valid = true;
         m_dirty = true;
         m_anchors.reserve( 2 );
@@ -306,6 +310,16 @@ public:
         return m_visited;
     }
 
+    void SetClusterNet( int aNet )
+    {
+        m_clusterNet = aNet;
+    }
+
+    int ClusterNet() const
+    {
+        return m_clusterNet;
+    }
+
     bool CanChangeNet() const
     {
         return m_canChangeNet;
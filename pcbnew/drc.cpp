@@ -61,6 +61,13 @@
 #include <geometry/shape_arc.h>
 
 #include <drc/courtyard_overlap.h>
+#include <drc/drc_rtree.h>
+#include <profile.h>
+#include <thread_pool.h>
+
+#include <atomic>
+#include <set>
+#include <unordered_set>
 
 void DRC::ShowDRCDialog( wxWindow* aParent )
 {
@@ -103,9 +110,14 @@ void DRC::ShowDRCDialog( wxWindow* aParent )
 
 void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
 {
+    // Without editor frame, the caller decides what to do with the markers
+    if( m_markerHandler )
+    {
+        m_markerHandler( aMarker );
+    }
     // In legacy routing mode, do not add markers to the board.
     // only shows the drc error message
-    if( m_drcInLegacyRoutingMode )
+    else if( m_drcInLegacyRoutingMode )
     {
         m_pcbEditorFrame->SetMsgPanel( aMarker );
         delete aMarker;
@@ -120,6 +132,25 @@ void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
 }
 
 
+void DRC::addMarkersToPcb( const std::vector<MARKER_PCB*>& aMarkers )
+{
+    if( m_markerHandler || m_drcInLegacyRoutingMode )
+    {
+        for( MARKER_PCB* marker : aMarkers )
+            addMarkerToPcb( marker );
+    }
+    else if( aMarkers.size() )
+    {
+        BOARD_COMMIT commit( m_pcbEditorFrame );
+
+        for( MARKER_PCB* marker : aMarkers )
+            commit.Add( marker );
+
+        commit.Push( wxEmptyString, false, false );
+    }
+}
+
+
 void DRC::DestroyDRCDialog( int aReason )
 {
     if( m_drcDialog )
@@ -136,6 +167,29 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
 {
     m_pcbEditorFrame = aPcbWindow;
     m_pcb = aPcbWindow->GetBoard();
+    m_units = aPcbWindow->GetUserUnits();
+
+    init();
+
+    m_markerFactory.SetUnitsProvider( [=]() { return aPcbWindow->GetUserUnits(); } );
+}
+
+
+DRC::DRC( BOARD* aBoard, EDA_UNITS_T aUnits, MARKER_HANDLER aMarkerHandler )
+{
+    m_pcbEditorFrame = nullptr;
+    m_pcb = aBoard;
+    m_units = aUnits;
+    m_markerHandler = aMarkerHandler;
+
+    init();
+
+    m_markerFactory.SetUnits( aUnits );
+}
+
+
+void DRC::init()
+{
     m_drcDialog  = NULL;
 
     // establish initial values for everything:
@@ -147,10 +201,14 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_refillZones = false;              // Only fill zones if requested by user.
     m_reportAllTrackErrors = false;
     m_testFootprints = false;
+    m_doOnlineTest = true;
 
     m_drcRun = false;
     m_footprintsTested = false;
 
+    m_markersBoard = nullptr;
+    m_markersGeneration = 0;
+
     m_doCreateRptFile = false;
     // m_rptFilename set to empty by its constructor
 
@@ -163,8 +221,12 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_ycliplo = 0;
     m_xcliphi = 0;
     m_ycliphi = 0;
+}
 
-    m_markerFactory.SetUnitsProvider( [=]() { return aPcbWindow->GetUserUnits(); } );
+
+EDA_UNITS_T DRC::userUnits() const
+{
+    return m_pcbEditorFrame ? m_pcbEditorFrame->GetUserUnits() : m_units;
 }
 
 
@@ -225,8 +287,10 @@ int DRC::DrcOnCreatingTrack( TRACK* aRefSegm, TRACK* aList )
 
 int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
 {
-    BOARD* board = m_pcbEditorFrame->GetBoard();
-    BOARD_COMMIT commit( m_pcbEditorFrame );
+    updatePointers();
+
+    BOARD* board = m_pcb;
+    std::vector<MARKER_PCB*> markers;
     int nerrors = 0;
 
     std::vector<SHAPE_POLY_SET> smoothed_polys;
@@ -312,7 +376,7 @@ int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
                 if( smoothed_polys[ia].Contains( currentVertex ) )
                 {
                     if( aCreateMarkers )
-                        commit.Add( m_markerFactory.NewMarker(
+                        markers.push_back( m_markerFactory.NewMarker(
                                 pt, zoneToTest, zoneRef, DRCE_ZONES_INTERSECT ) );
 
                     nerrors++;
@@ -361,7 +425,7 @@ int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
             for( wxPoint pt : conflictPoints )
             {
                 if( aCreateMarkers )
-                    commit.Add( m_markerFactory.NewMarker(
+                    markers.push_back( m_markerFactory.NewMarker(
                             pt, zoneRef, zoneToTest, DRCE_ZONES_TOO_CLOSE ) );
 
                 nerrors++;
@@ -370,7 +434,7 @@ int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
     }
 
     if( aCreateMarkers )
-        commit.Push( wxEmptyString, false, false );
+        addMarkersToPcb( markers );
 
     return nerrors;
 }
@@ -583,10 +647,64 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 }
 
 
+void DRC::RunBatchTests( const PASS_HANDLER& aPassHandler )
+{
+    updatePointers();
+
+    PROF_COUNTER timer;
+
+    auto runPass = [&]( const wxString& aPassName, const std::function<void()>& aTest )
+    {
+        timer.Start();
+        aTest();
+        timer.Stop();
+
+        if( aPassHandler )
+            aPassHandler( aPassName, timer.msecs() );
+    };
+
+    runPass( "outline", [&]() { testOutline(); } );
+
+    bool netclassesOk = true;
+
+    runPass( "netclasses", [&]() { netclassesOk = testNetClasses(); } );
+
+    // Same as RunTests(): when netclasses fail, every item of their nets fails too
+    if( !netclassesOk )
+        return;
+
+    if( m_doPad2PadTest )
+        runPass( "pad_clearances", [&]() { testPad2Pad(); } );
+
+    runPass( "drill_clearances", [&]() { testDrilledHoles(); } );
+    runPass( "track_clearances", [&]() { testTracks( nullptr, false ); } );
+    runPass( "zone_clearances", [&]() { testZones(); } );
+
+    if( m_doUnconnectedTest )
+        runPass( "unconnected", [&]() { testUnconnected(); } );
+
+    if( m_doKeepoutTest )
+        runPass( "keepout_areas", [&]() { testKeepoutAreas(); } );
+
+    runPass( "text_and_graphics", [&]() { testCopperTextAndGraphics(); } );
+
+    if( m_pcb->GetDesignSettings().m_ProhibitOverlappingCourtyards
+        || m_pcb->GetDesignSettings().m_RequireCourtyards )
+    {
+        runPass( "courtyards", [&]() { doFootprintOverlappingDrc(); } );
+    }
+
+    runPass( "disabled_layers", [&]() { testDisabledLayers(); } );
+
+    m_drcRun = true;
+}
+
+
 void DRC::updatePointers()
 {
     // update my pointers, m_pcbEditorFrame is the only unchangeable one
-    m_pcb = m_pcbEditorFrame->GetBoard();
+    if( m_pcbEditorFrame )
+        m_pcb = m_pcbEditorFrame->GetBoard();
 
     if( m_drcDialog )  // Use diag list boxes only in DRC dialog
     {
@@ -608,7 +726,7 @@ bool DRC::doNetClass( const NETCLASSPTR& nc, wxString& msg )
 
     const BOARD_DESIGN_SETTINGS& g = m_pcb->GetDesignSettings();
 
-#define FmtVal( x ) GetChars( StringFromValue( m_pcbEditorFrame->GetUserUnits(), x ) )
+#define FmtVal( x ) GetChars( StringFromValue( userUnits(), x ) )
 
 #if 0   // set to 1 when (if...) BOARD_DESIGN_SETTINGS has a m_MinClearance value
     if( nc->GetClearance() < g.m_MinClearance )
@@ -817,7 +935,7 @@ void DRC::testDrilledHoles()
             if( KiROUND( GetLineLength( checkHole.m_location, refHole.m_location ) )
                     <  checkHole.m_drillRadius + refHole.m_drillRadius + holeToHoleMin )
             {
-                addMarkerToPcb( new MARKER_PCB( m_pcbEditorFrame->GetUserUnits(),
+                addMarkerToPcb( new MARKER_PCB( userUnits(),
                                                 DRCE_DRILLED_HOLES_TOO_CLOSE, refHole.m_location,
                                                 refHole.m_owner, refHole.m_location,
                                                 checkHole.m_owner, checkHole.m_location ) );
@@ -827,17 +945,86 @@ void DRC::testDrilledHoles()
 }
 
 
+/**
+ * Return the area and the layers a pad must be indexed on for the clearance tests.
+ * The hole is tested on all copper layers, even those the pad is not on.
+ */
+static EDA_RECT padClearanceBBox( D_PAD* aPad, LSET* aLayers )
+{
+    EDA_RECT bbox = aPad->GetBoundingBox();
+
+    if( aLayers )
+        *aLayers = aPad->GetLayerSet();
+
+    if( aPad->GetDrillSize().x )
+    {
+        int radius = std::max( aPad->GetDrillSize().x, aPad->GetDrillSize().y ) / 2;
+        bbox.Merge( EDA_RECT( aPad->GetPosition(), wxSize( 0, 0 ) ).Inflate( radius ) );
+
+        if( aLayers )
+            *aLayers |= LSET::AllCuMask();
+    }
+
+    return bbox;
+}
+
+
+int DRC::biggestClearance( const std::vector<TRACK*>& aTracks, const std::vector<D_PAD*>& aPads )
+{
+    int maxClearance = m_pcb->GetDesignSettings().GetBiggestClearanceValue();
+
+    for( TRACK* track : aTracks )
+        maxClearance = std::max( maxClearance, track->GetClearance() );
+
+    for( D_PAD* pad : aPads )
+        maxClearance = std::max( maxClearance, pad->GetClearance() );
+
+    return maxClearance;
+}
+
+
+void DRC::buildClearanceIndex( const std::vector<TRACK*>& aTracks,
+                               const std::vector<D_PAD*>& aPads,
+                               DRC_RTREE& aTrackTree, DRC_RTREE& aPadTree )
+{
+    for( int ii = 0; ii < (int) aTracks.size(); ++ii )
+        aTrackTree.Insert( ii, aTracks[ii]->GetBoundingBox(), aTracks[ii]->GetLayerSet() );
+
+    for( int ii = 0; ii < (int) aPads.size(); ++ii )
+    {
+        LSET     layers;
+        EDA_RECT bbox = padClearanceBBox( aPads[ii], &layers );
+
+        // GetBoundingRadius() caches its value: compute it before the pads are
+        // shared between threads
+        aPads[ii]->GetBoundingRadius();
+
+        aPadTree.Insert( ii, bbox, layers );
+    }
+}
+
+
 void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
 {
+    std::vector<TRACK*> tracks;
+    std::vector<D_PAD*> pads = m_pcb->GetPads();
+
+    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+        tracks.push_back( segm );
+
+    // Two items farther apart than the biggest clearance cannot be in violation, so
+    // only the items found in the bounding box of the reference segment, inflated by
+    // this clearance, are tested.
+    int       maxClearance = biggestClearance( tracks, pads );
+    DRC_RTREE trackTree;
+    DRC_RTREE padTree;
+
+    buildClearanceIndex( tracks, pads, trackTree, padTree );
+
     wxProgressDialog * progressDialog = NULL;
     const int delta = 500;  // This is the number of tests between 2 calls to the
                             // progress bar
-    int count = 0;
-
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
-        count++;
-
-    int deltamax = count/delta;
+    int deltamax = tracks.size() / delta;
 
     if( aShowProgressBar && deltamax > 3 )
     {
@@ -849,41 +1036,443 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
         progressDialog->Update( 0, wxEmptyString );
     }
 
-    int ii = 0;
-    count = 0;
+    // Markers are stored by reference segment, and added to the board in the track
+    // list order once all threads are finished, so the result does not depend on
+    // the thread scheduling.
+    std::vector<std::vector<MARKER_PCB*>> markers( tracks.size() );
 
-    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+    std::atomic<size_t> nextItem( 0 );
+    std::atomic<size_t> doneCount( 0 );
+
+    // We don't want to start a new task for fewer than 100 tracks (overhead costs)
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    size_t parallelThreadCount = pool.GetTaskCount( tracks.size(), 100 );
+    TASK_GROUP tasks( pool );
+
+    // Returns false when the user aborted the test
+    auto updateProgress = [&]() -> bool
     {
-        if( ii++ > delta )
-        {
-            ii = 0;
-            count++;
+        if( !progressDialog )
+            return true;
 
-            if( progressDialog )
-            {
-                if( !progressDialog->Update( count, wxEmptyString ) )
-                    break;  // Aborted by user
+        int count = doneCount / delta;
+
+        if( !progressDialog->Update( std::min( count, deltamax ), wxEmptyString ) )
+            return false;   // Aborted by user
 #ifdef __WXMAC__
-                // Work around a dialog z-order issue on OS X
-                if( count == deltamax )
-                    aActiveWindow->Raise();
+        // Work around a dialog z-order issue on OS X
+        if( count == deltamax )
+            aActiveWindow->Raise();
 #endif
+        return true;
+    };
+
+    auto drc_lambda = [&]() -> size_t
+    {
+        // The clearance test functions store the reference segment geometry in
+        // member variables, so each thread needs its own DRC
+        DRC worker( m_pcb, userUnits(), MARKER_HANDLER() );
+
+        worker.m_board_outlines = m_board_outlines;
+        worker.m_reportAllTrackErrors = m_reportAllTrackErrors;
+
+        std::vector<int>    found;
+        std::vector<TRACK*> nearTracks;
+        std::vector<D_PAD*> nearPads;
+        size_t              num = 0;
+
+        for( size_t i = nextItem++; i < tracks.size() && !tasks.IsCancelled(); i = nextItem++ )
+        {
+            TRACK*   segm = tracks[i];
+            EDA_RECT area = segm->GetBoundingBox();
+
+            area.Inflate( maxClearance + 1 );
+
+            // Each pair of segments is tested once: only test against the next ones
+            trackTree.Query( area, segm->GetLayerSet(), found, i + 1 );
+            nearTracks.clear();
+
+            for( int idx : found )
+                nearTracks.push_back( tracks[idx] );
+
+            padTree.Query( area, segm->GetLayerSet(), found );
+            nearPads.clear();
+
+            for( int idx : found )
+                nearPads.push_back( pads[idx] );
+
+            // Test new segment against tracks and pads, optionally against copper zones
+            worker.doTrackDrc( segm, nearTracks, nearPads, m_doZonesTest, &markers[i] );
+
+            doneCount++;
+            num++;
+
+            // Without worker threads, this is the thread polled for the progress
+            if( parallelThreadCount <= 1 && doneCount % delta == 0 && !updateProgress() )
+                break;
+        }
+
+        return num;
+    };
+
+    if( parallelThreadCount <= 1 )
+        drc_lambda();
+    else
+    {
+        tasks.Run( drc_lambda, parallelThreadCount );
+
+        // Here we poll the tasks with a 100ms timeout to allow UI updating
+        tasks.WaitAndPoll( updateProgress );
+    }
+
+    if( progressDialog )
+        progressDialog->Destroy();
+
+    std::vector<MARKER_PCB*> allMarkers;
+
+    for( std::vector<MARKER_PCB*>& segmMarkers : markers )
+        allMarkers.insert( allMarkers.end(), segmMarkers.begin(), segmMarkers.end() );
+
+    addMarkersToPcb( allMarkers );
+}
+
+
+/**
+ * @return true if aErrorCode is one of the errors reported by the track and pad clearance
+ * tests, i.e. the errors DRC::TestChangedItems() can update.
+ */
+static bool isItemClearanceError( int aErrorCode )
+{
+    switch( aErrorCode )
+    {
+    case DRCE_TRACK_NEAR_THROUGH_HOLE:
+    case DRCE_TRACK_NEAR_PAD:
+    case DRCE_TRACK_NEAR_VIA:
+    case DRCE_VIA_NEAR_VIA:
+    case DRCE_VIA_NEAR_TRACK:
+    case DRCE_TRACK_ENDS1:
+    case DRCE_TRACK_ENDS2:
+    case DRCE_TRACK_ENDS3:
+    case DRCE_TRACK_ENDS4:
+    case DRCE_TRACK_SEGMENTS_TOO_CLOSE:
+    case DRCE_TRACKS_CROSSING:
+    case DRCE_ENDS_PROBLEM1:
+    case DRCE_ENDS_PROBLEM2:
+    case DRCE_ENDS_PROBLEM3:
+    case DRCE_ENDS_PROBLEM4:
+    case DRCE_ENDS_PROBLEM5:
+    case DRCE_PAD_NEAR_PAD1:
+    case DRCE_VIA_HOLE_BIGGER:
+    case DRCE_MICRO_VIA_INCORRECT_LAYER_PAIR:
+    case DRCE_HOLE_NEAR_PAD:
+    case DRCE_TOO_SMALL_TRACK_WIDTH:
+    case DRCE_TOO_SMALL_VIA:
+    case DRCE_TOO_SMALL_MICROVIA:
+    case DRCE_TOO_SMALL_VIA_DRILL:
+    case DRCE_TOO_SMALL_MICROVIA_DRILL:
+    case DRCE_TRACK_NEAR_ZONE:
+    case DRCE_MICRO_VIA_NOT_ALLOWED:
+    case DRCE_BURIED_VIA_NOT_ALLOWED:
+    case DRCE_TRACK_NEAR_EDGE:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+void DRC::updateMarkerIndex()
+{
+    if( m_markersBoard == m_pcb && m_markersGeneration == m_pcb->GetMARKERGeneration() )
+        return;
+
+    m_markersByItem.clear();
+
+    for( int ii = 0; ii < m_pcb->GetMARKERCount(); ++ii )
+    {
+        MARKER_PCB*     marker = m_pcb->GetMARKER( ii );
+        const DRC_ITEM& drcItem = marker->GetReporter();
+
+        if( drcItem.GetMainItemRef() && isItemClearanceError( drcItem.GetErrorCode() ) )
+            m_markersByItem[ drcItem.GetMainItemRef() ].push_back( marker );
+    }
+
+    m_markersBoard = m_pcb;
+    m_markersGeneration = m_pcb->GetMARKERGeneration();
+}
+
+
+void DRC::TestChangedItems( const std::vector<BOARD_ITEM*>& aChanged,
+                            const std::vector<BOARD_ITEM*>& aRemoved,
+                            const std::vector<BOARD_ITEM*>& aPrevious )
+{
+    // Markers are only kept up to date once the user asked for them
+    if( !m_doOnlineTest || !m_drcRun || m_drcInLegacyRoutingMode )
+        return;
+
+    if( m_pcbEditorFrame )
+        m_pcb = m_pcbEditorFrame->GetBoard();
+
+    // The tracks and pads of the commit, where they are and where they were.  Modules
+    // stand for their pads.
+    std::vector<TRACK*>             dirtyTracks;
+    std::vector<D_PAD*>             dirtyPads;
+    std::unordered_set<const void*> removed;
+
+    auto addItem = [&]( BOARD_ITEM* aItem, bool aIsRemoved )
+    {
+        switch( aItem->Type() )
+        {
+        case PCB_MODULE_T:
+            for( D_PAD* pad : static_cast<MODULE*>( aItem )->Pads() )
+            {
+                dirtyPads.push_back( pad );
+
+                if( aIsRemoved )
+                    removed.insert( pad );
             }
+
+            break;
+
+        case PCB_TRACE_T:
+        case PCB_VIA_T:
+            dirtyTracks.push_back( static_cast<TRACK*>( aItem ) );
+
+            if( aIsRemoved )
+                removed.insert( aItem );
+
+            break;
+
+        case PCB_PAD_T:
+            dirtyPads.push_back( static_cast<D_PAD*>( aItem ) );
+
+            if( aIsRemoved )
+                removed.insert( aItem );
+
+            break;
+
+        default:
+            break;
         }
+    };
+
+    for( BOARD_ITEM* item : aChanged )
+        addItem( item, false );
+
+    for( BOARD_ITEM* item : aRemoved )
+        addItem( item, true );
+
+    for( BOARD_ITEM* item : aPrevious )
+        addItem( item, false );
+
+    if( dirtyTracks.empty() && dirtyPads.empty() )
+        return;
+
+    std::vector<TRACK*> allTracks;
+    std::vector<D_PAD*> allPads = m_pcb->GetPads();
+
+    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+        allTracks.push_back( segm );
+
+    int maxClearance = std::max( biggestClearance( allTracks, allPads ),
+                                 biggestClearance( dirtyTracks, dirtyPads ) );
+
+    DRC_RTREE        dirtyTree;
+    std::vector<int> found;
+
+    for( TRACK* track : dirtyTracks )
+        dirtyTree.Insert( 0, track->GetBoundingBox(), track->GetLayerSet() );
+
+    for( D_PAD* pad : dirtyPads )
+    {
+        LSET     layers;
+        EDA_RECT bbox = padClearanceBBox( pad, &layers );
+
+        dirtyTree.Insert( 0, bbox, layers );
+    }
+
+    auto isNearDirtyItem = [&]( EDA_RECT aArea, LSET aLayers, int aDistance ) -> bool
+    {
+        aArea.Inflate( aDistance );
+        dirtyTree.Query( aArea, aLayers, found );
+
+        return !found.empty();
+    };
+
+    // The markers of the items within the clearance of a dirty item are tested again, as
+    // in a full run.  Their neighbors are within twice this distance of the dirty items,
+    // so the items farther away are left out of the tests.  The lists keep the board
+    // order, which is the order of the tests of testTracks().
+    std::vector<TRACK*>        tracks;
+    std::vector<D_PAD*>        pads;
+    std::vector<bool>          retestTrack;
+    std::unordered_set<D_PAD*> retestPads;
+
+    for( TRACK* track : allTracks )
+    {
+        EDA_RECT bbox = track->GetBoundingBox();
 
-        // Test new segment against tracks and pads, optionally against copper zones
-        if( !doTrackDrc( segm, segm->Next(), true, m_doZonesTest ) )
+        if( !isNearDirtyItem( bbox, LSET::AllCuMask(), 2 * ( maxClearance + 1 ) ) )
+            continue;
+
+        tracks.push_back( track );
+        retestTrack.push_back( isNearDirtyItem( bbox, track->GetLayerSet(), maxClearance + 1 ) );
+    }
+
+    for( D_PAD* pad : allPads )
+    {
+        LSET     layers;
+        EDA_RECT bbox = padClearanceBBox( pad, &layers );
+
+        if( !isNearDirtyItem( bbox, LSET::AllCuMask(), 2 * ( maxClearance + 1 ) ) )
+            continue;
+
+        pads.push_back( pad );
+
+        if( isNearDirtyItem( bbox, layers, maxClearance + 1 ) )
+            retestPads.insert( pad );
+    }
+
+    DRC_RTREE trackTree;
+    DRC_RTREE padTree;
+
+    buildClearanceIndex( tracks, pads, trackTree, padTree );
+
+    std::unordered_set<const void*> retested;
+    std::vector<MARKER_PCB*>        newMarkers;
+    std::vector<TRACK*>             nearTracks;
+    std::vector<D_PAD*>             nearPads;
+
+    for( int ii = 0; ii < (int) tracks.size(); ++ii )
+    {
+        if( !retestTrack[ii] )
+            continue;
+
+        TRACK*   segm = tracks[ii];
+        EDA_RECT area = segm->GetBoundingBox();
+
+        area.Inflate( maxClearance + 1 );
+        retested.insert( segm );
+
+        trackTree.Query( area, segm->GetLayerSet(), found, ii + 1 );
+        nearTracks.clear();
+
+        for( int idx : found )
+            nearTracks.push_back( tracks[idx] );
+
+        padTree.Query( area, segm->GetLayerSet(), found );
+        nearPads.clear();
+
+        for( int idx : found )
+            nearPads.push_back( pads[idx] );
+
+        doTrackDrc( segm, nearTracks, nearPads, m_doZonesTest, &newMarkers );
+    }
+
+    if( m_doPad2PadTest && !retestPads.empty() )
+    {
+        // As in testPad2Pad(), each pad is tested against the next ones in X then Y order
+        int maxSize = 0;
+
+        for( D_PAD* pad : allPads )
+            maxSize = std::max( maxSize, pad->GetBoundingRadius() );
+
+        std::sort( pads.begin(), pads.end(), []( D_PAD* aFirst, D_PAD* aSecond )
+                                             {
+                                                 if( aFirst->GetPosition().x
+                                                         == aSecond->GetPosition().x )
+                                                     return aFirst->GetPosition().y
+                                                            < aSecond->GetPosition().y;
+
+                                                 return aFirst->GetPosition().x
+                                                        < aSecond->GetPosition().x;
+                                             } );
+
+        D_PAD** listEnd = &pads[0] + pads.size();
+
+        for( unsigned ii = 0; ii < pads.size(); ++ii )
         {
-            if( m_currentMarker )
+            D_PAD* pad = pads[ii];
+
+            if( !retestPads.count( pad ) )
+                continue;
+
+            int x_limit = maxSize + pad->GetClearance() + pad->GetBoundingRadius()
+                          + pad->GetPosition().x;
+
+            retested.insert( pad );
+
+            if( !doPadToPadsDrc( pad, &pads[ii], listEnd, x_limit ) )
             {
-                addMarkerToPcb ( m_currentMarker );
+                wxASSERT( m_currentMarker );
+                newMarkers.push_back( m_currentMarker );
                 m_currentMarker = nullptr;
             }
         }
     }
 
-    if( progressDialog )
-        progressDialog->Destroy();
+    // The tests above rebuilt all the markers of the retested items
+    std::vector<MARKER_PCB*> staleMarkers;
+
+    updateMarkerIndex();
+
+    auto takeMarkers = [&]( const void* aItem )
+    {
+        auto it = m_markersByItem.find( aItem );
+
+        if( it != m_markersByItem.end() )
+        {
+            staleMarkers.insert( staleMarkers.end(), it->second.begin(), it->second.end() );
+            m_markersByItem.erase( it );
+        }
+    };
+
+    for( const void* item : retested )
+        takeMarkers( item );
+
+    for( const void* item : removed )
+        takeMarkers( item );
+
+    if( staleMarkers.empty() && newMarkers.empty() )
+        return;
+
+    if( m_pcbEditorFrame )
+    {
+        // Markers are not undoable items: the commit only updates the view and the selection
+        BOARD_COMMIT commit( m_pcbEditorFrame );
+
+        for( MARKER_PCB* marker : staleMarkers )
+            commit.Remove( marker );
+
+        for( MARKER_PCB* marker : newMarkers )
+            commit.Add( marker );
+
+        commit.Push( wxEmptyString, false, false );
+
+        // Without undo entry, nothing owns the removed markers anymore
+        for( MARKER_PCB* marker : staleMarkers )
+            delete marker;
+
+        for( MARKER_PCB* marker : newMarkers )
+            m_markersByItem[ marker->GetReporter().GetMainItemRef() ].push_back( marker );
+
+        m_markersGeneration = m_pcb->GetMARKERGeneration();
+    }
+    else
+    {
+        for( MARKER_PCB* marker : staleMarkers )
+        {
+            m_pcb->Remove( marker );
+            delete marker;
+        }
+
+        // The marker handler decides where the new markers go: index them again next time
+        addMarkersToPcb( newMarkers );
+        m_markersBoard = nullptr;
+    }
+
+    updatePointers();
 }
 
 
@@ -908,7 +1497,7 @@ void DRC::testUnconnected()
         auto src = edge.GetSourcePos();
         auto dst = edge.GetTargetPos();
 
-        m_unconnected.emplace_back( new DRC_ITEM( m_pcbEditorFrame->GetUserUnits(),
+        m_unconnected.emplace_back( new DRC_ITEM( userUnits(),
                                                   DRCE_UNCONNECTED_ITEMS,
                                                   edge.GetSourceNode()->Parent(),
                                                   wxPoint( src.x, src.y ),
@@ -1257,7 +1846,7 @@ void DRC::testOutline()
 
 void DRC::testDisabledLayers()
 {
-    BOARD* board = m_pcbEditorFrame->GetBoard();
+    BOARD* board = m_pcb;
     wxCHECK( board, /*void*/ );
     LSET disabledLayers = board->GetEnabledLayers().flip();
 
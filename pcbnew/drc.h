@@ -31,10 +31,12 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include <geometry/seg.h>
 #include <geometry/shape_poly_set.h>
 
 #include <drc/drc_marker_factory.h>
+#include <drc/drc_provider.h>
 
 #define OK_DRC  0
 #define BAD_DRC 1
@@ -122,6 +124,7 @@ class ZONE_CONTAINER;
 class TRACK;
 class MARKER_PCB;
 class DRC_ITEM;
+class DRC_RTREE;
 class NETCLASS;
 class EDA_TEXT;
 class DRAWSEGMENT;
@@ -189,6 +192,13 @@ class DRC
 {
     friend class DIALOG_DRC_CONTROL;
 
+public:
+    /// Receives the markers when the DRC is not attached to an editor frame
+    typedef DRC_PROVIDER::MARKER_HANDLER MARKER_HANDLER;
+
+    /// Called by RunBatchTests() after each test pass, with its name and its duration
+    typedef std::function<void( const wxString& aPassName, double aMsecs )> PASS_HANDLER;
+
 private:
 
     //  protected or private functions() are lowercase first character.
@@ -200,6 +210,7 @@ private:
     bool     m_refillZones;             // refill zones if requested (by user).
     bool     m_reportAllTrackErrors;    // Report all tracks errors (or only 4 first errors)
     bool     m_testFootprints;          // Test footprints against schematic
+    bool     m_doOnlineTest;            // update the markers of the items changed by a commit
 
     wxString m_rptFilename;
 
@@ -237,11 +248,19 @@ private:
     int                 m_ycliphi;
 
     PCB_EDIT_FRAME*     m_pcbEditorFrame;   ///< The pcb frame editor which owns the board
+                                            ///< (NULL when run from a command line tool)
     BOARD*              m_pcb;
+    EDA_UNITS_T         m_units;            ///< Units used in messages without editor frame
+    MARKER_HANDLER      m_markerHandler;    ///< Receives the markers without editor frame
     SHAPE_POLY_SET      m_board_outlines;   ///< The board outline including cutouts
     DIALOG_DRC_CONTROL* m_drcDialog;
     DRC_MARKER_FACTORY  m_markerFactory; ///< Class that generates markers
 
+    /// The clearance markers of m_markersBoard by main item, see updateMarkerIndex()
+    std::unordered_map<const void*, std::vector<MARKER_PCB*>> m_markersByItem;
+    BOARD*              m_markersBoard;
+    unsigned long long  m_markersGeneration;    ///< marker generation of m_markersBoard
+
     DRC_LIST            m_unconnected;      ///< list of unconnected pads, as DRC_ITEMs
     DRC_LIST            m_footprints;       ///< list of footprint warnings, as DRC_ITEMs
     bool                m_drcRun;
@@ -253,11 +272,46 @@ private:
      */
     void updatePointers();
 
+    /**
+     * @return the biggest clearance used by the board and by the given items.  Two items
+     * farther apart than this distance cannot be in violation.
+     */
+    int biggestClearance( const std::vector<TRACK*>& aTracks, const std::vector<D_PAD*>& aPads );
+
+    /**
+     * Index tracks and pads for the clearance tests.  The items are stored in the trees
+     * by their index in aTracks and aPads.
+     */
+    void buildClearanceIndex( const std::vector<TRACK*>& aTracks,
+                              const std::vector<D_PAD*>& aPads,
+                              DRC_RTREE& aTrackTree, DRC_RTREE& aPadTree );
+
+    /**
+     * Set the default values of the settings, shared by the constructors.
+     */
+    void init();
+
+    /**
+     * @return the units used in the messages of the markers.
+     */
+    EDA_UNITS_T userUnits() const;
+
+    /**
+     * Build m_markersByItem again from the markers of the board, unless they did not
+     * change since it was built.
+     */
+    void updateMarkerIndex();
+
     /**
      * Adds a DRC marker to the PCB through the COMMIT mechanism.
      */
     void addMarkerToPcb( MARKER_PCB* aMarker );
 
+    /**
+     * Adds several DRC markers to the PCB in a single commit.
+     */
+    void addMarkersToPcb( const std::vector<MARKER_PCB*>& aMarkers );
+
     //-----<categorical group tests>-----------------------------------------
 
     /**
@@ -274,6 +328,9 @@ private:
     /**
      * Perform the DRC on all tracks.
      *
+     * Tracks and pads are indexed in per-layer R-trees, and the segments are tested
+     * in parallel.  Markers are added to the board in the track list order.
+     *
      * This test can take a while, a progress bar can be displayed
      * @param aActiveWindow = the active window ued as parent for the progress bar
      * @param aShowProgressBar = true to show a progress bar
@@ -337,6 +394,24 @@ private:
     bool doTrackDrc( TRACK* aRefSeg, TRACK* aStart,
                      bool aTestPads, bool aTestZones );
 
+    /**
+     * Test the current segment against a given set of tracks and pads.
+     *
+     * This variant does not walk the board lists: it is used with the items found in a
+     * spatial index, and can run in a worker thread when aMarkers is given.
+     *
+     * @param aRefSeg The segment to test
+     * @param aTracks the tracks to test against aRefSeg, in the order of the track list
+     * @param aPads the pads to test against aRefSeg
+     * @param aTestZones true if should do copper zones test. This can be very time consumming
+     * @param aMarkers if not NULL, the new markers are appended to this list instead of
+     *                 being added to the board
+     * @return bool - true if no problems, else false.
+     */
+    bool doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                     const std::vector<D_PAD*>& aPads, bool aTestZones,
+                     std::vector<MARKER_PCB*>* aMarkers );
+
     /**
      * Test the current segment or via.
      *
@@ -420,6 +495,12 @@ private:
 public:
     DRC( PCB_EDIT_FRAME* aPcbWindow );
 
+    /**
+     * Create a DRC not attached to an editor frame, to run the tests from a command line
+     * tool.  The markers are not added to the board, but given to aMarkerHandler.
+     */
+    DRC( BOARD* aBoard, EDA_UNITS_T aUnits, MARKER_HANDLER aMarkerHandler );
+
     ~DRC();
 
     /**
@@ -498,6 +579,52 @@ public:
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
 
+    /**
+     * Run, without user interface, all the tests of RunTests() which do not need the editor
+     * frame.  The zone fills are used as they are: they are neither refilled nor checked
+     * for being up to date.  The zone to zone clearances are tested.  Footprints are not
+     * tested against the schematic.
+     *
+     * @param aPassHandler if not empty, is called after each test pass
+     */
+    void RunBatchTests( const PASS_HANDLER& aPassHandler );
+
+    /**
+     * @return the unconnected items found by the last run of the tests.
+     */
+    const DRC_LIST& GetUnconnectedItems() const
+    {
+        return m_unconnected;
+    }
+
+    /**
+     * Update the clearance markers after a change of the board.
+     *
+     * The tracks, vias and pads within the biggest clearance of a changed item, where it
+     * is or where it was, are tested again as in a full run, and their markers replace
+     * the previous ones.  The markers of the other items cannot change.  This is called
+     * by BOARD_COMMIT::Push(), and does nothing until the DRC was run once on the board.
+     *
+     * Without editor frame, the stale markers are deleted from the board and the new ones
+     * are given to the marker handler.
+     *
+     * @param aChanged the items added or modified
+     * @param aRemoved the items removed from the board. They are not tested, but their
+     *                 markers are deleted.
+     * @param aPrevious copies of the modified items as they were before the change, only
+     *                  used for their position
+     */
+    void TestChangedItems( const std::vector<BOARD_ITEM*>& aChanged,
+                           const std::vector<BOARD_ITEM*>& aRemoved,
+                           const std::vector<BOARD_ITEM*>& aPrevious );
+
+    /**
+     * Enable or disable the update of the markers when the board is modified.
+     */
+    void SetOnlineTest( bool aEnable ) { m_doOnlineTest = aEnable; }
+
+    bool IsOnlineTestEnabled() const { return m_doOnlineTest; }
+
     /**
      * @return a pointer to the current marker (last created marker
      */
@@ -0,0 +1,138 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#ifndef DRC_DRC_RTREE__H
+#define DRC_DRC_RTREE__H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <eda_rect.h>
+#include <layers_id_colors_and_visibility.h>
+
+#include <geometry/rtree.h>
+
+
+/**
+ * Class DRC_RTREE
+ * Implements one R-tree per board layer, used by the DRC to find the items that can be
+ * close enough to a given item to violate a clearance rule.
+ *
+ * Items are not stored directly: the tree holds indices into a list owned by the caller.
+ * Query() returns them sorted and without duplicates, so the order of the tests run
+ * on the result does not depend on the shape of the tree.
+ *
+ * Once built, the tree can be queried from several threads at the same time.
+ */
+class DRC_RTREE
+{
+public:
+    typedef RTree<int, int, 2, double> LAYER_TREE;
+
+    DRC_RTREE() :
+        m_count( 0 )
+    {
+    }
+
+    /**
+     * Function Insert()
+     * Adds the item at index aIndex, having the bounding box aBBox, to the tree of each
+     * layer of aLayers.
+     */
+    void Insert( int aIndex, const EDA_RECT& aBBox, LSET aLayers )
+    {
+        EDA_RECT  bbox = aBBox;
+        bbox.Normalize();
+
+        const int mmin[2] = { bbox.GetX(), bbox.GetY() };
+        const int mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+        for( LSEQ seq = aLayers.Seq();  seq;  ++seq )
+        {
+            std::unique_ptr<LAYER_TREE>& tree = m_trees[ *seq ];
+
+            if( !tree )
+                tree.reset( new LAYER_TREE );
+
+            tree->Insert( mmin, mmax, aIndex );
+        }
+
+        m_count++;
+    }
+
+    /**
+     * Function Query()
+     * Stores in aResult the indices of all items on one of the layers of aLayers whose
+     * bounding box intersects aArea.  aResult is sorted by increasing index.
+     * @param aMinIndex is the lowest index reported. Items below it are skipped.
+     */
+    void Query( const EDA_RECT& aArea, LSET aLayers, std::vector<int>& aResult,
+                int aMinIndex = 0 ) const
+    {
+        EDA_RECT  area = aArea;
+        area.Normalize();
+
+        const int mmin[2] = { area.GetX(), area.GetY() };
+        const int mmax[2] = { area.GetRight(), area.GetBottom() };
+
+        aResult.clear();
+
+        auto visitor = [&]( const int& aIndex ) -> bool
+        {
+            if( aIndex >= aMinIndex )
+                aResult.push_back( aIndex );
+
+            return true;
+        };
+
+        for( LSEQ seq = aLayers.Seq();  seq;  ++seq )
+        {
+            const std::unique_ptr<LAYER_TREE>& tree = m_trees[ *seq ];
+
+            if( tree )
+                tree->Search( mmin, mmax, visitor );
+        }
+
+        // Items on several layers (vias, through hole pads) are found once per layer
+        std::sort( aResult.begin(), aResult.end() );
+        aResult.erase( std::unique( aResult.begin(), aResult.end() ), aResult.end() );
+    }
+
+    /**
+     * Function size()
+     * @return the number of items inserted in the tree.
+     */
+    int size() const
+    {
+        return m_count;
+    }
+
+private:
+    std::unique_ptr<LAYER_TREE> m_trees[PCB_LAYER_ID_COUNT];
+    int                         m_count;
+};
+
+
+#endif // DRC_DRC_RTREE__H
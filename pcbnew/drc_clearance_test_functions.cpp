@@ -137,7 +137,24 @@ bool convex2pointDRC( wxPoint* aTref, int aTrefCount, wxPoint aPcompare, int aDi
 
 bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool aTestPads, bool aTestZones )
 {
-    TRACK*    track;
+    std::vector<TRACK*> tracks;
+
+    for( TRACK* track = aStart; track; track = track->Next() )
+        tracks.push_back( track );
+
+    std::vector<D_PAD*> pads;
+
+    if( aTestPads )
+        pads = m_pcb->GetPads();
+
+    return doTrackDrc( aRefSeg, tracks, pads, aTestZones, nullptr );
+}
+
+
+bool DRC::doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                      const std::vector<D_PAD*>& aPads, bool aTestZones,
+                      std::vector<MARKER_PCB*>* aMarkers )
+{
     wxPoint   delta;           // length on X and Y axis of segments
     LSET layerMask;
     int       net_code_ref;
@@ -147,9 +164,15 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool aTestPads, bool aTestZ
 
     auto commitMarkers = [&]()
     {
+        // The caller wants to commit the markers itself
+        if( aMarkers )
+        {
+            aMarkers->insert( aMarkers->end(), markers.begin(), markers.end() );
+            markers.clear();
+        }
         // In legacy routing mode, do not add markers to the board.
         // only shows the drc error message
-        if( m_drcInLegacyRoutingMode )
+        else if( m_drcInLegacyRoutingMode )
         {
             while( markers.size() > 0 )
             {
@@ -160,12 +183,7 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool aTestPads, bool aTestZ
         }
         else
         {
-            BOARD_COMMIT commit( m_pcbEditorFrame );
-
-            for( auto marker : markers )
-                commit.Add( marker );
-
-            commit.Push( wxEmptyString, false, false );
+            addMarkersToPcb( markers );
         }
     };
 
@@ -354,70 +372,62 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool aTestPads, bool aTestZ
     dummypad.SetLayerSet( LSET::AllCuMask() );     // Ensure the hole is on all layers
 
     // Compute the min distance to pads
-    if( aTestPads )
+    for( D_PAD* pad : aPads )
     {
-        unsigned pad_count = m_pcb->GetPadCount();
+        SEG padSeg( pad->GetPosition(), pad->GetPosition() );
 
-        auto pads = m_pcb->GetPads();
 
-        for( unsigned ii = 0; ii < pad_count; ++ii )
+        /* No problem if pads are on another layer,
+         * But if a drill hole exists	(a pad on a single layer can have a hole!)
+         * we must test the hole
+         */
+        if( !( pad->GetLayerSet() & layerMask ).any() )
         {
-            D_PAD* pad = pads[ii];
-            SEG padSeg( pad->GetPosition(), pad->GetPosition() );
-
-
-            /* No problem if pads are on another layer,
-             * But if a drill hole exists	(a pad on a single layer can have a hole!)
-             * we must test the hole
+            /* We must test the pad hole. In order to use the function
+             * checkClearanceSegmToPad(),a pseudo pad is used, with a shape and a
+             * size like the hole
              */
-            if( !( pad->GetLayerSet() & layerMask ).any() )
-            {
-                /* We must test the pad hole. In order to use the function
-                 * checkClearanceSegmToPad(),a pseudo pad is used, with a shape and a
-                 * size like the hole
-                 */
-                if( pad->GetDrillSize().x == 0 )
-                    continue;
-
-                dummypad.SetSize( pad->GetDrillSize() );
-                dummypad.SetPosition( pad->GetPosition() );
-                dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_SHAPE_OBLONG ?
-                                   PAD_SHAPE_OVAL : PAD_SHAPE_CIRCLE );
-                dummypad.SetOrientation( pad->GetOrientation() );
-
-                m_padToTestPos = dummypad.GetPosition() - origin;
-
-                if( !checkClearanceSegmToPad( &dummypad, aRefSeg->GetWidth(),
-                                              netclass->GetClearance() ) )
-                {
-                    markers.push_back( m_markerFactory.NewMarker(
-                            aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_THROUGH_HOLE ) );
-
-                    if( !handleNewMarker() )
-                        return false;
-                }
-
+            if( pad->GetDrillSize().x == 0 )
                 continue;
-            }
 
-            // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
-            // but no problem if the pad netcode is the current netcode (same net)
-            if( pad->GetNetCode()                       // the pad must be connected
-               && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
-                continue;
+            dummypad.SetSize( pad->GetDrillSize() );
+            dummypad.SetPosition( pad->GetPosition() );
+            dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_SHAPE_OBLONG ?
+                               PAD_SHAPE_OVAL : PAD_SHAPE_CIRCLE );
+            dummypad.SetOrientation( pad->GetOrientation() );
 
-            // DRC for the pad
-            shape_pos = pad->ShapePos();
-            m_padToTestPos = shape_pos - origin;
+            m_padToTestPos = dummypad.GetPosition() - origin;
 
-            if( !checkClearanceSegmToPad( pad, aRefSeg->GetWidth(), aRefSeg->GetClearance( pad ) ) )
+            if( !checkClearanceSegmToPad( &dummypad, aRefSeg->GetWidth(),
+                                          netclass->GetClearance() ) )
             {
-                markers.push_back(
-                        m_markerFactory.NewMarker( aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_PAD ) );
+                markers.push_back( m_markerFactory.NewMarker(
+                        aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_THROUGH_HOLE ) );
 
                 if( !handleNewMarker() )
                     return false;
             }
+
+            continue;
+        }
+
+        // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
+        // but no problem if the pad netcode is the current netcode (same net)
+        if( pad->GetNetCode()                       // the pad must be connected
+           && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
+            continue;
+
+        // DRC for the pad
+        shape_pos = pad->ShapePos();
+        m_padToTestPos = shape_pos - origin;
+
+        if( !checkClearanceSegmToPad( pad, aRefSeg->GetWidth(), aRefSeg->GetClearance( pad ) ) )
+        {
+            markers.push_back(
+                    m_markerFactory.NewMarker( aRefSeg, pad, padSeg, DRCE_TRACK_NEAR_PAD ) );
+
+            if( !handleNewMarker() )
+                return false;
         }
     }
 
@@ -431,7 +441,7 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool aTestPads, bool aTestZ
     wxPoint segStartPoint;
     wxPoint segEndPoint;
 
-    for( track = aStart; track; track = track->Next() )
+    for( TRACK* track : aTracks )
     {
         // No problem if segments have the same net code:
         if( net_code_ref == track->GetNetCode() )
@@ -727,7 +737,16 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool aTestPads, bool aTestZ
             SHAPE_POLY_SET* outline = const_cast<SHAPE_POLY_SET*>( &zone->GetFilledPolysList() );
 
             if( outline->Distance( refSeg, aRefSeg->GetWidth() ) < clearance )
-                addMarkerToPcb( m_markerFactory.NewMarker( aRefSeg, zone, DRCE_TRACK_NEAR_ZONE ) );
+            {
+                // Zone markers are always kept, and do not fail the test of the segment
+                MARKER_PCB* marker = m_markerFactory.NewMarker( aRefSeg, zone,
+                                                                DRCE_TRACK_NEAR_ZONE );
+
+                if( aMarkers )
+                    aMarkers->push_back( marker );
+                else
+                    addMarkerToPcb( marker );
+            }
         }
     }
 
@@ -41,6 +41,99 @@
 #include <thread>
 #include <mutex>
 
+#include <wx/dir.h>
+
+
+/// Bump it when the format of the footprint info cache files changes
+static const int FP_INFO_CACHE_VERSION = 3;
+
+
+/**
+ * The key telling whether the entries of a library in the list are up to date.
+ *
+ * The plugin timestamp of a .pretty library only sums the modification times of its
+ * footprint files in whole seconds, which renaming a file or copying it with its times
+ * keeps.  The names and sizes of the files of a library directory, and the modification
+ * time of the directory itself, are added to it.  Only the directory is read, not the files.
+ */
+static long long libraryKey( FP_LIB_TABLE* aTable, const wxString& aNickname )
+{
+    unsigned long long key = aTable->GenerateTimestamp( &aNickname );
+    wxString           path = aTable->FindRow( aNickname )->GetFullURI( true );
+
+    auto combine = [&key]( unsigned long long aValue )
+    {
+        key ^= aValue + 0x9e3779b9 + ( key << 6 ) + ( key >> 2 );
+    };
+
+    if( wxDir::Exists( path ) )
+    {
+        wxDir         dir( path );
+        wxArrayString names;
+        wxString      name;
+
+        if( dir.IsOpened() && dir.GetFirst( &name, wxEmptyString, wxDIR_FILES | wxDIR_HIDDEN ) )
+        {
+            do
+            {
+                names.Add( name );
+            } while( dir.GetNext( &name ) );
+        }
+
+        names.Sort();
+
+        for( const wxString& fileName : names )
+        {
+            combine( wxHashTable::MakeKey( fileName ) );
+            combine( wxFileName::GetSize( path + wxFileName::GetPathSeparator() + fileName )
+                             .GetValue() );
+        }
+
+        combine( wxFileModificationTime( path ) );
+    }
+    else if( wxFileName::FileExists( path ) )
+    {
+        // Single file libraries
+        combine( wxFileName::GetSize( path ).GetValue() );
+        combine( wxFileModificationTime( path ) );
+    }
+
+    return (long long) key;
+}
+
+
+/**
+ * The keys of the libraries read by a call to ReadFootprintFiles(), see libraryKey().  The
+ * libraries whose row can not be found are left out: reading them reports the error.
+ *
+ * @return false if the key of a library could not be computed.
+ */
+static bool libraryKeys( FP_LIB_TABLE* aTable, const wxString* aNickname,
+                         std::map<wxString, long long>& aKeys )
+{
+    std::vector<wxString> nicknames;
+    bool                  found = true;
+
+    if( aNickname )
+        nicknames.push_back( *aNickname );
+    else
+        nicknames = aTable->GetLogicalLibs();
+
+    for( const wxString& nickname : nicknames )
+    {
+        try
+        {
+            aKeys[ nickname ] = libraryKey( aTable, nickname );
+        }
+        catch( const IO_ERROR& )
+        {
+            found = false;
+        }
+    }
+
+    return found;
+}
+
 
 void FOOTPRINT_INFO_IMPL::load()
 {
@@ -119,9 +212,16 @@ void FOOTPRINT_LIST_IMPL::loader_job()
 bool FOOTPRINT_LIST_IMPL::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxString* aNickname,
                                               PROGRESS_REPORTER* aProgressReporter )
 {
-    long long int generatedTimestamp = aTable->GenerateTimestamp( aNickname );
+    m_current_timestamps.clear();
+
+    bool          keysFound = libraryKeys( aTable, aNickname, m_current_timestamps );
+    long long int generatedTimestamp = 0;
 
-    if( generatedTimestamp == m_list_timestamp )
+    for( const auto& entry : m_current_timestamps )
+        generatedTimestamp += entry.second;
+
+    // A library whose key is missing is read again, to report its error
+    if( keysFound && generatedTimestamp == m_list_timestamp )
         return true;
 
     m_progress_reporter = aProgressReporter;
@@ -183,19 +283,56 @@ void FOOTPRINT_LIST_IMPL::StartWorkers( FP_LIB_TABLE* aTable, wxString const* aN
     // Clear data before reading files
     m_count_finished.store( 0 );
     m_errors.clear();
-    m_list.clear();
+    m_cached.clear();
     m_threads.clear();
     m_queue_in.clear();
     m_queue_out.clear();
+    m_queued_timestamps.clear();
+
+    std::vector<wxString>         nicknames;
+    std::map<wxString, long long> keptTimestamps;
 
     if( aNickname )
-        m_queue_in.push( *aNickname );
+        nicknames.push_back( *aNickname );
     else
+        nicknames = aTable->GetLogicalLibs();
+
+    // Only read again the libraries which changed since their entries were listed
+    for( const wxString& nickname : nicknames )
     {
-        for( auto const& nickname : aTable->GetLogicalLibs() )
+        auto current = m_current_timestamps.find( nickname );
+
+        if( current == m_current_timestamps.end() )
+        {
+            // No key: the loader will report the error
+            m_queue_in.push( nickname );
+            continue;
+        }
+
+        long long timestamp = current->second;
+        auto      it = m_lib_timestamps.find( nickname );
+
+        if( it != m_lib_timestamps.end() && it->second == timestamp )
+        {
+            keptTimestamps[ nickname ] = timestamp;
+        }
+        else
+        {
+            m_queued_timestamps[ nickname ] = timestamp;
             m_queue_in.push( nickname );
+        }
     }
 
+    for( std::unique_ptr<FOOTPRINT_INFO>& fpinfo : m_list )
+    {
+        if( keptTimestamps.count( fpinfo->GetLibNickname() ) )
+            m_cached.push_back( std::move( fpinfo ) );
+    }
+
+    m_list.clear();
+    m_lib_timestamps = std::move( keptTimestamps );
+    m_current_timestamps.clear();
+
     m_loader->m_total_libs = m_queue_in.size();
 
     for( unsigned i = 0; i < aNThreads; ++i )
@@ -221,7 +358,11 @@ void FOOTPRINT_LIST_IMPL::StopWorkers()
 
     // If we have cancelled in the middle of a load, clear our timestamp to re-load next time
     if( m_cancelled )
+    {
         m_list_timestamp = 0;
+        m_lib_timestamps.clear();
+        m_cached.clear();
+    }
 }
 
 bool FOOTPRINT_LIST_IMPL::JoinWorkers()
@@ -249,20 +390,23 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
     // TODO: blast LOCALE_IO into the sun
 
     SYNC_QUEUE<std::unique_ptr<FOOTPRINT_INFO>> queue_parsed;
+    SYNC_QUEUE<wxString>                        queue_listed;
     std::vector<std::thread>                    threads;
 
     for( size_t ii = 0; ii < std::thread::hardware_concurrency() + 1; ++ii )
     {
-        threads.push_back( std::thread( [this, &queue_parsed]() {
+        threads.push_back( std::thread( [this, &queue_parsed, &queue_listed]() {
             wxString nickname;
 
             while( this->m_queue_out.pop( nickname ) && !m_cancelled )
             {
                 wxArrayString fpnames;
+                bool          listed = false;
 
                 try
                 {
                     m_lib_table->FootprintEnumerate( fpnames, nickname );
+                    listed = true;
                 }
                 catch( const IO_ERROR& ioe )
                 {
@@ -289,6 +433,9 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
                     queue_parsed.move_push( std::unique_ptr<FOOTPRINT_INFO>( fpinfo ) );
                 }
 
+                if( listed && !m_cancelled )
+                    queue_listed.push( nickname );
+
                 if( m_progress_reporter )
                     m_progress_reporter->AdvanceProgress();
 
@@ -313,6 +460,29 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
     while( queue_parsed.pop( fpi ) )
         m_list.push_back( std::move( fpi ) );
 
+    for( std::unique_ptr<FOOTPRINT_INFO>& cached : m_cached )
+        m_list.push_back( std::move( cached ) );
+
+    m_cached.clear();
+
+    // A library is up to date in the list only once all its footprints are in it
+    if( m_cancelled )
+    {
+        m_lib_timestamps.clear();
+    }
+    else
+    {
+        wxString nickname;
+
+        while( queue_listed.pop( nickname ) )
+        {
+            auto it = m_queued_timestamps.find( nickname );
+
+            if( it != m_queued_timestamps.end() )
+                m_lib_timestamps[ nickname ] = it->second;
+        }
+    }
+
     std::sort( m_list.begin(), m_list.end(), []( std::unique_ptr<FOOTPRINT_INFO> const& lhs,
                                                  std::unique_ptr<FOOTPRINT_INFO> const& rhs ) -> bool
                                              {
@@ -351,7 +521,15 @@ void FOOTPRINT_LIST_IMPL::WriteCacheToFile( wxTextFile* aCacheFile )
         aCacheFile->Create();
     }
 
+    aCacheFile->AddLine( wxString::Format( "version %d", FP_INFO_CACHE_VERSION ) );
     aCacheFile->AddLine( wxString::Format( "%lld", m_list_timestamp ) );
+    aCacheFile->AddLine( wxString::Format( "%u", (unsigned) m_lib_timestamps.size() ) );
+
+    for( const std::pair<const wxString, long long>& lib : m_lib_timestamps )
+    {
+        aCacheFile->AddLine( lib.first );
+        aCacheFile->AddLine( wxString::Format( "%lld", lib.second ) );
+    }
 
     for( auto& fpinfo : m_list )
     {
@@ -372,6 +550,7 @@ void FOOTPRINT_LIST_IMPL::WriteCacheToFile( wxTextFile* aCacheFile )
 void FOOTPRINT_LIST_IMPL::ReadCacheFromFile( wxTextFile* aCacheFile )
 {
     m_list_timestamp = 0;
+    m_lib_timestamps.clear();
     m_list.clear();
 
     try
@@ -380,7 +559,31 @@ void FOOTPRINT_LIST_IMPL::ReadCacheFromFile( wxTextFile* aCacheFile )
         {
             aCacheFile->Open();
 
-            aCacheFile->GetFirstLine().ToLongLong( &m_list_timestamp );
+            // Files written by another version are read again from the libraries
+            if( aCacheFile->GetLineCount() < 3
+                    || aCacheFile->GetFirstLine() != wxString::Format( "version %d",
+                                                                       FP_INFO_CACHE_VERSION ) )
+            {
+                aCacheFile->Close();
+                return;
+            }
+
+            unsigned long libCount = 0;
+
+            aCacheFile->GetNextLine().ToLongLong( &m_list_timestamp );
+            aCacheFile->GetNextLine().ToULong( &libCount );
+
+            for( unsigned long ii = 0; ii < libCount; ++ii )
+            {
+                if( aCacheFile->GetCurrentLine() + 2 >= aCacheFile->GetLineCount() )
+                    THROW_IO_ERROR( "truncated footprint info cache" );
+
+                wxString  libNickname = aCacheFile->GetNextLine();
+                long long timestamp = 0;
+
+                aCacheFile->GetNextLine().ToLongLong( &timestamp );
+                m_lib_timestamps[ libNickname ] = timestamp;
+            }
 
             while( aCacheFile->GetCurrentLine() + 6 < aCacheFile->GetLineCount() )
             {
@@ -402,11 +605,15 @@ void FOOTPRINT_LIST_IMPL::ReadCacheFromFile( wxTextFile* aCacheFile )
     {
         // whatever went wrong, invalidate the cache
         m_list_timestamp = 0;
+        m_lib_timestamps.clear();
     }
 
     // Sanity check: an empty list is very unlikely to be correct.
     if( m_list.size() == 0 )
+    {
         m_list_timestamp = 0;
+        m_lib_timestamps.clear();
+    }
 
     if( aCacheFile->IsOpened() )
         aCacheFile->Close();
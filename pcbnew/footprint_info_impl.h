@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -93,6 +94,11 @@ class FOOTPRINT_LIST_IMPL : public FOOTPRINT_LIST
     std::atomic_bool         m_cancelled;
     std::mutex               m_join;
 
+    std::map<wxString, long long> m_lib_timestamps;     ///< Of the libraries in m_list
+    std::map<wxString, long long> m_queued_timestamps;  ///< Of the libraries being read
+    std::map<wxString, long long> m_current_timestamps; ///< Computed by ReadFootprintFiles()
+    FPILIST                       m_cached;             ///< Entries of the unchanged libraries
+
     /**
      * Call aFunc, pushing any IO_ERRORs and std::exceptions it throws onto m_errors.
      *
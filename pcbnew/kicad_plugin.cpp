@@ -44,6 +44,8 @@
 #include <zones.h>
 #include <kicad_plugin.h>
 #include <pcb_parser.h>
+#include <board_snapshot.h>
+#include <advanced_config.h>
 
 #include <wx/dir.h>
 #include <wx/filename.h>
@@ -1916,38 +1918,94 @@ PCB_IO::~PCB_IO()
 
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER    reader( aFileName );
+    // The parser gets the whole file at once, to split it and parse the footprints, tracks
+    // and zones in parallel.  Large files are mapped in memory, the other ones, and the
+    // files which cannot be mapped, are read into a buffer.
+    std::unique_ptr<LINE_READER> reader( OpenFileLineReader( aFileName ) );
+    auto        mapped = dynamic_cast<MAPPED_FILE_LINE_READER*>( reader.get() );
+    std::string text;
+    const char* data;
+    size_t      size;
+
+    if( mapped )
+    {
+        data = mapped->Data();
+        size = mapped->Size();
+    }
+    else
+    {
+        while( reader->ReadLine() )
+            text.append( reader->Line(), reader->Length() );
+
+        data = text.data();
+        size = text.size();
+    }
 
     init( aProperties );
 
-    m_parser->SetLineReader( &reader );
     m_parser->SetBoard( aAppendToMe );
 
-    BOARD* board;
+    BOARD* board = NULL;
 
-    try
-    {
-        board = dynamic_cast<BOARD*>( m_parser->Parse() );
-    }
-    catch( const FUTURE_FORMAT_ERROR& )
-    {
-        // Don't wrap a FUTURE_FORMAT_ERROR in another
-        throw;
-    }
-    catch( const PARSE_ERROR& parse_error )
+    // Snapshots hold whole boards: they are not used when appending
+    std::unique_ptr<BOARD_SNAPSHOT> snapshot;
+
+    if( ADVANCED_CFG::GetCfg().m_enableBoardSnapshots && !aAppendToMe )
     {
-        if( m_parser->IsTooRecent() )
-            throw FUTURE_FORMAT_ERROR( parse_error, m_parser->GetRequiredVersion() );
-        else
-            throw;
+        snapshot.reset( new BOARD_SNAPSHOT( aFileName, data, size ) );
+
+        if( snapshot->Load() )
+        {
+            try
+            {
+                board = m_parser->ParseBoardTokens( snapshot->GetTokens(),
+                                                    snapshot->GetTokensEnd(), aFileName );
+                snapshot.reset();
+            }
+            catch( const PARSE_ERROR& ioe )
+            {
+                // A damaged snapshot: parse the text, which reports errors properly,
+                // with a parser in a clean state.  Other errors, like a cancelled zone
+                // fill conversion, are not related to the snapshot and are passed on.
+                wxLogTrace( traceKicadPcbPlugin, "Board snapshot not loaded: %s", ioe.What() );
+
+                delete m_parser;
+                m_parser = new PCB_PARSER();
+            }
+        }
     }
 
     if( !board )
     {
-        // The parser loaded something that was valid, but wasn't a board.
-        THROW_PARSE_ERROR( _( "this file does not contain a PCB" ),
-                m_parser->CurSource(), m_parser->CurLine(),
-                m_parser->CurLineNumber(), m_parser->CurOffset() );
+        try
+        {
+            board = m_parser->ParseBoard( data, data + size, aFileName );
+        }
+        catch( const FUTURE_FORMAT_ERROR& )
+        {
+            // Don't wrap a FUTURE_FORMAT_ERROR in another
+            throw;
+        }
+        catch( const PARSE_ERROR& parse_error )
+        {
+            if( m_parser->IsTooRecent() )
+                throw FUTURE_FORMAT_ERROR( parse_error, m_parser->GetRequiredVersion() );
+            else
+                throw;
+        }
+
+        if( snapshot )
+        {
+            try
+            {
+                snapshot->Save();
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                // Not being able to write the snapshot does not prevent loading the board
+                wxLogTrace( traceKicadPcbPlugin, "Board snapshot not saved: %s", ioe.What() );
+            }
+        }
     }
 
     // Give the filename to the board if it's new
@@ -406,9 +406,9 @@ BOARD* LEGACY_PLUGIN::Load( const wxString& aFileName, BOARD* aAppendToMe,
     // delete on exception, iff I own m_board, according to aAppendToMe
     unique_ptr<BOARD> deleter( aAppendToMe ? NULL : m_board );
 
-    FILE_LINE_READER    reader( aFileName );
+    unique_ptr<LINE_READER> reader( OpenFileLineReader( aFileName ) );
 
-    m_reader = &reader;          // member function accessibility
+    m_reader = reader.get();     // member function accessibility
 
     checkVersion();
 
@@ -3258,11 +3258,11 @@ void LP_CACHE::Load()
 {
     m_cache_dirty = false;
 
-    FILE_LINE_READER    reader( m_lib_path );
+    unique_ptr<LINE_READER> reader( OpenFileLineReader( m_lib_path ) );
 
-    ReadAndVerifyHeader( &reader );
-    SkipIndex( &reader );
-    LoadModules( &reader );
+    ReadAndVerifyHeader( reader.get() );
+    SkipIndex( reader.get() );
+    LoadModules( reader.get() );
 
     // Remember the file modification time of library file when the
     // cache snapshot was made, so that in a networked environment we will
@@ -231,6 +231,11 @@ void prepareRouteMenu( wxMenu* aParentMenu )
 
     aParentMenu->AppendSeparator();
 
+    AddMenuItem( aParentMenu, ID_MENU_AUTOROUTE_UNROUTED,
+                 _( "&Autoroute Unrouted Connections" ),
+                 _( "Route the unconnected items of the ratsnest with the push & shove router" ),
+                 KiBitmap( ps_router_xpm ) );
+
     AddMenuItem( aParentMenu, ID_MENU_INTERACTIVE_ROUTER_SETTINGS,
                  _( "&Interactive Router Settings..." ),
                  _( "Configure interactive router" ),
@@ -41,8 +41,8 @@
 
 #include <gal/graphics_abstraction_layer.h>
 
+#include <thread_pool.h>
 #include <functional>
-#include <thread>
 using namespace std::placeholders;
 
 const LAYER_NUM GAL_LAYER_ORDER[] =
@@ -146,21 +146,15 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
 
     auto zones = aBoard->Zones();
     std::atomic<size_t> next( 0 );
-    std::atomic<size_t> count_done( 0 );
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    TASK_GROUP triangulation( pool );
 
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    // Zones are triangulated while the other items are added to the view
+    triangulation.Run( [ &next, &zones ]( )
     {
-        std::thread t = std::thread( [ &count_done, &next, &zones ]( )
-        {
-            for( size_t i = next.fetch_add( 1 ); i < zones.size(); i = next.fetch_add( 1 ) )
-                zones[i]->CacheTriangulation();
-
-            count_done++;
-        } );
-
-        t.detach();
-    }
+        for( size_t i = next.fetch_add( 1 ); i < zones.size(); i = next.fetch_add( 1 ) )
+            zones[i]->CacheTriangulation();
+    }, pool.GetTaskCount( zones.size() ) );
 
     if( m_worksheet )
         m_worksheet->SetFileName( TO_UTF8( aBoard->GetFileName() ) );
@@ -183,9 +177,8 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
         m_view->Add( aBoard->GetMARKER( marker_idx ) );
     }
 
-    // Finalize the triangulation threads
-    while( count_done < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    // Finalize the triangulation tasks
+    triangulation.Wait();
 
     // Load zones
     for( auto zone : aBoard->Zones() )
@@ -708,6 +708,7 @@ void PCB_EDIT_FRAME::enableGALSpecificMenus()
         pcbnew_ids id_list[] =
         {
             ID_MENU_INTERACTIVE_ROUTER_SETTINGS,
+            ID_MENU_AUTOROUTE_UNROUTED,
             ID_DIFF_PAIR_BUTT,
             ID_TUNE_SINGLE_TRACK_LEN_BUTT,
             ID_TUNE_DIFF_PAIR_LEN_BUTT,
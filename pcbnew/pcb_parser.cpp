@@ -28,6 +28,11 @@
  */
 
 #include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+
 #include <common.h>
 #include <confirm.h>
 #include <macros.h>
@@ -50,6 +55,7 @@
 #include <zones.h>
 #include <pcb_parser.h>
 #include <convert_basic_shapes_to_polygon.h>    // for RECT_CHAMFER_POSITIONS definition
+#include <thread_pool.h>
 
 using namespace PCB_KEYS_T;
 
@@ -57,6 +63,9 @@ using namespace PCB_KEYS_T;
 void PCB_PARSER::init()
 {
     m_showLegacyZoneWarning = true;
+    m_deferBoardChanges = false;
+    m_deferredZoneNet = false;
+    m_deferredLegacyZoneFill = false;
     m_tooRecent = false;
     m_requiredVersion = 0;
     m_layerIndices.clear();
@@ -582,89 +591,660 @@ BOARD* PCB_PARSER::parseBOARD_unchecked()
         }
     }
 
-    if( m_undefinedLayers.size() > 0 )
+    resolveUndefinedLayers();
+
+    return m_board;
+}
+
+
+void PCB_PARSER::resolveUndefinedLayers()
+{
+    if( m_undefinedLayers.empty() )
+        return;
+
+    bool deleteItems;
+    std::vector<BOARD_ITEM*> deleteList;
+    wxString msg = wxString::Format( _( "Items found on undefined layers.  Do you wish to\n"
+                                        "rescue them to the Cmts.User layer?" ) );
+    wxString details = wxString::Format( _( "Undefined layers:" ) );
+
+    for( const wxString& undefinedLayer : m_undefinedLayers )
+        details += wxT( "\n   " ) + undefinedLayer;
+
+    wxRichMessageDialog dlg( nullptr, msg, _( "Warning" ),
+                             wxYES_NO | wxCANCEL | wxCENTRE | wxICON_WARNING | wxSTAY_ON_TOP );
+    dlg.ShowDetailedText( details );
+    dlg.SetYesNoCancelLabels( _( "Rescue" ), _( "Delete" ), _( "Cancel" ) );
+
+    switch( dlg.ShowModal() )
     {
-        bool deleteItems;
-        std::vector<BOARD_ITEM*> deleteList;
-        wxString msg = wxString::Format( _( "Items found on undefined layers.  Do you wish to\n"
-                                            "rescue them to the Cmts.User layer?" ) );
-        wxString details = wxString::Format( _( "Undefined layers:" ) );
+    case wxID_YES:    deleteItems = false; break;
+    case wxID_NO:     deleteItems = true;  break;
+    case wxID_CANCEL:
+    default:          THROW_IO_ERROR( wxT( "CANCEL" ) );
+    }
+
+    auto visitItem = [&]( BOARD_ITEM* item )
+                        {
+                            if( item->GetLayer() == Rescue )
+                            {
+                                if( deleteItems )
+                                    deleteList.push_back( item );
+                                else
+                                    item->SetLayer( Cmts_User );
+                            }
+                        };
+
+    for( TRACK* segm = m_board->m_Track;  segm;  segm = segm->Next() )
+    {
+        if( segm->Type() == PCB_VIA_T )
+        {
+            VIA*         via = (VIA*) segm;
+            PCB_LAYER_ID top_layer, bottom_layer;
 
-        for( const wxString& undefinedLayer : m_undefinedLayers )
-            details += wxT( "\n   " ) + undefinedLayer;
+            if( via->GetViaType() == VIA_THROUGH )
+                continue;
 
-        wxRichMessageDialog dlg( nullptr, msg, _( "Warning" ),
-                                 wxYES_NO | wxCANCEL | wxCENTRE | wxICON_WARNING | wxSTAY_ON_TOP );
-        dlg.ShowDetailedText( details );
-        dlg.SetYesNoCancelLabels( _( "Rescue" ), _( "Delete" ), _( "Cancel" ) );
+            via->LayerPair( &top_layer, &bottom_layer );
+
+            if( top_layer == Rescue || bottom_layer == Rescue )
+            {
+                if( deleteItems )
+                    deleteList.push_back( via );
+                else
+                {
+                    if( top_layer == Rescue )
+                        top_layer = F_Cu;
+
+                    if( bottom_layer == Rescue )
+                        bottom_layer = B_Cu;
+
+                    via->SetLayerPair( top_layer, bottom_layer );
+                }
+            }
+        }
+        else
+            visitItem( segm );
+    }
+
+    for( BOARD_ITEM* zone : m_board->Zones() )
+        visitItem( zone );
+
+    for( BOARD_ITEM* drawing : m_board->Drawings() )
+        visitItem( drawing );
+
+    for( BOARD_ITEM* item : deleteList )
+        m_board->Delete( item );
+
+    m_undefinedLayers.clear();
+}
+
+
+BOARD_ITEM* PCB_PARSER::parseBoardItem()
+{
+    T token = CurTok();
 
-        switch( dlg.ShowModal() )
+    switch( token )
+    {
+    case T_gr_arc:
+    case T_gr_circle:
+    case T_gr_curve:
+    case T_gr_line:
+    case T_gr_poly:
+        return parseDRAWSEGMENT();
+
+    case T_gr_text:
+        return parseTEXTE_PCB();
+
+    case T_dimension:
+        return parseDIMENSION();
+
+    case T_module:
+        return parseMODULE();
+
+    case T_segment:
+        return parseTRACK();
+
+    case T_via:
+        return parseVIA();
+
+    case T_zone:
+        return parseZONE_CONTAINER();
+
+    case T_target:
+        return parsePCB_TARGET();
+
+    default:
+        wxString err;
+        err.Printf( _( "Unknown token \"%s\"" ), GetChars( FromUTF8() ) );
+        THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+    }
+}
+
+
+/**
+ * Class BOARD_RECORD_READER
+ * reads the lines of a part of a board file held in memory.  Lines are numbered as in
+ * the whole file, so errors are reported at the same place as when parsing the whole
+ * file with a single reader.
+ *
+ * When parsing a token stream, the parser replays the tokens of the record, and the
+ * reader has nothing to read: it only gives the source name for error reports.
+ */
+class BOARD_RECORD_READER : public LINE_READER
+{
+public:
+    /**
+     * @param aLineCount is the number of lines of the file before aBegin.
+     * @param aTokens is true if aBegin .. aEnd is a token stream rather than text.
+     */
+    BOARD_RECORD_READER( const char* aBegin, const char* aEnd, unsigned aLineCount,
+                         const wxString& aSource, bool aTokens = false ) :
+        m_next( aTokens ? aEnd : aBegin ),
+        m_end( aEnd )
+    {
+        m_source  = aSource;
+        m_lineNum = aLineCount;
+    }
+
+    char* ReadLine() override
+    {
+        const char* eol = std::find( m_next, m_end, '\n' );
+
+        if( eol != m_end )
+            ++eol;      // include the newline
+
+        m_length = eol - m_next;
+
+        if( m_length )
         {
-        case wxID_YES:    deleteItems = false; break;
-        case wxID_NO:     deleteItems = true;  break;
-        case wxID_CANCEL:
-        default:          THROW_IO_ERROR( wxT( "CANCEL" ) );
+            if( m_length >= m_maxLineLength )
+                THROW_IO_ERROR( _( "Line length exceeded" ) );
+
+            if( m_length + 1 > m_capacity )   // +1 for terminating nul
+                expandCapacity( m_length + 1 );
+
+            memcpy( m_line, m_next, m_length );
+            m_next = eol;
         }
 
-        auto visitItem = [&]( BOARD_ITEM* item )
-                            {
-                                if( item->GetLayer() == Rescue )
-                                {
-                                    if( deleteItems )
-                                        deleteList.push_back( item );
-                                    else
-                                        item->SetLayer( Cmts_User );
-                                }
-                            };
-
-        for( TRACK* segm = m_board->m_Track;  segm;  segm = segm->Next() )
+        ++m_lineNum;      // this gets incremented even if no bytes were read
+        m_line[m_length] = 0;
+
+        return m_length ? m_line : NULL;
+    }
+
+private:
+    const char* m_next;
+    const char* m_end;
+};
+
+
+/**
+ * A top level record of a board file: one of the lists directly inside (kicad_pcb ...)
+ */
+struct BOARD_RECORD
+{
+    const char* m_begin;        ///< the opening paren, or the start of its line if blank
+    const char* m_end;          ///< after the closing paren
+                                ///< (in a token stream: the opening and closing tokens)
+    unsigned    m_lineCount;    ///< number of lines before m_begin
+    std::string m_keyword;      ///< first symbol of the list
+};
+
+
+/**
+ * Function findBoardRecords
+ * locates the top level records of a board file with a bracket scan.  Quoted strings
+ * and comment lines are skipped the way the lexer does, nothing else is checked.
+ * @return false if the text is not a single, balanced list, or contains something
+ *         unusual enough to be left to the lexer (multi-line strings...).
+ */
+static bool findBoardRecords( const char* aBegin, const char* aEnd,
+                              std::vector<BOARD_RECORD>& aRecords )
+{
+    BOARD_RECORD record;
+    int          depth = 0;
+    unsigned     lineCount = 0;
+    const char*  lineBegin = aBegin;
+    bool         blankLine = true;     // nothing but whitespace yet on the current line
+    bool         closed = false;
+
+    for( const char* cc = aBegin; cc < aEnd; ++cc )
+    {
+        switch( *cc )
         {
-            if( segm->Type() == PCB_VIA_T )
+        case '\n':
+            ++lineCount;
+            lineBegin = cc + 1;
+            blankLine = true;
+            continue;
+
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\0':
+            continue;
+
+        case '#':
+            // A comment only when first on its line
+            if( blankLine )
             {
-                VIA*         via = (VIA*) segm;
-                PCB_LAYER_ID top_layer, bottom_layer;
+                cc = std::find( cc, aEnd, '\n' ) - 1;
+                continue;
+            }
 
-                if( via->GetViaType() == VIA_THROUGH )
-                    continue;
+            break;
 
-                via->LayerPair( &top_layer, &bottom_layer );
+        case '"':
+            // Strings end on their line, and may contain escaped quotes
+            for( ++cc; cc < aEnd && *cc != '"'; ++cc )
+            {
+                if( *cc == '\\' )
+                    ++cc;
 
-                if( top_layer == Rescue || bottom_layer == Rescue )
-                {
-                    if( deleteItems )
-                        deleteList.push_back( via );
-                    else
-                    {
-                        if( top_layer == Rescue )
-                            top_layer = F_Cu;
+                if( cc >= aEnd || *cc == '\n' )
+                    return false;
+            }
 
-                        if( bottom_layer == Rescue )
-                            bottom_layer = B_Cu;
+            if( cc >= aEnd )
+                return false;
 
-                        via->SetLayerPair( top_layer, bottom_layer );
-                    }
-                }
+            break;
+
+        case '(':
+            if( closed )
+                return false;
+
+            if( ++depth == 2 )
+            {
+                const char* kw = cc + 1;
+                const char* kwEnd = kw;
+
+                while( kwEnd < aEnd && ( isalnum( (unsigned char) *kwEnd ) || *kwEnd == '_' ) )
+                    ++kwEnd;
+
+                record.m_begin = blankLine ? lineBegin : cc;
+                record.m_lineCount = lineCount;
+                record.m_keyword.assign( kw, kwEnd );
+            }
+
+            break;
+
+        case ')':
+            if( depth == 0 )
+                return false;
+
+            if( --depth == 1 )
+            {
+                record.m_end = cc + 1;
+                aRecords.push_back( record );
             }
-            else
-                visitItem( segm );
+            else if( depth == 0 )
+            {
+                closed = true;
+            }
+
+            break;
         }
 
-        for( BOARD_ITEM* zone : m_board->Zones() )
-            visitItem( zone );
+        blankLine = false;
+    }
+
+    return closed;
+}
 
-        for( BOARD_ITEM* drawing : m_board->Drawings() )
-            visitItem( drawing );
 
-        for( BOARD_ITEM* item : deleteList )
-            m_board->Delete( item );
+/**
+ * Function findTokenRecords
+ * locates the top level records of a token stream of a board file.
+ * @return false if the stream is not a single, balanced kicad_pcb list.
+ */
+static bool findTokenRecords( const char* aBegin, const char* aEnd,
+                              std::vector<BOARD_RECORD>& aRecords )
+{
+    DSNLEXER     lexer( std::string(), wxEmptyString );     // no keywords, only symbols
+    BOARD_RECORD record;
+    int          depth = 0;
+    bool         keyword = false;   // the next token is the keyword of a list
+    bool         closed = false;
+
+    record.m_lineCount = 0;
+    lexer.SetTokenStream( aBegin, aEnd );
+
+    while( true )
+    {
+        const char* tokBegin = lexer.GetTokenStreamPosition();
+        int         tok = lexer.NextTok();
+
+        if( tok == DSN_EOF )
+            return closed;
+
+        if( keyword )
+        {
+            keyword = false;
+
+            if( depth == 1 && ( tok != DSN_SYMBOL || lexer.CurStr() != "kicad_pcb" ) )
+                return false;
+
+            record.m_keyword = tok == DSN_SYMBOL ? lexer.CurStr() : std::string();
+        }
 
-        m_undefinedLayers.clear();
+        switch( tok )
+        {
+        case DSN_LEFT:
+            if( closed )
+                return false;
+
+            if( ++depth == 2 )
+                record.m_begin = tokBegin;
+
+            keyword = depth <= 2;
+            break;
+
+        case DSN_RIGHT:
+            if( depth == 0 )
+                return false;
+
+            if( --depth == 1 )
+            {
+                record.m_end = lexer.GetTokenStreamPosition();
+                aRecords.push_back( record );
+            }
+            else if( depth == 0 )
+            {
+                closed = true;
+            }
+
+            break;
+
+        default:
+            if( depth == 0 )
+                return false;
+        }
     }
+}
+
+
+static bool isIndependentBoardItem( const std::string& aKeyword )
+{
+    static const char* const keywords[] =
+    {
+        "gr_arc", "gr_circle", "gr_curve", "gr_line", "gr_poly", "gr_text",
+        "dimension", "module", "segment", "via", "zone", "target"
+    };
+
+    for( const char* keyword : keywords )
+    {
+        if( aKeyword == keyword )
+            return true;
+    }
+
+    return false;
+}
+
+
+void PCB_PARSER::initRecordParser( const PCB_PARSER& aParent )
+{
+    m_board = aParent.m_board;
+    m_layerIndices = aParent.m_layerIndices;
+    m_layerMasks = aParent.m_layerMasks;
+    m_netCodes = aParent.m_netCodes;
+    m_deferBoardChanges = true;
+}
+
+
+BOARD* PCB_PARSER::ParseBoard( const char* aBegin, const char* aEnd, const wxString& aSource )
+{
+    return parseBoard( aBegin, aEnd, aSource, false );
+}
+
+
+BOARD* PCB_PARSER::ParseBoardTokens( const char* aBegin, const char* aEnd,
+                                     const wxString& aSource )
+{
+    wxCHECK_MSG( m_board == NULL, NULL, "Cannot append a token stream to a board" );
+
+    try
+    {
+        return parseBoard( aBegin, aEnd, aSource, true );
+    }
+    catch( ... )
+    {
+        delete m_board;
+        m_board = NULL;
+        throw;
+    }
+}
+
+
+BOARD* PCB_PARSER::parseBoard( const char* aBegin, const char* aEnd, const wxString& aSource,
+                               bool aTokens )
+{
+    LOCALE_IO                 toggle;
+    std::vector<BOARD_RECORD> records;
+    size_t                    firstItem = 0;
+    bool                      split;
+
+    if( aTokens )
+    {
+        split = findTokenRecords( aBegin, aEnd, records );
+    }
+    else
+    {
+        const char* first = aBegin;
+
+        while( first < aEnd && isspace( (unsigned char) *first ) )
+            ++first;
+
+        split = aEnd - first > 10 && strncmp( first, "(kicad_pcb", 10 ) == 0
+                    && findBoardRecords( aBegin, aEnd, records );
+    }
+
+    if( split )
+    {
+        // The header sections (layers, nets...) are needed to parse the items: they must
+        // all come first, as written by Pcbnew.
+        while( firstItem < records.size() && !isIndependentBoardItem( records[firstItem].m_keyword ) )
+            ++firstItem;
+
+        for( size_t ii = firstItem; ii < records.size(); ++ii )
+        {
+            if( !isIndependentBoardItem( records[ii].m_keyword ) )
+            {
+                records.clear();
+                break;
+            }
+        }
+    }
+
+    if( firstItem >= records.size() )
+    {
+        // Nothing worth splitting, or an unusual layout: parse the usual way
+        BOARD_RECORD_READER reader( aBegin, aEnd, 0, aSource, aTokens );
+        SetLineReader( &reader );
+        SetTokenStream( aTokens ? aBegin : NULL, aEnd );
+
+        BOARD_ITEM* item = Parse();
+
+        if( !dynamic_cast<BOARD*>( item ) )
+        {
+            // The parser loaded something that was valid, but wasn't a board.
+            delete item;
+            THROW_PARSE_ERROR( _( "this file does not contain a PCB" ),
+                               CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+        }
+
+        return static_cast<BOARD*>( item );
+    }
+
+    // Parse the header, closing the board list before the first item
+    std::string header( aBegin, records[firstItem].m_begin );
+
+    if( aTokens )
+        DSNLEXER::WriteToken( header, DSN_RIGHT );
+    else
+        header += ")\n";
+
+    const char* headerEnd = header.data() + header.size();
+
+    BOARD_RECORD_READER headerReader( header.data(), headerEnd, 0, aSource, aTokens );
+    SetLineReader( &headerReader );
+    SetTokenStream( aTokens ? header.data() : NULL, headerEnd );
+
+    Parse();
+
+    records.erase( records.begin(), records.begin() + firstItem );
+
+    try
+    {
+        parseBoardRecords( records, aSource, aTokens );
+    }
+    catch( const PARSE_ERROR& parse_error )
+    {
+        if( m_tooRecent )
+            throw FUTURE_FORMAT_ERROR( parse_error, GetRequiredVersion() );
+        else
+            throw;
+    }
+
+    resolveUndefinedLayers();
 
     return m_board;
 }
 
 
+void PCB_PARSER::parseBoardRecords( const std::vector<BOARD_RECORD>& aRecords,
+                                    const wxString& aSource, bool aTokens )
+{
+    struct PARSED_RECORD
+    {
+        std::unique_ptr<BOARD_ITEM> m_item;
+        std::exception_ptr          m_error;
+        int                         m_requiredVersion = 0;
+        bool                        m_zoneNetMismatch = false;
+        wxString                    m_zoneNetname;
+        bool                        m_legacyZoneFill = false;
+    };
+
+    std::vector<PARSED_RECORD> parsed( aRecords.size() );
+    std::atomic<size_t>        nextRecord( 0 );
+    std::mutex                 undefinedLayersLock;
+
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    TASK_GROUP   tasks( pool );
+
+    // The items are parsed by worker parsers, which only read the board: changes to the
+    // board (nets of zones, legacy zone warning) are applied below, in file order.
+    tasks.Run( [&]()
+    {
+        std::unique_ptr<PCB_PARSER> parser;
+
+        for( size_t ii = nextRecord.fetch_add( 1 ); ii < aRecords.size();
+                ii = nextRecord.fetch_add( 1 ) )
+        {
+            const BOARD_RECORD& record = aRecords[ii];
+            PARSED_RECORD&      result = parsed[ii];
+
+            if( !parser )
+            {
+                parser.reset( new PCB_PARSER );
+                parser->initRecordParser( *this );
+            }
+
+            BOARD_RECORD_READER reader( record.m_begin, record.m_end, record.m_lineCount,
+                                        aSource, aTokens );
+            parser->SetLineReader( &reader );
+            parser->SetTokenStream( aTokens ? record.m_begin : NULL, record.m_end );
+            parser->m_requiredVersion = m_requiredVersion;
+            parser->m_tooRecent = m_tooRecent;
+            parser->m_deferredZoneNet = false;
+            parser->m_deferredLegacyZoneFill = false;
+
+            try
+            {
+                parser->NeedLEFT();
+                parser->NextTok();
+                result.m_item.reset( parser->parseBoardItem() );
+            }
+            catch( ... )
+            {
+                result.m_error = std::current_exception();
+            }
+
+            result.m_requiredVersion = parser->m_requiredVersion;
+            result.m_zoneNetMismatch = parser->m_deferredZoneNet;
+            result.m_zoneNetname = parser->m_deferredZoneNetname;
+            result.m_legacyZoneFill = parser->m_deferredLegacyZoneFill;
+
+            // Do not reuse a lexer left in the middle of a list
+            if( result.m_error )
+            {
+                std::lock_guard<std::mutex> lock( undefinedLayersLock );
+                m_undefinedLayers.insert( parser->m_undefinedLayers.begin(),
+                                          parser->m_undefinedLayers.end() );
+                parser.reset();
+            }
+        }
+
+        if( parser )
+        {
+            std::lock_guard<std::mutex> lock( undefinedLayersLock );
+            m_undefinedLayers.insert( parser->m_undefinedLayers.begin(),
+                                      parser->m_undefinedLayers.end() );
+        }
+    }, pool.GetTaskCount( aRecords.size(), 16 ) );
+
+    tasks.Wait();
+
+    // Once a zone added a net, the net codes of the following records could be mapped
+    // differently: parse them again here, the way the serial parser would.
+    bool reparse = false;
+
+    for( size_t ii = 0; ii < aRecords.size(); ++ii )
+    {
+        const BOARD_RECORD& record = aRecords[ii];
+        PARSED_RECORD&      result = parsed[ii];
+        BOARD_ITEM*         item;
+
+        if( reparse )
+        {
+            BOARD_RECORD_READER reader( record.m_begin, record.m_end, record.m_lineCount,
+                                        aSource, aTokens );
+            SetLineReader( &reader );
+            SetTokenStream( aTokens ? record.m_begin : NULL, record.m_end );
+            NeedLEFT();
+            NextTok();
+            item = parseBoardItem();
+        }
+        else
+        {
+            m_requiredVersion = std::max( m_requiredVersion, result.m_requiredVersion );
+            m_tooRecent = ( m_requiredVersion > SEXPR_BOARD_FILE_VERSION );
+
+            if( result.m_error )
+                std::rethrow_exception( result.m_error );
+
+            if( result.m_legacyZoneFill )
+                convertLegacyZoneFill();
+
+            if( result.m_zoneNetMismatch )
+            {
+                reparse = fixZoneNet( static_cast<ZONE_CONTAINER*>( result.m_item.get() ),
+                                      result.m_zoneNetname );
+            }
+
+            item = result.m_item.release();
+        }
+
+        if( item->Type() == PCB_TRACE_T || item->Type() == PCB_VIA_T )
+            m_board->Add( item, ADD_INSERT );
+        else
+            m_board->Add( item, ADD_APPEND );
+    }
+}
+
+
 void PCB_PARSER::parseHeader()
 {
     wxCHECK_RET( CurTok() == T_kicad_pcb,
@@ -3182,25 +3762,12 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER()
 
                     if( token == T_segment )    // deprecated
                     {
-                        // SEGMENT fill mode no longer supported.  Make sure user is OK with converting them.
-                        if( m_showLegacyZoneWarning )
-                        {
-                            KIDIALOG dlg( nullptr,
-                                          _( "The legacy segment fill mode is no longer supported.\n"
-                                             "Convert zones to polygon fills?"),
-                                          _( "Legacy Zone Warning" ),
-                                          wxYES_NO | wxICON_WARNING );
-
-                            dlg.DoNotShowCheckbox( __FILE__, __LINE__ );
-
-                            if( dlg.ShowModal() == wxID_NO )
-                                THROW_IO_ERROR( wxT( "CANCEL" ) );
-
-                            m_showLegacyZoneWarning = false;
-                        }
+                        if( m_deferBoardChanges )
+                            m_deferredLegacyZoneFill = true;
+                        else
+                            convertLegacyZoneFill();
 
                         zone->SetFillMode( ZFM_POLYGONS );
-                        m_board->SetModified();
                     }
                     else if( token == T_hatch )
                         zone->SetFillMode( ZFM_HATCH_PATTERN );
@@ -3428,34 +3995,13 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER()
     // Ensure the zone net name is valid, and matches the net code, for copper zones
     if( zone_has_net && ( zone->GetNet()->GetNetname() != netnameFromfile ) )
     {
-        // Can happens which old boards, with nonexistent nets ...
-        // or after being edited by hand
-        // We try to fix the mismatch.
-        NETINFO_ITEM* net = m_board->FindNet( netnameFromfile );
-
-        if( net )   // An existing net has the same net name. use it for the zone
-            zone->SetNetCode( net->GetNet() );
-        else    // Not existing net: add a new net to keep trace of the zone netname
+        if( m_deferBoardChanges )
         {
-            int newnetcode = m_board->GetNetCount();
-            net = new NETINFO_ITEM( m_board, netnameFromfile, newnetcode );
-            m_board->Add( net );
-
-            // Store the new code mapping
-            pushValueIntoMap( newnetcode, net->GetNet() );
-            // and update the zone netcode
-            zone->SetNetCode( net->GetNet() );
-
-            // FIXME: a call to any GUI item is not allowed in io plugins:
-            // Change this code to generate a warning message outside this plugin
-            // Prompt the user
-            wxString msg;
-            msg.Printf( _( "There is a zone that belongs to a not existing net\n"
-                           "\"%s\"\n"
-                           "you should verify and edit it (run DRC test)." ),
-                           GetChars( netnameFromfile ) );
-            DisplayError( NULL, msg );
+            m_deferredZoneNet = true;
+            m_deferredZoneNetname = netnameFromfile;
         }
+        else
+            fixZoneNet( zone.get(), netnameFromfile );
     }
 
     // Clear flags used in zone edition:
@@ -3465,6 +4011,66 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER()
 }
 
 
+bool PCB_PARSER::fixZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetname )
+{
+    // Can happens which old boards, with nonexistent nets ...
+    // or after being edited by hand
+    // We try to fix the mismatch.
+    NETINFO_ITEM* net = m_board->FindNet( aNetname );
+
+    if( net )   // An existing net has the same net name. use it for the zone
+    {
+        aZone->SetNetCode( net->GetNet() );
+        return false;
+    }
+
+    // Not existing net: add a new net to keep trace of the zone netname
+    int newnetcode = m_board->GetNetCount();
+    net = new NETINFO_ITEM( m_board, aNetname, newnetcode );
+    m_board->Add( net );
+
+    // Store the new code mapping
+    pushValueIntoMap( newnetcode, net->GetNet() );
+    // and update the zone netcode
+    aZone->SetNetCode( net->GetNet() );
+
+    // FIXME: a call to any GUI item is not allowed in io plugins:
+    // Change this code to generate a warning message outside this plugin
+    // Prompt the user
+    wxString msg;
+    msg.Printf( _( "There is a zone that belongs to a not existing net\n"
+                   "\"%s\"\n"
+                   "you should verify and edit it (run DRC test)." ),
+                   GetChars( aNetname ) );
+    DisplayError( NULL, msg );
+
+    return true;
+}
+
+
+void PCB_PARSER::convertLegacyZoneFill()
+{
+    // SEGMENT fill mode no longer supported.  Make sure user is OK with converting them.
+    if( m_showLegacyZoneWarning )
+    {
+        KIDIALOG dlg( nullptr,
+                      _( "The legacy segment fill mode is no longer supported.\n"
+                         "Convert zones to polygon fills?"),
+                      _( "Legacy Zone Warning" ),
+                      wxYES_NO | wxICON_WARNING );
+
+        dlg.DoNotShowCheckbox( __FILE__, __LINE__ );
+
+        if( dlg.ShowModal() == wxID_NO )
+            THROW_IO_ERROR( wxT( "CANCEL" ) );
+
+        m_showLegacyZoneWarning = false;
+    }
+
+    m_board->SetModified();
+}
+
+
 PCB_TARGET* PCB_PARSER::parsePCB_TARGET()
 {
     wxCHECK_MSG( CurTok() == T_target, NULL,
@@ -55,6 +55,7 @@ class VIA;
 class ZONE_CONTAINER;
 class MODULE_3D_SETTINGS;
 struct LAYER;
+struct BOARD_RECORD;
 
 
 /**
@@ -77,6 +78,12 @@ class PCB_PARSER : public PCB_LEXER
 
     bool                m_showLegacyZoneWarning;
 
+    bool                m_deferBoardChanges;      ///< true for the parsers of ParseBoard() workers,
+                                                  ///< which must not modify the board
+    bool                m_deferredZoneNet;        ///< the last zone parsed needs fixZoneNet()
+    wxString            m_deferredZoneNetname;    ///< the net name to give to fixZoneNet()
+    bool                m_deferredLegacyZoneFill; ///< the last zone parsed needs convertLegacyZoneFill()
+
     ///> Converts net code using the mapping table if available,
     ///> otherwise returns unchanged net code if < 0 or if is is out of range
     inline int getNetCode( int aNetCode )
@@ -154,6 +161,59 @@ class PCB_PARSER : public PCB_LEXER
      */
     BOARD*          parseBOARD_unchecked();
 
+    /**
+     * Function parseBoardItem
+     * parses a board item which does not depend on other items (footprint, track, via, zone,
+     * drawing...), starting on its keyword.
+     * @return the item, not yet added to the board.
+     */
+    BOARD_ITEM*     parseBoardItem();
+
+    /**
+     * Function parseBoardRecords
+     * parses the item records of a board on the thread pool, then adds the items to the
+     * board in file order, applying the board changes the workers deferred.
+     */
+    void            parseBoardRecords( const std::vector<BOARD_RECORD>& aRecords,
+                                       const wxString& aSource, bool aTokens );
+
+    /**
+     * Function parseBoard
+     * implements ParseBoard() and ParseBoardTokens().
+     * @param aTokens is true if aBegin .. aEnd is a token stream rather than text.
+     */
+    BOARD*          parseBoard( const char* aBegin, const char* aEnd, const wxString& aSource,
+                                bool aTokens );
+
+    /**
+     * Function initRecordParser
+     * prepares a parser for parsing items of the board of aParent on a worker thread.
+     */
+    void            initRecordParser( const PCB_PARSER& aParent );
+
+    /**
+     * Function resolveUndefinedLayers
+     * asks the user whether items found on undefined layers should be moved to a user layer
+     * or deleted.
+     * @throw IO_ERROR if the user cancels loading.
+     */
+    void            resolveUndefinedLayers();
+
+    /**
+     * Function fixZoneNet
+     * gives a copper zone the net named aNetname when its net code does not match,
+     * adding the net to the board if it does not exist.
+     * @return true if a net was added.
+     */
+    bool            fixZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetname );
+
+    /**
+     * Function convertLegacyZoneFill
+     * asks the user, once, to confirm converting segment filled zones to polygon fills.
+     * @throw IO_ERROR if the user refuses.
+     */
+    void            convertLegacyZoneFill();
+
 
     /**
      * Function lookUpLayer
@@ -319,6 +379,7 @@ public:
     {
         LINE_READER* ret = PopReader();
         PushReader( aReader );
+        SetTokenStream( NULL, NULL );
         return ret;
     }
 
@@ -329,6 +390,31 @@ public:
     }
 
     BOARD_ITEM* Parse();
+
+    /**
+     * Function ParseBoard
+     * parses a whole board file held in memory, giving the same result as Parse().
+     *
+     * The top level records are located with a bracket scan.  Once the header (layers,
+     * nets, setup...) is parsed, footprints, tracks, zones and drawings are parsed in
+     * parallel, and added to the board in file order.  Files which cannot be split this
+     * way are handed to Parse().
+     *
+     * @param aBegin and @param aEnd delimit the file content.
+     * @param aSource is the file name, for error messages.
+     */
+    BOARD* ParseBoard( const char* aBegin, const char* aEnd, const wxString& aSource );
+
+    /**
+     * Function ParseBoardTokens
+     * parses a new board from a token stream of a board file (see DSNLEXER::WriteTokens()),
+     * the same way as ParseBoard() does from its text.  Error locations are not known:
+     * the board is deleted on error, so that the caller can parse the text instead.
+     *
+     * @param aBegin and @param aEnd delimit the token stream.
+     * @param aSource is the file name, for error messages.
+     */
+    BOARD* ParseBoardTokens( const char* aBegin, const char* aEnd, const wxString& aSource );
     /**
      * Function parseMODULE
      * @param aInitialComments may be a pointer to a heap allocated initial comment block
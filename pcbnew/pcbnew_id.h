@@ -53,6 +53,7 @@ enum pcbnew_ids
     ID_MENU_ADD_TEARDROPS,
     ID_MENU_DIFF_PAIR_DIMENSIONS,
     ID_MENU_INTERACTIVE_ROUTER_SETTINGS,
+    ID_MENU_AUTOROUTE_UNROUTED,
 
     ID_MENU_PCB_FLIP_VIEW,
 
@@ -33,6 +33,7 @@
 #endif
 
 #include <ratsnest_data.h>
+#include <ttl/ttl.h>
 #include <functional>
 using namespace std::placeholders;
 
@@ -49,102 +50,123 @@ static uint64_t getDistance( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& a
 }
 
 
-static bool sortWeight( const CN_EDGE& aEdge1, const CN_EDGE& aEdge2 )
-{
-    return aEdge1.GetWeight() < aEdge2.GetWeight();
-}
-
-
-static const std::vector<CN_EDGE> kruskalMST( std::list<CN_EDGE>& aEdges,
+static const std::vector<CN_EDGE> kruskalMST( const std::vector<CN_EDGE>& aEdges,
         std::vector<CN_ANCHOR_PTR>& aNodes )
 {
-    unsigned int    nodeNumber = aNodes.size();
-    unsigned int    mstExpectedSize = nodeNumber - 1;
-    unsigned int    mstSize = 0;
-    bool ratsnestLines = false;
-
     // The output
     std::vector<CN_EDGE> mst;
 
-    // Set tags for marking cycles
-    std::unordered_map<CN_ANCHOR_PTR, int> tags;
-    unsigned int tag = 0;
+    if( aNodes.empty() )
+        return mst;
+
+    // Edges refer to the nodes by their index, stored as tag until the connected
+    // nodes get tagged
+    for( unsigned int i = 0; i < aNodes.size(); ++i )
+        aNodes[i]->SetTag( i );
 
-    for( auto& node : aNodes )
+    struct SORTED_EDGE
     {
-        node->SetTag( tag );
-        tags[node] = tag++;
-    }
+        int weight;
+        int source;
+        int target;
+        unsigned int edge;
 
-    // Lists of nodes connected together (subtrees) to detect cycles in the graph
-    std::vector<std::list<int> > cycles( nodeNumber );
+        bool operator<( const SORTED_EDGE& aOther ) const
+        {
+            if( weight != aOther.weight )
+                return weight < aOther.weight;
+            else if( source != aOther.source )
+                return source < aOther.source;
 
-    for( unsigned int i = 0; i < nodeNumber; ++i )
-        cycles[i].push_back( i );
+            return target < aOther.target;
+        }
+    };
+
+    std::vector<SORTED_EDGE> edges;
+    edges.reserve( aEdges.size() );
+
+    for( unsigned int i = 0; i < aEdges.size(); ++i )
+    {
+        const CN_EDGE& edge = aEdges[i];
+
+        edges.push_back( { edge.GetWeight(), edge.GetSourceNode()->GetTag(),
+                           edge.GetTargetNode()->GetTag(), i } );
+    }
 
     // Kruskal algorithm requires edges to be sorted by their weight
-    aEdges.sort( sortWeight );
+    std::sort( edges.begin(), edges.end() );
+
+    // Union-find of the subtrees, to detect cycles in the graph
+    std::vector<int> parent( aNodes.size() );
+    std::vector<int> size( aNodes.size(), 1 );
+
+    for( unsigned int i = 0; i < aNodes.size(); ++i )
+        parent[i] = i;
 
-    while( mstSize < mstExpectedSize && !aEdges.empty() )
+    auto findRoot = [&parent] ( int aNode )
     {
-        //printf("mstSize %d %d\n", mstSize, mstExpectedSize);
-        auto& dt = aEdges.front();
+        while( parent[aNode] != aNode )
+        {
+            parent[aNode] = parent[parent[aNode]];
+            aNode = parent[aNode];
+        }
+
+        return aNode;
+    };
+
+    auto tagNodes = [&] ()
+    {
+        for( unsigned int i = 0; i < aNodes.size(); ++i )
+            aNodes[i]->SetTag( findRoot( i ) );
+    };
+
+    unsigned int subtreeCount = aNodes.size();
+    bool ratsnestLines = false;
+
+    for( const SORTED_EDGE& dt : edges )
+    {
+        if( subtreeCount <= 1 )
+            break;
 
-        int srcTag  = tags[dt.GetSourceNode()];
-        int trgTag  = tags[dt.GetTargetNode()];
+        int srcRoot = findRoot( dt.source );
+        int trgRoot = findRoot( dt.target );
 
         // Check if by adding this edge we are going to join two different forests
-        if( srcTag != trgTag )
+        if( srcRoot == trgRoot )
+            continue;
+
+        // Because edges are sorted by their weight, first we always process connected
+        // items (weight == 0). Once we stumble upon an edge with non-zero weight,
+        // it means that the rest of the lines are ratsnest.
+        if( !ratsnestLines && dt.weight != 0 )
         {
-            // Because edges are sorted by their weight, first we always process connected
-            // items (weight == 0). Once we stumble upon an edge with non-zero weight,
-            // it means that the rest of the lines are ratsnest.
-            if( !ratsnestLines && dt.GetWeight() != 0 )
-                ratsnestLines = true;
-
-            // Update tags
-            if( ratsnestLines )
-            {
-                for( auto it = cycles[trgTag].begin(); it != cycles[trgTag].end(); ++it )
-                {
-                    tags[aNodes[*it]] = srcTag;
-                }
+            ratsnestLines = true;
 
-                // Do a copy of edge, but make it RN_EDGE_MST. In contrary to RN_EDGE,
-                // RN_EDGE_MST saves both source and target node and does not require any other
-                // edges to exist for getting source/target nodes
-                CN_EDGE newEdge ( dt.GetSourceNode(), dt.GetTargetNode(), dt.GetWeight() );
+            // Nodes connected by the board items share the same tag
+            tagNodes();
+        }
 
-                assert( newEdge.GetSourceNode()->GetTag() != newEdge.GetTargetNode()->GetTag() );
-                assert( newEdge.GetWeight() > 0 );
+        if( size[srcRoot] < size[trgRoot] )
+            std::swap( srcRoot, trgRoot );
 
-                mst.push_back( newEdge );
-                ++mstSize;
-            }
-            else
-            {
-                // for( it = cycles[trgTag].begin(), itEnd = cycles[trgTag].end(); it != itEnd; ++it )
-                // for( auto it : cycles[trgTag] )
-                for( auto it = cycles[trgTag].begin(); it != cycles[trgTag].end(); ++it )
-                {
-                    tags[aNodes[*it]] = srcTag;
-                    aNodes[*it]->SetTag( srcTag );
-                }
+        parent[trgRoot] = srcRoot;
+        size[srcRoot] += size[trgRoot];
+        subtreeCount--;
 
-                // Processing a connection, decrease the expected size of the ratsnest MST
-                --mstExpectedSize;
-            }
+        if( ratsnestLines )
+        {
+            const CN_EDGE& edge = aEdges[dt.edge];
+            CN_EDGE newEdge ( edge.GetSourceNode(), edge.GetTargetNode(), dt.weight );
 
-            // Move nodes that were marked with old tag to the list marked with the new tag
-            cycles[srcTag].splice( cycles[srcTag].end(), cycles[trgTag] );
-        }
+            assert( newEdge.GetSourceNode()->GetTag() != newEdge.GetTargetNode()->GetTag() );
+            assert( newEdge.GetWeight() > 0 );
 
-        // Remove the edge that was just processed
-        aEdges.erase( aEdges.begin() );
+            mst.push_back( newEdge );
+        }
     }
 
-    // Probably we have discarded some of edges, so reduce the size
-    mst.resize( mstSize );
+    if( !ratsnestLines )
+        tagNodes();
 
     return mst;
 }
@@ -155,17 +177,27 @@ class RN_NET::TRIANGULATOR_STATE
 private:
     std::vector<CN_ANCHOR_PTR>  m_allNodes;
 
-    std::list<hed::EDGE_PTR> hedTriangulation( std::vector<hed::NODE_PTR>& aNodes )
+    ///> Delaunay triangulation of the anchor positions.  It is kept between updates, so
+    ///> that only the positions which changed are removed and inserted.  The enclosing
+    ///> triangles it is built from are kept too: their corners have a negative id.
+    std::unique_ptr<hed::TRIANGULATION> m_triangulation;
+
+    ///> Nodes of m_triangulation, in the order of m_allNodes
+    std::vector<hed::NODE_PTR> m_triNodes;
+
+    ///> Number of times m_triangulation was built from scratch
+    int m_buildCount = 0;
+
+    static bool lessPos( const VECTOR2I& aPos1, const VECTOR2I& aPos2 )
     {
-        hed::TRIANGULATION triangulator;
-        triangulator.CreateDelaunay( aNodes.begin(), aNodes.end() );
-        std::list<hed::EDGE_PTR> edges;
-        triangulator.GetEdges( edges );
+        if( aPos1.y < aPos2.y )
+            return true;
+        else if( aPos1.y == aPos2.y )
+            return aPos1.x < aPos2.x;
 
-        return edges;
+        return false;
     }
 
-
     // Checks if all nodes in aNodes lie on a single line. Requires the nodes to
     // have unique coordinates!
     bool areNodesColinear( const std::vector<hed::NODE_PTR>& aNodes ) const
@@ -189,6 +221,102 @@ private:
         return true;
     }
 
+    void resetTriangulation()
+    {
+        m_triangulation.reset();
+        m_triNodes.clear();
+    }
+
+    bool removeNode( ttl::TRIANGULATION_HELPER& aHelper, const hed::NODE_PTR& aNode )
+    {
+        hed::DART dart = m_triangulation->CreateDart();
+
+        if( !ttl::TRIANGULATION_HELPER::LocateFaceSimplest<hed::TTLtraits>( aNode, dart ) )
+            return false;
+
+        // The node is a corner of the triangle found at its position
+        for( int i = 0; i < 3; i++ )
+        {
+            if( dart.GetNode() == aNode )
+            {
+                aHelper.RemoveNode<hed::TTLtraits>( dart );
+                return true;
+            }
+
+            dart.Alpha0().Alpha1();
+        }
+
+        return false;
+    }
+
+    /**
+     * Brings the triangulation to aNodes, by removing aRemoved and inserting aAdded, or
+     * by triangulating aNodes again when too many nodes changed.
+     */
+    void updateTriangulation( std::vector<hed::NODE_PTR>& aNodes,
+                              const std::vector<hed::NODE_PTR>& aRemoved,
+                              std::vector<hed::NODE_PTR>& aAdded )
+    {
+        bool rebuild = !m_triangulation || ( aRemoved.size() + aAdded.size() ) * 2 > aNodes.size();
+
+        if( !rebuild )
+        {
+            ttl::TRIANGULATION_HELPER helper( *m_triangulation );
+
+            for( const auto& node : aRemoved )
+            {
+                if( !removeNode( helper, node ) )
+                {
+                    rebuild = true;
+                    break;
+                }
+            }
+
+            if( !rebuild )
+            {
+                hed::DART dart = m_triangulation->CreateDart();
+
+                for( auto& node : aAdded )
+                {
+                    if( !helper.InsertNode<hed::TTLtraits>( dart, node ) )
+                    {
+                        rebuild = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if( rebuild )
+        {
+            m_buildCount++;
+            m_triangulation.reset( new hed::TRIANGULATION );
+
+            hed::EDGE_PTR edge = m_triangulation->InitTwoEnclosingTriangles( aNodes.begin(),
+                                                                              aNodes.end() );
+
+            // Tag the corners of the enclosing triangles, their edges are not ratsnest
+            for( const hed::EDGE_PTR& leadingEdge : m_triangulation->GetLeadingEdges() )
+            {
+                hed::EDGE_PTR triEdge = leadingEdge;
+
+                for( int i = 0; i < 3; i++ )
+                {
+                    triEdge->GetSourceNode()->SetId( -1 );
+                    triEdge = triEdge->GetNextEdgeInFace();
+                }
+            }
+
+            ttl::TRIANGULATION_HELPER helper( *m_triangulation );
+            hed::DART dart( edge );
+
+            for( auto& node : aNodes )
+                helper.InsertNode<hed::TTLtraits>( dart, node );
+        }
+
+        m_triNodes = aNodes;
+    }
+
 public:
 
     void Clear()
@@ -196,16 +324,39 @@ public:
         m_allNodes.clear();
     }
 
+    int GetBuildCount() const
+    {
+        return m_buildCount;
+    }
+
+    void DropNode( const VECTOR2I& aPos )
+    {
+        if( !m_triangulation )
+            return;
+
+        ttl::TRIANGULATION_HELPER helper( *m_triangulation );
+
+        for( const auto& node : m_triNodes )
+        {
+            if( node->GetPos() == aPos )
+            {
+                removeNode( helper, node );
+                return;
+            }
+        }
+    }
+
     void AddNode( CN_ANCHOR_PTR aNode )
     {
         m_allNodes.push_back( aNode );
     }
 
-    const std::list<CN_EDGE> Triangulate()
+    const std::vector<CN_EDGE> Triangulate()
     {
-        std::list<CN_EDGE> mstEdges;
-        std::list<hed::EDGE_PTR> triangEdges;
+        std::vector<CN_EDGE> mstEdges;
         std::vector<hed::NODE_PTR> triNodes;
+        std::vector<hed::NODE_PTR> removedNodes;
+        std::vector<hed::NODE_PTR> addedNodes;
 
         using ANCHOR_LIST = std::vector<CN_ANCHOR_PTR>;
         std::vector<ANCHOR_LIST> anchorChains;
@@ -216,14 +367,7 @@ public:
         std::sort( m_allNodes.begin(), m_allNodes.end(),
                 [] ( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& aNode2 )
         {
-            if( aNode1->Pos().y < aNode2->Pos().y )
-                return true;
-            else if( aNode1->Pos().y == aNode2->Pos().y )
-            {
-                return aNode1->Pos().x < aNode2->Pos().x;
-            }
-
-            return false;
+            return lessPos( aNode1->Pos(), aNode2->Pos() );
         }
                 );
 
@@ -235,11 +379,28 @@ public:
             anchorChains.push_back( ANCHOR_LIST() );
         }
 
+        // Both node lists are sorted: the nodes of the previous triangulation at the
+        // positions still used are kept, the other ones are removed
+        auto oldNode = m_triNodes.begin();
+
         for( auto n : m_allNodes )
         {
             if( !prev || prev->Pos() != n->Pos() )
             {
-                auto tn = std::make_shared<hed::NODE> ( n->Pos().x, n->Pos().y );
+                while( oldNode != m_triNodes.end() && lessPos( (*oldNode)->GetPos(), n->Pos() ) )
+                    removedNodes.push_back( *oldNode++ );
+
+                hed::NODE_PTR tn;
+
+                if( oldNode != m_triNodes.end() && (*oldNode)->GetPos() == n->Pos() )
+                {
+                    tn = *oldNode++;
+                }
+                else
+                {
+                    tn = std::make_shared<hed::NODE> ( n->Pos().x, n->Pos().y );
+                    addedNodes.push_back( tn );
+                }
 
                 tn->SetId( id );
                 triNodes.push_back( tn );
@@ -249,6 +410,8 @@ public:
             prev = n;
         }
 
+        removedNodes.insert( removedNodes.end(), oldNode, m_triNodes.end() );
+
         int prevId = 0;
 
         for( auto n : triNodes )
@@ -264,10 +427,13 @@ public:
 
         if( triNodes.size() == 1 )
         {
+            resetTriangulation();
             return mstEdges;
         }
         else if( areNodesColinear( triNodes ) )
         {
+            resetTriangulation();
+
             // special case: all nodes are on the same line - there's no
             // triangulation for such set. In this case, we sort along any coordinate
             // and chain the nodes together.
@@ -280,16 +446,31 @@ public:
         }
         else
         {
-            hed::TRIANGULATION triangulator;
-            triangulator.CreateDelaunay( triNodes.begin(), triNodes.end() );
-            triangulator.GetEdges( triangEdges );
+            updateTriangulation( triNodes, removedNodes, addedNodes );
+
+            mstEdges.reserve( 3 * triNodes.size() );
 
-            for( auto e : triangEdges )
+            // One half edge of each edge between two anchors
+            for( const hed::EDGE_PTR& leadingEdge : m_triangulation->GetLeadingEdges() )
             {
-                auto    src = m_allNodes[ e->GetSourceNode()->Id() ];
-                auto    dst = m_allNodes[ e->GetTargetNode()->Id() ];
+                hed::EDGE_PTR e = leadingEdge;
 
-                mstEdges.emplace_back( src, dst, getDistance( src, dst ) );
+                for( int i = 0; i < 3; i++ )
+                {
+                    hed::EDGE_PTR twin = e->GetTwinEdge();
+                    int srcId = e->GetSourceNode()->Id();
+                    int dstId = e->GetTargetNode()->Id();
+
+                    if( srcId >= 0 && dstId >= 0 && ( !twin || e.get() > twin.get() ) )
+                    {
+                        auto    src = m_allNodes[ srcId ];
+                        auto    dst = m_allNodes[ dstId ];
+
+                        mstEdges.emplace_back( src, dst, getDistance( src, dst ) );
+                    }
+
+                    e = e->GetNextEdgeInFace();
+                }
             }
         }
 
@@ -371,8 +552,7 @@ void RN_NET::compute()
     cnt.Show();
     #endif
 
-    for( const auto& e : m_boardEdges )
-        triangEdges.push_back( e );
+    triangEdges.insert( triangEdges.end(), m_boardEdges.begin(), m_boardEdges.end() );
 
 // Get the minimal spanning tree
 #ifdef PROFILE
@@ -394,6 +574,18 @@ void RN_NET::Update()
 }
 
 
+int RN_NET::triangulationBuildCount() const
+{
+    return m_triangulator->GetBuildCount();
+}
+
+
+void RN_NET::dropTriangulationNode( const VECTOR2I& aPos )
+{
+    m_triangulator->DropNode( aPos );
+}
+
+
 void RN_NET::Clear()
 {
     m_rnEdges.clear();
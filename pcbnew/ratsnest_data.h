@@ -145,9 +145,18 @@ public:
     bool NearestBicoloredPair( const RN_NET& aOtherNet, CN_ANCHOR_PTR& aNode1, CN_ANCHOR_PTR& aNode2 ) const;
 
 protected:
-    ///> Recomputes ratsnest from scratch.
+    ///> Recomputes ratsnest, reusing the triangulation of the previous update.
     void compute();
 
+    ///> Returns the number of times the triangulation was built from scratch instead of
+    ///> updated.  Used by the QA tests.
+    int triangulationBuildCount() const;
+
+    ///> Removes the anchor position aPos from the kept triangulation but not from its node
+    ///> list, so that removing it at the next update fails.  Used by the QA tests of the
+    ///> rebuild fallback.
+    void dropTriangulationNode( const VECTOR2I& aPos );
+
     ///> Vector of nodes
     std::vector<CN_ANCHOR_PTR> m_nodes;
 
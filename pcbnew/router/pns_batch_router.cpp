@@ -0,0 +1,644 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_data.h>
+#include <convert_to_biu.h>
+#include <profile.h>
+#include <thread_pool.h>
+#include <widgets/progress_reporter.h>
+#include <wx/intl.h>
+
+#include "pns_batch_router.h"
+#include "pns_debug_decorator.h"
+#include "pns_kicad_iface.h"
+#include "pns_line.h"
+#include "pns_line_placer.h"
+#include "pns_node.h"
+#include "pns_router.h"
+
+// Room left around a connection for the detours of its route, at least
+static const int c_minDetourMargin = Millimeter2iu( 1.0 );
+
+
+/**
+ * Router interface of the batch router: nothing is displayed and the board is not
+ * modified.  The changes made to the world by the router are copied to the current ROUTE.
+ */
+class PNS_BATCH_IFACE : public PNS_KICAD_IFACE
+{
+public:
+    PNS_BATCH_IFACE( PNS_BATCH_ROUTER* aBatch ) :
+        m_batch( aBatch ),
+        m_route( nullptr )
+    {
+    }
+
+    void SetRoute( PNS_BATCH_ROUTER::ROUTE* aRoute )
+    {
+        m_route = aRoute;
+    }
+
+    void SyncWorld( PNS::NODE* aWorld ) override
+    {
+        PNS_KICAD_IFACE::SyncWorld( aWorld );
+
+        // The world is the board with the routes committed so far
+        for( BOARD_CONNECTED_ITEM* item : m_batch->m_removedItems )
+        {
+            if( PNS::ITEM* routerItem = aWorld->FindItemByParent( item ) )
+                aWorld->Remove( routerItem );
+        }
+
+        for( BOARD_CONNECTED_ITEM* item : m_batch->m_newOrder )
+        {
+            auto it = m_batch->m_newItems.find( item );
+
+            if( it != m_batch->m_newItems.end() )
+                aWorld->Add( PNS::Clone( *it->second ) );
+        }
+    }
+
+    void EraseView() override {}
+    void HideItem( PNS::ITEM* aItem ) override {}
+    void DisplayItem( const PNS::ITEM* aItem, int aColor, int aClearance, bool aEdit ) override {}
+    void Commit() override {}
+
+    void RemoveItem( PNS::ITEM* aItem ) override
+    {
+        m_route->m_removed.push_back( PNS::Clone( *aItem ) );
+    }
+
+    void AddItem( PNS::ITEM* aItem ) override
+    {
+        // The new track or via is created now, to be the parent of the item: later routes
+        // replacing it refer to it
+        BOARD_CONNECTED_ITEM* newItem = createBoardItem( aItem );
+
+        if( newItem )
+        {
+            aItem->SetParent( newItem );
+            m_route->m_added.push_back( PNS::Clone( *aItem ) );
+        }
+    }
+
+    PNS::DEBUG_DECORATOR* GetDebugDecorator() override
+    {
+        return &m_decorator;
+    }
+
+private:
+    PNS_BATCH_ROUTER*        m_batch;
+    PNS_BATCH_ROUTER::ROUTE* m_route;
+    PNS::DEBUG_DECORATOR     m_decorator;
+};
+
+
+PNS_BATCH_ROUTER::PNS_BATCH_ROUTER( BOARD* aBoard ) :
+    m_board( aBoard ),
+    m_progressReporter( nullptr ),
+    m_parallel( true )
+{
+}
+
+
+PNS_BATCH_ROUTER::~PNS_BATCH_ROUTER()
+{
+    m_mergeWorker.reset();
+
+    for( auto& entry : m_newItems )
+        delete entry.first;
+
+    for( BOARD_CONNECTED_ITEM* item : m_garbage )
+        delete item;
+}
+
+
+static bool isRoutable( const BOARD_CONNECTED_ITEM* aItem )
+{
+    // The edges ending on zones are not routed, zones are not items of the router
+    return aItem && ( aItem->Type() == PCB_PAD_T || aItem->Type() == PCB_TRACE_T
+                      || aItem->Type() == PCB_VIA_T );
+}
+
+
+void PNS_BATCH_ROUTER::findConnections()
+{
+    std::vector<CN_EDGE> edges;
+
+    m_board->GetConnectivity()->GetUnconnectedEdges( edges );
+
+    for( const CN_EDGE& edge : edges )
+    {
+        if( !edge.GetSourceNode() || !edge.GetTargetNode() )
+            continue;
+
+        CONNECTION conn;
+
+        conn.m_sourceItem = edge.GetSourceNode()->Parent();
+        conn.m_targetItem = edge.GetTargetNode()->Parent();
+
+        if( !isRoutable( conn.m_sourceItem ) || !isRoutable( conn.m_targetItem ) )
+            continue;
+
+        conn.m_net = conn.m_sourceItem->GetNetCode();
+        conn.m_source = edge.GetSourcePos();
+        conn.m_target = edge.GetTargetPos();
+        conn.m_tile = -1;
+        conn.m_routed = false;
+
+        if( conn.m_source == conn.m_target )
+            continue;
+
+        conn.m_bbox = BOX2I( conn.m_source, conn.m_target - conn.m_source );
+        conn.m_bbox.Inflate( std::max( c_minDetourMargin,
+                                       std::max( conn.m_bbox.GetWidth(),
+                                                 conn.m_bbox.GetHeight() ) / 4 ) );
+
+        if( !m_netSizes.count( conn.m_net ) )
+            m_netSizes[conn.m_net].Init( m_board, nullptr, conn.m_net );
+
+        m_connections.push_back( conn );
+    }
+
+    // Shortest connections first: they have the fewest ways around the obstacles, and
+    // their routes take the least room from the others
+    std::stable_sort( m_connections.begin(), m_connections.end(),
+            []( const CONNECTION& aA, const CONNECTION& aB )
+            {
+                int64_t lenA = std::abs( (int64_t) aA.m_target.x - aA.m_source.x )
+                               + std::abs( (int64_t) aA.m_target.y - aA.m_source.y );
+                int64_t lenB = std::abs( (int64_t) aB.m_target.x - aB.m_source.x )
+                               + std::abs( (int64_t) aB.m_target.y - aB.m_source.y );
+
+                if( lenA != lenB )
+                    return lenA < lenB;
+
+                return aA.m_net < aB.m_net;
+            } );
+
+    m_stats.m_connections = m_connections.size();
+}
+
+
+void PNS_BATCH_ROUTER::assignTiles( int aTileCount )
+{
+    BOX2I area = m_connections.front().m_bbox;
+
+    for( const CONNECTION& conn : m_connections )
+        area.Merge( conn.m_bbox );
+
+    int64_t tileWidth = (int64_t) area.GetWidth() / aTileCount + 1;
+    int64_t tileHeight = (int64_t) area.GetHeight() / aTileCount + 1;
+
+    m_tiles.assign( aTileCount * aTileCount, std::vector<int>() );
+
+    for( size_t ii = 0; ii < m_connections.size(); ++ii )
+    {
+        CONNECTION& conn = m_connections[ii];
+
+        int x0 = ( (int64_t) conn.m_bbox.GetLeft() - area.GetLeft() ) / tileWidth;
+        int x1 = ( (int64_t) conn.m_bbox.GetRight() - area.GetLeft() ) / tileWidth;
+        int y0 = ( (int64_t) conn.m_bbox.GetTop() - area.GetTop() ) / tileHeight;
+        int y1 = ( (int64_t) conn.m_bbox.GetBottom() - area.GetTop() ) / tileHeight;
+
+        if( x0 == x1 && y0 == y1 )
+        {
+            conn.m_tile = y0 * aTileCount + x0;
+            m_tiles[conn.m_tile].push_back( ii );
+        }
+    }
+}
+
+
+std::unique_ptr<PNS_BATCH_ROUTER::WORKER> PNS_BATCH_ROUTER::makeWorker( PNS::PNS_MODE aMode )
+{
+    std::unique_ptr<WORKER> worker( new WORKER );
+    PNS::ROUTING_SETTINGS   settings = m_settings;
+
+    settings.SetMode( aMode );
+
+    worker->m_iface.reset( new PNS_BATCH_IFACE( this ) );
+    worker->m_iface->SetBoard( m_board );
+
+    worker->m_router.reset( new PNS::ROUTER );
+    worker->m_router->SetInterface( worker->m_iface.get() );
+    worker->m_router->SetMode( PNS::PNS_MODE_ROUTE_SINGLE );
+    worker->m_router->ClearWorld();
+    worker->m_router->SyncWorld();
+    worker->m_router->LoadSettings( settings );
+
+    return worker;
+}
+
+
+/**
+ * Finds the item of the world at one end of a connection.  The item of the board may have
+ * been replaced by a route (a track merged with a new segment), the item found at its
+ * position then takes its place.
+ */
+static PNS::ITEM* findEndItem( PNS::NODE* aWorld, BOARD_CONNECTED_ITEM* aParent,
+                               const VECTOR2I& aPos, int aNet )
+{
+    if( PNS::ITEM* item = aWorld->FindItemByParent( aParent ) )
+        return item;
+
+    const PNS::ITEM_SET hits = aWorld->HitTest( aPos );
+    PNS::ITEM*          best = nullptr;
+
+    for( PNS::ITEM* item : hits.CItems() )
+    {
+        if( item->Net() != aNet
+                || !item->OfKind( PNS::ITEM::SOLID_T | PNS::ITEM::VIA_T | PNS::ITEM::SEGMENT_T ) )
+        {
+            continue;
+        }
+
+        // Pads and vias first
+        if( !best || best->OfKind( PNS::ITEM::SEGMENT_T ) )
+            best = item;
+    }
+
+    return best;
+}
+
+
+bool PNS_BATCH_ROUTER::routeConnection( WORKER& aWorker, const CONNECTION& aConnection,
+                                        ROUTE& aRoute )
+{
+    PNS::ROUTER* router = aWorker.m_router.get();
+    PNS::ITEM*   start = findEndItem( router->GetWorld(), aConnection.m_sourceItem,
+                                      aConnection.m_source, aConnection.m_net );
+    PNS::ITEM*   end = findEndItem( router->GetWorld(), aConnection.m_targetItem,
+                                    aConnection.m_target, aConnection.m_net );
+
+    if( !start || !end )
+        return false;
+
+    // Layer changes are not handled: the route stays on a layer of both ends, the top one
+    // first, then the bottom one
+    int top = std::max( start->Layers().Start(), end->Layers().Start() );
+    int bottom = std::min( start->Layers().End(), end->Layers().End() );
+
+    if( top > bottom )
+        return false;
+
+    router->UpdateSizes( m_netSizes.at( aConnection.m_net ) );
+    aWorker.m_iface->SetRoute( &aRoute );
+
+    for( int layer = top; layer <= bottom; layer += std::max( 1, bottom - top ) )
+    {
+        if( !m_board->IsLayerEnabled( ToLAYER_ID( layer ) ) )
+            continue;
+
+        if( !router->StartRouting( aConnection.m_source, start, layer ) )
+            continue;
+
+        router->Move( aConnection.m_target, end );
+
+        // The walkaround stops the route at the obstacles it cannot avoid
+        auto            placer = static_cast<PNS::LINE_PLACER*>( router->Placer() );
+        const PNS::LINE trace = placer->Trace();
+
+        if( trace.PointCount() && trace.CPoint( -1 ) == aConnection.m_target
+                && router->FixRoute( aConnection.m_target, end ) )
+        {
+            aWorker.m_iface->SetRoute( nullptr );
+            return true;
+        }
+
+        router->StopRouting();
+    }
+
+    aWorker.m_iface->SetRoute( nullptr );
+    return false;
+}
+
+
+void PNS_BATCH_ROUTER::routeTile( WORKER& aWorker, int aTile, std::vector<ROUTE>& aRoutes )
+{
+    for( int idx : m_tiles[aTile] )
+    {
+        ROUTE route;
+
+        route.m_connection = idx;
+
+        if( routeConnection( aWorker, m_connections[idx], route ) )
+            aRoutes.push_back( std::move( route ) );
+
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
+    }
+
+    // Each tile is routed against the board as it was before the batch, whichever worker
+    // routes it, so that the result does not depend on the scheduling of the tiles
+    revertRoutes( aWorker, aRoutes );
+}
+
+
+void PNS_BATCH_ROUTER::revertRoutes( WORKER& aWorker, std::vector<ROUTE>& aRoutes )
+{
+    PNS::NODE* world = aWorker.m_router->GetWorld();
+
+    for( auto route = aRoutes.rbegin(); route != aRoutes.rend(); ++route )
+    {
+        for( const auto& item : route->m_added )
+        {
+            if( PNS::ITEM* routerItem = world->FindItemByParent( item->Parent() ) )
+                world->Remove( routerItem );
+        }
+
+        for( const auto& item : route->m_removed )
+            world->Add( PNS::Clone( *item ) );
+    }
+}
+
+
+bool PNS_BATCH_ROUTER::mergeRoute( ROUTE& aRoute )
+{
+    PNS::NODE* world = m_mergeWorker->m_router->GetWorld();
+
+    // The items replaced by the route may have been replaced by another tile already
+    for( const auto& item : aRoute.m_removed )
+    {
+        if( !item->Parent() || !world->FindItemByParent( item->Parent() ) )
+            return false;
+    }
+
+    for( const auto& item : aRoute.m_added )
+    {
+        if( world->CheckColliding( item.get() ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+void PNS_BATCH_ROUTER::commitRoute( ROUTE& aRoute, PNS::NODE* aWorld )
+{
+    for( const auto& item : aRoute.m_removed )
+    {
+        BOARD_CONNECTED_ITEM* parent = item->Parent();
+
+        if( !parent )
+            continue;
+
+        if( aWorld )
+        {
+            if( PNS::ITEM* routerItem = aWorld->FindItemByParent( parent ) )
+                aWorld->Remove( routerItem );
+        }
+
+        auto it = m_newItems.find( parent );
+
+        // A route of the batch replaced by this one
+        if( it != m_newItems.end() )
+        {
+            m_newItems.erase( it );
+            m_garbage.push_back( parent );
+        }
+        else
+        {
+            m_removedItems.insert( parent );
+        }
+    }
+
+    for( auto& item : aRoute.m_added )
+    {
+        BOARD_CONNECTED_ITEM* parent = item->Parent();
+
+        if( aWorld )
+            aWorld->Add( PNS::Clone( *item ) );
+
+        m_newOrder.push_back( parent );
+        m_newItems[parent] = std::move( item );
+    }
+
+    m_connections[aRoute.m_connection].m_routed = true;
+}
+
+
+void PNS_BATCH_ROUTER::discardRoute( ROUTE& aRoute )
+{
+    for( const auto& item : aRoute.m_added )
+        m_garbage.push_back( item->Parent() );
+}
+
+
+bool PNS_BATCH_ROUTER::routeParallel()
+{
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+
+    if( !m_parallel || pool.GetThreadCount() < 2 )
+        return true;
+
+    // A few tiles per thread, so that the threads are kept busy when the tiles are uneven
+    assignTiles( (int) std::ceil( std::sqrt( 4.0 * pool.GetThreadCount() ) ) );
+
+    std::vector<int> tiles;
+    size_t           tiledCount = 0;
+
+    for( size_t ii = 0; ii < m_tiles.size(); ++ii )
+    {
+        if( !m_tiles[ii].empty() )
+        {
+            tiles.push_back( ii );
+            tiledCount += m_tiles[ii].size();
+        }
+    }
+
+    m_stats.m_tiles = tiles.size();
+
+    if( tiles.size() < 2 )
+        return true;
+
+    if( m_progressReporter )
+    {
+        m_progressReporter->Report( _( "Routing connections in parallel..." ) );
+        m_progressReporter->SetMaxProgress( tiledCount );
+    }
+
+    PROF_COUNTER counter;
+
+    // The worlds are synchronized from the board in the main thread: it may ask the user
+    // about malformed zones
+    std::vector<std::unique_ptr<WORKER>> workers;
+
+    for( size_t ii = 0; ii < std::min( pool.GetThreadCount(), tiles.size() ); ++ii )
+        workers.push_back( makeWorker( PNS::RM_Walkaround ) );
+
+    m_mergeWorker = makeWorker( PNS::RM_Walkaround );
+
+    std::vector<std::vector<ROUTE>> routes( tiles.size() );
+    std::atomic<size_t>             nextTile( 0 );
+    std::atomic<size_t>             nextWorker( 0 );
+    TASK_GROUP                      tasks;
+
+    tasks.Run( [&]()
+            {
+                WORKER& worker = *workers[nextWorker++];
+
+                for( size_t ii = nextTile++; ii < tiles.size() && !tasks.IsCancelled();
+                        ii = nextTile++ )
+                {
+                    routeTile( worker, tiles[ii], routes[ii] );
+                }
+            },
+            workers.size() );
+
+    bool completed = tasks.WaitAndRefresh( m_progressReporter, true );
+
+    // The routes are merged in the order of the tiles
+    PNS::NODE* mergeWorld = m_mergeWorker->m_router->GetWorld();
+
+    for( std::vector<ROUTE>& tileRoutes : routes )
+    {
+        for( ROUTE& route : tileRoutes )
+        {
+            if( !completed )
+            {
+                discardRoute( route );
+            }
+            else if( mergeRoute( route ) )
+            {
+                commitRoute( route, mergeWorld );
+                m_stats.m_routedInParallel++;
+            }
+            else
+            {
+                discardRoute( route );
+                m_stats.m_conflicts++;
+            }
+        }
+    }
+
+    workers.clear();
+    m_mergeWorker.reset();
+
+    m_stats.m_parallelMsecs = counter.msecs();
+
+    return completed;
+}
+
+
+bool PNS_BATCH_ROUTER::routeSerial()
+{
+    std::vector<int> remaining;
+
+    for( size_t ii = 0; ii < m_connections.size(); ++ii )
+    {
+        if( !m_connections[ii].m_routed )
+            remaining.push_back( ii );
+    }
+
+    if( remaining.empty() )
+        return true;
+
+    if( m_progressReporter )
+    {
+        m_progressReporter->Report( _( "Routing remaining connections..." ) );
+        m_progressReporter->SetMaxProgress( remaining.size() );
+    }
+
+    PROF_COUNTER counter;
+
+    // The marking of obstacles would give routes violating the clearances
+    PNS::PNS_MODE mode = m_settings.Mode();
+
+    if( mode == PNS::RM_MarkObstacles )
+        mode = PNS::RM_Walkaround;
+
+    std::unique_ptr<WORKER> worker = makeWorker( mode );
+
+    for( int idx : remaining )
+    {
+        ROUTE route;
+
+        route.m_connection = idx;
+
+        if( routeConnection( *worker, m_connections[idx], route ) )
+            commitRoute( route, nullptr );
+
+        if( m_progressReporter )
+        {
+            m_progressReporter->AdvanceProgress();
+
+            if( !m_progressReporter->KeepRefreshing() )
+                return false;
+        }
+    }
+
+    m_stats.m_serialMsecs = counter.msecs();
+
+    return true;
+}
+
+
+bool PNS_BATCH_ROUTER::Route()
+{
+    findConnections();
+
+    if( m_connections.empty() )
+        return true;
+
+    if( m_progressReporter )
+        m_progressReporter->BeginPhase( 0 );
+
+    if( !routeParallel() )
+        return false;
+
+    if( m_progressReporter )
+        m_progressReporter->AdvancePhase();
+
+    if( !routeSerial() )
+        return false;
+
+    for( const CONNECTION& conn : m_connections )
+    {
+        if( conn.m_routed )
+            m_stats.m_routed++;
+        else
+            m_stats.m_failed++;
+    }
+
+    return true;
+}
+
+
+void PNS_BATCH_ROUTER::GetChanges( std::vector<BOARD_CONNECTED_ITEM*>& aAdded,
+                                   std::vector<BOARD_CONNECTED_ITEM*>& aRemoved )
+{
+    for( BOARD_CONNECTED_ITEM* item : m_newOrder )
+    {
+        if( m_newItems.erase( item ) )
+            aAdded.push_back( item );
+    }
+
+    m_newOrder.clear();
+
+    aRemoved.insert( aRemoved.end(), m_removedItems.begin(), m_removedItems.end() );
+    m_removedItems.clear();
+}
@@ -0,0 +1,221 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PNS_BATCH_ROUTER_H
+#define __PNS_BATCH_ROUTER_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <math/box2.h>
+#include <math/vector2d.h>
+
+#include "pns_routing_settings.h"
+#include "pns_sizes_settings.h"
+
+class BOARD;
+class BOARD_CONNECTED_ITEM;
+class PROGRESS_REPORTER;
+class PNS_BATCH_IFACE;
+
+namespace PNS {
+
+class ITEM;
+class NODE;
+class ROUTER;
+
+}
+
+/**
+ * Class PNS_BATCH_ROUTER
+ *
+ * Routes the unconnected edges of the ratsnest with the push and shove router, without
+ * user interaction.  The connections are routed shortest first, on a copper layer common
+ * to both of their ends.
+ *
+ * The board is divided in tiles.  The connections which fit in a tile are first routed in
+ * parallel, in walkaround mode, by one router per thread.  Each tile is routed against the
+ * board as it was before the batch, then the routes are merged in the order of the tiles:
+ * a route colliding with the route of another tile is rejected.  The connections spanning
+ * several tiles, the rejected ones and the ones which failed are then routed one after the
+ * other, in the mode of the routing settings, against the merged routes.
+ *
+ * The board is not modified: the new tracks and vias, and the removed ones, are given by
+ * GetChanges().
+ */
+class PNS_BATCH_ROUTER
+{
+public:
+    struct STATS
+    {
+        int    m_connections = 0;       ///< unconnected edges of the ratsnest
+        int    m_routed = 0;
+        int    m_routedInParallel = 0;  ///< routes of the tiles kept by the merge
+        int    m_conflicts = 0;         ///< routes of the tiles rejected by the merge
+        int    m_failed = 0;
+        int    m_tiles = 0;
+        double m_parallelMsecs = 0.0;
+        double m_serialMsecs = 0.0;
+    };
+
+    PNS_BATCH_ROUTER( BOARD* aBoard );
+    ~PNS_BATCH_ROUTER();
+
+    /**
+     * Sets the routing settings.  The parallel phase always runs in walkaround mode,
+     * the mode of the settings is used for the final serial phase.
+     */
+    void SetSettings( const PNS::ROUTING_SETTINGS& aSettings )
+    {
+        m_settings = aSettings;
+    }
+
+    void SetProgressReporter( PROGRESS_REPORTER* aReporter )
+    {
+        m_progressReporter = aReporter;
+    }
+
+    /**
+     * Enables the parallel routing of the tiles.  When disabled, all the connections are
+     * routed one after the other.
+     */
+    void SetParallel( bool aParallel )
+    {
+        m_parallel = aParallel;
+    }
+
+    /**
+     * Function Route()
+     *
+     * Routes the unconnected edges of the ratsnest of the board, which must be up to date.
+     * @return false if cancelled through the progress reporter.
+     */
+    bool Route();
+
+    /**
+     * Function GetChanges()
+     *
+     * Gives the result of Route(): the new tracks and vias, whose ownership goes to the
+     * caller, and the items of the board to delete.
+     */
+    void GetChanges( std::vector<BOARD_CONNECTED_ITEM*>& aAdded,
+                     std::vector<BOARD_CONNECTED_ITEM*>& aRemoved );
+
+    const STATS& Stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    friend class PNS_BATCH_IFACE;
+
+    ///> An unconnected edge of the ratsnest
+    struct CONNECTION
+    {
+        int                   m_net;
+        VECTOR2I              m_source;
+        VECTOR2I              m_target;
+        BOARD_CONNECTED_ITEM* m_sourceItem;
+        BOARD_CONNECTED_ITEM* m_targetItem;
+        BOX2I                 m_bbox;      ///< area of the route, with room for detours
+        int                   m_tile;      ///< -1 if the connection spans several tiles
+        bool                  m_routed;
+    };
+
+    ///> The changes made by the route of a connection, as copies of the router items
+    struct ROUTE
+    {
+        int                                      m_connection;
+        std::vector<std::unique_ptr<PNS::ITEM>>  m_added;    ///< parents are new items
+        std::vector<std::unique_ptr<PNS::ITEM>>  m_removed;
+    };
+
+    ///> A router with its own world, for the parallel phase
+    struct WORKER
+    {
+        std::unique_ptr<PNS_BATCH_IFACE> m_iface;
+        std::unique_ptr<PNS::ROUTER>     m_router;
+    };
+
+    void findConnections();
+    void assignTiles( int aTileCount );
+
+    std::unique_ptr<WORKER> makeWorker( PNS::PNS_MODE aMode );
+
+    /**
+     * Routes aConnection with aRouter, trying each layer common to both of its ends.
+     * @return true if the route reached the end of the connection.  The changes made
+     * to the world of the router are then stored in aRoute.
+     */
+    bool routeConnection( WORKER& aWorker, const CONNECTION& aConnection, ROUTE& aRoute );
+
+    void routeTile( WORKER& aWorker, int aTile, std::vector<ROUTE>& aRoutes );
+
+    /**
+     * Undoes the changes of aRoutes in the world of aWorker.
+     */
+    void revertRoutes( WORKER& aWorker, std::vector<ROUTE>& aRoutes );
+
+    /**
+     * Adds a route of the parallel phase to the merged routes.
+     * @return false if the route collides with a route of another tile.
+     */
+    bool mergeRoute( ROUTE& aRoute );
+
+    /**
+     * Adds the changes of aRoute to the result of the batch.
+     * @param aWorld is a world to update too, if the route was not made in it.
+     */
+    void commitRoute( ROUTE& aRoute, PNS::NODE* aWorld );
+
+    void discardRoute( ROUTE& aRoute );
+
+    bool routeParallel();
+    bool routeSerial();
+
+    BOARD*                   m_board;
+    PNS::ROUTING_SETTINGS    m_settings;
+    PROGRESS_REPORTER*       m_progressReporter;
+    bool                     m_parallel;
+
+    std::vector<CONNECTION>  m_connections;
+    std::vector<std::vector<int>> m_tiles;     ///< the connections of each tile, in order
+    std::map<int, PNS::SIZES_SETTINGS> m_netSizes;
+
+    ///> Routed tracks and vias, with their copy in the router worlds
+    std::map<BOARD_CONNECTED_ITEM*, std::unique_ptr<PNS::ITEM>> m_newItems;
+
+    ///> The routed tracks and vias in the order they were created, some may be replaced
+    std::vector<BOARD_CONNECTED_ITEM*> m_newOrder;
+
+    ///> Tracks and vias of the board replaced by the routes
+    std::set<BOARD_CONNECTED_ITEM*> m_removedItems;
+
+    ///> New items of the rejected or replaced routes, deleted with the batch router
+    std::vector<BOARD_CONNECTED_ITEM*> m_garbage;
+
+    ///> The merged routes of the parallel phase, to check the routes of the other tiles
+    std::unique_ptr<WORKER>  m_mergeWorker;
+
+    STATS                    m_stats;
+};
+
+#endif
@@ -32,6 +32,7 @@
 #include <geometry/shape_index.h>
 
 #include "pns_item.h"
+#include "pns_pool.h"
 
 namespace PNS {
 
@@ -53,6 +54,8 @@ public:
     INDEX();
     ~INDEX();
 
+    PNS_POOLED_OBJECT( INDEX )
+
     /**
      * Function Add()
      *
@@ -33,6 +33,7 @@
 #include <layers_id_colors_and_visibility.h>
 #include <geometry/convex_hull.h>
 #include <confirm.h>
+#include <kicad_plugin.h>
 
 #include <view/view.h>
 #include <view/view_item.h>
@@ -1164,7 +1165,7 @@ void PNS_KICAD_IFACE::RemoveItem( PNS::ITEM* aItem )
 }
 
 
-void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
+BOARD_CONNECTED_ITEM* PNS_KICAD_IFACE::createBoardItem( const PNS::ITEM* aItem )
 {
     BOARD_CONNECTED_ITEM* newBI = NULL;
 
@@ -1172,7 +1173,7 @@ void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
     {
     case PNS::ITEM::SEGMENT_T:
     {
-        PNS::SEGMENT* seg = static_cast<PNS::SEGMENT*>( aItem );
+        const PNS::SEGMENT* seg = static_cast<const PNS::SEGMENT*>( aItem );
         TRACK* track = new TRACK( m_board );
         const SEG& s = seg->Seg();
         track->SetStart( wxPoint( s.A.x, s.A.y ) );
@@ -1187,7 +1188,7 @@ void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
     case PNS::ITEM::VIA_T:
     {
         VIA* via_board = new VIA( m_board );
-        PNS::VIA* via = static_cast<PNS::VIA*>( aItem );
+        const PNS::VIA* via = static_cast<const PNS::VIA*>( aItem );
         via_board->SetPosition( wxPoint( via->Pos().x, via->Pos().y ) );
         via_board->SetWidth( via->Diameter() );
         via_board->SetDrill( via->Drill() );
@@ -1204,10 +1205,19 @@ void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
     }
 
     if( newBI )
-    {
-        aItem->SetParent( newBI );
         newBI->ClearFlags();
 
+    return newBI;
+}
+
+
+void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
+{
+    BOARD_CONNECTED_ITEM* newBI = createBoardItem( aItem );
+
+    if( newBI )
+    {
+        aItem->SetParent( newBI );
         m_commit->Add( newBI );
     }
 }
@@ -1248,6 +1258,23 @@ void PNS_KICAD_IFACE::UpdateNet( int aNetCode )
 }
 
 
+bool PNS_KICAD_IFACE::SaveBoard( const wxString& aFileName )
+{
+    try
+    {
+        PCB_IO io;
+        io.Save( aFileName, m_board );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        wxLogTrace( "PNS", "Cannot save the board: %s", ioe.What() );
+        return false;
+    }
+
+    return true;
+}
+
+
 PNS::RULE_RESOLVER* PNS_KICAD_IFACE::GetRuleResolver()
 {
     return m_ruleResolver;
@@ -59,10 +59,18 @@ public:
     void Commit() override;
 
     void UpdateNet( int aNetCode ) override;
+    bool SaveBoard( const wxString& aFileName ) override;
 
     PNS::RULE_RESOLVER* GetRuleResolver() override;
     PNS::DEBUG_DECORATOR* GetDebugDecorator() override;
 
+protected:
+    /**
+     * Creates the track or via matching a segment or via of the router.
+     * @return the new item, not added to the board, or nullptr for other kinds of items.
+     */
+    BOARD_CONNECTED_ITEM* createBoardItem( const PNS::ITEM* aItem );
+
 private:
     PNS_PCBNEW_RULE_RESOLVER* m_ruleResolver;
     PNS_PCBNEW_DEBUG_DECORATOR* m_debugDecorator;
@@ -49,6 +49,8 @@ NODE::NODE()
 {
     wxLogTrace( "PNS", "NODE::create %p", this );
     m_depth = 0;
+    m_revision = 0;
+    m_parentRevision = 0;
     m_root = this;
     m_parent = NULL;
     m_maxClearance = 800000;    // fixme: depends on how thick traces are.
@@ -114,26 +116,17 @@ NODE* NODE::Branch()
 
     child->m_depth = m_depth + 1;
     child->m_parent = this;
+    child->m_parentRevision = m_revision;
     child->m_ruleResolver = m_ruleResolver;
     child->m_root = isRoot() ? this : m_root;
     child->m_maxClearance = m_maxClearance;
 
-    // immmediate offspring of the root branch needs not copy anything.
-    // For the rest, deep-copy joints, overridden item map and pointers
-    // to stored items.
-    if( !isRoot() )
-    {
-        JOINT_MAP::iterator j;
+    // The items and joints of the parents are not copied: the branch looks them up in
+    // its parents.  Only the set of the removed items is copied, as it is checked for every
+    // item found in the parents.
+    child->m_override = m_override;
 
-        for( INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-            child->m_index->Add( *i );
-
-        child->m_joints = m_joints;
-        child->m_override = m_override;
-    }
-
-    wxLogTrace( "PNS", "%d items, %d joints, %d overrides",
-            child->m_index->Size(), (int) child->m_joints.size(), (int) child->m_override.size() );
+    wxLogTrace( "PNS", "%d overrides", (int) child->m_override.size() );
 
     return child;
 }
@@ -148,6 +141,22 @@ void NODE::unlinkParent()
 }
 
 
+void NODE::assertParentsUnchanged() const
+{
+#ifdef DEBUG
+    for( const NODE* node = this; node->m_parent; node = node->m_parent )
+    {
+        if( node->m_parentRevision != node->m_parent->m_revision )
+        {
+            wxLogTrace( "PNS", "branch %p sees parent %p changed after branching",
+                        node, node->m_parent );
+            assert( false );
+        }
+    }
+#endif
+}
+
+
 OBSTACLE_VISITOR::OBSTACLE_VISITOR( const ITEM* aItem ) :
     m_item( aItem ),
     m_node( NULL ),
@@ -260,14 +269,13 @@ struct NODE::DEFAULT_OBSTACLE_VISITOR : public OBSTACLE_VISITOR
 
 int NODE::QueryColliding( const ITEM* aItem, OBSTACLE_VISITOR& aVisitor )
 {
-    aVisitor.SetWorld( this, NULL );
-    m_index->Query( aItem, m_maxClearance, aVisitor );
+    assertParentsUnchanged();
 
-    // if we haven't found enough items, look in the root branch as well.
-    if( !isRoot() )
+    // look in this branch, then in the parent branches up to the root.
+    for( NODE* node = this; node; node = node->m_parent )
     {
-        aVisitor.SetWorld( m_root, this );
-        m_root->m_index->Query( aItem, m_maxClearance, aVisitor );
+        aVisitor.SetWorld( node, node == this ? NULL : this );
+        node->m_index->Query( aItem, m_maxClearance, aVisitor );
     }
 
     return 0;
@@ -283,17 +291,20 @@ int NODE::QueryColliding( const ITEM* aItem,
     assert( allocNodes.find( this ) != allocNodes.end() );
 #endif
 
+    assertParentsUnchanged();
+
     visitor.SetCountLimit( aLimitCount );
-    visitor.SetWorld( this, NULL );
     visitor.m_forceClearance = aForceClearance;
-    // first, look for colliding items in the local index
-    m_index->Query( aItem, m_maxClearance, visitor );
 
-    // if we haven't found enough items, look in the root branch as well.
-    if( !isRoot() && ( visitor.m_matchCount < aLimitCount || aLimitCount < 0 ) )
+    // first, look for colliding items in the local index, then, if we haven't found
+    // enough items, in the parent branches up to the root.
+    for( NODE* node = this; node; node = node->m_parent )
     {
-        visitor.SetWorld( m_root, this );
-        m_root->m_index->Query( aItem, m_maxClearance, visitor );
+        if( node != this && visitor.m_matchCount >= aLimitCount && aLimitCount >= 0 )
+            break;
+
+        visitor.SetWorld( node, node == this ? NULL : this );
+        node->m_index->Query( aItem, m_maxClearance, visitor );
     }
 
     return aObstacles.size();
@@ -506,23 +517,21 @@ const ITEM_SET NODE::HitTest( const VECTOR2I& aPoint ) const
 {
     ITEM_SET items;
 
+    assertParentsUnchanged();
+
     // fixme: we treat a point as an infinitely small circle - this is inefficient.
     SHAPE_CIRCLE s( aPoint, 0 );
-    HIT_VISITOR visitor( items, aPoint );
-    visitor.SetWorld( this, NULL );
-
-    m_index->Query( &s, m_maxClearance, visitor );
 
-    if( !isRoot() )    // fixme: could be made cleaner
+    for( const NODE* node = this; node; node = node->m_parent )
     {
-        ITEM_SET items_root;
-        visitor.SetWorld( m_root, NULL );
-        HIT_VISITOR  visitor_root( items_root, aPoint );
-        m_root->m_index->Query( &s, m_maxClearance, visitor_root );
+        ITEM_SET items_node;
+        HIT_VISITOR visitor( items_node, aPoint );
 
-        for( ITEM* item : items_root.Items() )
+        node->m_index->Query( &s, m_maxClearance, visitor );
+
+        for( ITEM* item : items_node.Items() )
         {
-            if( !Overrides( item ) )
+            if( node == this || !Overrides( item ) )
                 items.Add( item );
         }
     }
@@ -533,6 +542,7 @@ const ITEM_SET NODE::HitTest( const VECTOR2I& aPoint ) const
 
 void NODE::addSolid( SOLID* aSolid )
 {
+    m_revision++;
     linkJoint( aSolid->Pos(), aSolid->Layers(), aSolid->Net(), aSolid );
     m_index->Add( aSolid );
 }
@@ -545,6 +555,7 @@ void NODE::Add( std::unique_ptr< SOLID > aSolid )
 
 void NODE::addVia( VIA* aVia )
 {
+    m_revision++;
     linkJoint( aVia->Pos(), aVia->Layers(), aVia->Net(), aVia );
     m_index->Add( aVia );
 }
@@ -586,6 +597,7 @@ void NODE::Add( LINE& aLine, bool aAllowRedundant )
 
 void NODE::addSegment( SEGMENT* aSeg )
 {
+    m_revision++;
     linkJoint( aSeg->Seg().A, aSeg->Layers(), aSeg->Net(), aSeg );
     linkJoint( aSeg->Seg().B, aSeg->Layers(), aSeg->Net(), aSeg );
 
@@ -637,14 +649,15 @@ void NODE::Add( std::unique_ptr< ITEM > aItem, bool aAllowRedundant )
 
 void NODE::doRemove( ITEM* aItem )
 {
-    // case 1: removing an item that is stored in the root node from any branch:
-    // mark it as overridden, but do not remove
-    if( aItem->BelongsTo( m_root ) && !isRoot() )
+    m_revision++;
+
+    // case 1: removing an item that is stored in a parent branch or in the root node
+    // from a branch: mark it as overridden, but do not remove
+    if( !isRoot() && !m_index->Contains( aItem ) )
         m_override.insert( aItem );
 
-    // case 2: the item belongs to this branch or a parent, non-root branch,
-    // or the root itself and we are the root: remove from the index
-    else if( !aItem->BelongsTo( m_root ) || isRoot() )
+    // case 2: the item is stored in this branch, or we are the root: remove from the index
+    else
         m_index->Remove( aItem );
 
     // the item belongs to this particular branch: un-reference it
@@ -679,6 +692,9 @@ void NODE::removeViaIndex( VIA* aVia )
     tag.net = net;
     tag.pos = p;
 
+    // the joints may still be those of a parent branch: work on a copy of them
+    copyJoints( tag );
+
     bool split;
     do
     {
@@ -707,6 +723,10 @@ void NODE::removeViaIndex( VIA* aVia )
         if( item != aVia )
             linkJoint( p, item->Layers(), net, item );
     }
+
+    // keep an empty joint, so the joints of the parents do not show through
+    if( !isRoot() && m_joints.find( tag ) == m_joints.end() )
+        m_joints.insert( TagJointPair( tag, JOINT( p, vLayers, net ) ) );
 }
 
 void NODE::removeSolidIndex( SOLID* aSolid )
@@ -975,10 +995,15 @@ JOINT* NODE::FindJoint( const VECTOR2I& aPos, int aLayer, int aNet )
 
     JOINT_MAP::iterator f = m_joints.find( tag ), end = m_joints.end();
 
-    if( f == end && !isRoot() )
+    if( f == end )
+        assertParentsUnchanged();
+
+    // the joints of a position not changed in this branch are those of the nearest
+    // parent which changed them, or of the root.
+    for( NODE* node = m_parent; f == end && node; node = node->m_parent )
     {
-        end = m_root->m_joints.end();
-        f = m_root->m_joints.find( tag );    // m_root->FindJoint(aPos, aLayer, aNet);
+        end = node->m_joints.end();
+        f = node->m_joints.find( tag );
     }
 
     if( f == end )
@@ -1010,22 +1035,15 @@ JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int a
     tag.pos = aPos;
     tag.net = aNet;
 
-    // try to find the joint in this node.
-    JOINT_MAP::iterator f = m_joints.find( tag );
-
-    std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range;
-
-    // not found and we are not root? find in the root and copy results here.
-    if( f == m_joints.end() && !isRoot() )
-    {
-        range = m_root->m_joints.equal_range( tag );
+    m_revision++;
 
-        for( f = range.first; f != range.second; ++f )
-            m_joints.insert( *f );
-    }
+    // not found in this node? copy the joints of the parents here.
+    copyJoints( tag );
 
     // now insert and combine overlapping joints
     JOINT jt( aPos, aLayers, aNet );
+    JOINT_MAP::iterator f;
+    std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range;
 
     bool merged;
 
@@ -1054,6 +1072,29 @@ JOINT& NODE::touchJoint( const VECTOR2I& aPos, const LAYER_RANGE& aLayers, int a
 }
 
 
+void NODE::copyJoints( const JOINT::HASH_TAG& aTag )
+{
+    if( isRoot() || m_joints.find( aTag ) != m_joints.end() )
+        return;
+
+    assertParentsUnchanged();
+
+    for( NODE* node = m_parent; node; node = node->m_parent )
+    {
+        std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range =
+                node->m_joints.equal_range( aTag );
+
+        if( range.first == range.second )
+            continue;
+
+        for( JOINT_MAP::iterator f = range.first; f != range.second; ++f )
+            m_joints.insert( *f );
+
+        return;
+    }
+}
+
+
 void JOINT::Dump() const
 {
     wxLogTrace( "PNS", "joint layers %d-%d, net %d, pos %s, links: %d", m_layers.Start(),
@@ -1161,6 +1202,30 @@ void NODE::Dump( bool aLong )
 }
 
 
+template <class FUNC>
+void NODE::forEachBranchItem( FUNC aFunc )
+{
+    if( isRoot() )
+    {
+        for( ITEM* item : *m_index )
+            aFunc( item );
+
+        return;
+    }
+
+    assertParentsUnchanged();
+
+    for( NODE* node = this; node != m_root; node = node->m_parent )
+    {
+        for( ITEM* item : *node->m_index )
+        {
+            if( node == this || !Overrides( item ) )
+                aFunc( item );
+        }
+    }
+}
+
+
 void NODE::GetUpdatedItems( ITEM_VECTOR& aRemoved, ITEM_VECTOR& aAdded )
 {
     aRemoved.reserve( m_override.size() );
@@ -1169,11 +1234,14 @@ void NODE::GetUpdatedItems( ITEM_VECTOR& aRemoved, ITEM_VECTOR& aAdded )
     if( isRoot() )
         return;
 
+    // the items of the parent branches removed here were never in the root
     for( ITEM* item : m_override )
-        aRemoved.push_back( item );
+    {
+        if( item->BelongsTo( m_root ) )
+            aRemoved.push_back( item );
+    }
 
-    for( INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-        aAdded.push_back( *i );
+    forEachBranchItem( [&]( ITEM* aItem ) { aAdded.push_back( aItem ); } );
 }
 
 void NODE::releaseChildren()
@@ -1209,10 +1277,14 @@ void NODE::Commit( NODE* aNode )
         if( aNode->isRoot() )
             return;
 
-        for( ITEM* item : aNode->m_override )
+        ITEM_VECTOR removed, added;
+
+        aNode->GetUpdatedItems( removed, added );
+
+        for( ITEM* item : removed )
             Remove( item );
 
-        for( auto i : *aNode->m_index )
+        for( ITEM* i : added )
         {
             i->SetRank( -1 );
             i->Unmark();
@@ -1233,43 +1305,41 @@ void NODE::KillChildren()
 
 void NODE::AllItemsInNet( int aNet, std::set<ITEM*>& aItems )
 {
-    INDEX::NET_ITEMS_LIST* l_cur = m_index->GetItemsForNet( aNet );
+    assertParentsUnchanged();
 
-    if( l_cur )
+    for( NODE* node = this; node; node = node->m_parent )
     {
-        for( ITEM*item : *l_cur )
-            aItems.insert( item );
-    }
-
-    if( !isRoot() )
-    {
-        INDEX::NET_ITEMS_LIST* l_root = m_root->m_index->GetItemsForNet( aNet );
+        INDEX::NET_ITEMS_LIST* l_cur = node->m_index->GetItemsForNet( aNet );
 
-        if( l_root )
-            for( INDEX::NET_ITEMS_LIST::iterator i = l_root->begin(); i!= l_root->end(); ++i )
-                if( !Overrides( *i ) )
-                    aItems.insert( *i );
+        if( l_cur )
+        {
+            for( ITEM* item : *l_cur )
+            {
+                if( node == this || !Overrides( item ) )
+                    aItems.insert( item );
+            }
+        }
     }
 }
 
 
 void NODE::ClearRanks( int aMarkerMask )
 {
-    for( INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-    {
-        (*i)->SetRank( -1 );
-        (*i)->Mark( (*i)->Marker() & (~aMarkerMask) );
-    }
+    forEachBranchItem( [aMarkerMask]( ITEM* aItem )
+            {
+                aItem->SetRank( -1 );
+                aItem->Mark( aItem->Marker() & (~aMarkerMask) );
+            } );
 }
 
 
 int NODE::FindByMarker( int aMarker, ITEM_SET& aItems )
 {
-    for( INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-    {
-        if( (*i)->Marker() & aMarker )
-            aItems.Add( *i );
-    }
+    forEachBranchItem( [&]( ITEM* aItem )
+            {
+                if( aItem->Marker() & aMarker )
+                    aItems.Add( aItem );
+            } );
 
     return 0;
 }
@@ -1279,13 +1349,11 @@ int NODE::RemoveByMarker( int aMarker )
 {
     std::list<ITEM*> garbage;
 
-    for( INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-    {
-        if( (*i)->Marker() & aMarker )
-        {
-            garbage.push_back( *i );
-        }
-    }
+    forEachBranchItem( [&]( ITEM* aItem )
+            {
+                if( aItem->Marker() & aMarker )
+                    garbage.push_back( aItem );
+            } );
 
     for( std::list<ITEM*>::const_iterator i = garbage.begin(), end = garbage.end(); i != end; ++i )
     {
@@ -1331,6 +1399,9 @@ ITEM *NODE::FindItemByParent( const BOARD_CONNECTED_ITEM* aParent )
 {
     INDEX::NET_ITEMS_LIST* l_cur = m_index->GetItemsForNet( aParent->GetNetCode() );
 
+    if( !l_cur )
+        return NULL;
+
     for( ITEM*item : *l_cur )
         if( item->Parent() == aParent )
             return item;
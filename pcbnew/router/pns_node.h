@@ -36,6 +36,7 @@
 #include "pns_item.h"
 #include "pns_joint.h"
 #include "pns_itemset.h"
+#include "pns_pool.h"
 
 namespace PNS {
 
@@ -143,6 +144,8 @@ public:
     NODE();
     ~NODE();
 
+    PNS_POOLED_OBJECT( NODE )
+
     ///> Returns the expected clearance between items a and b.
     int GetClearance( const ITEM* aA, const ITEM* aB ) const;
 
@@ -317,8 +320,11 @@ public:
      * Function Branch()
      *
      * Creates a lightweight copy (called branch) of self that tracks
-     * the changes (added/removed items) wrs to the root. Note that if there are
-     * any branches in use, their parents must NOT be deleted.
+     * the changes (added/removed items) wrs to the root. The branch shares the items
+     * and joints of its parents instead of copying them, so creating and deleting it is
+     * cheap. Note that if there are any branches in use, their parents must NOT be deleted,
+     * and must not be changed: the changes would show through in the branches.  Debug
+     * builds assert when a branch looks up a parent changed since it was branched.
      * @return the new branch
      */
     NODE* Branch();
@@ -427,6 +433,15 @@ private:
     NODE( const NODE& aB );
     NODE& operator=( const NODE& aB );
 
+    ///> copies the joints of the parent branches at a position to this branch, before
+    ///> changing them
+    void copyJoints( const JOINT::HASH_TAG& aTag );
+
+    ///> calls aFunc on the items added by this branch and its parents, and not removed
+    ///> since, or on all the items of the root
+    template <class FUNC>
+    void forEachBranchItem( FUNC aFunc );
+
     ///> tries to find matching joint and creates a new one if not found
     JOINT& touchJoint( const VECTOR2I&     aPos,
                        const LAYER_RANGE&  aLayers,
@@ -450,6 +465,10 @@ private:
 
     void doRemove( ITEM* aItem );
     void unlinkParent();
+
+    ///> asserts in debug builds that the parents did not change since this branch was
+    ///> created, as their items and joints are looked up, not copied
+    void assertParentsUnchanged() const;
     void releaseChildren();
     void releaseGarbage();
 
@@ -473,7 +492,8 @@ private:
                      bool        aStopAtLockedJoints );
 
     ///> hash table with the joints, linking the items. Joints are hashed by
-    ///> their position, layer set and net.
+    ///> their position, layer set and net. A branch only stores the joints it changed,
+    ///> the others are those of its parents.
     JOINT_MAP m_joints;
 
     ///> node this node was branched from
@@ -485,7 +505,7 @@ private:
     ///> list of nodes branched from this one
     std::set<NODE*> m_children;
 
-    ///> hash of root's items that have been changed in this node
+    ///> hash of the root's and parent branches' items that have been changed in this node
     std::unordered_set<ITEM*> m_override;
 
     ///> worst case item-item clearance
@@ -494,12 +514,18 @@ private:
     ///> Design rules resolver
     RULE_RESOLVER* m_ruleResolver;
 
-    ///> Geometric/Net index of the items
+    ///> Geometric/Net index of the items added in this node
     INDEX* m_index;
 
     ///> depth of the node (number of parent nodes in the inheritance chain)
     int m_depth;
 
+    ///> number of changes made to the items and joints of this node
+    int m_revision;
+
+    ///> revision of the parent when this branch was created
+    int m_parentRevision;
+
     std::unordered_set<ITEM*> m_garbageItems;
 };
 
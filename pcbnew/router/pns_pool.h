@@ -0,0 +1,178 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PNS_POOL_H
+#define __PNS_POOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace PNS {
+
+/**
+ * Class OBJECT_POOL
+ *
+ * Recycles the memory of the objects of class T.  The shove algorithm creates and
+ * throws away hundreds of branches (and their segments and vias) for each mouse move:
+ * instead of going back to the heap, the freed blocks are kept on a free list and reused
+ * by the next objects.  The memory is allocated in chunks, released by Trim() once the
+ * routing session is over and all the objects are deleted.
+ *
+ * A class uses its pool through the PNS_POOLED_OBJECT() macro.
+ */
+template <class T>
+class OBJECT_POOL
+{
+public:
+    static OBJECT_POOL& Instance()
+    {
+        // Never destroyed, as items may still be deleted by static destructors
+        static OBJECT_POOL* pool = new OBJECT_POOL;
+        return *pool;
+    }
+
+    void* Allocate( size_t aSize )
+    {
+        // Classes derived from T have their own size
+        if( aSize != sizeof( T ) )
+            return ::operator new( aSize );
+
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        if( !m_free )
+            grow();
+
+        BLOCK* block = m_free;
+
+        m_free = block->m_next;
+        m_used++;
+        m_allocations++;
+
+        return &block->m_storage;
+    }
+
+    void Free( void* aPtr, size_t aSize )
+    {
+        if( !aPtr )
+            return;
+
+        if( aSize != sizeof( T ) )
+        {
+            ::operator delete( aPtr );
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        BLOCK* block = static_cast<BLOCK*>( aPtr );
+
+        block->m_next = m_free;
+        m_free = block;
+        m_used--;
+    }
+
+    ///> Returns the number of objects allocated from the pool since its creation.
+    size_t Allocations()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_allocations;
+    }
+
+    ///> Returns the number of objects of the pool currently allocated.
+    size_t Used()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_used;
+    }
+
+    /**
+     * Function Trim()
+     *
+     * Gives the memory of the pool back to the heap, if no object is allocated.
+     */
+    void Trim()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        if( m_used )
+            return;
+
+        for( BLOCK* chunk : m_chunks )
+            delete[] chunk;
+
+        m_chunks.clear();
+        m_free = nullptr;
+    }
+
+private:
+    static const int ChunkSize = 256;
+
+    union BLOCK
+    {
+        BLOCK* m_next;
+        typename std::aligned_storage<sizeof( T ), alignof( T )>::type m_storage;
+    };
+
+    OBJECT_POOL() :
+        m_free( nullptr ),
+        m_used( 0 ),
+        m_allocations( 0 )
+    {
+    }
+
+    void grow()
+    {
+        BLOCK* chunk = new BLOCK[ChunkSize];
+
+        m_chunks.push_back( chunk );
+
+        for( int i = ChunkSize - 1; i >= 0; i-- )
+        {
+            chunk[i].m_next = m_free;
+            m_free = &chunk[i];
+        }
+    }
+
+    std::mutex          m_lock;
+    std::vector<BLOCK*> m_chunks;
+    BLOCK*              m_free;
+    size_t              m_used;
+    size_t              m_allocations;
+};
+
+}
+
+/**
+ * Allocates the objects of class aClass from its OBJECT_POOL.  To be placed in the
+ * declaration of the class.
+ */
+#define PNS_POOLED_OBJECT( aClass )                                                       \
+    static void* operator new( size_t aSize )                                             \
+    {                                                                                     \
+        return PNS::OBJECT_POOL<aClass>::Instance().Allocate( aSize );                    \
+    }                                                                                     \
+    static void operator delete( void* aPtr, size_t aSize )                               \
+    {                                                                                     \
+        PNS::OBJECT_POOL<aClass>::Instance().Free( aPtr, aSize );                         \
+    }
+
+#endif
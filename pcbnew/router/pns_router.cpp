@@ -22,6 +22,9 @@
 #include <cstdio>
 #include <vector>
 
+#include <wx/datetime.h>
+#include <wx/filename.h>
+
 #include <view/view.h>
 #include <view/view_item.h>
 #include <view/view_group.h>
@@ -37,9 +40,12 @@
 #include <geometry/convex_hull.h>
 
 #include "pns_node.h"
+#include "pns_index.h"
 #include "pns_line_placer.h"
 #include "pns_line.h"
 #include "pns_solid.h"
+#include "pns_segment.h"
+#include "pns_via.h"
 #include "pns_utils.h"
 #include "pns_router.h"
 #include "pns_shove.h"
@@ -49,6 +55,7 @@
 #include "pns_meander_placer.h"
 #include "pns_meander_skew_placer.h"
 #include "pns_dp_meander_placer.h"
+#include "pns_session_log.h"
 
 #include <router/router_preview_item.h>
 
@@ -60,7 +67,9 @@ static ROUTER* theRouter;
 
 ROUTER::ROUTER()
 {
-    theRouter = this;
+    // the routers of batch routing (PNS_BATCH_ROUTER) must not take over the interactive one
+    if( !theRouter )
+        theRouter = this;
 
     m_state = IDLE;
     m_mode = PNS_MODE_ROUTE_SINGLE;
@@ -84,7 +93,9 @@ ROUTER* ROUTER::GetInstance()
 ROUTER::~ROUTER()
 {
     ClearWorld();
-    theRouter = nullptr;
+
+    if( theRouter == this )
+        theRouter = nullptr;
 }
 
 
@@ -95,8 +106,11 @@ void ROUTER::SyncWorld()
     m_world = std::unique_ptr<NODE>( new NODE );
     m_iface->SyncWorld( m_world.get() );
 
+    if( m_sessionLog )
+        startSessionLog();
 }
 
+
 void ROUTER::ClearWorld()
 {
     if( m_world )
@@ -106,6 +120,12 @@ void ROUTER::ClearWorld()
     }
 
     m_placer.reset();
+
+    // give the memory of the routing session back
+    OBJECT_POOL<NODE>::Instance().Trim();
+    OBJECT_POOL<INDEX>::Instance().Trim();
+    OBJECT_POOL<SEGMENT>::Instance().Trim();
+    OBJECT_POOL<VIA>::Instance().Trim();
 }
 
 
@@ -126,6 +146,10 @@ const ITEM_SET ROUTER::QueryHoverItems( const VECTOR2I& aP )
 
 bool ROUTER::StartDragging( const VECTOR2I& aP, ITEM* aStartItem, int aDragMode )
 {
+    logState();
+
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_START_DRAG, aP,
+                                        aDragMode, aStartItem );
 
     if( aDragMode & DM_FREE_ANGLE )
         m_forceMarkObstaclesMode = true;
@@ -175,6 +199,10 @@ bool ROUTER::isStartingPointRoutable( const VECTOR2I& aWhere, int aLayer )
 
 bool ROUTER::StartRouting( const VECTOR2I& aP, ITEM* aStartItem, int aLayer )
 {
+    logState();
+
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_START_ROUTE, aP,
+                                        aLayer, aStartItem );
 
     if( ! isStartingPointRoutable( aP, aLayer ) )
     {
@@ -230,6 +258,9 @@ void ROUTER::DisplayItems( const ITEM_SET& aItems )
 
 void ROUTER::Move( const VECTOR2I& aP, ITEM* endItem )
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_MOVE, aP, 0,
+                                        endItem );
+
     m_currentEnd = aP;
 
     switch( m_state )
@@ -318,6 +349,7 @@ void ROUTER::updateView( NODE* aNode, ITEM_SET& aCurrent, bool aDragging )
 void ROUTER::UpdateSizes( const SIZES_SETTINGS& aSizes )
 {
     m_sizes = aSizes;
+    logState();
 
     // Change track/via size settings
     if( m_state == ROUTE_TRACK)
@@ -373,6 +405,8 @@ void ROUTER::CommitRouting( NODE* aNode )
 
 bool ROUTER::FixRoute( const VECTOR2I& aP, ITEM* aEndItem, bool aForceFinish )
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_FIX, aP,
+                                        aForceFinish, aEndItem );
     bool rv = false;
 
     switch( m_state )
@@ -398,6 +432,8 @@ bool ROUTER::FixRoute( const VECTOR2I& aP, ITEM* aEndItem, bool aForceFinish )
 
 void ROUTER::StopRouting()
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_STOP );
+
     // Update the ratsnest with new changes
 
     if( m_placer )
@@ -426,6 +462,8 @@ void ROUTER::StopRouting()
 
 void ROUTER::FlipPosture()
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_FLIP_POSTURE );
+
     if( m_state == ROUTE_TRACK )
     {
         m_placer->FlipPosture();
@@ -435,6 +473,9 @@ void ROUTER::FlipPosture()
 
 void ROUTER::SwitchLayer( int aLayer )
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_SWITCH_LAYER,
+                                        VECTOR2I(), aLayer );
+
     switch( m_state )
     {
     case ROUTE_TRACK:
@@ -448,6 +489,8 @@ void ROUTER::SwitchLayer( int aLayer )
 
 void ROUTER::ToggleViaPlacement()
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_TOGGLE_VIA );
+
     if( m_state == ROUTE_TRACK )
     {
         bool toggle = !m_placer->IsPlacingVia();
@@ -496,6 +539,59 @@ void ROUTER::DumpLog()
 }
 
 
+void ROUTER::EnableSessionLog( const wxString& aDirectory )
+{
+    m_sessionLogDir = aDirectory;
+
+    if( aDirectory.IsEmpty() )
+    {
+        m_sessionLog.reset();
+    }
+    else
+    {
+        m_sessionLog.reset( new SESSION_LOG );
+
+        if( m_world )
+            startSessionLog();
+    }
+}
+
+
+void ROUTER::startSessionLog()
+{
+    // Several worlds may be synchronized in the same second
+    static int sessionCount = 0;
+
+    wxString   now = wxDateTime::Now().Format( "%Y%m%d-%H%M%S" );
+    wxFileName fn( m_sessionLogDir, wxString::Format( "pns-%s-%d", now, sessionCount++ ) );
+
+    fn.SetExt( "kicad_pcb" );
+
+    if( !m_iface->SaveBoard( fn.GetFullPath() ) )
+    {
+        wxLogTrace( "PNS", "Cannot save the board to '%s', not recording",
+                    fn.GetFullPath().c_str() );
+
+        m_sessionLog->Start( std::string(), std::string() );
+        return;
+    }
+
+    wxString boardFile = fn.GetFullName();
+
+    fn.SetExt( "log" );
+    m_sessionLog->Start( fn.GetFullPath().ToStdString(), boardFile.ToStdString() );
+
+    logState();
+}
+
+
+void ROUTER::logState()
+{
+    if( m_sessionLog )
+        m_sessionLog->LogState( m_mode, m_settings, m_sizes );
+}
+
+
 bool ROUTER::IsPlacingVia() const
 {
     if( !m_placer )
@@ -507,6 +603,9 @@ bool ROUTER::IsPlacingVia() const
 
 void ROUTER::SetOrthoMode( bool aEnable )
 {
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_ORTHO, VECTOR2I(),
+                                        aEnable );
+
     if( !m_placer )
         return;
 
@@ -517,6 +616,14 @@ void ROUTER::SetOrthoMode( bool aEnable )
 void ROUTER::SetMode( ROUTER_MODE aMode )
 {
     m_mode = aMode;
+    logState();
+}
+
+
+void ROUTER::LoadSettings( const ROUTING_SETTINGS& aSettings )
+{
+    m_settings = aSettings;
+    logState();
 }
 
 
@@ -528,6 +635,11 @@ void ROUTER::SetInterface( ROUTER_IFACE *aIface )
 
 void ROUTER::BreakSegment( ITEM *aItem, const VECTOR2I& aP )
 {
+    logState();
+
+    SESSION_LOG::SCOPED_EVENT logEvent( m_sessionLog.get(), SESSION_LOG::EVT_BREAK_SEGMENT, aP,
+                                        0, aItem );
+
     NODE *node = m_world->Branch();
 
     LINE_PLACER placer( this );
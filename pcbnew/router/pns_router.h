@@ -60,6 +60,7 @@ class VIA;
 class RULE_RESOLVER;
 class SHOVE;
 class DRAGGER;
+class SESSION_LOG;
 
 enum ROUTER_MODE {
     PNS_MODE_ROUTE_SINGLE = 1,
@@ -101,6 +102,9 @@ enum DRAG_MODE
         virtual void EraseView() = 0;
         virtual void UpdateNet( int aNetCode ) = 0;
 
+        ///> Saves the board the world was synchronized from, for the session logs.
+        virtual bool SaveBoard( const wxString& aFileName ) = 0;
+
         virtual RULE_RESOLVER* GetRuleResolver() = 0;
         virtual DEBUG_DECORATOR* GetDebugDecorator() = 0;
 };
@@ -160,6 +164,13 @@ public:
 
     void DumpLog();
 
+    /**
+     * Records the routing sessions in aDirectory, with a snapshot of the board taken at
+     * each world synchronization, to replay them offline (see SESSION_LOG).
+     * @param aDirectory is the directory of the logs, or empty to stop recording.
+     */
+    void EnableSessionLog( const wxString& aDirectory );
+
     RULE_RESOLVER* GetRuleResolver() const
     {
         return m_iface->GetRuleResolver();
@@ -198,10 +209,7 @@ public:
      * Changes routing settings to ones passed in the parameter.
      * @param aSettings are the new settings.
      */
-    void LoadSettings( const ROUTING_SETTINGS& aSettings )
-    {
-        m_settings = aSettings;
-    }
+    void LoadSettings( const ROUTING_SETTINGS& aSettings );
 
     SIZES_SETTINGS& Sizes()
     {
@@ -244,6 +252,9 @@ private:
 
     void highlightCurrent( bool enabled );
 
+    void startSessionLog();
+    void logState();
+
     void markViolations( NODE* aNode, ITEM_SET& aCurrent, NODE::ITEM_VECTOR& aRemoved );
     bool isStartingPointRoutable( const VECTOR2I& aWhere, int aLayer );
 
@@ -271,6 +282,9 @@ private:
 
     wxString m_toolStatusbarName;
     wxString m_failureReason;
+
+    std::unique_ptr<SESSION_LOG> m_sessionLog;
+    wxString m_sessionLogDir;
 };
 
 }
@@ -24,6 +24,7 @@
 #include <geometry/direction45.h>
 
 #include "pns_routing_settings.h"
+#include "pns_session_log.h"
 
 namespace PNS {
 
@@ -47,10 +48,12 @@ ROUTING_SETTINGS::ROUTING_SETTINGS()
     m_inlineDragEnabled = false;
     m_snapToTracks = false;
     m_snapToPads = false;
+    m_parallelCandidates = true;     // same results as the serial evaluation, only faster
 }
 
 
-void ROUTING_SETTINGS::Save( TOOL_SETTINGS& aSettings ) const
+template <class SETTINGS_T>
+void ROUTING_SETTINGS::Save( SETTINGS_T& aSettings ) const
 {
     aSettings.Set( "Mode", (int) m_routingMode );
     aSettings.Set( "OptimizerEffort", (int) m_optimizerEffort );
@@ -67,10 +70,12 @@ void ROUTING_SETTINGS::Save( TOOL_SETTINGS& aSettings ) const
     aSettings.Set( "SuggestFinish", m_suggestFinish );
     aSettings.Set( "FreeAngleMode", m_freeAngleMode );
     aSettings.Set( "InlineDragEnabled", m_inlineDragEnabled );
+    aSettings.Set( "ParallelCandidates", m_parallelCandidates );
 }
 
 
-void ROUTING_SETTINGS::Load( const TOOL_SETTINGS& aSettings )
+template <class SETTINGS_T>
+void ROUTING_SETTINGS::Load( const SETTINGS_T& aSettings )
 {
     m_routingMode = (PNS_MODE) aSettings.Get( "Mode", (int) RM_Walkaround );
     m_optimizerEffort = (PNS_OPTIMIZATION_EFFORT) aSettings.Get( "OptimizerEffort", (int) OE_MEDIUM );
@@ -87,6 +92,7 @@ void ROUTING_SETTINGS::Load( const TOOL_SETTINGS& aSettings )
     m_suggestFinish = aSettings.Get( "SuggestFinish", false );
     m_freeAngleMode = aSettings.Get( "FreeAngleMode", false );
     m_inlineDragEnabled = aSettings.Get( "InlineDragEnabled", false );
+    m_parallelCandidates = aSettings.Get( "ParallelCandidates", true );
 }
 
 
@@ -110,4 +116,10 @@ int ROUTING_SETTINGS::ShoveIterationLimit() const
     return m_shoveIterationLimit;
 }
 
+
+template void ROUTING_SETTINGS::Save( TOOL_SETTINGS& aSettings ) const;
+template void ROUTING_SETTINGS::Load( const TOOL_SETTINGS& aSettings );
+template void ROUTING_SETTINGS::Save( SESSION_LOG::SETTINGS_MAP& aSettings ) const;
+template void ROUTING_SETTINGS::Load( const SESSION_LOG::SETTINGS_MAP& aSettings );
+
 }
@@ -59,8 +59,13 @@ class ROUTING_SETTINGS
 public:
     ROUTING_SETTINGS();
 
-    void Load( const TOOL_SETTINGS& where );
-    void Save( TOOL_SETTINGS& where ) const;
+    ///> Loads the settings from a TOOL_SETTINGS, or from a SESSION_LOG::SETTINGS_MAP.
+    template <class SETTINGS_T>
+    void Load( const SETTINGS_T& where );
+
+    ///> Saves the settings to a TOOL_SETTINGS, or to a SESSION_LOG::SETTINGS_MAP.
+    template <class SETTINGS_T>
+    void Save( SETTINGS_T& where ) const;
 
     ///> Returns the routing mode.
     PNS_MODE Mode() const { return m_routingMode; }
@@ -133,6 +138,13 @@ public:
     int WalkaroundIterationLimit() const { return m_walkaroundIterationLimit; };
     TIME_LIMIT WalkaroundTimeLimit() const;
 
+    ///> Returns true if the candidate paths of the walkaround and shove algorithms are
+    ///> evaluated on several threads.  On by default: the candidates are picked in the
+    ///> serial order, so the routed path is the same either way.  Turning it off runs them
+    ///> one after another on the calling thread.
+    bool ParallelCandidates() const { return m_parallelCandidates; }
+    void SetParallelCandidates( bool aEnable ) { m_parallelCandidates = aEnable; }
+
     void SetInlineDragEnabled ( bool aEnable ) { m_inlineDragEnabled = aEnable; }
     bool InlineDragEnabled() const { return m_inlineDragEnabled; }
 
@@ -156,6 +168,7 @@ private:
     bool m_inlineDragEnabled;
     bool m_snapToTracks;
     bool m_snapToPads;
+    bool m_parallelCandidates;
 
     PNS_MODE m_routingMode;
     PNS_OPTIMIZATION_EFFORT m_optimizerEffort;
@@ -30,6 +30,7 @@
 
 #include "pns_item.h"
 #include "pns_line.h"
+#include "pns_pool.h"
 
 namespace PNS {
 
@@ -58,6 +59,8 @@ public:
         m_rank = aParentLine.Rank();
     }
 
+    PNS_POOLED_OBJECT( SEGMENT )
+
     static inline bool ClassOf( const ITEM* aItem )
     {
         return aItem && SEGMENT_T == aItem->Kind();
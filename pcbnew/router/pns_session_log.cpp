@@ -0,0 +1,544 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+
+#include "pns_session_log.h"
+#include "pns_item.h"
+#include "pns_itemset.h"
+#include "pns_router.h"
+#include "pns_segment.h"
+#include "pns_solid.h"
+#include "pns_via.h"
+
+namespace PNS {
+
+static const char* eventNames[] =
+{
+    "mode",
+    "settings",
+    "sizes",
+    "start_route",
+    "start_drag",
+    "move",
+    "fix",
+    "stop",
+    "switch_layer",
+    "toggle_via",
+    "flip_posture",
+    "ortho",
+    "break_segment"
+};
+
+static_assert( sizeof( eventNames ) / sizeof( eventNames[0] ) == SESSION_LOG::EVT_LAST,
+               "an event type has no name" );
+
+
+static const char* kindName( int aKind )
+{
+    switch( aKind )
+    {
+    case ITEM::SOLID_T:   return "solid";
+    case ITEM::SEGMENT_T: return "segment";
+    case ITEM::VIA_T:     return "via";
+    default:              return "none";
+    }
+}
+
+
+static int kindFromName( const std::string& aName )
+{
+    for( int kind : { ITEM::SOLID_T, ITEM::SEGMENT_T, ITEM::VIA_T } )
+    {
+        if( aName == kindName( kind ) )
+            return kind;
+    }
+
+    return 0;
+}
+
+
+SESSION_LOG::SCOPED_EVENT::SCOPED_EVENT( SESSION_LOG* aLog, EVENT_TYPE aType,
+                                         const VECTOR2I& aP, int aArg, const ITEM* aItem ) :
+    m_log( aLog )
+{
+    if( !m_log )
+        return;
+
+    m_log->m_depth++;
+
+    m_event.m_type = aType;
+    m_event.m_p = aP;
+    m_event.m_arg = aArg;
+
+    // The item may not exist any more at the end of the call
+    m_event.m_item = MakeRef( aItem );
+    m_counter.Start();
+}
+
+
+SESSION_LOG::SCOPED_EVENT::~SCOPED_EVENT()
+{
+    if( !m_log )
+        return;
+
+    m_counter.Stop();
+    m_event.m_msecs = m_counter.msecs();
+
+    m_log->m_depth--;
+    m_log->Add( m_event );
+}
+
+
+SESSION_LOG::SESSION_LOG() :
+    m_depth( 0 ),
+    m_unsaved( false )
+{
+}
+
+
+SESSION_LOG::~SESSION_LOG()
+{
+    if( m_unsaved )
+        Save( m_fileName );
+}
+
+
+void SESSION_LOG::Start( const std::string& aFileName, const std::string& aBoardFileName )
+{
+    if( m_unsaved )
+        Save( m_fileName );
+
+    m_fileName = aFileName;
+    m_boardFileName = aBoardFileName;
+    m_events.clear();
+    m_unsaved = false;
+
+    for( std::string& state : m_lastState )
+        state.clear();
+}
+
+
+void SESSION_LOG::Add( const EVENT& aEvent )
+{
+    // Inner calls are replayed by the outer one
+    if( m_depth > 0 || m_fileName.empty() )
+        return;
+
+    m_events.push_back( aEvent );
+    m_unsaved = true;
+
+    // Keep the file up to date at the end of each action, a session may end with a crash
+    switch( aEvent.m_type )
+    {
+    case EVT_FIX:
+    case EVT_STOP:
+    case EVT_BREAK_SEGMENT:
+        if( Save( m_fileName ) )
+            m_unsaved = false;
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void SESSION_LOG::LogState( int aMode, const ROUTING_SETTINGS& aSettings,
+                            const SIZES_SETTINGS& aSizes )
+{
+    if( m_fileName.empty() )
+        return;
+
+    EVENT mode, settings, sizes;
+
+    mode.m_type = EVT_MODE;
+    mode.m_arg = aMode;
+    settings.m_type = EVT_SETTINGS;
+    settings.m_settings = aSettings;
+    sizes.m_type = EVT_SIZES;
+    sizes.m_sizes = aSizes;
+
+    for( const EVENT* evt : { &mode, &settings, &sizes } )
+    {
+        std::ostringstream state;
+
+        formatEvent( state, *evt );
+
+        if( state.str() != m_lastState[evt->m_type] )
+        {
+            m_lastState[evt->m_type] = state.str();
+            Add( *evt );
+        }
+    }
+}
+
+
+void SESSION_LOG::formatEvent( std::ostream& aStream, const EVENT& aEvent ) const
+{
+    aStream << eventNames[aEvent.m_type] << " " << aEvent.m_msecs;
+
+    switch( aEvent.m_type )
+    {
+    case EVT_MODE:
+        aStream << " " << aEvent.m_arg;
+        break;
+
+    case EVT_SETTINGS:
+    {
+        SETTINGS_MAP settings;
+
+        aEvent.m_settings.Save( settings );
+
+        for( const auto& value : settings.m_values )
+            aStream << " " << value.first << "=" << value.second;
+
+        break;
+    }
+
+    case EVT_SIZES:
+    {
+        const SIZES_SETTINGS& sizes = aEvent.m_sizes;
+
+        aStream << " " << sizes.TrackWidth() << " " << sizes.ViaDiameter() << " "
+                << sizes.ViaDrill() << " " << (int) sizes.ViaType() << " "
+                << sizes.DiffPairWidth() << " " << sizes.DiffPairGap() << " "
+                << sizes.DiffPairViaGap() << " " << sizes.DiffPairViaGapSameAsTraceGap() << " "
+                << sizes.LayerPairs().size();
+
+        for( const auto& pair : sizes.LayerPairs() )
+            aStream << " " << pair.first << " " << pair.second;
+
+        break;
+    }
+
+    default:
+    {
+        const ITEM_REF& item = aEvent.m_item;
+
+        aStream << " " << aEvent.m_p.x << " " << aEvent.m_p.y << " " << aEvent.m_arg << " "
+                << kindName( item.m_kind );
+
+        if( item.m_kind )
+        {
+            aStream << " " << item.m_net << " " << item.m_layerStart << " " << item.m_layerEnd
+                    << " " << item.m_a.x << " " << item.m_a.y << " " << item.m_b.x << " "
+                    << item.m_b.y;
+        }
+
+        break;
+    }
+    }
+}
+
+
+bool SESSION_LOG::parseEvent( std::istream& aStream, EVENT& aEvent ) const
+{
+    std::string name;
+
+    aStream >> name;
+
+    for( int type = 0; type < EVT_LAST; type++ )
+    {
+        if( name == eventNames[type] )
+            aEvent.m_type = (EVENT_TYPE) type;
+    }
+
+    if( aEvent.m_type == EVT_LAST )
+        return false;
+
+    aStream >> aEvent.m_msecs;
+
+    switch( aEvent.m_type )
+    {
+    case EVT_MODE:
+        aStream >> aEvent.m_arg;
+        break;
+
+    case EVT_SETTINGS:
+    {
+        SETTINGS_MAP settings;
+        std::string  value;
+
+        while( aStream >> value )
+        {
+            size_t sep = value.find( '=' );
+
+            if( sep == std::string::npos )
+                return false;
+
+            settings.m_values[value.substr( 0, sep )] = value.substr( sep + 1 );
+        }
+
+        aEvent.m_settings.Load( settings );
+
+        // Reading the settings consumed the whole line
+        return true;
+    }
+
+    case EVT_SIZES:
+    {
+        SIZES_SETTINGS& sizes = aEvent.m_sizes;
+        int    width, viaDiameter, viaDrill, viaType, dpWidth, dpGap, dpViaGap;
+        bool   sameGap;
+        size_t pairCount;
+
+        aStream >> width >> viaDiameter >> viaDrill >> viaType >> dpWidth >> dpGap >> dpViaGap
+                >> sameGap >> pairCount;
+
+        sizes.SetTrackWidth( width );
+        sizes.SetViaDiameter( viaDiameter );
+        sizes.SetViaDrill( viaDrill );
+        sizes.SetViaType( (VIATYPE_T) viaType );
+        sizes.SetDiffPairWidth( dpWidth );
+        sizes.SetDiffPairGap( dpGap );
+        sizes.SetDiffPairViaGap( dpViaGap );
+        sizes.SetDiffPairViaGapSameAsTraceGap( sameGap );
+
+        for( size_t i = 0; i < pairCount && aStream; i++ )
+        {
+            int l1, l2;
+
+            aStream >> l1 >> l2;
+            sizes.AddLayerPair( l1, l2 );
+        }
+
+        break;
+    }
+
+    default:
+    {
+        ITEM_REF&   item = aEvent.m_item;
+        std::string kind;
+
+        aStream >> aEvent.m_p.x >> aEvent.m_p.y >> aEvent.m_arg >> kind;
+
+        item.m_kind = kindFromName( kind );
+
+        if( item.m_kind )
+        {
+            aStream >> item.m_net >> item.m_layerStart >> item.m_layerEnd >> item.m_a.x
+                    >> item.m_a.y >> item.m_b.x >> item.m_b.y;
+        }
+
+        break;
+    }
+    }
+
+    return !aStream.fail();
+}
+
+
+bool SESSION_LOG::Save( const std::string& aFileName ) const
+{
+    std::ofstream out( aFileName );
+
+    if( !out )
+        return false;
+
+    out << "# KiCad router session" << std::endl;
+    out << "board " << m_boardFileName << std::endl;
+
+    for( const EVENT& evt : m_events )
+    {
+        formatEvent( out, evt );
+        out << std::endl;
+    }
+
+    return !out.fail();
+}
+
+
+bool SESSION_LOG::Load( const std::string& aFileName )
+{
+    std::ifstream in( aFileName );
+
+    if( !in )
+        return false;
+
+    m_events.clear();
+    m_boardFileName.clear();
+
+    std::string line;
+
+    while( std::getline( in, line ) )
+    {
+        if( line.empty() || line[0] == '#' )
+            continue;
+
+        std::istringstream stream( line );
+
+        if( line.compare( 0, 6, "board " ) == 0 )
+        {
+            m_boardFileName = line.substr( 6 );
+            continue;
+        }
+
+        EVENT evt;
+
+        if( !parseEvent( stream, evt ) )
+        {
+            wxLogTrace( "PNS", "Invalid session log line: %s", line.c_str() );
+            return false;
+        }
+
+        m_events.push_back( evt );
+    }
+
+    return true;
+}
+
+
+SESSION_LOG::ITEM_REF SESSION_LOG::MakeRef( const ITEM* aItem )
+{
+    ITEM_REF ref;
+
+    if( !aItem )
+        return ref;
+
+    ref.m_net = aItem->Net();
+    ref.m_layerStart = aItem->Layers().Start();
+    ref.m_layerEnd = aItem->Layers().End();
+
+    switch( aItem->Kind() )
+    {
+    case ITEM::SEGMENT_T:
+        ref.m_kind = ITEM::SEGMENT_T;
+        ref.m_a = static_cast<const SEGMENT*>( aItem )->Seg().A;
+        ref.m_b = static_cast<const SEGMENT*>( aItem )->Seg().B;
+        break;
+
+    case ITEM::VIA_T:
+        ref.m_kind = ITEM::VIA_T;
+        ref.m_a = ref.m_b = static_cast<const VIA*>( aItem )->Pos();
+        break;
+
+    case ITEM::SOLID_T:
+        ref.m_kind = ITEM::SOLID_T;
+        ref.m_a = ref.m_b = static_cast<const SOLID*>( aItem )->Pos();
+        break;
+
+    default:
+        // Lines are not in the world, the tools never pass them
+        break;
+    }
+
+    return ref;
+}
+
+
+ITEM* SESSION_LOG::FindItem( ROUTER* aRouter, const ITEM_REF& aRef )
+{
+    if( !aRef.m_kind )
+        return nullptr;
+
+    ITEM_SET candidates = aRouter->QueryHoverItems( aRef.m_a );
+
+    for( ITEM* item : candidates.Items() )
+    {
+        if( item->Kind() != aRef.m_kind || item->Net() != aRef.m_net
+                || item->Layers().Start() != aRef.m_layerStart
+                || item->Layers().End() != aRef.m_layerEnd )
+        {
+            continue;
+        }
+
+        ITEM_REF ref = MakeRef( item );
+
+        if( ref.m_a == aRef.m_a && ref.m_b == aRef.m_b )
+            return item;
+    }
+
+    return nullptr;
+}
+
+
+bool SESSION_LOG::Replay( ROUTER* aRouter, const EVENT& aEvent )
+{
+    ITEM* item = FindItem( aRouter, aEvent.m_item );
+
+    switch( aEvent.m_type )
+    {
+    case EVT_MODE:
+        aRouter->SetMode( (ROUTER_MODE) aEvent.m_arg );
+        break;
+
+    case EVT_SETTINGS:
+        aRouter->LoadSettings( aEvent.m_settings );
+        break;
+
+    case EVT_SIZES:
+        aRouter->UpdateSizes( aEvent.m_sizes );
+        break;
+
+    case EVT_START_ROUTE:
+        return aRouter->StartRouting( aEvent.m_p, item, aEvent.m_arg );
+
+    case EVT_START_DRAG:
+        return aRouter->StartDragging( aEvent.m_p, item, aEvent.m_arg );
+
+    case EVT_MOVE:
+        aRouter->Move( aEvent.m_p, item );
+        break;
+
+    case EVT_FIX:
+        return aRouter->FixRoute( aEvent.m_p, item, aEvent.m_arg != 0 );
+
+    case EVT_STOP:
+        aRouter->StopRouting();
+        break;
+
+    case EVT_SWITCH_LAYER:
+        aRouter->SwitchLayer( aEvent.m_arg );
+        break;
+
+    case EVT_TOGGLE_VIA:
+        aRouter->ToggleViaPlacement();
+        break;
+
+    case EVT_FLIP_POSTURE:
+        aRouter->FlipPosture();
+        break;
+
+    case EVT_ORTHO:
+        aRouter->SetOrthoMode( aEvent.m_arg != 0 );
+        break;
+
+    case EVT_BREAK_SEGMENT:
+        if( !item )
+            return false;
+
+        aRouter->BreakSegment( item, aEvent.m_p );
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+
+const char* SESSION_LOG::TypeName( EVENT_TYPE aType )
+{
+    return aType < EVT_LAST ? eventNames[aType] : "unknown";
+}
+
+}
@@ -0,0 +1,242 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PNS_SESSION_LOG_H
+#define __PNS_SESSION_LOG_H
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <math/vector2d.h>
+#include <profile.h>
+
+#include "pns_routing_settings.h"
+#include "pns_sizes_settings.h"
+
+namespace PNS {
+
+class ITEM;
+class ROUTER;
+
+/**
+ * Class SESSION_LOG
+ *
+ * Records the calls made to the ROUTER by the interactive tools (start, mouse moves, fix,
+ * layer switch...), with their arguments and the time each of them took, so that a routing
+ * session can be replayed offline on the same board.  The routing settings and sizes are
+ * recorded as events too.
+ *
+ * The log is a text file, one event per line, which refers to a snapshot of the board
+ * saved next to it.
+ */
+class SESSION_LOG
+{
+public:
+    enum EVENT_TYPE
+    {
+        EVT_MODE,           ///< ROUTER::SetMode()
+        EVT_SETTINGS,       ///< ROUTER::LoadSettings()
+        EVT_SIZES,          ///< ROUTER::UpdateSizes()
+        EVT_START_ROUTE,    ///< ROUTER::StartRouting()
+        EVT_START_DRAG,     ///< ROUTER::StartDragging()
+        EVT_MOVE,           ///< ROUTER::Move()
+        EVT_FIX,            ///< ROUTER::FixRoute()
+        EVT_STOP,           ///< ROUTER::StopRouting()
+        EVT_SWITCH_LAYER,   ///< ROUTER::SwitchLayer()
+        EVT_TOGGLE_VIA,     ///< ROUTER::ToggleViaPlacement()
+        EVT_FLIP_POSTURE,   ///< ROUTER::FlipPosture()
+        EVT_ORTHO,          ///< ROUTER::SetOrthoMode()
+        EVT_BREAK_SEGMENT,  ///< ROUTER::BreakSegment()
+        EVT_LAST
+    };
+
+    /**
+     * Identifies an item of the world by its kind, net, layers and position, as item
+     * pointers do not survive the session.
+     */
+    struct ITEM_REF
+    {
+        ITEM_REF() :
+            m_kind( 0 ),
+            m_net( 0 ),
+            m_layerStart( 0 ),
+            m_layerEnd( 0 )
+        {}
+
+        int      m_kind;        ///< PnsKind of the item, 0 for none
+        int      m_net;
+        int      m_layerStart;
+        int      m_layerEnd;
+        VECTOR2I m_a;           ///< start of a segment, position of a via or pad
+        VECTOR2I m_b;           ///< end of a segment
+    };
+
+    struct EVENT
+    {
+        EVENT() :
+            m_type( EVT_LAST ),
+            m_arg( 0 ),
+            m_msecs( 0.0 )
+        {}
+
+        EVENT_TYPE       m_type;
+        VECTOR2I         m_p;        ///< cursor position
+        int              m_arg;      ///< mode, layer, drag mode or flag, depending on the type
+        ITEM_REF         m_item;     ///< start or end item
+        double           m_msecs;    ///< time taken by the call in the recorded session
+        ROUTING_SETTINGS m_settings; ///< for EVT_SETTINGS
+        SIZES_SETTINGS   m_sizes;    ///< for EVT_SIZES
+    };
+
+    /**
+     * Class SETTINGS_MAP
+     *
+     * Key/value store for the ROUTING_SETTINGS of EVT_SETTINGS, with the Get() and Set()
+     * methods of TOOL_SETTINGS.
+     */
+    class SETTINGS_MAP
+    {
+    public:
+        template <class T>
+        T Get( const std::string& aName, T aDefaultValue ) const
+        {
+            auto it = m_values.find( aName );
+            T    value = aDefaultValue;
+
+            if( it != m_values.end() )
+            {
+                std::istringstream stream( it->second );
+                stream >> value;
+            }
+
+            return value;
+        }
+
+        template <class T>
+        void Set( const std::string& aName, const T& aValue )
+        {
+            std::ostringstream stream;
+
+            stream << aValue;
+            m_values[aName] = stream.str();
+        }
+
+        std::map<std::string, std::string> m_values;
+    };
+
+    /**
+     * Class SCOPED_EVENT
+     *
+     * Records an event when going out of scope, with the time spent in the scope.  Events
+     * recorded inside another one (e.g. the StopRouting() of a FixRoute()) are not logged,
+     * they are replayed by their outer event.
+     */
+    class SCOPED_EVENT
+    {
+    public:
+        SCOPED_EVENT( SESSION_LOG* aLog, EVENT_TYPE aType, const VECTOR2I& aP = VECTOR2I(),
+                      int aArg = 0, const ITEM* aItem = nullptr );
+        ~SCOPED_EVENT();
+
+    private:
+        SESSION_LOG* m_log;
+        EVENT        m_event;
+        PROF_COUNTER m_counter;
+    };
+
+    SESSION_LOG();
+    ~SESSION_LOG();
+
+    /**
+     * Function Start()
+     *
+     * Starts a new log, written to a file at the end of each routing action (fix or stop).
+     * @param aFileName is the file the log is written to.  Nothing is recorded if empty.
+     * @param aBoardFileName is the snapshot of the board the session runs on.
+     */
+    void Start( const std::string& aFileName, const std::string& aBoardFileName );
+
+    void Add( const EVENT& aEvent );
+
+    /**
+     * Function LogState()
+     *
+     * Records the router mode, settings and sizes, if they changed since they were last
+     * recorded.  The tools change the settings in place, so they are checked before each
+     * routing action.
+     */
+    void LogState( int aMode, const ROUTING_SETTINGS& aSettings, const SIZES_SETTINGS& aSizes );
+
+    const std::vector<EVENT>& Events() const
+    {
+        return m_events;
+    }
+
+    /**
+     * Function BoardFileName()
+     *
+     * @return the snapshot of the board, relative to the directory of the log.
+     */
+    const std::string& BoardFileName() const
+    {
+        return m_boardFileName;
+    }
+
+    bool Save( const std::string& aFileName ) const;
+    bool Load( const std::string& aFileName );
+
+    static ITEM_REF MakeRef( const ITEM* aItem );
+
+    /**
+     * Function FindItem()
+     *
+     * Finds the item matching aRef among the items the router would hover at its position.
+     * @return the item, or nullptr for a null reference or when there is no such item.
+     */
+    static ITEM* FindItem( ROUTER* aRouter, const ITEM_REF& aRef );
+
+    /**
+     * Function Replay()
+     *
+     * Calls the ROUTER method of aEvent, as the tool did in the recorded session.
+     * @return the value returned by the method, true for methods without return value.
+     */
+    static bool Replay( ROUTER* aRouter, const EVENT& aEvent );
+
+    static const char* TypeName( EVENT_TYPE aType );
+
+private:
+    void formatEvent( std::ostream& aStream, const EVENT& aEvent ) const;
+    bool parseEvent( std::istream& aStream, EVENT& aEvent ) const;
+
+    std::string        m_fileName;
+    std::string        m_boardFileName;
+    std::vector<EVENT> m_events;
+    int                m_depth;
+    bool               m_unsaved;
+
+    ///> Last mode, settings and sizes recorded, as formatted in the log
+    std::string        m_lastState[EVT_SIZES + 1];
+};
+
+}
+
+#endif
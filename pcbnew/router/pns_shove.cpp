@@ -23,6 +23,7 @@
 
 #include <deque>
 #include <cassert>
+#include <atomic>
 
 #include "range.h"
 
@@ -42,6 +43,7 @@
 #include "time_limit.h"
 
 #include <profile.h>
+#include <thread_pool.h>
 
 namespace PNS {
 
@@ -161,100 +163,175 @@ SHOVE::SHOVE_STATUS SHOVE::walkaroundLoneVia( LINE& aCurrent, LINE& aObstacle,
 }
 
 
-SHOVE::SHOVE_STATUS SHOVE::processHullSet( LINE& aCurrent, LINE& aObstacle,
-                                                   LINE& aShoved, const HULL_SET& aHulls )
+SHOVE::HULL_SET_ATTEMPT SHOVE::hullSetAttempt( const LINE& aCurrent, const LINE& aObstacle,
+                                               const HULL_SET& aHulls, int aAttempt,
+                                               LINE& aShoved ) const
 {
     const SHAPE_LINE_CHAIN& obs = aObstacle.CLine();
 
-    int attempt;
+    bool invertTraversal = ( aAttempt >= 2 );
+    bool clockwise = aAttempt % 2;
+    int vFirst = -1, vLast = -1;
 
-    for( attempt = 0; attempt < 4; attempt++ )
-    {
-        bool invertTraversal = ( attempt >= 2 );
-        bool clockwise = attempt % 2;
-        int vFirst = -1, vLast = -1;
+    SHAPE_LINE_CHAIN path;
+    LINE l( aObstacle );
 
-        SHAPE_LINE_CHAIN path;
-        LINE l( aObstacle );
+    for( int i = 0; i < (int) aHulls.size(); i++ )
+    {
+        const SHAPE_LINE_CHAIN& hull = aHulls[invertTraversal ? aHulls.size() - 1 - i : i];
 
-        for( int i = 0; i < (int) aHulls.size(); i++ )
-        {
-            const SHAPE_LINE_CHAIN& hull = aHulls[invertTraversal ? aHulls.size() - 1 - i : i];
+        if( ! l.Walkaround( hull, path, clockwise ) )
+            return HA_WALK_FAILED;
 
-            if( ! l.Walkaround( hull, path, clockwise ) )
-                return SH_INCOMPLETE;
+        path.Simplify();
+        l.SetShape( path );
+    }
 
-            path.Simplify();
-            l.SetShape( path );
-        }
+    aShoved.SetShape( l.CLine() );
 
-        for( int i = 0; i < std::min( path.PointCount(), obs.PointCount() ); i++ )
+    for( int i = 0; i < std::min( path.PointCount(), obs.PointCount() ); i++ )
+    {
+        if( path.CPoint( i ) != obs.CPoint( i ) )
         {
-            if( path.CPoint( i ) != obs.CPoint( i ) )
-            {
-                vFirst = i;
-                break;
-            }
+            vFirst = i;
+            break;
         }
+    }
 
-        int k = obs.PointCount() - 1;
-        for( int i = path.PointCount() - 1; i >= 0 && k >= 0; i--, k-- )
+    int k = obs.PointCount() - 1;
+    for( int i = path.PointCount() - 1; i >= 0 && k >= 0; i--, k-- )
+    {
+        if( path.CPoint( i ) != obs.CPoint( k ) )
         {
-            if( path.CPoint( i ) != obs.CPoint( k ) )
-            {
-                vLast = i;
-                break;
-            }
+            vLast = i;
+            break;
         }
+    }
+
+    if( ( vFirst < 0 || vLast < 0 ) && !path.CompareGeometry( aObstacle.CLine() ) )
+        return HA_FAIL_VFIRST_LAST;
+
+    if( path.CPoint( -1 ) != obs.CPoint( -1 ) || path.CPoint( 0 ) != obs.CPoint( 0 ) )
+        return HA_FAIL_VEND_START;
 
-        if( ( vFirst < 0 || vLast < 0 ) && !path.CompareGeometry( aObstacle.CLine() ) )
+    if( !checkBumpDirection( aCurrent, l ) )
+        return HA_FAIL_DIRECTION;
+
+    if( path.SelfIntersecting() )
+        return HA_FAIL_SELF_INTERSECT;
+
+    bool colliding = m_currentNode->CheckColliding( &l, &aCurrent, ITEM::ANY_T, m_forceClearance );
+
+    if( ( aCurrent.Marker() & MK_HEAD ) && !colliding )
+    {
+        JOINT* jtStart = m_currentNode->FindJoint( aCurrent.CPoint( 0 ), &aCurrent );
+
+        for( ITEM* item : jtStart->LinkList() )
         {
-            wxLogTrace( "PNS", "attempt %d fail vfirst-last", attempt );
-            continue;
+            if( m_currentNode->CheckColliding( item, &l ) )
+                colliding = true;
         }
+    }
+
+    if( colliding )
+        return HA_FAIL_COLLIDING;
+
+    return HA_OK;
+}
+
+
+SHOVE::SHOVE_STATUS SHOVE::processHullSet( LINE& aCurrent, LINE& aObstacle,
+                                                   LINE& aShoved, const HULL_SET& aHulls )
+{
+    const int attemptCount = 4;
+
+    // Walking around the hulls in both directions and both orders gives four candidates.
+    // The first one which succeeds is kept, or the last one shoved the wrong way.
+    std::vector<LINE>             shoved( attemptCount, aObstacle );
+    std::vector<HULL_SET_ATTEMPT> results( attemptCount, HA_SKIPPED );
+
+    // The attempts only query the current node, so they can run on several threads when
+    // they are long enough to pay for it.  Attempts after one which ends the search are
+    // skipped, so the result is the same as trying them one after another.
+    bool parallel = Settings().ParallelCandidates()
+                    && aHulls.size() * aObstacle.PointCount() >= PARALLEL_HULL_SET_MIN_WORK
+                    && THREAD_POOL::GetInstance().GetThreadCount() > 1;
+
+    if( parallel )
+    {
+        std::atomic<int> lastAttempt( attemptCount - 1 );
 
-        if( path.CPoint( -1 ) != obs.CPoint( -1 ) || path.CPoint( 0 ) != obs.CPoint( 0 ) )
+        auto runAttempt =
+                [&]( int aAttempt )
+                {
+                    if( aAttempt > lastAttempt )
+                        return;
+
+                    results[aAttempt] = hullSetAttempt( aCurrent, aObstacle, aHulls, aAttempt,
+                                                        shoved[aAttempt] );
+
+                    if( results[aAttempt] != HA_OK && results[aAttempt] != HA_WALK_FAILED )
+                        return;
+
+                    int last = lastAttempt;
+
+                    while( aAttempt < last && !lastAttempt.compare_exchange_weak( last, aAttempt ) )
+                    {
+                    }
+                };
+
+        TASK_GROUP tasks;
+
+        for( int attempt = 1; attempt < attemptCount; attempt++ )
+            tasks.Run( [&runAttempt, attempt]() { runAttempt( attempt ); } );
+
+        runAttempt( 0 );
+        tasks.Wait();
+    }
+
+    for( int attempt = 0; attempt < attemptCount; attempt++ )
+    {
+        if( !parallel )
         {
-            wxLogTrace( "PNS", "attempt %d fail vend-start\n", attempt );
-            continue;
+            results[attempt] = hullSetAttempt( aCurrent, aObstacle, aHulls, attempt,
+                                               shoved[attempt] );
         }
 
-        if( !checkBumpDirection( aCurrent, l ) )
+        switch( results[attempt] )
         {
-            wxLogTrace( "PNS", "attempt %d fail direction-check", attempt );
-            aShoved.SetShape( l.CLine() );
+        case HA_OK:
+            aShoved.SetShape( shoved[attempt].CLine() );
+            return SH_OK;
 
-            continue;
-        }
+        case HA_WALK_FAILED:
+            return SH_INCOMPLETE;
 
-        if( path.SelfIntersecting() )
-        {
-            wxLogTrace( "PNS", "attempt %d fail self-intersect", attempt );
-            continue;
-        }
+        case HA_FAIL_VFIRST_LAST:
+            wxLogTrace( "PNS", "attempt %d fail vfirst-last", attempt );
+            break;
 
-        bool colliding = m_currentNode->CheckColliding( &l, &aCurrent, ITEM::ANY_T, m_forceClearance );
+        case HA_FAIL_VEND_START:
+            wxLogTrace( "PNS", "attempt %d fail vend-start\n", attempt );
+            break;
 
-        if( ( aCurrent.Marker() & MK_HEAD ) && !colliding )
-        {
-            JOINT* jtStart = m_currentNode->FindJoint( aCurrent.CPoint( 0 ), &aCurrent );
+        case HA_FAIL_DIRECTION:
+            wxLogTrace( "PNS", "attempt %d fail direction-check", attempt );
+            aShoved.SetShape( shoved[attempt].CLine() );
+            break;
 
-            for( ITEM* item : jtStart->LinkList() )
-            {
-                if( m_currentNode->CheckColliding( item, &l ) )
-                    colliding = true;
-            }
-        }
+        case HA_FAIL_SELF_INTERSECT:
+            wxLogTrace( "PNS", "attempt %d fail self-intersect", attempt );
+            break;
 
-        if( colliding )
-        {
+        case HA_FAIL_COLLIDING:
             wxLogTrace( "PNS", "attempt %d fail coll-check", attempt );
-            continue;
-        }
-
-        aShoved.SetShape( l.CLine() );
+            break;
 
-        return SH_OK;
+        case HA_SKIPPED:
+            // Only attempts after the one ending the search are skipped
+            assert( false );
+            break;
+        }
     }
 
     return SH_INCOMPLETE;
@@ -102,6 +102,26 @@ private:
         OPT_BOX2I m_affectedArea;
     };
 
+    ///> Outcome of one attempt of processHullSet()
+    enum HULL_SET_ATTEMPT
+    {
+        HA_OK = 0,
+        HA_WALK_FAILED,         ///> walking around a hull failed, no other attempt is made
+        HA_FAIL_VFIRST_LAST,
+        HA_FAIL_VEND_START,
+        HA_FAIL_DIRECTION,      ///> the line is shoved the wrong way, but still kept
+        HA_FAIL_SELF_INTERSECT,
+        HA_FAIL_COLLIDING,
+        HA_SKIPPED
+    };
+
+    ///> Minimum number of hulls times obstacle points for running the attempts of
+    ///> processHullSet() in parallel
+    static const size_t PARALLEL_HULL_SET_MIN_WORK = 64;
+
+    HULL_SET_ATTEMPT hullSetAttempt( const LINE& aCurrent, const LINE& aObstacle,
+                                     const HULL_SET& aHulls, int aAttempt, LINE& aShoved ) const;
+
     SHOVE_STATUS processHullSet( LINE& aCurrent, LINE& aObstacle,
                                  LINE& aShoved, const HULL_SET& hulls );
 
@@ -90,6 +90,8 @@ public:
         return m_layerPairs[aLayerId];
     }
 
+    const std::map<int, int>& LayerPairs() const { return m_layerPairs; }
+
     int GetLayerTop() const;
     int GetLayerBottom() const;
 
@@ -40,6 +40,7 @@ using namespace std::placeholders;
 #include <base_units.h>
 #include <bitmaps.h>
 #include <hotkeys.h>
+#include <advanced_config.h>
 
 #include <tool/context_menu.h>
 #include <tools/pcb_actions.h>
@@ -101,6 +102,7 @@ void TOOL_BASE::Reset( RESET_REASON aReason )
 
     m_router = new ROUTER;
     m_router->SetInterface( m_iface );
+    m_router->EnableSessionLog( ADVANCED_CFG::GetCfg().m_routerSessionLogDir );
     m_router->ClearWorld();
     m_router->SyncWorld();
     m_router->LoadSettings( m_savedSettings );
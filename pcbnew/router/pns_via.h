@@ -28,6 +28,7 @@
 #include "../class_track.h"
 
 #include "pns_item.h"
+#include "pns_pool.h"
 
 namespace PNS {
 
@@ -79,6 +80,8 @@ public:
         m_viaType = aB.m_viaType;
     }
 
+    PNS_POOLED_OBJECT( VIA )
+
     static inline bool ClassOf( const ITEM* aItem )
     {
         return aItem && VIA_T == aItem->Kind();
@@ -22,6 +22,7 @@
 #include <core/optional.h>
 
 #include <geometry/shape_line_chain.h>
+#include <thread_pool.h>
 
 #include "pns_walkaround.h"
 #include "pns_optimizer.h"
@@ -51,13 +52,12 @@ NODE::OPT_OBSTACLE WALKAROUND::nearestObstacle( const LINE& aPath )
 }
 
 
-WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
-                                                              bool aWindingDirection )
+WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( WALK& aWalk, int aIteration )
 {
-    OPT<OBSTACLE>& current_obs =
-        aWindingDirection ? m_currentObstacle[0] : m_currentObstacle[1];
-
-    bool& prev_recursive = aWindingDirection ? m_recursiveCollision[0] : m_recursiveCollision[1];
+    LINE& aPath = aWalk.m_path;
+    bool aWindingDirection = aWalk.m_cw;
+    OPT<OBSTACLE>& current_obs = aWalk.m_currentObstacle;
+    bool& prev_recursive = aWalk.m_recursiveCollision;
 
     if( !current_obs )
         return DONE;
@@ -68,9 +68,9 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
 
     if( ( current_obs->m_hull ).PointInside( last ) || ( current_obs->m_hull ).PointOnEdge( last ) )
     {
-        m_recursiveBlockageCount++;
+        aWalk.m_recursiveBlockageCount++;
 
-        if( m_recursiveBlockageCount < 3 )
+        if( aWalk.m_recursiveBlockageCount < 3 )
             aPath.Line().Append( current_obs->m_hull.NearestPoint( last ) );
         else
         {
@@ -88,12 +88,16 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
         return STUCK;
 
 #ifdef DEBUG
-    m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", m_iteration );
-    m_logger.Log( &path_walk[0], 0, "path-walk" );
-    m_logger.Log( &path_pre[0], 1, "path-pre" );
-    m_logger.Log( &path_post[0], 4, "path-post" );
-    m_logger.Log( &current_obs->m_hull, 2, "hull" );
-    m_logger.Log( current_obs->m_item, 3, "item" );
+    {
+        std::lock_guard<std::mutex> lock( m_loggerLock );
+
+        m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", aIteration );
+        m_logger.Log( &path_walk[0], 0, "path-walk" );
+        m_logger.Log( &path_pre[0], 1, "path-pre" );
+        m_logger.Log( &path_post[0], 4, "path-post" );
+        m_logger.Log( &current_obs->m_hull, 2, "hull" );
+        m_logger.Log( current_obs->m_item, 3, "item" );
+    }
 #endif
 
     int len_pre = path_walk[0].Length();
@@ -144,12 +148,72 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
 }
 
 
+void WALKAROUND::advance( WALK& aWalk, int aIteration, std::atomic<int>& aStopIteration )
+{
+    aWalk.m_status = singleStep( aWalk, aIteration );
+
+    if( aWalk.m_status == IN_PROGRESS )
+        return;
+
+    aWalk.m_endIteration = aIteration;
+
+    // Route() stops at the first path found, unless looking for the longest one.  The
+    // other direction only has to be walked up to the same iteration.
+    if( aWalk.m_status == DONE && !m_forceLongerPath )
+    {
+        int stop = aStopIteration;
+
+        while( aIteration + 1 < stop
+               && !aStopIteration.compare_exchange_weak( stop, aIteration + 1 ) )
+        {
+        }
+    }
+}
+
+
+void WALKAROUND::walkBothDirections( WALK& aCw, WALK& aCcw )
+{
+    std::atomic<int> stopIteration( m_iterationLimit );
+
+    auto walk =
+            [&]( WALK& aWalk )
+            {
+                for( int i = 0; i < stopIteration && aWalk.m_status == IN_PROGRESS; i++ )
+                    advance( aWalk, i, stopIteration );
+            };
+
+    // The directions do not depend on each other, and only query the world.  When both
+    // have to be walked, the counter-clockwise one is walked on another thread.
+    if( Settings().ParallelCandidates() && aCw.m_status == IN_PROGRESS
+            && aCcw.m_status == IN_PROGRESS && THREAD_POOL::GetInstance().GetThreadCount() > 1 )
+    {
+        TASK_GROUP tasks;
+
+        tasks.Run( [&]() { walk( aCcw ); } );
+        walk( aCw );
+        tasks.Wait();
+
+        return;
+    }
+
+    for( int i = 0; i < stopIteration; i++ )
+    {
+        if( aCw.m_status != IN_PROGRESS && aCcw.m_status != IN_PROGRESS )
+            break;
+
+        if( aCw.m_status == IN_PROGRESS )
+            advance( aCw, i, stopIteration );
+
+        if( aCcw.m_status == IN_PROGRESS )
+            advance( aCcw, i, stopIteration );
+    }
+}
+
+
 WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
         LINE& aWalkPath, bool aOptimize )
 {
-    LINE path_cw( aInitialPath ), path_ccw( aInitialPath );
     WALKAROUND_STATUS s_cw = IN_PROGRESS, s_ccw = IN_PROGRESS;
-    SHAPE_LINE_CHAIN best_path;
 
     // special case for via-in-the-middle-of-track placement
     if( aInitialPath.PointCount() <= 1 )
@@ -163,27 +227,34 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
 
     start( aInitialPath );
 
-    m_currentObstacle[0] = m_currentObstacle[1] = nearestObstacle( aInitialPath );
-    m_recursiveBlockageCount = 0;
+    WALK walk_cw( aInitialPath, true ), walk_ccw( aInitialPath, false );
+
+    walk_cw.m_currentObstacle = walk_ccw.m_currentObstacle = nearestObstacle( aInitialPath );
 
     aWalkPath = aInitialPath;
 
     if( m_forceWinding )
     {
-        s_cw = m_forceCw ? IN_PROGRESS : STUCK;
-        s_ccw = m_forceCw ? STUCK : IN_PROGRESS;
+        WALK& stuck = m_forceCw ? walk_ccw : walk_cw;
+
+        stuck.m_status = STUCK;
+        stuck.m_endIteration = -1;
         m_forceSingleDirection = true;
     } else {
         m_forceSingleDirection = false;
     }
 
-    while( m_iteration < m_iterationLimit )
-    {
-        if( s_cw != STUCK )
-            s_cw = singleStep( path_cw, true );
+    walkBothDirections( walk_cw, walk_ccw );
+
+    const LINE& path_cw = walk_cw.m_path;
+    const LINE& path_ccw = walk_ccw.m_path;
 
-        if( s_ccw != STUCK )
-            s_ccw = singleStep( path_ccw, false );
+    // Pick the path as if both directions were walked in lockstep, so the result does not
+    // depend on which one finished first.
+    for( ; m_iteration < m_iterationLimit; m_iteration++ )
+    {
+        s_cw = walk_cw.m_endIteration <= m_iteration ? walk_cw.m_status : IN_PROGRESS;
+        s_ccw = walk_ccw.m_endIteration <= m_iteration ? walk_ccw.m_status : IN_PROGRESS;
 
         if( ( s_cw == DONE && s_ccw == DONE ) || ( s_cw == STUCK && s_ccw == STUCK ) )
         {
@@ -207,8 +278,6 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
             aWalkPath = path_ccw;
             break;
         }
-
-        m_iteration++;
     }
 
     if( m_iteration == m_iterationLimit )
@@ -22,6 +22,9 @@
 #ifndef __PNS_WALKAROUND_H
 #define __PNS_WALKAROUND_H
 
+#include <atomic>
+#include <climits>
+#include <mutex>
 #include <set>
 
 #include "pns_line.h"
@@ -49,8 +52,6 @@ public:
         m_itemMask = ITEM::ANY_T;
 
         // Initialize other members, to avoid uninitialized variables.
-        m_recursiveBlockageCount = 0;
-        m_recursiveCollision[0] = m_recursiveCollision[1] = false;
         m_iteration = 0;
         m_forceCw = false;
     }
@@ -127,14 +128,39 @@ public:
     }
 
 private:
+    ///> State of the walk around the obstacles in one direction
+    struct WALK
+    {
+        WALK( const LINE& aPath, bool aCw ) :
+            m_path( aPath ),
+            m_cw( aCw ),
+            m_status( IN_PROGRESS ),
+            m_endIteration( INT_MAX ),
+            m_recursiveCollision( false ),
+            m_recursiveBlockageCount( 0 )
+        {}
+
+        LINE m_path;
+        bool m_cw;
+        WALKAROUND_STATUS m_status;
+
+        ///> iteration at which the walk got DONE or STUCK
+        int m_endIteration;
+
+        NODE::OPT_OBSTACLE m_currentObstacle;
+        bool m_recursiveCollision;
+        int m_recursiveBlockageCount;
+    };
+
     void start( const LINE& aInitialPath );
 
-    WALKAROUND_STATUS singleStep( LINE& aPath, bool aWindingDirection );
+    WALKAROUND_STATUS singleStep( WALK& aWalk, int aIteration );
+    void advance( WALK& aWalk, int aIteration, std::atomic<int>& aStopIteration );
+    void walkBothDirections( WALK& aCw, WALK& aCcw );
     NODE::OPT_OBSTACLE nearestObstacle( const LINE& aPath );
 
     NODE* m_world;
 
-    int m_recursiveBlockageCount;
     int m_iteration;
     int m_iterationLimit;
     int m_itemMask;
@@ -143,9 +169,8 @@ private:
     bool m_forceWinding;
     bool m_forceCw;
     VECTOR2I m_cursorPos;
-    NODE::OPT_OBSTACLE m_currentObstacle[2];
-    bool m_recursiveCollision[2];
     LOGGER m_logger;
+    std::mutex m_loggerLock;
     std::set<ITEM*> m_restrictedSet;
 };
 
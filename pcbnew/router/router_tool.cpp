@@ -51,6 +51,9 @@ using namespace std::placeholders;
 #include <tool/grid_menu.h>
 
 #include <tool/zoom_menu.h>
+#include <board_commit.h>
+#include <connectivity/connectivity_data.h>
+#include <widgets/progress_reporter.h>
 #include <tools/pcb_actions.h>
 #include <tools/selection_tool.h>
 #include <tools/edit_tool.h>
@@ -58,6 +61,7 @@ using namespace std::placeholders;
 #include <tools/tool_event_utils.h>
 
 #include "router_tool.h"
+#include "pns_batch_router.h"
 #include "pns_segment.h"
 #include "pns_router.h"
 
@@ -100,6 +104,12 @@ TOOL_ACTION PCB_ACTIONS::routerActivateDpDimensionsDialog( "pcbnew.InteractiveRo
         _( "Open Differential Pair Dimension settings" ),
         ps_diff_pair_gap_xpm );
 
+TOOL_ACTION PCB_ACTIONS::routerAutorouteUnrouted( "pcbnew.InteractiveRouter.AutorouteUnrouted",
+        AS_GLOBAL, 0,
+        _( "Autoroute Unrouted Connections" ),
+        _( "Route the unconnected items of the ratsnest with the push & shove router" ),
+        ps_router_xpm );
+
 TOOL_ACTION PCB_ACTIONS::routerActivateTuneSingleTrace( "pcbnew.LengthTuner.TuneSingleTrack",
         AS_GLOBAL, TOOL_ACTION::LegacyHotKey( HK_ROUTE_TUNE_SINGLE ),
         _( "Tune length of a single track" ), "", ps_tune_length_xpm, AF_ACTIVATE );
@@ -889,12 +899,55 @@ int ROUTER_TOOL::SettingsDialog( const TOOL_EVENT& aEvent )
 }
 
 
+int ROUTER_TOOL::AutorouteUnrouted( const TOOL_EVENT& aEvent )
+{
+    m_toolMgr->RunAction( PCB_ACTIONS::selectionClear, true );
+
+    Activate();
+
+    board()->GetConnectivity()->RecalculateRatsnest();
+
+    PNS_BATCH_ROUTER batchRouter( board() );
+
+    {
+        WX_PROGRESS_REPORTER reporter( frame(), _( "Autoroute Unrouted Connections" ), 2 );
+
+        batchRouter.SetSettings( m_router->Settings() );
+        batchRouter.SetProgressReporter( &reporter );
+
+        if( !batchRouter.Route() )
+            return 0;
+    }
+
+    std::vector<BOARD_CONNECTED_ITEM*> added, removed;
+    BOARD_COMMIT                       commit( this );
+
+    batchRouter.GetChanges( added, removed );
+
+    for( BOARD_CONNECTED_ITEM* item : removed )
+        commit.Remove( item );
+
+    for( BOARD_CONNECTED_ITEM* item : added )
+        commit.Add( item );
+
+    commit.Push( _( "Autoroute unrouted connections" ) );
+
+    const PNS_BATCH_ROUTER::STATS& stats = batchRouter.Stats();
+
+    frame()->SetStatusText( wxString::Format( _( "%d of %d connections routed" ),
+                                              stats.m_routed, stats.m_connections ) );
+
+    return 0;
+}
+
+
 void ROUTER_TOOL::setTransitions()
 {
     Go( &ROUTER_TOOL::RouteSingleTrace, PCB_ACTIONS::routerActivateSingle.MakeEvent() );
     Go( &ROUTER_TOOL::RouteDiffPair, PCB_ACTIONS::routerActivateDiffPair.MakeEvent() );
     Go( &ROUTER_TOOL::DpDimensionsDialog, PCB_ACTIONS::routerActivateDpDimensionsDialog.MakeEvent() );
     Go( &ROUTER_TOOL::SettingsDialog, PCB_ACTIONS::routerActivateSettingsDialog.MakeEvent() );
+    Go( &ROUTER_TOOL::AutorouteUnrouted, PCB_ACTIONS::routerAutorouteUnrouted.MakeEvent() );
     Go( &ROUTER_TOOL::InlineDrag, PCB_ACTIONS::routerInlineDrag.MakeEvent() );
     Go( &ROUTER_TOOL::InlineBreakTrack, PCB_ACTIONS::inlineBreakTrack.MakeEvent() );
 
@@ -45,6 +45,9 @@ public:
     int SettingsDialog( const TOOL_EVENT& aEvent );
     int CustomTrackWidthDialog( const TOOL_EVENT& aEvent );
 
+    ///> Routes the unconnected edges of the ratsnest, see PNS_BATCH_ROUTER
+    int AutorouteUnrouted( const TOOL_EVENT& aEvent );
+
     void setTransitions() override;
 
     // A filter for narrowing a collection representing a simple corner
@@ -49,6 +49,7 @@
 
 #include <cstdarg>
 #include <cstdio>
+#include <memory>
 
 #include <build_version.h>
 
@@ -242,9 +243,9 @@ void SPECCTRA_DB::readTIME( time_t* time_stamp )
 
 void SPECCTRA_DB::LoadPCB( const wxString& aFilename )
 {
-    FILE_LINE_READER curr_reader( aFilename );
+    std::unique_ptr<LINE_READER> curr_reader( OpenFileLineReader( aFilename ) );
 
-    PushReader( &curr_reader );
+    PushReader( curr_reader.get() );
 
     if( NextTok() != T_LEFT )
         Expecting( T_LEFT );
@@ -261,9 +262,9 @@ void SPECCTRA_DB::LoadPCB( const wxString& aFilename )
 
 void SPECCTRA_DB::LoadSESSION( const wxString& aFilename )
 {
-    FILE_LINE_READER curr_reader( aFilename );
+    std::unique_ptr<LINE_READER> curr_reader( OpenFileLineReader( aFilename ) );
 
-    PushReader( &curr_reader );
+    PushReader( curr_reader.get() );
 
     if( NextTok() != T_LEFT )
         Expecting( T_LEFT );
@@ -74,6 +74,9 @@ OPT<TOOL_EVENT> PCB_ACTIONS::TranslateLegacyId( int aId )
     case ID_MENU_DIFF_PAIR_DIMENSIONS:
         return PCB_ACTIONS::routerActivateDpDimensionsDialog.MakeEvent();
 
+    case ID_MENU_AUTOROUTE_UNROUTED:
+        return PCB_ACTIONS::routerAutorouteUnrouted.MakeEvent();
+
     case ID_PCB_ZONES_BUTT:
         return PCB_ACTIONS::drawZone.MakeEvent();
 
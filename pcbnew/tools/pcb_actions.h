@@ -183,6 +183,9 @@ public:
     static TOOL_ACTION routerActivateSettingsDialog;
     static TOOL_ACTION routerActivateDpDimensionsDialog;
 
+    /// Batch routing of the unconnected edges of the ratsnest
+    static TOOL_ACTION routerAutorouteUnrouted;
+
 
     /// Activation of the Push and Shove router (inline dragging mode)
     static TOOL_ACTION routerInlineDrag;
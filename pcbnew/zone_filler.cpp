@@ -24,10 +24,9 @@
  */
 
 #include <cstdint>
-#include <thread>
 #include <mutex>
 #include <algorithm>
-#include <future>
+#include <tuple>
 
 #include <class_board.h>
 #include <class_zone.h>
@@ -48,6 +47,8 @@
 #include <geometry/convex_hull.h>
 #include <geometry/geometry_utils.h>
 #include <confirm.h>
+#include <hash_eda.h>
+#include <thread_pool.h>
 
 #include "zone_filler.h"
 
@@ -83,6 +84,51 @@ static double s_thermalRot = 450;   // angle of stubs in thermal reliefs for rou
 static const bool s_DumpZonesWhenFilling = false;
 
 
+/// Orders the items of fill inputs by key, then by area
+static bool itemLess( const ZONE_FILL_INPUTS::ITEM& aA, const ZONE_FILL_INPUTS::ITEM& aB )
+{
+    auto tie = []( const ZONE_FILL_INPUTS::ITEM& aItem )
+    {
+        const EDA_RECT& r = aItem.second;
+        return std::make_tuple( aItem.first, r.GetX(), r.GetY(), r.GetWidth(), r.GetHeight() );
+    };
+
+    return tie( aA ) < tie( aB );
+}
+
+
+static inline void hashCombine( size_t& aSeed, size_t aValue )
+{
+    aSeed ^= aValue + 0x9e3779b9 + ( aSeed << 6 ) + ( aSeed >> 2 );
+}
+
+
+static void hashPolySet( size_t& aSeed, const SHAPE_POLY_SET& aPolySet )
+{
+    hashCombine( aSeed, aPolySet.OutlineCount() );
+
+    for( int ii = 0; ii < aPolySet.OutlineCount(); ii++ )
+    {
+        hashCombine( aSeed, aPolySet.HoleCount( ii ) );
+
+        for( auto it = aPolySet.CIterateWithHoles( ii ); it; it++ )
+        {
+            hashCombine( aSeed, it->x );
+            hashCombine( aSeed, it->y );
+        }
+    }
+}
+
+
+static void hashRect( size_t& aSeed, const EDA_RECT& aRect )
+{
+    hashCombine( aSeed, aRect.GetX() );
+    hashCombine( aSeed, aRect.GetY() );
+    hashCombine( aSeed, aRect.GetWidth() );
+    hashCombine( aSeed, aRect.GetHeight() );
+}
+
+
 ZONE_FILLER::ZONE_FILLER(  BOARD* aBoard, COMMIT* aCommit ) :
     m_board( aBoard ), m_commit( aCommit ), m_progressReporter( nullptr )
 {
@@ -111,10 +157,18 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         return false;
 
     if( m_progressReporter )
-    {
         m_progressReporter->Report( _( "Checking zone fills..." ) );
-        m_progressReporter->SetMaxProgress( toFill.size() );
-    }
+
+    // Zones whose raw filled areas are out of date
+    struct REFILL
+    {
+        ZONE_CONTAINER*  m_zone;
+        ZONE_FILL_INPUTS m_inputs;
+        bool             m_partial;     ///< refill only m_dirtyArea
+        EDA_RECT         m_dirtyArea;
+    };
+
+    std::vector<REFILL> toRefill;
 
     for( auto zone : aZones )
     {
@@ -135,23 +189,75 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         // Remove existing fill first to prevent drawing invalid polygons
         // on some platforms
         zone->UnFill();
+
+        REFILL refill;
+        refill.m_zone = zone;
+        refill.m_partial = false;
+        computeFillInputs( zone, refill.m_inputs );
+
+        const ZONE_FILL_INPUTS& previous = zone->GetFillInputs();
+
+        if( previous.m_settingsKey == refill.m_inputs.m_settingsKey )
+        {
+            if( !findDirtyArea( previous, refill.m_inputs, refill.m_dirtyArea ) )
+            {
+                // Nothing around the zone changed: its raw filled areas are still valid.
+                // Insulated islands are removed again below, as they depend on other zones.
+                zone->SetFilledPolysList( zone->RawPolysList() );
+                zone->SetIsFilled( true );
+                zone->SetNeedRefill( false );
+                continue;
+            }
+
+            // Refill only around the changed items, unless they cover most of the zone.
+            // Hatched fills are not refilled partially, their grid depends on the whole fill.
+            if( zone->IsOnCopperLayer() && zone->GetFillMode() == ZFM_POLYGONS )
+            {
+                growDirtyAreaForThermals( zone, refill.m_dirtyArea );
+
+                EDA_RECT zoneBBox = zone->GetBoundingBox();
+                double   dirtySize = double( refill.m_dirtyArea.GetWidth() )
+                                     * refill.m_dirtyArea.GetHeight();
+                double   zoneSize = double( zoneBBox.GetWidth() ) * zoneBBox.GetHeight();
+
+                refill.m_partial = dirtySize < zoneSize / 2;
+            }
+        }
+
+        toRefill.push_back( refill );
     }
 
+    // Only the zones to refill are reported, the other ones are already done
+    if( m_progressReporter )
+        m_progressReporter->SetMaxProgress( toRefill.size() );
+
     std::atomic<size_t> nextItem( 0 );
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(), toFill.size() );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    THREAD_POOL& pool = THREAD_POOL::GetInstance();
+    size_t parallelThreadCount = pool.GetTaskCount( toFill.size() );
+    size_t fillThreadCount = pool.GetTaskCount( toRefill.size() );
+    TASK_GROUP fillTasks( pool );
 
     auto fill_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
     {
         size_t num = 0;
 
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
+        for( size_t i = nextItem++; i < toRefill.size() && !fillTasks.IsCancelled(); i = nextItem++ )
         {
-            ZONE_CONTAINER* zone = toFill[i].m_zone;
+            REFILL& refill = toRefill[i];
+            ZONE_CONTAINER* zone = refill.m_zone;
             SHAPE_POLY_SET rawPolys, finalPolys;
-            fillSingleZone( zone, rawPolys, finalPolys );
+            bool filled;
+
+            if( refill.m_partial )
+                filled = refillDirtyArea( zone, refill.m_dirtyArea, rawPolys, finalPolys );
+            else
+                filled = fillSingleZone( zone, rawPolys, finalPolys );
+
+            if( !filled )
+                refill.m_inputs = ZONE_FILL_INPUTS();
 
             zone->SetRawPolysList( rawPolys );
+            zone->SetFillInputs( refill.m_inputs );
             zone->SetFilledPolysList( finalPolys );
             zone->SetIsFilled( true );
 
@@ -164,24 +270,17 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         return num;
     };
 
-    if( parallelThreadCount <= 1 )
+    if( fillThreadCount <= 1 )
         fill_lambda( m_progressReporter );
     else
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, fill_lambda, m_progressReporter );
+        fillTasks.Run( [&]() { fill_lambda( m_progressReporter ); }, fillThreadCount );
 
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        // Filling can only be aborted when the changes can be reverted
+        if( !fillTasks.WaitAndRefresh( m_progressReporter, m_commit != nullptr ) )
         {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
-
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
+            m_commit->Revert();
+            return false;
         }
     }
 
@@ -281,21 +380,11 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         tri_lambda( m_progressReporter );
     else
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, tri_lambda, m_progressReporter );
+        TASK_GROUP triangulationTasks( pool );
 
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
-
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
-        }
+        triangulationTasks.Run( [&]() { tri_lambda( m_progressReporter ); },
+                                parallelThreadCount );
+        triangulationTasks.WaitAndRefresh( m_progressReporter );
     }
 
     if( m_progressReporter )
@@ -323,8 +412,316 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
 }
 
 
+void ZONE_FILLER::computeFillInputs( ZONE_CONTAINER* aZone, ZONE_FILL_INPUTS& aInputs ) const
+{
+    // The items taken into account here must be a superset of the items used by
+    // buildZoneFeatureHoleList() and buildUnconnectedThermalStubsPolygonList():
+    // an item missing here would leave a stale fill in place after it is edited.
+    const BOARD_DESIGN_SETTINGS& bds = m_board->GetDesignSettings();
+    size_t key = 0;
+
+    hashPolySet( key, *aZone->Outline() );
+    hashCombine( key, aZone->GetLayerSet().to_ullong() );
+    hashCombine( key, aZone->GetNetCode() );
+    hashCombine( key, aZone->GetPriority() );
+    hashCombine( key, aZone->GetClearance() );
+    hashCombine( key, aZone->GetZoneClearance() );
+    hashCombine( key, aZone->GetMinThickness() );
+    hashCombine( key, aZone->GetArcSegmentCount() );
+    hashCombine( key, aZone->GetCornerSmoothingType() );
+    hashCombine( key, aZone->GetCornerRadius() );
+    hashCombine( key, aZone->GetFillMode() );
+    hashCombine( key, aZone->GetHatchFillTypeThickness() );
+    hashCombine( key, aZone->GetHatchFillTypeGap() );
+    hashCombine( key, std::hash<double>{}( aZone->GetHatchFillTypeOrientation() ) );
+    hashCombine( key, aZone->GetHatchFillTypeSmoothingLevel() );
+    hashCombine( key, std::hash<double>{}( aZone->GetHatchFillTypeSmoothingValue() ) );
+    hashCombine( key, bds.GetBiggestClearanceValue() );
+    hashCombine( key, bds.m_CopperEdgeClearance );
+
+    // A null key means "not filled"
+    aInputs.m_settingsKey = key ? key : 1;
+    aInputs.m_items.clear();
+
+    int outline_half_thickness = aZone->GetMinThickness() / 2;
+    int zone_clearance = aZone->GetClearance() + outline_half_thickness;
+    EDA_RECT zone_boundingbox = aZone->GetBoundingBox();
+    zone_boundingbox.Inflate( std::max( bds.GetBiggestClearanceValue(), zone_clearance ) );
+
+    // Adds an item whose knock-out (or thermal relief) lies inside aItemBBox inflated
+    // by aClearance, if this area can reach the zone
+    auto addItem = [&]( size_t aItemKey, EDA_RECT aItemBBox, int aClearance )
+    {
+        aItemBBox.Inflate( std::max( aClearance, zone_clearance ) + outline_half_thickness );
+
+        if( aItemBBox.Intersects( zone_boundingbox ) )
+            aInputs.m_items.emplace_back( aItemKey, aItemBBox );
+    };
+
+    // Pads of any net: other nets are knocked out, the zone net gets thermal reliefs.
+    // Pads on other layers are knocked out if they have a hole.
+    for( auto module : m_board->Modules() )
+    {
+        for( auto pad : module->Pads() )
+        {
+            // hash_eda() uses the position of the pad inside its footprint: the absolute
+            // position and orientation are needed to see a moved or rotated footprint
+            size_t itemKey = hash_eda( pad, HASH_FLAGS::ALL );
+
+            hashCombine( itemKey, pad->GetPosition().x );
+            hashCombine( itemKey, pad->GetPosition().y );
+            hashCombine( itemKey, std::hash<double>{}( pad->GetOrientation() ) );
+            hashCombine( itemKey, pad->GetDrillSize().x );
+            hashCombine( itemKey, pad->GetDrillSize().y );
+            hashCombine( itemKey, pad->GetAttribute() );
+            hashCombine( itemKey, std::hash<double>{}( pad->GetRoundRectRadiusRatio() ) );
+            hashCombine( itemKey, std::hash<double>{}( pad->GetChamferRectRatio() ) );
+            hashCombine( itemKey, pad->GetChamferPositions() );
+            hashCombine( itemKey, pad->GetClearance() );
+            hashCombine( itemKey, aZone->GetPadConnection( pad ) );
+            hashCombine( itemKey, aZone->GetThermalReliefGap( pad ) );
+            hashCombine( itemKey, aZone->GetThermalReliefCopperBridge( pad ) );
+
+            if( pad->GetShape() == PAD_SHAPE_CUSTOM )
+            {
+                hashCombine( itemKey, pad->GetCustomShapeInZoneOpt() );
+                hashPolySet( itemKey, pad->GetCustomShapeAsPolygon() );
+            }
+
+            addItem( itemKey, pad->GetBoundingBox(),
+                     std::max( pad->GetClearance(), aZone->GetThermalReliefGap( pad ) ) );
+        }
+    }
+
+    for( auto track : m_board->Tracks() )
+    {
+        if( !track->IsOnLayer( aZone->GetLayer() ) )
+            continue;
+
+        size_t itemKey = hash_eda( track, HASH_FLAGS::ALL );
+        hashCombine( itemKey, track->GetClearance() );
+
+        addItem( itemKey, track->GetBoundingBox(), track->GetClearance() );
+    }
+
+    auto doGraphicItem = [&]( BOARD_ITEM* aItem )
+    {
+        if( !aItem->IsOnLayer( aZone->GetLayer() ) && !aItem->IsOnLayer( Edge_Cuts ) )
+            return;
+
+        // Texts are knocked out by their bounding box, which hash_eda() does not
+        // fully cover (e.g. the pen width of module texts)
+        size_t itemKey = aItem->Type();
+        hashRect( itemKey, aItem->GetBoundingBox() );
+
+        switch( aItem->Type() )
+        {
+        case PCB_LINE_T:
+        case PCB_TEXT_T:
+        case PCB_MODULE_EDGE_T:
+            hashCombine( itemKey, hash_eda( aItem, HASH_FLAGS::ALL ) );
+            break;
+
+        case PCB_MODULE_TEXT_T:
+            hashCombine( itemKey, hash_eda( aItem, HASH_FLAGS::ALL ) );
+            hashCombine( itemKey, static_cast<TEXTE_MODULE*>( aItem )->IsVisible() );
+            break;
+
+        default:
+            break;
+        }
+
+        addItem( itemKey, aItem->GetBoundingBox(), bds.m_CopperEdgeClearance );
+    };
+
+    for( auto module : m_board->Modules() )
+    {
+        doGraphicItem( &module->Reference() );
+        doGraphicItem( &module->Value() );
+
+        for( auto item : module->GraphicalItems() )
+            doGraphicItem( item );
+    }
+
+    for( auto item : m_board->Drawings() )
+        doGraphicItem( item );
+
+    for( int ii = 0; ii < m_board->GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zone = m_board->GetArea( ii );
+
+        if( zone == aZone || !aZone->CommonLayerExists( zone->GetLayerSet() ) )
+            continue;
+
+        size_t itemKey = PCB_ZONE_AREA_T;
+        hashPolySet( itemKey, *zone->Outline() );
+        hashCombine( itemKey, zone->GetNetCode() );
+        hashCombine( itemKey, zone->GetPriority() );
+        hashCombine( itemKey, zone->GetClearance() );
+        hashCombine( itemKey, zone->GetIsKeepout() );
+        hashCombine( itemKey, zone->GetDoNotAllowCopperPour() );
+
+        addItem( itemKey, zone->GetBoundingBox(), zone->GetClearance() );
+    }
+
+    std::sort( aInputs.m_items.begin(), aInputs.m_items.end(), itemLess );
+}
+
+
+bool ZONE_FILLER::findDirtyArea( const ZONE_FILL_INPUTS& aPrevious,
+                                 const ZONE_FILL_INPUTS& aCurrent, EDA_RECT& aDirtyArea ) const
+{
+    aDirtyArea = EDA_RECT();
+
+    // Items are sorted by key and area: the items found only in one of the lists are the
+    // ones which were added, removed, modified or moved since the previous fill.  An item
+    // whose key is unchanged but whose area is not dirties both its old and new areas.
+    auto prev = aPrevious.m_items.begin();
+    auto curr = aCurrent.m_items.begin();
+    bool dirty = false;
+
+    auto addArea = [&]( const EDA_RECT& aArea )
+    {
+        if( dirty )
+            aDirtyArea.Merge( aArea );
+        else
+            aDirtyArea = aArea;
+
+        dirty = true;
+    };
+
+    while( prev != aPrevious.m_items.end() || curr != aCurrent.m_items.end() )
+    {
+        if( curr == aCurrent.m_items.end()
+                || ( prev != aPrevious.m_items.end() && itemLess( *prev, *curr ) ) )
+        {
+            addArea( prev->second );
+            ++prev;
+        }
+        else if( prev == aPrevious.m_items.end() || itemLess( *curr, *prev ) )
+        {
+            addArea( curr->second );
+            ++curr;
+        }
+        else
+        {
+            ++prev;
+            ++curr;
+        }
+    }
+
+    return dirty;
+}
+
+
+void ZONE_FILLER::growDirtyAreaForThermals( const ZONE_CONTAINER* aZone,
+                                            EDA_RECT& aDirtyArea ) const
+{
+    if( aZone->GetNetCode() <= 0 )
+        return;
+
+    // Whether a thermal stub is kept is tested at points around its pad, against the
+    // fill of the whole zone: these points must be inside the area being refilled.
+    std::vector<EDA_RECT> thermalAreas;
+    int pen_radius = aZone->GetMinThickness() / 2;
+
+    for( auto module : m_board->Modules() )
+    {
+        for( auto pad : module->Pads() )
+        {
+            if( aZone->GetPadConnection( pad ) != PAD_ZONE_CONN_THERMAL
+                && aZone->GetPadConnection( pad ) != PAD_ZONE_CONN_THT_THERMAL )
+                continue;
+
+            if( !pad->IsOnLayer( aZone->GetLayer() ) || pad->GetNetCode() != aZone->GetNetCode() )
+                continue;
+
+            EDA_RECT area = pad->GetBoundingBox();
+            area.Inflate( 2 * ( aZone->GetThermalReliefGap( pad ) + pen_radius ) );
+            thermalAreas.push_back( area );
+        }
+    }
+
+    bool grown = true;
+
+    while( grown )
+    {
+        grown = false;
+
+        for( const EDA_RECT& area : thermalAreas )
+        {
+            if( !area.Intersects( aDirtyArea ) || aDirtyArea.Contains( area ) )
+                continue;
+
+            aDirtyArea.Merge( area );
+            grown = true;
+        }
+    }
+}
+
+
+bool ZONE_FILLER::refillDirtyArea( ZONE_CONTAINER* aZone, const EDA_RECT& aDirtyArea,
+                                   SHAPE_POLY_SET& aRawPolys, SHAPE_POLY_SET& aFinalPolys ) const
+{
+    SHAPE_POLY_SET smoothedPoly;
+
+    if( !aZone->BuildSmoothedPoly( smoothedPoly ) )
+        return false;
+
+    int segsPerCircle = std::max( aZone->GetArcSegmentCount(), ARC_APPROX_SEGMENTS_COUNT_HIGH_DEF );
+    double correctionFactor = GetCircletoPolyCorrectionFactor( segsPerCircle );
+
+    SHAPE_POLY_SET dirtyPoly;
+    dirtyPoly.NewOutline();
+    dirtyPoly.Append( aDirtyArea.GetOrigin() );
+    dirtyPoly.Append( aDirtyArea.GetRight(), aDirtyArea.GetY() );
+    dirtyPoly.Append( aDirtyArea.GetEnd() );
+    dirtyPoly.Append( aDirtyArea.GetX(), aDirtyArea.GetBottom() );
+
+    // Same steps as computeRawFilledAreas(), restricted to the dirty area
+    SHAPE_POLY_SET solidAreas = smoothedPoly;
+
+    solidAreas.Inflate( -aZone->GetMinThickness() / 2, segsPerCircle );
+    solidAreas.BooleanIntersection( dirtyPoly, SHAPE_POLY_SET::PM_FAST );
+
+    SHAPE_POLY_SET holes;
+
+    buildZoneFeatureHoleList( aZone, holes, &aDirtyArea );
+    holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+    solidAreas.BooleanSubtract( holes, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+
+    SHAPE_POLY_SET thermalHoles;
+
+    if( aZone->GetNetCode() > 0 )
+    {
+        buildUnconnectedThermalStubsPolygonList( thermalHoles, aZone, solidAreas,
+                correctionFactor, s_thermalRot );
+    }
+
+    if( !thermalHoles.IsEmpty() )
+    {
+        thermalHoles.Simplify( SHAPE_POLY_SET::PM_FAST );
+        solidAreas.BooleanSubtract( thermalHoles, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+    }
+
+    // Splice the refilled area into the previous fill
+    SHAPE_POLY_SET unchangedAreas = aZone->RawPolysList();
+
+    unchangedAreas.BooleanSubtract( dirtyPoly, SHAPE_POLY_SET::PM_FAST );
+    solidAreas.BooleanAdd( unchangedAreas, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+    solidAreas.Fracture( SHAPE_POLY_SET::PM_FAST );
+
+    aFinalPolys = solidAreas;
+    aRawPolys = aFinalPolys;
+
+    aZone->SetNeedRefill( false );
+    return true;
+}
+
+
 void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
-        SHAPE_POLY_SET& aFeatures ) const
+        SHAPE_POLY_SET& aFeatures, const EDA_RECT* aArea ) const
 {
     // Set the number of segments in arc approximations
     // Since we can no longer edit the segment count in pcbnew, we set
@@ -360,7 +757,7 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
      * the bounding box is the zone bounding box + the biggest clearance found in Netclass list
      */
     EDA_RECT    item_boundingbox;
-    EDA_RECT    zone_boundingbox = aZone->GetBoundingBox();
+    EDA_RECT    zone_boundingbox = aArea ? *aArea : aZone->GetBoundingBox();
     int biggest_clearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
     biggest_clearance = std::max( biggest_clearance, zone_clearance );
     zone_boundingbox.Inflate( biggest_clearance );
@@ -46,8 +46,42 @@ public:
 
 private:
 
+    /**
+     * Collects everything the raw filled areas of aZone depend on: the zone outline and
+     * settings, and every item close enough to the zone to change its fill.
+     * When the inputs of a zone did not change since its last fill, its raw filled areas
+     * are still valid and are reused instead of being computed again.
+     */
+    void computeFillInputs( ZONE_CONTAINER* aZone, ZONE_FILL_INPUTS& aInputs ) const;
+
+    /**
+     * Finds the area of a zone fill which can change between two sets of fill inputs
+     * having the same settings.
+     * @return false if both sets of inputs have the same items.
+     */
+    bool findDirtyArea( const ZONE_FILL_INPUTS& aPrevious, const ZONE_FILL_INPUTS& aCurrent,
+            EDA_RECT& aDirtyArea ) const;
+
+    /**
+     * Grows aDirtyArea to fully contain the thermal reliefs it touches, because the
+     * thermal stubs of a pad are tested against the fill all around the pad.
+     */
+    void growDirtyAreaForThermals( const ZONE_CONTAINER* aZone, EDA_RECT& aDirtyArea ) const;
+
+    /**
+     * Refills aZone inside aDirtyArea only, and splices the result into the current raw
+     * filled areas of the zone.  Only valid for solid fills on copper layers.
+     * @return false if the solid polygons cannot be built
+     */
+    bool refillDirtyArea( ZONE_CONTAINER* aZone, const EDA_RECT& aDirtyArea,
+            SHAPE_POLY_SET& aRawPolys, SHAPE_POLY_SET& aFinalPolys ) const;
+
+    /**
+     * Builds the knock-outs of the items close to aZone.
+     * @param aArea when not null, only the items close to this area are used.
+     */
     void buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
-            SHAPE_POLY_SET& aFeatures ) const;
+            SHAPE_POLY_SET& aFeatures, const EDA_RECT* aArea = nullptr ) const;
 
     /**
      * Function computeRawFilledAreas
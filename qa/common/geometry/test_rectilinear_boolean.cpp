@@ -0,0 +1,368 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the rectilinear boolean operations, checking they cover the same area as
+ * the results of Clipper
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <random>
+#include <set>
+#include <utility>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+// Code under test
+#include <geometry/rectilinear_boolean.h>
+
+
+/**
+ * Enables the rectilinear engine again at the end of a test
+ */
+struct RECTILINEAR_BOOLEAN_FIXTURE
+{
+    ~RECTILINEAR_BOOLEAN_FIXTURE()
+    {
+        RECTILINEAR_BOOLEAN::SetEnabled( true );
+    }
+};
+
+
+///> All coordinates are multiples of this, the sample points are in between
+static const int GRID = 10;
+
+
+static SHAPE_LINE_CHAIN makeRect( int aX, int aY, int aW, int aH, bool aClockwise = false )
+{
+    SHAPE_LINE_CHAIN chain;
+
+    chain.Append( aX, aY );
+
+    if( aClockwise )
+    {
+        chain.Append( aX, aY + aH );
+        chain.Append( aX + aW, aY + aH );
+        chain.Append( aX + aW, aY );
+    }
+    else
+    {
+        chain.Append( aX + aW, aY );
+        chain.Append( aX + aW, aY + aH );
+        chain.Append( aX, aY + aH );
+    }
+
+    chain.SetClosed( true );
+
+    return chain;
+}
+
+
+/**
+ * Overlapping rectangles of both orientations, some with a hole, like pads and spokes
+ */
+static SHAPE_POLY_SET makeRandomSet( std::mt19937& aRng, int aCount )
+{
+    std::uniform_int_distribution<int> pos( 0, 40 );
+    std::uniform_int_distribution<int> size( 1, 15 );
+    std::uniform_int_distribution<int> coin( 0, 3 );
+    SHAPE_POLY_SET                     set;
+
+    for( int i = 0; i < aCount; i++ )
+    {
+        int x = pos( aRng ) * GRID;
+        int y = pos( aRng ) * GRID;
+        int w = size( aRng ) * GRID + 2 * GRID;
+        int h = size( aRng ) * GRID + 2 * GRID;
+
+        set.AddOutline( makeRect( x, y, w, h, coin( aRng ) == 0 ) );
+
+        if( coin( aRng ) == 0 )
+            set.AddHole( makeRect( x + GRID, y + GRID, w - 2 * GRID, h - 2 * GRID ) );
+    }
+
+    return set;
+}
+
+
+static double totalArea( const SHAPE_POLY_SET& aSet )
+{
+    double area = 0.0;
+
+    for( int i = 0; i < aSet.OutlineCount(); i++ )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : aSet.CPolygon( i ) )
+            area += chain.Area();
+    }
+
+    return area;
+}
+
+
+/**
+ * @return true if no point of the outlines and holes of aSet is visited twice by its loop
+ */
+static bool isStrictlySimple( const SHAPE_POLY_SET& aSet )
+{
+    for( int i = 0; i < aSet.OutlineCount(); i++ )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : aSet.CPolygon( i ) )
+        {
+            std::set<std::pair<int, int>> points;
+
+            for( int j = 0; j < chain.PointCount(); j++ )
+            {
+                if( !points.emplace( chain.CPoint( j ).x, chain.CPoint( j ).y ).second )
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+static SHAPE_POLY_SET booleanOp( ClipperLib::ClipType aType, const SHAPE_POLY_SET& aA,
+                                 const SHAPE_POLY_SET& aB, bool aRectilinear )
+{
+    SHAPE_POLY_SET result;
+
+    RECTILINEAR_BOOLEAN::SetEnabled( aRectilinear );
+
+    switch( aType )
+    {
+    case ClipperLib::ctUnion:
+        result.BooleanAdd( aA, aB, SHAPE_POLY_SET::PM_FAST );
+        break;
+    case ClipperLib::ctDifference:
+        result.BooleanSubtract( aA, aB, SHAPE_POLY_SET::PM_FAST );
+        break;
+    case ClipperLib::ctIntersection:
+        result.BooleanIntersection( aA, aB, SHAPE_POLY_SET::PM_FAST );
+        break;
+    default:
+        break;
+    }
+
+    RECTILINEAR_BOOLEAN::SetEnabled( true );
+
+    return result;
+}
+
+
+/**
+ * Checks both sets cover the same points, sampled between the grid lines
+ */
+static void checkSameArea( const SHAPE_POLY_SET& aExpected, const SHAPE_POLY_SET& aResult )
+{
+    BOOST_CHECK_CLOSE( totalArea( aExpected ), totalArea( aResult ), 1e-9 );
+
+    int mismatches = 0;
+
+    for( int x = -GRID / 2; x < 60 * GRID; x += GRID )
+    {
+        for( int y = -GRID / 2; y < 60 * GRID; y += GRID )
+        {
+            if( aExpected.Contains( VECTOR2I( x, y ) ) != aResult.Contains( VECTOR2I( x, y ) ) )
+                mismatches++;
+        }
+    }
+
+    BOOST_CHECK_EQUAL( mismatches, 0 );
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( RectilinearBoolean, RECTILINEAR_BOOLEAN_FIXTURE )
+
+
+/**
+ * Random sets give the same results as Clipper, with outlines and holes oriented alike
+ */
+BOOST_AUTO_TEST_CASE( SameAsClipper )
+{
+    std::mt19937 rng( 42 );
+
+    for( int iter = 0; iter < 50; iter++ )
+    {
+        SHAPE_POLY_SET a = makeRandomSet( rng, 1 + iter % 7 );
+        SHAPE_POLY_SET b = makeRandomSet( rng, 1 + iter % 5 );
+
+        for( auto type : { ClipperLib::ctUnion, ClipperLib::ctDifference,
+                           ClipperLib::ctIntersection } )
+        {
+            BOOST_TEST_CONTEXT( "Iteration " << iter << ", operation " << type )
+            {
+                RECTILINEAR_BOOLEAN::ResetStats();
+
+                SHAPE_POLY_SET expected = booleanOp( type, a, b, false );
+                SHAPE_POLY_SET result = booleanOp( type, a, b, true );
+
+                BOOST_CHECK_EQUAL( RECTILINEAR_BOOLEAN::GetStats().m_calls, 1 );
+
+                checkSameArea( expected, result );
+                BOOST_CHECK( isStrictlySimple( result ) );
+
+                for( int i = 0; i < result.OutlineCount(); i++ )
+                {
+                    BOOST_CHECK_GT( result.COutline( i ).Area(), 0.0 );
+
+                    for( int j = 0; j < result.HoleCount( i ); j++ )
+                        BOOST_CHECK_LT( result.CHole( i, j ).Area(), 0.0 );
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Regions touching at a corner stay apart
+ */
+BOOST_AUTO_TEST_CASE( TouchingCorners )
+{
+    SHAPE_POLY_SET a;
+    SHAPE_POLY_SET b;
+
+    a.AddOutline( makeRect( 0, 0, 100, 100 ) );
+    b.AddOutline( makeRect( 100, 100, 100, 100 ) );
+
+    SHAPE_POLY_SET result = booleanOp( ClipperLib::ctUnion, a, b, true );
+
+    BOOST_CHECK_EQUAL( result.OutlineCount(), 2 );
+    BOOST_CHECK_EQUAL( result.COutline( 0 ).PointCount(), 4 );
+    BOOST_CHECK_EQUAL( result.COutline( 1 ).PointCount(), 4 );
+
+    // A frame with a corner cut out of its hole: the hole touches the outline at a point
+    SHAPE_POLY_SET frame;
+    SHAPE_POLY_SET cut;
+
+    frame.AddOutline( makeRect( 0, 0, 300, 300 ) );
+    frame.AddHole( makeRect( 100, 100, 100, 100 ) );
+    cut.AddOutline( makeRect( 200, 200, 100, 100 ) );
+
+    SHAPE_POLY_SET expected = booleanOp( ClipperLib::ctDifference, frame, cut, false );
+    result = booleanOp( ClipperLib::ctDifference, frame, cut, true );
+
+    checkSameArea( expected, result );
+    BOOST_CHECK( isStrictlySimple( result ) );
+}
+
+
+/**
+ * Holes touching at a corner stay apart, instead of making one loop touching itself
+ */
+BOOST_AUTO_TEST_CASE( TouchingHoles )
+{
+    SHAPE_POLY_SET plane;
+    SHAPE_POLY_SET cuts;
+
+    plane.AddOutline( makeRect( 0, 0, 400, 400 ) );
+    cuts.AddOutline( makeRect( 100, 100, 100, 100 ) );
+    cuts.AddOutline( makeRect( 200, 200, 100, 100 ) );
+
+    SHAPE_POLY_SET expected = booleanOp( ClipperLib::ctDifference, plane, cuts, false );
+    SHAPE_POLY_SET result = booleanOp( ClipperLib::ctDifference, plane, cuts, true );
+
+    checkSameArea( expected, result );
+    BOOST_CHECK( isStrictlySimple( result ) );
+
+    BOOST_REQUIRE_EQUAL( result.OutlineCount(), 1 );
+    BOOST_REQUIRE_EQUAL( result.HoleCount( 0 ), 2 );
+    BOOST_CHECK_EQUAL( result.CHole( 0, 0 ).PointCount(), 4 );
+    BOOST_CHECK_EQUAL( result.CHole( 0, 1 ).PointCount(), 4 );
+
+    // A notch in the outline touching the first hole at a corner
+    cuts.AddOutline( makeRect( 0, 0, 100, 100 ) );
+
+    expected = booleanOp( ClipperLib::ctDifference, plane, cuts, false );
+    result = booleanOp( ClipperLib::ctDifference, plane, cuts, true );
+
+    checkSameArea( expected, result );
+    BOOST_CHECK( isStrictlySimple( result ) );
+}
+
+
+/**
+ * Outlines nested in holes get their own polygon
+ */
+BOOST_AUTO_TEST_CASE( NestedIslands )
+{
+    SHAPE_POLY_SET plane;
+    SHAPE_POLY_SET islands;
+
+    plane.AddOutline( makeRect( 0, 0, 500, 500 ) );
+
+    for( int i = 0; i < 4; i++ )
+        islands.AddOutline( makeRect( 50 + i * 110, 50, 100, 100 ) );
+
+    // Knock out rings around the islands
+    SHAPE_POLY_SET rings;
+
+    for( int i = 0; i < 4; i++ )
+    {
+        rings.AddOutline( makeRect( 40 + i * 110, 40, 120, 120 ) );
+        rings.AddHole( makeRect( 50 + i * 110, 50, 100, 100 ) );
+    }
+
+    SHAPE_POLY_SET expected = booleanOp( ClipperLib::ctDifference, plane, rings, false );
+    SHAPE_POLY_SET result = booleanOp( ClipperLib::ctDifference, plane, rings, true );
+
+    checkSameArea( expected, result );
+    BOOST_CHECK_EQUAL( result.OutlineCount(), expected.OutlineCount() );
+}
+
+
+/**
+ * Sets with a slanted edge are left to Clipper
+ */
+BOOST_AUTO_TEST_CASE( Fallback )
+{
+    SHAPE_POLY_SET   a;
+    SHAPE_POLY_SET   b;
+    SHAPE_LINE_CHAIN triangle;
+
+    triangle.Append( 0, 0 );
+    triangle.Append( 100, 0 );
+    triangle.Append( 0, 100 );
+    triangle.SetClosed( true );
+
+    a.AddOutline( makeRect( 0, 0, 50, 50 ) );
+    b.AddOutline( triangle );
+
+    BOOST_CHECK( RECTILINEAR_BOOLEAN::IsRectilinear( a ) );
+    BOOST_CHECK( !RECTILINEAR_BOOLEAN::IsRectilinear( b ) );
+
+    RECTILINEAR_BOOLEAN::ResetStats();
+
+    a.BooleanAdd( b, SHAPE_POLY_SET::PM_FAST );
+
+    BOOST_CHECK_EQUAL( RECTILINEAR_BOOLEAN::GetStats().m_calls, 0 );
+    BOOST_CHECK_EQUAL( RECTILINEAR_BOOLEAN::GetStats().m_fallbacks, 1 );
+    BOOST_CHECK_EQUAL( a.OutlineCount(), 1 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the SEG_BATCH kernels, checking they give the same results as the SEG
+ * methods for each instruction set
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+#include <climits>
+#include <random>
+
+#include <geometry/shape_line_chain.h>
+
+// Code under test
+#include <geometry/seg_batch.h>
+
+
+/**
+ * Restores the best instruction set at the end of a test
+ */
+struct SEG_BATCH_FIXTURE
+{
+    ~SEG_BATCH_FIXTURE()
+    {
+        SEG_BATCH::SetIsa( SEG_BATCH::GetBestIsa() );
+    }
+};
+
+
+/**
+ * Random polylines, with the degenerate cases of real outlines: repeated points, short and
+ * axis-aligned segments
+ */
+static std::vector<VECTOR2I> makePolyline( std::mt19937& aRng, int aScale )
+{
+    std::uniform_int_distribution<int> coord( -aScale, aScale );
+    std::vector<VECTOR2I>              points;
+    int                                count = aRng() % 40;
+
+    for( int i = 0; i < count; i++ )
+    {
+        if( i > 0 && aRng() % 4 == 0 )
+            points.push_back( points.back() + VECTOR2I( aRng() % 3, 0 ) );
+        else if( i > 0 && aRng() % 5 == 0 )
+            points.push_back( VECTOR2I( points.back().x, coord( aRng ) ) );
+        else
+            points.push_back( VECTOR2I( coord( aRng ), coord( aRng ) ) );
+    }
+
+    return points;
+}
+
+
+/**
+ * Check that the batched search returns every segment closer than aDist to aSeg
+ */
+static bool findsNearSegments( const std::vector<VECTOR2I>& aPoints, const SEG& aSeg, int aDist )
+{
+    int              count = std::max<int>( 0, aPoints.size() - 1 );
+    std::vector<int> candidates;
+
+    for( int i = SEG_BATCH::FindCandidate( aSeg, aPoints.data(), count, 0, aDist );
+         i >= 0;
+         i = SEG_BATCH::FindCandidate( aSeg, aPoints.data(), count, i + 1, aDist ) )
+    {
+        candidates.push_back( i );
+    }
+
+    for( int i = 0; i < count; i++ )
+    {
+        if( SEG( aPoints[i], aPoints[i + 1] ).Distance( aSeg ) < aDist
+                && std::find( candidates.begin(), candidates.end(), i ) == candidates.end() )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static int distanceAll( const std::vector<VECTOR2I>& aPoints, const VECTOR2I& aP )
+{
+    int d = INT_MAX;
+
+    for( size_t i = 0; i + 1 < aPoints.size(); i++ )
+        d = std::min( d, SEG( aPoints[i], aPoints[i + 1] ).Distance( aP ) );
+
+    return d;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( SegBatch, SEG_BATCH_FIXTURE )
+
+
+/**
+ * The batched searches find the near segments and the same distances as testing every
+ * segment
+ */
+BOOST_AUTO_TEST_CASE( MatchesScalar )
+{
+    for( SEG_BATCH_ISA isa : { SEG_BATCH_ISA::SCALAR, SEG_BATCH_ISA::SSE2, SEG_BATCH_ISA::AVX2 } )
+    {
+        if( SEG_BATCH::SetIsa( isa ) != isa )
+            continue;
+
+        BOOST_TEST_CONTEXT( "Instruction set: " << (int) isa )
+        {
+            std::mt19937 rng( 42 );
+
+            for( int trial = 0; trial < 300; trial++ )
+            {
+                int scale = trial % 3 == 0 ? 100 : trial % 3 == 1 ? 100000 : 300000000;
+                std::uniform_int_distribution<int> coord( -scale, scale );
+                std::vector<VECTOR2I>              points = makePolyline( rng, scale );
+
+                for( int query = 0; query < 20; query++ )
+                {
+                    VECTOR2I a( coord( rng ), coord( rng ) );
+                    VECTOR2I b = rng() % 4 ? VECTOR2I( coord( rng ), coord( rng ) ) : a;
+                    int      clearance = rng() % 2 ? rng() % ( scale / 4 + 1 ) : rng() % 10;
+
+                    // Touching the polyline
+                    if( !points.empty() && rng() % 3 == 0 )
+                        a = points[rng() % points.size()] + VECTOR2I( rng() % 5, 0 );
+
+                    SEG seg( a, b );
+                    int count = std::max<int>( 0, points.size() - 1 );
+
+                    BOOST_CHECK( findsNearSegments( points, seg, clearance ) );
+                    BOOST_CHECK_EQUAL( SEG_BATCH::Distance( a, points.data(), count ),
+                                       distanceAll( points, a ) );
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * The closing segment of a closed line chain is tested too
+ */
+BOOST_AUTO_TEST_CASE( ClosedLineChain )
+{
+    SHAPE_LINE_CHAIN chain;
+
+    chain.Append( 0, 0 );
+    chain.Append( 1000, 0 );
+    chain.Append( 1000, 1000 );
+    chain.Append( 0, 1000 );
+
+    SEG outside( VECTOR2I( -50, 400 ), VECTOR2I( -50, 600 ) );
+
+    BOOST_CHECK( !chain.Collide( outside, 10 ) );
+    BOOST_CHECK_EQUAL( chain.Distance( VECTOR2I( -50, 500 ) ), 502 );
+
+    chain.SetClosed( true );
+
+    BOOST_CHECK( chain.Collide( outside, 60 ) );
+    BOOST_CHECK_EQUAL( chain.Distance( VECTOR2I( -50, 500 ) ), 50 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,246 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for SHAPE_POLY_SET_CACHE, and the fracture and triangulation of SHAPE_POLY_SET
+ * going through it
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cmath>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+// Code under test
+#include <geometry/shape_poly_set_cache.h>
+
+
+/**
+ * Starts each test with an empty cache, and restores its budget at the end
+ */
+struct POLY_SET_CACHE_FIXTURE
+{
+    POLY_SET_CACHE_FIXTURE()
+    {
+        SHAPE_POLY_SET_CACHE::Instance().Clear();
+    }
+
+    ~POLY_SET_CACHE_FIXTURE()
+    {
+        SHAPE_POLY_SET_CACHE::Instance().SetMaxBytes( SHAPE_POLY_SET_CACHE::DEFAULT_MAX_BYTES );
+        SHAPE_POLY_SET_CACHE::Instance().Clear();
+    }
+};
+
+
+/**
+ * A disc approximated by aSegments points, with a square hole if asked
+ */
+static SHAPE_POLY_SET makeDisc( int aRadius, int aSegments, bool aWithHole = true )
+{
+    SHAPE_POLY_SET   set;
+    SHAPE_LINE_CHAIN outline;
+    SHAPE_LINE_CHAIN hole;
+
+    for( int i = 0; i < aSegments; i++ )
+    {
+        double angle = 2.0 * M_PI * i / aSegments;
+
+        outline.Append( (int) ( aRadius * cos( angle ) ), (int) ( aRadius * sin( angle ) ) );
+    }
+
+    outline.SetClosed( true );
+
+    hole.Append( -aRadius / 4, -aRadius / 4 );
+    hole.Append( -aRadius / 4, aRadius / 4 );
+    hole.Append( aRadius / 4, aRadius / 4 );
+    hole.Append( aRadius / 4, -aRadius / 4 );
+    hole.SetClosed( true );
+
+    set.AddOutline( outline );
+
+    if( aWithHole )
+        set.AddHole( hole );
+
+    return set;
+}
+
+
+static void checkSameOutlines( const SHAPE_POLY_SET& aA, const SHAPE_POLY_SET& aB )
+{
+    BOOST_REQUIRE_EQUAL( aA.OutlineCount(), aB.OutlineCount() );
+
+    for( int i = 0; i < aA.OutlineCount(); i++ )
+    {
+        BOOST_REQUIRE_EQUAL( aA.CPolygon( i ).size(), aB.CPolygon( i ).size() );
+        BOOST_REQUIRE_EQUAL( aA.COutline( i ).PointCount(), aB.COutline( i ).PointCount() );
+
+        for( int j = 0; j < aA.COutline( i ).PointCount(); j++ )
+            BOOST_CHECK_EQUAL( aA.COutline( i ).CPoint( j ), aB.COutline( i ).CPoint( j ) );
+    }
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( ShapePolySetCache, POLY_SET_CACHE_FIXTURE )
+
+
+/**
+ * Sets with the same vertices share one triangulation
+ */
+BOOST_AUTO_TEST_CASE( SharedTriangulation )
+{
+    SHAPE_POLY_SET a = makeDisc( 100000, 128 );
+    SHAPE_POLY_SET b = makeDisc( 100000, 128 );
+
+    a.CacheTriangulation();
+    BOOST_REQUIRE( a.IsTriangulationUpToDate() );
+    BOOST_REQUIRE( a.TriangulatedPolyCount() > 0 );
+
+    b.CacheTriangulation();
+    BOOST_REQUIRE( b.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( a.TriangulatedPolyCount(), b.TriangulatedPolyCount() );
+    BOOST_CHECK_EQUAL( a.TriangulatedPolygon( 0 ), b.TriangulatedPolygon( 0 ) );
+
+    // A set with other vertices is triangulated again
+    SHAPE_POLY_SET c = makeDisc( 200000, 128 );
+
+    c.CacheTriangulation();
+    BOOST_CHECK( c.IsTriangulationUpToDate() );
+    BOOST_CHECK_NE( a.TriangulatedPolygon( 0 ), c.TriangulatedPolygon( 0 ) );
+}
+
+
+/**
+ * Copies and assignments keep the triangulation, until the vertices change
+ */
+BOOST_AUTO_TEST_CASE( CopyKeepsTriangulation )
+{
+    SHAPE_POLY_SET a = makeDisc( 100000, 128 );
+
+    a.CacheTriangulation();
+
+    SHAPE_POLY_SET copy( a );
+    SHAPE_POLY_SET assigned;
+
+    assigned = a;
+
+    BOOST_CHECK( copy.IsTriangulationUpToDate() );
+    BOOST_CHECK( assigned.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( assigned.TriangulatedPolygon( 0 ), a.TriangulatedPolygon( 0 ) );
+
+    assigned.Move( VECTOR2I( 10, 0 ) );
+    BOOST_CHECK( !assigned.IsTriangulationUpToDate() );
+    BOOST_CHECK( a.IsTriangulationUpToDate() );
+}
+
+
+/**
+ * A cached fracture gives the same polygons as fracturing again
+ */
+BOOST_AUTO_TEST_CASE( Fracture )
+{
+    SHAPE_POLY_SET_CACHE& cache = SHAPE_POLY_SET_CACHE::Instance();
+
+    for( auto mode : { SHAPE_POLY_SET::PM_FAST, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE } )
+    {
+        SHAPE_POLY_SET first = makeDisc( 100000, 128 );
+        SHAPE_POLY_SET second = makeDisc( 100000, 128 );
+
+        cache.Clear();
+        first.Fracture( mode );
+        BOOST_CHECK_EQUAL( cache.GetStats().m_hits, 0 );
+
+        second.Fracture( mode );
+        BOOST_CHECK_EQUAL( cache.GetStats().m_hits, 1 );
+        BOOST_CHECK( !second.HasHoles() );
+
+        checkSameOutlines( first, second );
+
+        // And the same as without the cache
+        SHAPE_POLY_SET uncached = makeDisc( 100000, 128 );
+
+        cache.SetMaxBytes( 0 );
+        uncached.Fracture( mode );
+        cache.SetMaxBytes( SHAPE_POLY_SET_CACHE::DEFAULT_MAX_BYTES );
+
+        checkSameOutlines( uncached, second );
+    }
+}
+
+
+/**
+ * Small sets are not cached
+ */
+BOOST_AUTO_TEST_CASE( SmallSets )
+{
+    SHAPE_POLY_SET_CACHE& cache = SHAPE_POLY_SET_CACHE::Instance();
+    SHAPE_POLY_SET        small = makeDisc( 100000, 8 );
+
+    small.Fracture( SHAPE_POLY_SET::PM_FAST );
+    small.CacheTriangulation();
+
+    BOOST_CHECK( small.IsTriangulationUpToDate() );
+    BOOST_CHECK_EQUAL( cache.GetStats().m_entries, 0 );
+    BOOST_CHECK_EQUAL( cache.GetStats().m_hits + cache.GetStats().m_misses, 0 );
+}
+
+
+/**
+ * The least recently used results are dropped first
+ */
+BOOST_AUTO_TEST_CASE( Budget )
+{
+    SHAPE_POLY_SET_CACHE& cache = SHAPE_POLY_SET_CACHE::Instance();
+
+    // Without holes, so that only the triangulations are cached
+    SHAPE_POLY_SET a = makeDisc( 100000, 128, false );
+    SHAPE_POLY_SET b = makeDisc( 200000, 128, false );
+
+    a.CacheTriangulation();
+    size_t oneEntry = cache.GetStats().m_bytes;
+
+    BOOST_CHECK_EQUAL( cache.GetStats().m_entries, 1 );
+
+    // Room for a single triangulation: b's replaces a's
+    cache.SetMaxBytes( oneEntry + oneEntry / 2 );
+    b.CacheTriangulation();
+
+    BOOST_CHECK_EQUAL( cache.GetStats().m_entries, 1 );
+    BOOST_CHECK( cache.GetStats().m_bytes <= oneEntry + oneEntry / 2 );
+
+    SHAPE_POLY_SET a2 = makeDisc( 100000, 128, false );
+    size_t         misses = cache.GetStats().m_misses;
+
+    a2.CacheTriangulation();
+    BOOST_CHECK_EQUAL( cache.GetStats().m_misses, misses + 1 );
+
+    // The sets keep their triangulation when it leaves the cache
+    BOOST_CHECK( a.IsTriangulationUpToDate() );
+    BOOST_CHECK( b.IsTriangulationUpToDate() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the keyword lookup generated for the DSN lexers
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cctype>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+// Code under test
+#include <netlist_lexer.h>
+
+
+/**
+ * The keywords of the netlist lexer, in the order of their tokens
+ */
+static std::vector<std::string> netlistKeywords()
+{
+    std::vector<std::string> keywords;
+
+    // TokenName() only knows the size of the keyword table
+    for( int tok = 0; strcmp( NETLIST_LEXER::TokenName( NL_T::T( tok ) ), "token too big" ); ++tok )
+        keywords.push_back( NETLIST_LEXER::TokenName( NL_T::T( tok ) ) );
+
+    return keywords;
+}
+
+
+/**
+ * The token the netlist lexer gives for aText
+ */
+static int lex( const std::string& aText )
+{
+    NETLIST_LEXER lexer( aText, "test" );
+
+    return lexer.NextTok();
+}
+
+
+BOOST_AUTO_TEST_SUITE( DsnLexer )
+
+
+/**
+ * Check that every keyword is lexed as its own token
+ */
+BOOST_AUTO_TEST_CASE( KeywordsRoundTrip )
+{
+    std::vector<std::string> keywords = netlistKeywords();
+
+    BOOST_REQUIRE( !keywords.empty() );
+
+    for( int tok = 0; tok < (int) keywords.size(); ++tok )
+        BOOST_CHECK_MESSAGE( lex( keywords[tok] ) == tok, "keyword " << keywords[tok] );
+}
+
+
+/**
+ * Check that the symbols which are not keywords, even if close to one, are lexed as
+ * DSN_SYMBOL
+ */
+BOOST_AUTO_TEST_CASE( NonKeywords )
+{
+    std::vector<std::string> keywords = netlistKeywords();
+    std::set<std::string>    keywordSet( keywords.begin(), keywords.end() );
+
+    auto checkSymbol = [&]( const std::string& aText )
+    {
+        if( !keywordSet.count( aText ) )
+            BOOST_CHECK_MESSAGE( lex( aText ) == DSN_SYMBOL, "symbol " << aText );
+    };
+
+    for( const std::string& keyword : keywords )
+    {
+        // Prefixes, extensions, and other letters at the first and last position
+        for( size_t len = 1; len < keyword.size(); ++len )
+            checkSymbol( keyword.substr( 0, len ) );
+
+        checkSymbol( keyword + "s" );
+        checkSymbol( keyword + "_" );
+        checkSymbol( "x" + keyword.substr( 1 ) );
+        checkSymbol( keyword.substr( 0, keyword.size() - 1 ) + "Z" );
+        checkSymbol( std::string( 1, toupper( keyword[0] ) ) + keyword.substr( 1 ) );
+    }
+
+    checkSymbol( "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for MAPPED_FILE_LINE_READER
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <wx/filename.h>
+
+// Code under test
+#include <richio.h>
+
+
+/**
+ * A temporary file holding some given text, removed when going out of scope
+ */
+class TEMP_TEXT_FILE
+{
+public:
+    TEMP_TEXT_FILE( const std::string& aText )
+    {
+        m_name = wxFileName::CreateTempFileName( "richio" );
+
+        FILE* fp = fopen( m_name.fn_str(), "wb" );
+        fwrite( aText.data(), 1, aText.size(), fp );
+        fclose( fp );
+    }
+
+    ~TEMP_TEXT_FILE()
+    {
+        wxRemoveFile( m_name );
+    }
+
+    const wxString& GetName() const
+    {
+        return m_name;
+    }
+
+private:
+    wxString m_name;
+};
+
+
+static std::vector<std::string> readLines( LINE_READER& aReader )
+{
+    std::vector<std::string> lines;
+
+    while( aReader.ReadLine() )
+        lines.emplace_back( aReader.Line(), aReader.Length() );
+
+    return lines;
+}
+
+
+static std::vector<std::string> readLineViews( LINE_READER& aReader )
+{
+    std::vector<std::string> lines;
+    const char*              line;
+
+    while( ( line = aReader.ReadLineView() ) != NULL )
+        lines.emplace_back( line, aReader.Length() );
+
+    return lines;
+}
+
+
+/**
+ * Declare the test suite
+ */
+BOOST_AUTO_TEST_SUITE( RichIO )
+
+
+/**
+ * Check that the lines read from a mapped file are the same as from a FILE
+ */
+BOOST_AUTO_TEST_CASE( MappedMatchesFile )
+{
+    const std::vector<std::string> texts = {
+        "",
+        "\n",
+        "one line\n",
+        "first\nsecond\n\nfourth\n",
+        "no newline at end\nlast",
+    };
+
+    for( const std::string& text : texts )
+    {
+        BOOST_TEST_CONTEXT( "Text: '" << text << "'" )
+        {
+            TEMP_TEXT_FILE file( text );
+
+            FILE_LINE_READER        fileReader( file.GetName() );
+            MAPPED_FILE_LINE_READER mappedReader( file.GetName() );
+
+            std::vector<std::string> expected = readLines( fileReader );
+
+            BOOST_CHECK( readLines( mappedReader ) == expected );
+            BOOST_CHECK_EQUAL( mappedReader.LineNumber(), fileReader.LineNumber() );
+
+            mappedReader.Rewind();
+
+            BOOST_CHECK( readLineViews( mappedReader ) == expected );
+            BOOST_CHECK_EQUAL( mappedReader.LineNumber(), fileReader.LineNumber() );
+        }
+    }
+}
+
+
+/**
+ * Check that the line length limit is enforced
+ */
+BOOST_AUTO_TEST_CASE( MappedMaxLineLength )
+{
+    TEMP_TEXT_FILE file( "short\n" + std::string( 100, 'x' ) + "\n" );
+
+    MAPPED_FILE_LINE_READER reader( file.GetName(), 0, 50 );
+
+    BOOST_CHECK( reader.ReadLine() );
+    BOOST_CHECK_THROW( reader.ReadLine(), IO_ERROR );
+}
+
+
+/**
+ * Check that a missing file is reported
+ */
+BOOST_AUTO_TEST_CASE( MappedMissingFile )
+{
+    BOOST_CHECK_THROW( MAPPED_FILE_LINE_READER( "/this/file/does/not/exist" ), IO_ERROR );
+}
+
+
+/**
+ * Check that only large files are mapped, and that both readers give the same lines
+ */
+BOOST_AUTO_TEST_CASE( OpenFileLineReaderThreshold )
+{
+    std::string line = std::string( 99, 'x' ) + "\n";
+    std::string small = line;
+    std::string large;
+
+    while( large.size() < LINE_READER_MAPPING_THRESHOLD )
+        large += line;
+
+    TEMP_TEXT_FILE smallFile( small );
+    TEMP_TEXT_FILE largeFile( large );
+
+    std::unique_ptr<LINE_READER> smallReader( OpenFileLineReader( smallFile.GetName() ) );
+    std::unique_ptr<LINE_READER> largeReader( OpenFileLineReader( largeFile.GetName() ) );
+
+    BOOST_CHECK( dynamic_cast<FILE_LINE_READER*>( smallReader.get() ) );
+    BOOST_CHECK( dynamic_cast<MAPPED_FILE_LINE_READER*>( largeReader.get() ) );
+
+    BOOST_CHECK_EQUAL( readLines( *smallReader ).size(), 1 );
+    BOOST_CHECK_EQUAL( readLines( *largeReader ).size(), large.size() / line.size() );
+
+    BOOST_CHECK_THROW( delete OpenFileLineReader( "/this/file/does/not/exist" ), IO_ERROR );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,198 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for THREAD_POOL and TASK_GROUP
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Code under test
+#include <thread_pool.h>
+
+/**
+ * Declare the test suite
+ */
+BOOST_AUTO_TEST_SUITE( ThreadPool )
+
+
+/**
+ * Check the number of tasks started for a given amount of work
+ */
+BOOST_AUTO_TEST_CASE( TaskCount )
+{
+    THREAD_POOL pool( 4 );
+
+    BOOST_CHECK_EQUAL( pool.GetThreadCount(), 4 );
+    BOOST_CHECK_EQUAL( pool.GetTaskCount( 0 ), 1 );
+    BOOST_CHECK_EQUAL( pool.GetTaskCount( 2 ), 2 );
+    BOOST_CHECK_EQUAL( pool.GetTaskCount( 100 ), 4 );
+    BOOST_CHECK_EQUAL( pool.GetTaskCount( 20, 8 ), 3 );
+}
+
+
+/**
+ * Check that all the items of a list shared between tasks are processed once
+ */
+BOOST_AUTO_TEST_CASE( RunAll )
+{
+    THREAD_POOL pool( 4 );
+    TASK_GROUP  tasks( pool );
+
+    const size_t        count = 10000;
+    std::vector<int>    done( count, 0 );
+    std::atomic<size_t> nextItem( 0 );
+
+    tasks.Run( [&]()
+    {
+        for( size_t i = nextItem.fetch_add( 1 ); i < count; i = nextItem.fetch_add( 1 ) )
+            done[i]++;
+    }, pool.GetThreadCount() );
+
+    BOOST_CHECK( tasks.Wait() );
+
+    for( size_t i = 0; i < count; ++i )
+        BOOST_CHECK_EQUAL( done[i], 1 );
+}
+
+
+/**
+ * Check that tasks can start other tasks and wait for them without deadlocking
+ */
+BOOST_AUTO_TEST_CASE( NestedGroups )
+{
+    THREAD_POOL      pool( 2 );
+    TASK_GROUP       outer( pool );
+    std::atomic<int> total( 0 );
+
+    outer.Run( [&]()
+    {
+        TASK_GROUP inner( pool );
+
+        inner.Run( [&]() { total++; }, 10 );
+        inner.Wait();
+    }, 8 );
+
+    outer.Wait();
+
+    BOOST_CHECK_EQUAL( total, 80 );
+}
+
+
+/**
+ * Check that cancelling a group skips the tasks that did not start yet
+ */
+BOOST_AUTO_TEST_CASE( Cancel )
+{
+    THREAD_POOL      pool( 1 );
+    TASK_GROUP       tasks( pool );
+    std::atomic<int> started( 0 );
+
+    tasks.Run( [&]()
+    {
+        started++;
+        tasks.Cancel();
+    }, 100 );
+
+    BOOST_CHECK( !tasks.Wait() );
+    BOOST_CHECK( tasks.IsCancelled() );
+    BOOST_CHECK_LT( started, 100 );
+}
+
+
+/**
+ * Check that an exception thrown by a task is thrown again by Wait()
+ */
+BOOST_AUTO_TEST_CASE( Exception )
+{
+    THREAD_POOL pool( 2 );
+    TASK_GROUP  tasks( pool );
+
+    tasks.Run( []()
+    {
+        throw std::runtime_error( "task failure" );
+    }, 4 );
+
+    BOOST_CHECK_THROW( tasks.Wait(), std::runtime_error );
+    BOOST_CHECK( tasks.IsCancelled() );
+}
+
+
+/**
+ * Check that a waiting thread only runs the tasks of the group it waits for
+ */
+BOOST_AUTO_TEST_CASE( WaitRunsOwnTasks )
+{
+    THREAD_POOL pool( 1 );
+    TASK_GROUP  blocker( pool );
+    TASK_GROUP  other( pool );
+    TASK_GROUP  mine( pool );
+
+    std::atomic<bool> started( false );
+    std::atomic<bool> released( false );
+    std::atomic<int>  otherRunHere( 0 );
+    std::atomic<int>  mineRunHere( 0 );
+    std::thread::id   here = std::this_thread::get_id();
+
+    // Keep the only worker busy
+    blocker.Run( [&]()
+    {
+        started = true;
+
+        while( !released )
+            std::this_thread::yield();
+    } );
+
+    while( !started )
+        std::this_thread::yield();
+
+    other.Run( [&]()
+    {
+        if( std::this_thread::get_id() == here )
+            otherRunHere++;
+    }, 4 );
+
+    mine.Run( [&]()
+    {
+        if( std::this_thread::get_id() == here )
+            mineRunHere++;
+    }, 2 );
+
+    BOOST_CHECK( mine.Wait() );
+    BOOST_CHECK_EQUAL( mineRunHere, 2 );
+    BOOST_CHECK_EQUAL( otherRunHere, 0 );
+
+    released = true;
+
+    BOOST_CHECK( blocker.Wait() );
+    BOOST_CHECK( other.Wait() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for VIEW_RTREE, checking its packed and dynamic parts together
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <random>
+#include <set>
+
+#include <view/view_item.h>
+
+// Code under test
+#include <view/view_rtree.h>
+
+
+using namespace KIGFX;
+
+
+class TEST_VIEW_ITEM : public VIEW_ITEM
+{
+public:
+    const BOX2I ViewBBox() const override
+    {
+        return m_bbox;
+    }
+
+    void ViewGetLayers( int aLayers[], int& aCount ) const override
+    {
+        aLayers[0] = 0;
+        aCount = 1;
+    }
+
+    BOX2I m_bbox;
+};
+
+
+struct COLLECTOR
+{
+    bool operator()( VIEW_ITEM* aItem )
+    {
+        m_items.insert( aItem );
+        m_count++;
+        return true;
+    }
+
+    std::set<VIEW_ITEM*> m_items;
+    int                  m_count = 0;
+};
+
+
+static std::set<VIEW_ITEM*> findItems( const std::set<TEST_VIEW_ITEM*>& aItems,
+                                       const BOX2I& aArea )
+{
+    std::set<VIEW_ITEM*> found;
+
+    for( TEST_VIEW_ITEM* item : aItems )
+    {
+        const BOX2I& bbox = item->m_bbox;
+
+        if( bbox.GetX() <= aArea.GetRight() && bbox.GetRight() >= aArea.GetX()
+                && bbox.GetY() <= aArea.GetBottom() && bbox.GetBottom() >= aArea.GetY() )
+            found.insert( item );
+    }
+
+    return found;
+}
+
+
+BOOST_AUTO_TEST_SUITE( ViewRtree )
+
+
+/**
+ * Queries find the same items as a linear search, before and after edits
+ */
+BOOST_AUTO_TEST_CASE( QueryAfterEdits )
+{
+    std::mt19937                rng( 42 );
+    std::vector<TEST_VIEW_ITEM> items( 5000 );
+    std::set<TEST_VIEW_ITEM*>   inserted;
+    VIEW_RTREE                  tree;
+
+    auto randomBox = [&rng]()
+    {
+        return BOX2I( VECTOR2I( rng() % 1000000, rng() % 1000000 ),
+                      VECTOR2I( rng() % 20000, rng() % 20000 ) );
+    };
+
+    // Bulk load most of the items
+    for( size_t ii = 0; ii < items.size(); ++ii )
+    {
+        items[ii].m_bbox = randomBox();
+
+        if( ii < 4000 )
+        {
+            tree.Insert( &items[ii] );
+            inserted.insert( &items[ii] );
+        }
+    }
+
+    for( int step = 0; step < 1000; ++step )
+    {
+        TEST_VIEW_ITEM* item = &items[ rng() % items.size() ];
+
+        if( !inserted.count( item ) )
+        {
+            tree.Insert( item );
+            inserted.insert( item );
+        }
+        else if( rng() % 2 )
+        {
+            tree.Remove( item );
+            inserted.erase( item );
+        }
+        else
+        {
+            tree.Remove( item );
+            item->m_bbox = randomBox();
+            tree.Insert( item );
+        }
+
+        if( step % 20 == 0 )
+        {
+            BOX2I     area( VECTOR2I( rng() % 1000000, rng() % 1000000 ),
+                            VECTOR2I( 100000, 100000 ) );
+            COLLECTOR collector;
+
+            tree.Query( area, collector );
+
+            BOOST_CHECK( collector.m_items == findItems( inserted, area ) );
+            BOOST_CHECK_EQUAL( collector.m_count, (int) collector.m_items.size() );
+        }
+    }
+
+    BOX2I     all;
+    COLLECTOR collector;
+
+    all.SetMaximum();
+    tree.Query( all, collector );
+
+    BOOST_CHECK_EQUAL( collector.m_count, (int) inserted.size() );
+
+    tree.RemoveAll();
+    collector.m_count = 0;
+    tree.Query( all, collector );
+
+    BOOST_CHECK_EQUAL( collector.m_count, 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -157,6 +157,28 @@ static void bench_line_reader_reuse( const wxFileName& aFile, int aReps, BENCH_R
 }
 
 
+/**
+ * Benchmark using a given LINE_READER implementation, reading the lines
+ * with ReadLineView(), like the DSNLEXER does.
+ * The LINE_READER is recreated for each cycle.
+ */
+template<typename LR>
+static void bench_line_reader_view( const wxFileName& aFile, int aReps, BENCH_REPORT& report )
+{
+    for( int i = 0; i < aReps; ++i)
+    {
+        LR fstr( aFile.GetFullPath() );
+        const char* line;
+
+        while( ( line = fstr.ReadLineView() ) != NULL )
+        {
+            report.linesRead++;
+            report.charAcc += (unsigned char) line[0];
+        }
+    }
+}
+
+
 /**
  * Benchmark using STRING_LINE_READER on string data read into memory from a file
  * using std::ifstream, but read the data fresh from the file each time
@@ -313,6 +335,9 @@ static std::vector<BENCHMARK> benchmarkList =
     { 'F', bench_fstream_reuse, "std::fstream, reused" },
     { 'r', bench_line_reader<FILE_LINE_READER>, "RichIO FILE_L_R" },
     { 'R', bench_line_reader_reuse<FILE_LINE_READER>, "RichIO FILE_L_R, reused" },
+    { 'm', bench_line_reader<MAPPED_FILE_LINE_READER>, "RichIO MAPPED_FILE_L_R" },
+    { 'M', bench_line_reader_reuse<MAPPED_FILE_LINE_READER>, "RichIO MAPPED_FILE_L_R, reused" },
+    { 'v', bench_line_reader_view<MAPPED_FILE_LINE_READER>, "RichIO MAPPED_FILE_L_R, view" },
     { 'n', bench_line_reader<IFSTREAM_LINE_READER>, "std::ifstream L_R" },
     { 'N', bench_line_reader_reuse<IFSTREAM_LINE_READER>, "std::ifstream L_R, reused" },
     { 's', bench_string_lr, "RichIO STRING_L_R"},
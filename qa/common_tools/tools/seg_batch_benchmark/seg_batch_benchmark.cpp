@@ -0,0 +1,266 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "seg_batch_benchmark.h"
+
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <iostream>
+#include <random>
+
+#include <common.h>
+#include <wx/cmdline.h>
+
+#include <geometry/seg_batch.h>
+#include <geometry/shape_line_chain.h>
+#include <math/box2.h>
+
+
+using CLOCK = std::chrono::steady_clock;
+
+
+/**
+ * The random outlines and the segments tested against them
+ */
+struct BENCH_DATA
+{
+    std::vector<SHAPE_LINE_CHAIN> m_outlines;
+    std::vector<SEG>              m_segs;
+    int                           m_clearance;
+};
+
+
+/**
+ * SHAPE_LINE_CHAIN::Collide() testing the segments one by one, as it did before the
+ * batched kernels
+ */
+static bool collidePlain( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg, int aClearance )
+{
+    BOX2I box_a( aSeg.A, aSeg.B - aSeg.A );
+    BOX2I::ecoord_type dist_sq = (BOX2I::ecoord_type) aClearance * aClearance;
+
+    for( int i = 0; i < aChain.SegmentCount(); i++ )
+    {
+        const SEG& s = aChain.CSegment( i );
+        BOX2I box_b( s.A, s.B - s.A );
+
+        if( box_a.SquaredDistance( box_b ) < dist_sq && s.Collide( aSeg, aClearance ) )
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * SHAPE_LINE_CHAIN::Distance() testing the segments one by one
+ */
+static int distancePlain( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP )
+{
+    int d = INT_MAX;
+
+    for( int s = 0; s < aChain.SegmentCount(); s++ )
+        d = std::min( d, aChain.CSegment( s ).Distance( aP ) );
+
+    return d;
+}
+
+
+static BENCH_DATA makeData( int aOutlines, int aPoints, int aSegs )
+{
+    // Tracks and outlines in a 100 mm board, tested with a 0.2 mm clearance
+    std::mt19937                       rng( 42 );
+    std::uniform_int_distribution<int> coord( 0, 100000000 );
+    std::uniform_int_distribution<int> step( -2000000, 2000000 );
+    BENCH_DATA                         data;
+
+    for( int ii = 0; ii < aOutlines; ++ii )
+    {
+        SHAPE_LINE_CHAIN chain;
+        VECTOR2I         p( coord( rng ), coord( rng ) );
+
+        for( int jj = 0; jj < aPoints; ++jj )
+        {
+            chain.Append( p );
+            p += VECTOR2I( step( rng ), step( rng ) );
+        }
+
+        data.m_outlines.push_back( chain );
+    }
+
+    for( int ii = 0; ii < aSegs; ++ii )
+    {
+        VECTOR2I p( coord( rng ), coord( rng ) );
+
+        data.m_segs.emplace_back( p, p + VECTOR2I( step( rng ), step( rng ) ) / 4 );
+    }
+
+    data.m_clearance = 200000;
+
+    return data;
+}
+
+
+/**
+ * Runs aFunc on every outline and segment, and prints its time and result
+ */
+static long runBench( const wxString& aName, const BENCH_DATA& aData, int aReps,
+                      const std::function<long( const SHAPE_LINE_CHAIN&, const SEG& )>& aFunc )
+{
+    long result = 0;
+    auto start = CLOCK::now();
+
+    for( int rep = 0; rep < aReps; ++rep )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : aData.m_outlines )
+        {
+            for( const SEG& seg : aData.m_segs )
+                result += aFunc( chain, seg );
+        }
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( CLOCK::now() - start );
+
+    std::cout << wxString::Format( "  %-24s %8d ms   result %ld", aName, (int) duration.count(),
+                                   result )
+              << std::endl;
+
+    return result;
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "reps",
+            _( "number of repetitions" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "p",
+            "points",
+            _( "number of points of each outline" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+static int seg_batch_benchmark_func( int argc, char** argv )
+{
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "Compare the batched segment kernels to the scalar code" ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long reps = 10;
+    long points = 200;
+    cl_parser.Found( "reps", &reps );
+    cl_parser.Found( "points", &points );
+
+    const BENCH_DATA data = makeData( 50, std::max( 2, (int) points ), 2000 );
+    const int        clearance = data.m_clearance;
+
+    const SEG_BATCH_ISA isas[] = { SEG_BATCH_ISA::SCALAR, SEG_BATCH_ISA::SSE2,
+                                   SEG_BATCH_ISA::AVX2 };
+    const char*         isaNames[] = { "scalar", "SSE2", "AVX2" };
+    const SEG_BATCH_ISA best = SEG_BATCH::GetBestIsa();
+    bool                same = true;
+
+    std::cout << "Segment kernels benchmark" << std::endl;
+    std::cout << "  Outlines: " << data.m_outlines.size() << " of " << points << " points, "
+              << data.m_segs.size() << " segments, " << reps << " repetitions" << std::endl;
+    std::cout << std::endl << "SHAPE_LINE_CHAIN::Collide( SEG )" << std::endl;
+
+    long expected = runBench( "one by one", data, reps,
+            [&]( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg )
+            {
+                return (long) collidePlain( aChain, aSeg, clearance );
+            } );
+
+    for( int ii = 0; ii <= (int) best; ++ii )
+    {
+        SEG_BATCH::SetIsa( isas[ii] );
+
+        same &= expected == runBench( isaNames[ii], data, reps,
+                [&]( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg )
+                {
+                    return (long) aChain.Collide( aSeg, clearance );
+                } );
+    }
+
+    std::cout << std::endl << "SHAPE_LINE_CHAIN::Distance( VECTOR2I )" << std::endl;
+
+    expected = runBench( "one by one", data, reps,
+            [&]( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg )
+            {
+                return (long) distancePlain( aChain, aSeg.A );
+            } );
+
+    for( int ii = 0; ii <= (int) best; ++ii )
+    {
+        SEG_BATCH::SetIsa( isas[ii] );
+
+        same &= expected == runBench( isaNames[ii], data, reps,
+                [&]( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg )
+                {
+                    return (long) aChain.Distance( aSeg.A );
+                } );
+    }
+
+    SEG_BATCH::SetIsa( best );
+
+    if( !same )
+    {
+        std::cout << std::endl << "The kernels gave different results" << std::endl;
+        return KI_TEST::RET_CODES::TOOL_SPECIFIC;
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+KI_TEST::UTILITY_PROGRAM seg_batch_benchmark_tool = {
+    "seg_batch_benchmark",
+    "Benchmark the batched segment collision and distance kernels",
+    seg_batch_benchmark_func,
+};
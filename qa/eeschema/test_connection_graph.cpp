@@ -0,0 +1,407 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the incremental recalculation of the connection graph gives the
+ * same connections as a full one
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+
+#include <class_libentry.h>
+#include <general.h>
+#include <lib_pin.h>
+#include <sch_component.h>
+#include <sch_connection.h>
+#include <sch_line.h>
+#include <sch_screen.h>
+#include <sch_sheet.h>
+#include <sch_sheet_path.h>
+#include <sch_text.h>
+
+// Code under test
+#include <connection_graph.h>
+
+
+///> Position of the component on the sheet
+static const wxPoint COMPONENT_POS( 1000, 1000 );
+
+
+/**
+ * Adds two pins to aPart: the first one at (-100, 0), the second one at (100, aSecondY)
+ */
+static void addPins( LIB_PART& aPart, int aSecondY )
+{
+    LIB_PIN* first = new LIB_PIN( &aPart );
+    LIB_PIN* second = new LIB_PIN( &aPart );
+
+    first->SetNumber( "1" );
+    first->SetPinPosition( wxPoint( -100, 0 ) );
+    second->SetNumber( "2" );
+    second->SetPinPosition( wxPoint( 100, aSecondY ) );
+
+    aPart.AddDrawItem( first );
+    aPart.AddDrawItem( second );
+}
+
+
+static SCH_LINE* makeWire( const wxPoint& aStart, const wxPoint& aEnd )
+{
+    SCH_LINE* wire = new SCH_LINE( aStart, LAYER_WIRE );
+
+    wire->SetEndPoint( aEnd );
+
+    return wire;
+}
+
+
+/**
+ * The connectable items of the sheet, pins included
+ */
+static std::vector<SCH_ITEM*> connectableItems( const SCH_SHEET_PATH& aSheet )
+{
+    std::vector<SCH_ITEM*> items;
+
+    for( auto item = aSheet.LastScreen()->GetDrawItems(); item; item = item->Next() )
+    {
+        if( !item->IsConnectable() )
+            continue;
+
+        items.push_back( item );
+
+        if( item->Type() == SCH_COMPONENT_T )
+        {
+            for( SCH_PIN& pin : static_cast<SCH_COMPONENT*>( item )->GetPins() )
+                items.push_back( &pin );
+        }
+        else if( item->Type() == SCH_SHEET_T )
+        {
+            for( SCH_SHEET_PIN& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+                items.push_back( &pin );
+        }
+    }
+
+    return items;
+}
+
+
+/**
+ * The names of the connections of the items of the sheet, pins included
+ */
+static std::vector<wxString> connectionNames( const SCH_SHEET_PATH& aSheet )
+{
+    std::vector<wxString> names;
+
+    for( SCH_ITEM* item : connectableItems( aSheet ) )
+    {
+        SCH_CONNECTION* connection = item->Connection( aSheet );
+        names.push_back( connection ? connection->Name() : wxString( "-" ) );
+    }
+
+    return names;
+}
+
+
+/**
+ * The names of the connections of the items of all the sheets
+ */
+static std::vector<wxString> connectionNames( const SCH_SHEET_LIST& aSheets )
+{
+    std::vector<wxString> names;
+
+    for( const SCH_SHEET_PATH& sheet : aSheets )
+    {
+        std::vector<wxString> sheetNames = connectionNames( sheet );
+        names.insert( names.end(), sheetNames.begin(), sheetNames.end() );
+    }
+
+    return names;
+}
+
+
+/**
+ * The net codes of the items of the sheet, pins included
+ */
+static std::vector<int> netCodes( const SCH_SHEET_PATH& aSheet )
+{
+    std::vector<int> codes;
+
+    for( SCH_ITEM* item : connectableItems( aSheet ) )
+    {
+        SCH_CONNECTION* connection = item->Connection( aSheet );
+        codes.push_back( connection ? connection->NetCode() : -1 );
+    }
+
+    return codes;
+}
+
+
+/**
+ * The connections look up the bus aliases in the global connection graph, and the graph
+ * caches the aliases of the global root sheet
+ */
+struct CONNECTION_GRAPH_FIXTURE
+{
+    CONNECTION_GRAPH_FIXTURE() :
+        m_graph( nullptr )
+    {
+        m_root.SetScreen( new SCH_SCREEN( nullptr ) );
+
+        m_previousGraph = g_ConnectionGraph;
+        m_previousRoot = g_RootSheet;
+        g_ConnectionGraph = &m_graph;
+        g_RootSheet = &m_root;
+    }
+
+    ~CONNECTION_GRAPH_FIXTURE()
+    {
+        g_ConnectionGraph = m_previousGraph;
+        g_RootSheet = m_previousRoot;
+    }
+
+    /**
+     * Adds two sheets to the root sheet, each with its own screen:
+     *  - sub1, whose hierarchical label A is wired to its sheet pin, and to the ROOT_A label
+     *    of the root sheet.  A wire ending near the wire of A carries the label B.
+     *  - sub2, with two wires carrying the labels C and D.
+     */
+    void buildHierarchy()
+    {
+        SCH_SCREEN* rootScreen = m_root.GetScreen();
+
+        m_sub1 = addSheet( "sub1", wxPoint( 2000, 2000 ) );
+        m_sub1->AddPin( new SCH_SHEET_PIN( m_sub1, wxPoint( 2000, 2500 ), "A" ) );
+
+        rootScreen->Append( makeWire( wxPoint( 1500, 2500 ), wxPoint( 2000, 2500 ) ) );
+        rootScreen->Append( new SCH_LABEL( wxPoint( 1500, 2500 ), "ROOT_A" ) );
+
+        SCH_SCREEN* screen = m_sub1->GetScreen();
+
+        m_labelA = new SCH_HIERLABEL( wxPoint( 1000, 1000 ), "A" );
+        screen->Append( m_labelA );
+        screen->Append( makeWire( wxPoint( 1000, 1000 ), wxPoint( 1500, 1000 ) ) );
+        m_wireB = makeWire( wxPoint( 1600, 1000 ), wxPoint( 2000, 1000 ) );
+        screen->Append( m_wireB );
+        screen->Append( new SCH_LABEL( wxPoint( 2000, 1000 ), "B" ) );
+
+        m_sub2 = addSheet( "sub2", wxPoint( 4000, 2000 ) );
+        screen = m_sub2->GetScreen();
+
+        screen->Append( makeWire( wxPoint( 1000, 1000 ), wxPoint( 1500, 1000 ) ) );
+        screen->Append( new SCH_LABEL( wxPoint( 1000, 1000 ), "C" ) );
+        m_wireD = makeWire( wxPoint( 1000, 3000 ), wxPoint( 1500, 3000 ) );
+        screen->Append( m_wireD );
+        screen->Append( new SCH_LABEL( wxPoint( 1000, 3000 ), "D" ) );
+    }
+
+    SCH_SHEET* addSheet( const wxString& aName, const wxPoint& aPos )
+    {
+        SCH_SHEET* sheet = new SCH_SHEET( aPos );
+
+        sheet->SetName( aName );
+        sheet->SetFileName( aName + ".sch" );
+        sheet->SetSize( wxSize( 1000, 1000 ) );
+        sheet->SetScreen( new SCH_SCREEN( nullptr ) );
+        m_root.GetScreen()->Append( sheet );
+
+        return sheet;
+    }
+
+    /**
+     * The path of aSheet in aSheets
+     */
+    static const SCH_SHEET_PATH& pathOf( const SCH_SHEET_LIST& aSheets, SCH_SHEET* aSheet )
+    {
+        auto it = std::find_if( aSheets.begin(), aSheets.end(),
+                                [&]( const SCH_SHEET_PATH& aPath )
+                                {
+                                    return aPath.Last() == aSheet;
+                                } );
+
+        BOOST_REQUIRE( it != aSheets.end() );
+
+        return *it;
+    }
+
+    SCH_SHEET         m_root;
+    SCH_SHEET*        m_sub1 = nullptr;
+    SCH_SHEET*        m_sub2 = nullptr;
+    SCH_HIERLABEL*    m_labelA = nullptr;
+    SCH_LINE*         m_wireB = nullptr;
+    SCH_LINE*         m_wireD = nullptr;
+    CONNECTION_GRAPH  m_graph;
+    CONNECTION_GRAPH* m_previousGraph;
+    SCH_SHEET*        m_previousRoot;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ConnectionGraph, CONNECTION_GRAPH_FIXTURE )
+
+
+/**
+ * Replacing the library symbol of a component moves its pins, although the pins are
+ * allocated again at the same addresses: the incremental recalculation sees it
+ */
+BOOST_AUTO_TEST_CASE( IncrementalMatchesFull )
+{
+    LIB_PART before( "R" );
+    LIB_PART after( "R" );
+
+    addPins( before, 0 );
+    addPins( after, 200 );
+
+    SCH_SHEET_LIST sheets( &m_root );
+    SCH_SCREEN*    screen = m_root.GetScreen();
+
+    SCH_COMPONENT* component = new SCH_COMPONENT( before, LIB_ID( "lib", "R" ), &sheets[0], 1, 1,
+                                                  COMPONENT_POS );
+
+    screen->Append( component );
+    screen->Append( makeWire( COMPONENT_POS + wxPoint( -100, 0 ),
+                              COMPONENT_POS + wxPoint( -500, 0 ) ) );
+    screen->Append( makeWire( COMPONENT_POS + wxPoint( 100, 0 ),
+                              COMPONENT_POS + wxPoint( 500, 0 ) ) );
+    screen->Append( new SCH_LABEL( COMPONENT_POS + wxPoint( -500, 0 ), "IN" ) );
+    screen->Append( new SCH_LABEL( COMPONENT_POS + wxPoint( 500, 0 ), "OUT" ) );
+
+    CONNECTION_GRAPH full( nullptr );
+
+    m_graph.Recalculate( sheets, true );
+
+    std::vector<wxString> beforeNames = connectionNames( sheets[0] );
+
+    // What SCH_COMPONENT::ResolveAll() does when a library symbol changed
+    const SCH_PIN* firstPin = component->GetPins().data();
+
+    component->GetPartRef() = after.SharedPtr();
+    component->UpdatePins();
+
+    BOOST_REQUIRE( component->GetPins().data() == firstPin );
+
+    m_graph.Recalculate( sheets, false );
+
+    std::vector<wxString> incrementalNames = connectionNames( sheets[0] );
+
+    full.Recalculate( sheets, true );
+
+    std::vector<wxString> fullNames = connectionNames( sheets[0] );
+
+    BOOST_CHECK( incrementalNames == fullNames );
+
+    // The second pin does not reach the OUT wire anymore
+    BOOST_CHECK( fullNames != beforeNames );
+}
+
+
+/**
+ * Moving a wire of a sheet of a hierarchy in place, and marking it connectivity-dirty, gives
+ * the connections of a full recalculation on every sheet
+ */
+BOOST_AUTO_TEST_CASE( IncrementalWireEditMatchesFull )
+{
+    buildHierarchy();
+
+    SCH_SHEET_LIST sheets( &m_root );
+
+    BOOST_REQUIRE_EQUAL( sheets.size(), 3 );
+
+    const SCH_SHEET_PATH& sub1 = pathOf( sheets, m_sub1 );
+
+    m_graph.Recalculate( sheets, true );
+
+    std::vector<wxString> beforeNames = connectionNames( sheets );
+
+    // The wire of B now touches the end of the wire of A
+    m_wireB->SetStartPoint( wxPoint( 1500, 1000 ) );
+    m_wireB->SetConnectivityDirty();
+
+    m_graph.Recalculate( sheets, false );
+
+    std::vector<wxString> incrementalNames = connectionNames( sheets );
+
+    CONNECTION_GRAPH full( nullptr );
+
+    full.Recalculate( sheets, true );
+
+    std::vector<wxString> fullNames = connectionNames( sheets );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( incrementalNames.begin(), incrementalNames.end(),
+                                   fullNames.begin(), fullNames.end() );
+    BOOST_CHECK( fullNames != beforeNames );
+
+    // The label B and the hierarchical label A are on the same net
+    BOOST_CHECK( m_wireB->Connection( sub1 )->Name() == m_labelA->Connection( sub1 )->Name() );
+}
+
+
+/**
+ * The nets which are not touched by an edit keep their codes through the incremental
+ * recalculations
+ */
+BOOST_AUTO_TEST_CASE( NetCodesStable )
+{
+    buildHierarchy();
+
+    SCH_SHEET_LIST sheets( &m_root );
+
+    const SCH_SHEET_PATH& root = pathOf( sheets, &m_root );
+    const SCH_SHEET_PATH& sub1 = pathOf( sheets, m_sub1 );
+    const SCH_SHEET_PATH& sub2 = pathOf( sheets, m_sub2 );
+
+    m_graph.Recalculate( sheets, true );
+
+    std::vector<int> rootCodes = netCodes( root );
+    std::vector<int> sub1Codes = netCodes( sub1 );
+    std::vector<int> sub2Codes = netCodes( sub2 );
+
+    // Nothing changed
+    m_graph.Recalculate( sheets, false );
+
+    BOOST_CHECK( netCodes( root ) == rootCodes );
+    BOOST_CHECK( netCodes( sub1 ) == sub1Codes );
+    BOOST_CHECK( netCodes( sub2 ) == sub2Codes );
+
+    // The wire of D leaves its label, on sub2 only
+    int codeD = m_wireD->Connection( sub2 )->NetCode();
+
+    m_wireD->SetStartPoint( wxPoint( 1100, 3000 ) );
+    m_wireD->SetConnectivityDirty();
+
+    m_graph.Recalculate( sheets, false );
+
+    BOOST_CHECK( netCodes( root ) == rootCodes );
+    BOOST_CHECK( netCodes( sub1 ) == sub1Codes );
+    BOOST_CHECK_NE( m_wireD->Connection( sub2 )->NetCode(), codeD );
+
+    // The label D alone keeps its net
+    SCH_ITEM* labelD = m_wireD->Next();
+
+    BOOST_REQUIRE( labelD && labelD->Type() == SCH_LABEL_T );
+    BOOST_CHECK_EQUAL( labelD->Connection( sub2 )->NetCode(), codeD );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
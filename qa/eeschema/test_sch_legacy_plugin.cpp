@@ -0,0 +1,284 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the legacy schematic plugin: the on demand loading of the symbols of
+ * legacy libraries, and the loading of schematic hierarchies
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_libentry.h>
+#include <kiway.h>
+#include <lib_pin.h>
+#include <properties.h>
+#include <sch_screen.h>
+#include <sch_sheet.h>
+#include <sch_sheet_path.h>
+#include <symbol_lib_table.h>
+
+// Code under test
+#include <sch_io_mgr.h>
+
+#include "eeschema_test_utils.h"
+
+
+static wxString getLazyLoadTestLibrary()
+{
+    wxFileName fn = KI_TEST::GetEeschemaTestDataDir();
+    fn.AppendDir( "legacy_libs" );
+    fn.SetFullName( "lazy_load.lib" );
+
+    return fn.GetFullPath();
+}
+
+
+/**
+ * A library whose symbol BROKEN has an invalid draw entry on line 13, after its first pin
+ */
+static wxString getLazyLoadErrorTestLibrary()
+{
+    wxFileName fn = KI_TEST::GetEeschemaTestDataDir();
+    fn.AppendDir( "legacy_libs" );
+    fn.SetFullName( "lazy_load_error.lib" );
+
+    return fn.GetFullPath();
+}
+
+
+/**
+ * The directory of the test hierarchy: top.sch has the sub-sheets sub/leaf.sch, broken.sch,
+ * which can not be parsed, and sub/nested.sch, which has leaf.sch as its own sub-sheet
+ */
+static wxFileName getHierarchyTestDir()
+{
+    wxFileName fn = KI_TEST::GetEeschemaTestDataDir();
+    fn.AppendDir( "legacy_schematics" );
+    fn.AppendDir( "hierarchy" );
+
+    return fn;
+}
+
+
+static SCH_SHEET* findSheet( SCH_SCREEN* aScreen, const wxString& aName )
+{
+    for( SCH_ITEM* item = aScreen->GetDrawItems(); item; item = item->Next() )
+    {
+        if( item->Type() == SCH_SHEET_T && static_cast<SCH_SHEET*>( item )->GetName() == aName )
+            return static_cast<SCH_SHEET*>( item );
+    }
+
+    return nullptr;
+}
+
+
+static int countItems( SCH_SCREEN* aScreen, KICAD_T aType )
+{
+    int count = 0;
+
+    for( SCH_ITEM* item = aScreen->GetDrawItems(); item; item = item->Next() )
+    {
+        if( item->Type() == aType )
+            count++;
+    }
+
+    return count;
+}
+
+
+static size_t pinCount( LIB_ALIAS* aAlias )
+{
+    LIB_PINS pins;
+
+    aAlias->GetPart()->GetPins( pins );
+
+    return pins.size();
+}
+
+
+BOOST_AUTO_TEST_SUITE( SchLegacyPlugin )
+
+
+/**
+ * Without the lazy load property, the enumerated symbols are complete
+ */
+BOOST_AUTO_TEST_CASE( EnumerateFull )
+{
+    SCH_PLUGIN::SCH_PLUGIN_RELEASER pi( SCH_IO_MGR::FindPlugin( SCH_IO_MGR::SCH_LEGACY ) );
+    std::vector<LIB_ALIAS*>         aliases;
+
+    pi->EnumerateSymbolLib( aliases, getLazyLoadTestLibrary() );
+
+    BOOST_REQUIRE_EQUAL( aliases.size(), 3 );
+
+    for( LIB_ALIAS* alias : aliases )
+        BOOST_CHECK_EQUAL( pinCount( alias ), 2 );
+}
+
+
+/**
+ * With the lazy load property, the draw items are only read when a symbol is loaded, and
+ * the aliases share them with their part
+ */
+BOOST_AUTO_TEST_CASE( EnumerateLazy )
+{
+    SCH_PLUGIN::SCH_PLUGIN_RELEASER pi( SCH_IO_MGR::FindPlugin( SCH_IO_MGR::SCH_LEGACY ) );
+    std::vector<LIB_ALIAS*>         aliases;
+    PROPERTIES                      props;
+
+    props[ SYMBOL_LIB_TABLE::PropLazyLoad ] = "";
+
+    pi->EnumerateSymbolLib( aliases, getLazyLoadTestLibrary(), &props );
+
+    BOOST_REQUIRE_EQUAL( aliases.size(), 3 );
+
+    for( LIB_ALIAS* alias : aliases )
+    {
+        BOOST_CHECK_EQUAL( pinCount( alias ), 0 );
+
+        // The fields are read with the symbol index
+        BOOST_CHECK( !alias->GetPart()->GetReferenceField().GetText().IsEmpty() );
+    }
+
+    LIB_ALIAS* rSmall = pi->LoadSymbol( getLazyLoadTestLibrary(), "R_Small", &props );
+
+    BOOST_REQUIRE( rSmall );
+    BOOST_CHECK_EQUAL( pinCount( rSmall ), 2 );
+    BOOST_CHECK_EQUAL( pinCount( pi->LoadSymbol( getLazyLoadTestLibrary(), "R", &props ) ), 2 );
+
+    // The other part is still waiting
+    LIB_ALIAS* capacitor = nullptr;
+
+    for( LIB_ALIAS* alias : aliases )
+    {
+        if( alias->GetName() == "C" )
+            capacitor = alias;
+    }
+
+    BOOST_REQUIRE( capacitor );
+    BOOST_CHECK_EQUAL( pinCount( capacitor ), 0 );
+
+    // Enumerating without the property completes the remaining symbols
+    aliases.clear();
+    pi->EnumerateSymbolLib( aliases, getLazyLoadTestLibrary() );
+
+    BOOST_CHECK_EQUAL( pinCount( capacitor ), 2 );
+}
+
+
+/**
+ * A symbol whose draw items can not be parsed reports the line of the library file, and
+ * keeps failing instead of giving a part with only some of its draw items
+ */
+BOOST_AUTO_TEST_CASE( LazyLoadError )
+{
+    SCH_PLUGIN::SCH_PLUGIN_RELEASER pi( SCH_IO_MGR::FindPlugin( SCH_IO_MGR::SCH_LEGACY ) );
+    std::vector<LIB_ALIAS*>         aliases;
+    PROPERTIES                      props;
+
+    props[ SYMBOL_LIB_TABLE::PropLazyLoad ] = "";
+
+    pi->EnumerateSymbolLib( aliases, getLazyLoadErrorTestLibrary(), &props );
+
+    BOOST_REQUIRE_EQUAL( aliases.size(), 2 );
+
+    for( int attempt = 0; attempt < 2; ++attempt )
+    {
+        BOOST_TEST_CONTEXT( "Attempt " << attempt )
+        {
+            int lineNumber = 0;
+
+            try
+            {
+                pi->LoadSymbol( getLazyLoadErrorTestLibrary(), "BROKEN", &props );
+            }
+            catch( const PARSE_ERROR& e )
+            {
+                lineNumber = e.lineNumber;
+            }
+
+            BOOST_CHECK_EQUAL( lineNumber, 13 );
+        }
+    }
+
+    // The other symbol of the library is not affected
+    LIB_ALIAS* capacitor = pi->LoadSymbol( getLazyLoadErrorTestLibrary(), "C", &props );
+
+    BOOST_REQUIRE( capacitor );
+    BOOST_CHECK_EQUAL( pinCount( capacitor ), 2 );
+}
+
+
+/**
+ * A hierarchy is loaded level by level: a sheet file used at two levels gets one screen, the
+ * file names of the sub-sheets are relative to the file of their parent, and a sub-sheet
+ * which can not be parsed is reported without stopping the loading of the others
+ */
+BOOST_AUTO_TEST_CASE( LoadHierarchy )
+{
+    wxFileName dir = getHierarchyTestDir();
+    wxFileName topFile( dir.GetPath(), "top.sch" );
+    KIWAY      kiway( nullptr, KFCTL_STANDALONE );
+
+    kiway.Prj().SetProjectFullName( wxFileName( dir.GetPath(), "top.pro" ).GetFullPath() );
+
+    SCH_PLUGIN::SCH_PLUGIN_RELEASER pi( SCH_IO_MGR::FindPlugin( SCH_IO_MGR::SCH_LEGACY ) );
+    std::unique_ptr<SCH_SHEET>      root( pi->Load( topFile.GetFullPath(), &kiway ) );
+
+    BOOST_REQUIRE( root && root->GetScreen() );
+
+    SCH_SCREEN* top = root->GetScreen();
+    SCH_SHEET*  leaf = findSheet( top, "leaf" );
+    SCH_SHEET*  broken = findSheet( top, "broken" );
+    SCH_SHEET*  nested = findSheet( top, "nested" );
+
+    BOOST_REQUIRE( leaf && broken && nested );
+    BOOST_REQUIRE( leaf->GetScreen() && nested->GetScreen() );
+
+    // The sheet of the second level is relative to sub/nested.sch
+    SCH_SHEET* nestedLeaf = findSheet( nested->GetScreen(), "leaf" );
+
+    BOOST_REQUIRE( nestedLeaf );
+    BOOST_CHECK_EQUAL( nestedLeaf->GetFileName(), "leaf.sch" );
+
+    // ...and is the file of the first level: the screen is shared
+    wxFileName leafFile( dir.GetPath(), "leaf.sch" );
+    leafFile.AppendDir( "sub" );
+
+    BOOST_CHECK_EQUAL( leaf->GetScreen()->GetFileName(), leafFile.GetFullPath() );
+    BOOST_CHECK( nestedLeaf->GetScreen() == leaf->GetScreen() );
+    BOOST_CHECK_EQUAL( leaf->GetScreen()->GetRefCount(), 2 );
+    BOOST_CHECK_EQUAL( countItems( leaf->GetScreen(), SCH_LINE_T ), 2 );
+
+    // The sheets after the broken one, and the next level, are loaded
+    BOOST_CHECK_EQUAL( countItems( nested->GetScreen(), SCH_LINE_T ), 1 );
+    BOOST_CHECK_EQUAL( countItems( top, SCH_LINE_T ), 1 );
+
+    // The error of the broken sheet is kept for the caller
+    BOOST_CHECK( pi->GetError().Contains( "broken.sch" ) );
+    BOOST_CHECK_EQUAL( SCH_SHEET_LIST( root.get() ).size(), 5 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,229 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the position queries of SCH_SCREEN, with and without the item index,
+ * and the dangling end test
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <random>
+
+#include <sch_junction.h>
+#include <sch_line.h>
+#include <sch_text.h>
+
+// Code under test
+#include <sch_screen.h>
+
+
+///> The items are placed on this grid, the queries are made on a grid twice as fine
+static const int GRID = 50;
+
+
+static SCH_LINE* makeWire( const wxPoint& aStart, const wxPoint& aEnd )
+{
+    SCH_LINE* wire = new SCH_LINE( aStart, LAYER_WIRE );
+
+    wire->SetEndPoint( aEnd );
+
+    return wire;
+}
+
+
+/**
+ * Horizontal and vertical wires with junctions and labels on some of their points
+ */
+static void fillScreen( SCH_SCREEN& aScreen, std::mt19937& aRng, int aCount )
+{
+    std::uniform_int_distribution<int> pos( 0, 20 );
+    std::uniform_int_distribution<int> length( 1, 6 );
+    std::uniform_int_distribution<int> coin( 0, 3 );
+
+    for( int i = 0; i < aCount; i++ )
+    {
+        wxPoint start( pos( aRng ) * GRID, pos( aRng ) * GRID );
+        wxPoint end = start;
+
+        if( coin( aRng ) < 2 )
+            end.x += length( aRng ) * GRID;
+        else
+            end.y += length( aRng ) * GRID;
+
+        aScreen.Append( makeWire( start, end ) );
+
+        if( coin( aRng ) == 0 )
+            aScreen.Append( new SCH_JUNCTION( start ) );
+
+        if( coin( aRng ) == 0 )
+            aScreen.Append( new SCH_LABEL( ( start + end ) / 2, wxString::Format( "N%d", i ) ) );
+    }
+}
+
+
+/**
+ * Summarizes the answers of the position queries at aPosition
+ */
+static std::vector<intptr_t> queryAll( SCH_SCREEN& aScreen, const wxPoint& aPosition )
+{
+    std::vector<intptr_t> answers;
+    EDA_ITEMS             node;
+
+    answers.push_back( aScreen.IsJunctionNeeded( aPosition ) );
+    answers.push_back( aScreen.IsJunctionNeeded( aPosition, true ) );
+    answers.push_back( aScreen.CountConnectedItems( aPosition, true ) );
+    answers.push_back( aScreen.CountConnectedItems( aPosition, false ) );
+    answers.push_back( (intptr_t) aScreen.GetItem( aPosition ) );
+    answers.push_back( (intptr_t) aScreen.GetItem( aPosition, 10, SCH_JUNCTION_T ) );
+    answers.push_back( (intptr_t) aScreen.GetWire( aPosition ) );
+    answers.push_back( (intptr_t) aScreen.GetLabel( aPosition ) );
+    answers.push_back( aScreen.IsTerminalPoint( aPosition, LAYER_WIRE ) );
+
+    aScreen.GetNode( aPosition, node );
+
+    for( EDA_ITEM* item : node )
+        answers.push_back( (intptr_t) item );
+
+    return answers;
+}
+
+
+static void checkSameAnswers( SCH_SCREEN& aScreen )
+{
+    int mismatches = 0;
+
+    for( int x = -GRID; x <= 28 * GRID; x += GRID / 2 )
+    {
+        for( int y = -GRID; y <= 28 * GRID; y += GRID / 2 )
+        {
+            std::vector<intptr_t> expected = queryAll( aScreen, wxPoint( x, y ) );
+
+            SCH_SCREEN_INDEX_SCOPE indexScope( &aScreen );
+
+            if( queryAll( aScreen, wxPoint( x, y ) ) != expected )
+                mismatches++;
+        }
+    }
+
+    BOOST_CHECK_EQUAL( mismatches, 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE( SchScreen )
+
+
+/**
+ * The queries give the same answers with the item index, in the same order
+ */
+BOOST_AUTO_TEST_CASE( IndexedQueries )
+{
+    std::mt19937 rng( 7 );
+    SCH_SCREEN   screen( nullptr );
+
+    fillScreen( screen, rng, 60 );
+    checkSameAnswers( screen );
+}
+
+
+/**
+ * The index follows the items appended and removed while it is enabled
+ */
+BOOST_AUTO_TEST_CASE( IndexUpdates )
+{
+    std::mt19937 rng( 11 );
+    SCH_SCREEN   screen( nullptr );
+
+    fillScreen( screen, rng, 30 );
+
+    SCH_SCREEN_INDEX_SCOPE indexScope( &screen );
+
+    SCH_LINE* wire = makeWire( wxPoint( 30 * GRID, 0 ), wxPoint( 30 * GRID, 4 * GRID ) );
+
+    screen.Append( wire );
+    BOOST_CHECK_EQUAL( screen.GetWire( wxPoint( 30 * GRID, 2 * GRID ) ), wire );
+
+    screen.Remove( wire );
+    BOOST_CHECK( screen.GetWire( wxPoint( 30 * GRID, 2 * GRID ) ) == nullptr );
+
+    screen.Append( wire );
+    screen.DeleteItem( wire );
+    BOOST_CHECK( screen.GetWire( wxPoint( 30 * GRID, 2 * GRID ) ) == nullptr );
+
+    // Nested scopes share the index
+    {
+        SCH_SCREEN_INDEX_SCOPE nestedScope( &screen );
+        fillScreen( screen, rng, 30 );
+    }
+
+    checkSameAnswers( screen );
+}
+
+
+/**
+ * Wire ends, and labels on wires, are only connected to the items at their position
+ */
+BOOST_AUTO_TEST_CASE( DanglingEnds )
+{
+    SCH_SCREEN screen( nullptr );
+
+    SCH_LINE*  first = makeWire( wxPoint( 0, 0 ), wxPoint( 10 * GRID, 0 ) );
+    SCH_LINE*  second = makeWire( wxPoint( 10 * GRID, 0 ), wxPoint( 10 * GRID, 10 * GRID ) );
+    SCH_LINE*  apart = makeWire( wxPoint( 20 * GRID, 0 ), wxPoint( 30 * GRID, 0 ) );
+    SCH_LABEL* onWire = new SCH_LABEL( wxPoint( 10 * GRID, 5 * GRID ), "A" );
+    SCH_LABEL* alone = new SCH_LABEL( wxPoint( 15 * GRID, 5 * GRID ), "B" );
+
+    for( SCH_ITEM* item : std::vector<SCH_ITEM*>{ first, second, apart, onWire, alone } )
+        screen.Append( item );
+
+    int changed = 0;
+
+    BOOST_CHECK( screen.TestDanglingEnds( [&changed]( SCH_ITEM* ) { changed++; } ) );
+    BOOST_CHECK( changed > 0 );
+
+    BOOST_CHECK( first->IsStartDangling() );
+    BOOST_CHECK( !first->IsEndDangling() );
+    BOOST_CHECK( !second->IsStartDangling() );
+    BOOST_CHECK( second->IsEndDangling() );
+    BOOST_CHECK( apart->IsStartDangling() );
+    BOOST_CHECK( apart->IsEndDangling() );
+    BOOST_CHECK( !onWire->IsDangling() );
+    BOOST_CHECK( alone->IsDangling() );
+
+    // Nothing changes the second time
+    BOOST_CHECK( !screen.TestDanglingEnds() );
+
+    // Connecting the wire apart to the first one
+    screen.Append( makeWire( wxPoint( 0, 0 ), wxPoint( 0, -10 * GRID ) ) );
+    screen.Append( makeWire( wxPoint( 0, -10 * GRID ), wxPoint( 20 * GRID, -10 * GRID ) ) );
+    screen.Append( makeWire( wxPoint( 20 * GRID, -10 * GRID ), wxPoint( 20 * GRID, 0 ) ) );
+
+    BOOST_CHECK( screen.TestDanglingEnds() );
+    BOOST_CHECK( !first->IsStartDangling() );
+    BOOST_CHECK( !apart->IsStartDangling() );
+    BOOST_CHECK( apart->IsEndDangling() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,256 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the markers updated by DRC::TestChangedItems() are the ones
+ * a full DRC run gives
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <random>
+#include <tuple>
+
+#include <class_board.h>
+#include <class_marker_pcb.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <convert_to_biu.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+// Code under test
+#include <drc.h>
+
+
+/// Error code, main item and auxiliary item of a marker
+typedef std::tuple<int, const void*, const void*> MARKER_KEY;
+
+
+/**
+ * Scatter footprints and short tracks of a few nets on a small area, so that many of
+ * them are too close to each other.
+ */
+static std::unique_ptr<BOARD> makeBoard( std::mt19937& aRng )
+{
+    std::uniform_int_distribution<int> pos( 20, 80 );   // half millimeters
+    std::uniform_int_distribution<int> offset( -6, 6 );
+    std::uniform_int_distribution<int> net( 1, 4 );
+
+    auto mm = []( int aHalfMillimeters )
+    {
+        return std::to_string( aHalfMillimeters / 2.0 );
+    };
+
+    std::string text;
+
+    for( int ii = 0; ii < 8; ++ii )
+    {
+        int n1 = net( aRng );
+        int n2 = net( aRng );
+
+        text += "  (module R (layer F.Cu) (tedit 0) (tstamp 0)\n"
+                "    (at " + mm( pos( aRng ) ) + " " + mm( pos( aRng ) ) + ")\n"
+                "    (pad 1 smd rect (at 0 -0.75) (size 1 1) (layers F.Cu)"
+                " (net " + std::to_string( n1 ) + " N))\n"
+                "    (pad 2 smd rect (at 0 0.75) (size 1 1) (layers F.Cu)"
+                " (net " + std::to_string( n2 ) + " N))\n"
+                "  )\n";
+    }
+
+    for( int ii = 0; ii < 40; ++ii )
+    {
+        int x = pos( aRng );
+        int y = pos( aRng );
+
+        text += "  (segment (start " + mm( x ) + " " + mm( y ) + ")"
+                " (end " + mm( x + offset( aRng ) ) + " " + mm( y + offset( aRng ) ) + ")"
+                " (width 0.25) (layer " + ( ii % 4 ? "F.Cu" : "B.Cu" ) + ")"
+                " (net " + std::to_string( net( aRng ) ) + "))\n";
+    }
+
+    return KI_TEST::MakeTwoLayerBoard( { "A", "B", "C", "D" }, text );
+}
+
+
+static MARKER_KEY markerKey( BOARD& aBoard, MARKER_PCB* aMarker )
+{
+    const DRC_ITEM& item = aMarker->GetReporter();
+
+    return MARKER_KEY( item.GetErrorCode(), item.GetMainItemRef(),
+                       item.GetAuxiliaryItem( &aBoard ) );
+}
+
+
+/**
+ * The markers of the board referring to board items
+ */
+static std::vector<MARKER_KEY> boardMarkers( BOARD& aBoard )
+{
+    std::vector<MARKER_KEY> keys;
+
+    for( int ii = 0; ii < aBoard.GetMARKERCount(); ++ii )
+    {
+        if( aBoard.GetMARKER( ii )->GetReporter().GetMainItemRef() )
+            keys.push_back( markerKey( aBoard, aBoard.GetMARKER( ii ) ) );
+    }
+
+    std::sort( keys.begin(), keys.end() );
+
+    return keys;
+}
+
+
+/**
+ * The markers referring to board items that a full DRC run gives for aBoard
+ */
+static std::vector<MARKER_KEY> fullRunMarkers( BOARD& aBoard )
+{
+    std::vector<MARKER_PCB*> markers;
+    std::vector<MARKER_KEY>  keys;
+
+    DRC drc( &aBoard, MILLIMETRES, [&]( MARKER_PCB* aMarker )
+                                   {
+                                       markers.push_back( aMarker );
+                                   } );
+
+    drc.RunBatchTests( DRC::PASS_HANDLER() );
+
+    for( MARKER_PCB* marker : markers )
+    {
+        if( marker->GetReporter().GetMainItemRef() )
+            keys.push_back( markerKey( aBoard, marker ) );
+
+        delete marker;
+    }
+
+    std::sort( keys.begin(), keys.end() );
+
+    return keys;
+}
+
+
+BOOST_AUTO_TEST_SUITE( DrcIncremental )
+
+
+/**
+ * After each change, the markers of the board are the ones of a full run
+ */
+BOOST_AUTO_TEST_CASE( MatchesFullRun )
+{
+    std::mt19937           rng( 3 );
+    std::unique_ptr<BOARD> board = makeBoard( rng );
+
+    DRC drc( board.get(), MILLIMETRES, [&]( MARKER_PCB* aMarker )
+                                       {
+                                           board->Add( aMarker );
+                                       } );
+
+    drc.RunBatchTests( DRC::PASS_HANDLER() );
+
+    BOOST_REQUIRE( !boardMarkers( *board ).empty() );
+    BOOST_CHECK( boardMarkers( *board ) == fullRunMarkers( *board ) );
+
+    std::uniform_int_distribution<int> action( 0, 3 );
+    std::uniform_int_distribution<int> delta( -4, 4 );
+
+    auto pick = [&]( int aCount )
+    {
+        return std::uniform_int_distribution<int>( 0, aCount - 1 )( rng );
+    };
+
+    for( int step = 0; step < 40; ++step )
+    {
+        wxPoint move( Millimeter2iu( delta( rng ) / 2.0 ), Millimeter2iu( delta( rng ) / 2.0 ) );
+
+        switch( action( rng ) )
+        {
+        case 0:     // move a track
+        {
+            TRACK* track = board->m_Track.GetFirst();
+
+            for( int ii = pick( board->m_Track.GetCount() ); ii > 0; --ii )
+                track = track->Next();
+
+            std::unique_ptr<BOARD_ITEM> copy( static_cast<BOARD_ITEM*>( track->Clone() ) );
+
+            track->Move( move );
+            drc.TestChangedItems( { track }, {}, { copy.get() } );
+            break;
+        }
+
+        case 1:     // remove a track
+        {
+            if( board->m_Track.GetCount() < 10 )
+                continue;
+
+            TRACK* track = board->m_Track.GetFirst();
+
+            for( int ii = pick( board->m_Track.GetCount() ); ii > 0; --ii )
+                track = track->Next();
+
+            board->Remove( track );
+            drc.TestChangedItems( {}, { track }, {} );
+            delete track;
+            break;
+        }
+
+        case 2:     // add a track crossing other ones
+        {
+            TRACK* track = new TRACK( board.get() );
+            wxPoint start( Millimeter2iu( 10 + pick( 30 ) ), Millimeter2iu( 10 + pick( 30 ) ) );
+
+            track->SetStart( start );
+            track->SetEnd( start + wxPoint( Millimeter2iu( 3 ), Millimeter2iu( 2 ) ) );
+            track->SetWidth( Millimeter2iu( 0.25 ) );
+            track->SetLayer( F_Cu );
+            track->SetNetCode( 1 + pick( 4 ) );
+
+            board->Add( track );
+            drc.TestChangedItems( { track }, {}, {} );
+            break;
+        }
+
+        case 3:     // move a footprint
+        {
+            MODULE* module = board->m_Modules.GetFirst();
+
+            for( int ii = pick( board->m_Modules.GetCount() ); ii > 0; --ii )
+                module = module->Next();
+
+            std::unique_ptr<BOARD_ITEM> copy( static_cast<BOARD_ITEM*>( module->Clone() ) );
+
+            module->Move( move );
+            drc.TestChangedItems( { module }, {}, { copy.get() } );
+            break;
+        }
+        }
+
+        BOOST_CHECK_MESSAGE( boardMarkers( *board ) == fullRunMarkers( *board ),
+                             "markers differ after step " << step );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <drc/drc_rtree.h>
+
+
+BOOST_AUTO_TEST_SUITE( DrcRtree )
+
+
+/**
+ * Check items are only found on the layers they were inserted on
+ */
+BOOST_AUTO_TEST_CASE( LayerFiltering )
+{
+    DRC_RTREE        tree;
+    std::vector<int> found;
+
+    tree.Insert( 0, EDA_RECT( wxPoint( 0, 0 ), wxSize( 100, 100 ) ), LSET( F_Cu ) );
+    tree.Insert( 1, EDA_RECT( wxPoint( 0, 0 ), wxSize( 100, 100 ) ), LSET( B_Cu ) );
+
+    BOOST_CHECK_EQUAL( tree.size(), 2 );
+
+    tree.Query( EDA_RECT( wxPoint( 50, 50 ), wxSize( 10, 10 ) ), LSET( F_Cu ), found );
+    BOOST_CHECK_EQUAL( found.size(), 1u );
+    BOOST_CHECK_EQUAL( found[0], 0 );
+
+    tree.Query( EDA_RECT( wxPoint( 50, 50 ), wxSize( 10, 10 ) ), LSET( In1_Cu ), found );
+    BOOST_CHECK( found.empty() );
+}
+
+
+/**
+ * Check the results are sorted, unique, and limited to the area and minimum index
+ */
+BOOST_AUTO_TEST_CASE( SortedUniqueResults )
+{
+    DRC_RTREE        tree;
+    std::vector<int> found;
+
+    // Inserted in reverse order, on all copper layers like a through via
+    for( int ii = 9; ii >= 0; --ii )
+        tree.Insert( ii, EDA_RECT( wxPoint( ii * 1000, 0 ), wxSize( 100, 100 ) ),
+                     LSET::AllCuMask() );
+
+    tree.Query( EDA_RECT( wxPoint( 0, 0 ), wxSize( 5050, 100 ) ), LSET::AllCuMask(), found );
+
+    const std::vector<int> expected = { 0, 1, 2, 3, 4, 5 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found.begin(), found.end(), expected.begin(), expected.end() );
+
+    tree.Query( EDA_RECT( wxPoint( 0, 0 ), wxSize( 5050, 100 ) ), LSET::AllCuMask(), found, 3 );
+
+    const std::vector<int> expected_min = { 3, 4, 5 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+            found.begin(), found.end(), expected_min.begin(), expected_min.end() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
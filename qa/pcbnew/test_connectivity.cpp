@@ -0,0 +1,156 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the incremental connectivity updates give the same ratsnest
+ * as a connectivity built from scratch
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <convert_to_biu.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+// Code under test
+#include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_data.h>
+
+
+/**
+ * Build a row of aCount footprints.  The GND pads are chained by tracks, the other pads
+ * are not routed.
+ */
+static std::unique_ptr<BOARD> makeBoard( int aCount )
+{
+    std::string text;
+
+    for( int ii = 0; ii < aCount; ++ii )
+    {
+        std::string x = std::to_string( 10 * ( ii + 1 ) );
+        std::string next = std::to_string( 10 * ( ii + 2 ) );
+
+        text += "  (module R (layer F.Cu) (tedit 0) (tstamp 0)\n"
+                "    (at " + x + " 20)\n"
+                "    (pad 1 smd rect (at 0 -1) (size 1 1) (layers F.Cu) (net 1 GND))\n"
+                "    (pad 2 smd rect (at 0 1) (size 1 1) (layers F.Cu) (net 2 SIG))\n"
+                "  )\n";
+
+        if( ii < aCount - 1 )
+            text += "  (segment (start " + x + " 19) (end " + next + " 19) (width 0.25)"
+                    " (layer F.Cu) (net 1))\n";
+    }
+
+    return KI_TEST::MakeTwoLayerBoard( { "GND", "SIG" }, text );
+}
+
+
+/**
+ * Check the incrementally updated connectivity of aBoard against a new one
+ */
+static void checkRatsnest( BOARD& aBoard, unsigned aExpected )
+{
+    std::shared_ptr<CONNECTIVITY_DATA> connectivity = aBoard.GetConnectivity();
+    connectivity->RecalculateRatsnest();
+
+    CONNECTIVITY_DATA reference;
+    reference.Build( &aBoard );
+
+    BOOST_CHECK_EQUAL( connectivity->GetUnconnectedCount(), aExpected );
+    BOOST_CHECK_EQUAL( reference.GetUnconnectedCount(), aExpected );
+
+    auto clusters = connectivity->GetConnectivityAlgo()->GetClusters();
+    auto refClusters = reference.GetConnectivityAlgo()->GetClusters();
+
+    BOOST_REQUIRE_EQUAL( clusters.size(), refClusters.size() );
+
+    for( size_t ii = 0; ii < clusters.size(); ++ii )
+    {
+        BOOST_CHECK_EQUAL( clusters[ii]->OriginNet(), refClusters[ii]->OriginNet() );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE( Connectivity )
+
+
+/**
+ * Moving and removing items only searches the clusters of their nets again
+ */
+BOOST_AUTO_TEST_CASE( IncrementalClusters )
+{
+    const int              count = 10;
+    std::unique_ptr<BOARD> board = makeBoard( count );
+    std::shared_ptr<CONNECTIVITY_DATA> connectivity = board->GetConnectivity();
+
+    // The SIG pads are not routed
+    checkRatsnest( *board, count - 1 );
+
+    // Cut the GND chain in two
+    TRACK* track = board->m_Track.GetFirst()->Next();
+
+    connectivity->Remove( track );
+    board->Remove( track );
+    delete track;
+
+    checkRatsnest( *board, count );
+
+    // Move the first footprint away from its track, then back
+    MODULE* module = board->m_Modules.GetFirst();
+
+    module->Move( wxPoint( 0, Millimeter2iu( 10 ) ) );
+    connectivity->Update( module );
+    checkRatsnest( *board, count + 1 );
+
+    module->Move( wxPoint( 0, -Millimeter2iu( 10 ) ) );
+    connectivity->Update( module );
+    checkRatsnest( *board, count );
+}
+
+
+/**
+ * A net changed without updating the connectivity first must not leave a cluster
+ * with a deleted item behind
+ */
+BOOST_AUTO_TEST_CASE( ChangedNet )
+{
+    const int              count = 4;
+    std::unique_ptr<BOARD> board = makeBoard( count );
+    std::shared_ptr<CONNECTIVITY_DATA> connectivity = board->GetConnectivity();
+
+    TRACK* track = board->m_Track.GetFirst();
+
+    track->SetNetCode( 2 );
+    connectivity->Remove( track );
+    board->Remove( track );
+    delete track;
+
+    checkRatsnest( *board, count );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,236 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the footprint list keeps the entries of the unchanged libraries
+ * through its cache file
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <wx/dir.h>
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/textfile.h>
+
+#include <fp_lib_table.h>
+
+// Code under test
+#include <footprint_info_impl.h>
+
+
+/**
+ * Two .pretty libraries, A with the footprints R and C, and B with the footprint L, in a
+ * temporary directory removed afterwards
+ */
+struct FOOTPRINT_LIST_FIXTURE
+{
+    FOOTPRINT_LIST_FIXTURE()
+    {
+        m_dir = wxFileName::CreateTempFileName( "fp_list" );
+        wxRemoveFile( m_dir );
+        wxFileName::Mkdir( m_dir );
+
+        wxFileName::Mkdir( libraryPath( "A" ) );
+        wxFileName::Mkdir( libraryPath( "B" ) );
+
+        writeFootprint( "A", "R" );
+        writeFootprint( "A", "C" );
+        writeFootprint( "B", "L" );
+    }
+
+    ~FOOTPRINT_LIST_FIXTURE()
+    {
+        wxFileName::Rmdir( m_dir, wxPATH_RMDIR_RECURSIVE );
+    }
+
+    wxString libraryPath( const wxString& aNickname ) const
+    {
+        return m_dir + wxFileName::GetPathSeparator() + aNickname + ".pretty";
+    }
+
+    wxString footprintPath( const wxString& aNickname, const wxString& aName ) const
+    {
+        return libraryPath( aNickname ) + wxFileName::GetPathSeparator() + aName + ".kicad_mod";
+    }
+
+    void writeFootprint( const wxString& aNickname, const wxString& aName ) const
+    {
+        wxFFile file( footprintPath( aNickname, aName ), "w" );
+
+        file.Write( "(module " + aName + " (layer F.Cu) (tedit 0)\n"
+                    "  (pad 1 smd rect (at 0 0) (size 1 1) (layers F.Cu))\n"
+                    ")\n" );
+    }
+
+    /**
+     * A new table, as a new session would have: its plugins did not cache the libraries yet
+     */
+    std::unique_ptr<FP_LIB_TABLE> makeTable() const
+    {
+        std::unique_ptr<FP_LIB_TABLE> table( new FP_LIB_TABLE );
+
+        table->InsertRow( new FP_LIB_TABLE_ROW( "A", libraryPath( "A" ), "KiCad", wxEmptyString ) );
+        table->InsertRow( new FP_LIB_TABLE_ROW( "B", libraryPath( "B" ), "KiCad", wxEmptyString ) );
+
+        return table;
+    }
+
+    wxString m_dir;
+};
+
+
+/**
+ * The "nickname:name" of the entries of aList
+ */
+static std::vector<wxString> entryNames( FOOTPRINT_LIST& aList )
+{
+    std::vector<wxString> names;
+
+    for( const std::unique_ptr<FOOTPRINT_INFO>& fpinfo : aList.GetList() )
+        names.push_back( fpinfo->GetLibNickname() + ":" + fpinfo->GetName() );
+
+    return names;
+}
+
+
+static std::vector<const FOOTPRINT_INFO*> entriesOf( FOOTPRINT_LIST& aList,
+                                                     const wxString& aNickname )
+{
+    std::vector<const FOOTPRINT_INFO*> entries;
+
+    for( const std::unique_ptr<FOOTPRINT_INFO>& fpinfo : aList.GetList() )
+    {
+        if( fpinfo->GetLibNickname() == aNickname )
+            entries.push_back( fpinfo.get() );
+    }
+
+    return entries;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( FootprintList, FOOTPRINT_LIST_FIXTURE )
+
+
+/**
+ * The cache file starts with its version, and reading it gives back the entries
+ */
+BOOST_AUTO_TEST_CASE( CacheFileRoundTrip )
+{
+    std::unique_ptr<FP_LIB_TABLE> table = makeTable();
+    FOOTPRINT_LIST_IMPL           list;
+
+    BOOST_REQUIRE( list.ReadFootprintFiles( table.get() ) );
+    BOOST_REQUIRE_EQUAL( list.GetCount(), 3 );
+
+    wxTextFile cacheFile( m_dir + wxFileName::GetPathSeparator() + "fp-info-cache" );
+
+    list.WriteCacheToFile( &cacheFile );
+
+    cacheFile.Open();
+    BOOST_CHECK( cacheFile.GetFirstLine().StartsWith( "version " ) );
+    cacheFile.Close();
+
+    FOOTPRINT_LIST_IMPL cachedList;
+
+    cachedList.ReadCacheFromFile( &cacheFile );
+
+    BOOST_CHECK( entryNames( cachedList ) == entryNames( list ) );
+
+    // Files written by another version are ignored
+    cacheFile.Open();
+    cacheFile.RemoveLine( 0 );
+    cacheFile.InsertLine( "version 1", 0 );
+    cacheFile.Write();
+    cacheFile.Close();
+
+    cachedList.ReadCacheFromFile( &cacheFile );
+
+    BOOST_CHECK_EQUAL( cachedList.GetCount(), 0 );
+}
+
+
+/**
+ * Renaming a footprint file keeps the sum of the modification times of the library: the
+ * library is read again anyway, and the entries of the other library are kept
+ */
+BOOST_AUTO_TEST_CASE( ReloadOnlyChangedLibrary )
+{
+    wxTextFile cacheFile( m_dir + wxFileName::GetPathSeparator() + "fp-info-cache" );
+
+    {
+        std::unique_ptr<FP_LIB_TABLE> table = makeTable();
+        FOOTPRINT_LIST_IMPL           list;
+
+        BOOST_REQUIRE( list.ReadFootprintFiles( table.get() ) );
+        list.WriteCacheToFile( &cacheFile );
+    }
+
+    BOOST_REQUIRE( wxRenameFile( footprintPath( "B", "L" ), footprintPath( "B", "L2" ) ) );
+
+    std::unique_ptr<FP_LIB_TABLE> table = makeTable();
+    FOOTPRINT_LIST_IMPL           list;
+
+    list.ReadCacheFromFile( &cacheFile );
+
+    std::vector<const FOOTPRINT_INFO*> cachedA = entriesOf( list, "A" );
+
+    BOOST_REQUIRE_EQUAL( cachedA.size(), 2 );
+
+    BOOST_REQUIRE( list.ReadFootprintFiles( table.get() ) );
+
+    BOOST_CHECK( entriesOf( list, "A" ) == cachedA );
+
+    std::vector<const FOOTPRINT_INFO*> entriesB = entriesOf( list, "B" );
+
+    BOOST_REQUIRE_EQUAL( entriesB.size(), 1 );
+    BOOST_CHECK_EQUAL( entriesB[0]->GetName(), "L2" );
+}
+
+
+/**
+ * A library missing from the table is reported as an error by each read, instead of
+ * throwing, and does not keep the list from being read again
+ */
+BOOST_AUTO_TEST_CASE( MissingLibraryReported )
+{
+    std::unique_ptr<FP_LIB_TABLE> table = makeTable();
+    FOOTPRINT_LIST_IMPL           list;
+    wxString                      missing = "Missing";
+
+    for( int attempt = 0; attempt < 2; ++attempt )
+    {
+        BOOST_TEST_CONTEXT( "Attempt " << attempt )
+        {
+            BOOST_CHECK( !list.ReadFootprintFiles( table.get(), &missing ) );
+            BOOST_CHECK( list.GetErrorCount() > 0 );
+        }
+    }
+
+    BOOST_CHECK( list.ReadFootprintFiles( table.get() ) );
+    BOOST_CHECK_EQUAL( list.GetCount(), 3 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
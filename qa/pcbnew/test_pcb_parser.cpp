@@ -0,0 +1,244 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that PCB_PARSER::ParseBoard() and ParseBoardTokens() give the same
+ * boards as Parse()
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <kicad_plugin.h>
+#include <richio.h>
+
+// Code under test
+#include <pcb_parser.h>
+
+
+/**
+ * Build a small board file with aCount footprints, each with a track, a via and a zone
+ */
+static std::string makeBoardText( int aCount, const std::string& aBadItem = "" )
+{
+    std::string text =
+        "(kicad_pcb (version 20171130) (host pcbnew 5.1.0)\n"
+        "  (general (thickness 1.6))\n"
+        "  (page A4)\n"
+        "  (layers\n"
+        "    (0 F.Cu signal)\n"
+        "    (31 B.Cu signal)\n"
+        "    (35 F.Paste user)\n"
+        "    (37 F.SilkS user)\n"
+        "    (39 F.Mask user)\n"
+        "    (44 Edge.Cuts user)\n"
+        "    (49 F.Fab user)\n"
+        "  )\n"
+        "  (setup\n"
+        "    (pcbplotparams (usegerberextensions false) (mirror false))\n"
+        "  )\n"
+        "  (net 0 \"\")\n"
+        "  (net 1 GND)\n"
+        "  (net 2 \"Net-(R1-Pad2)\")\n"
+        "  (gr_line (start 0 0) (end 200 0) (layer Edge.Cuts) (width 0.1))\n";
+
+    for( int ii = 0; ii < aCount; ++ii )
+    {
+        std::string x = std::to_string( 10 + ii );
+
+        text += "  (module R_0805 (layer F.Cu) (tedit 0) (tstamp 0)\n"
+                "    (at " + x + " 20)\n"
+                "    (fp_text reference R" + std::to_string( ii + 1 ) + " (at 0 -1.5) (layer F.SilkS)\n"
+                "      (effects (font (size 1 1) (thickness 0.15))))\n"
+                "    (fp_text value 10k (at 0 1.5) (layer F.Fab)\n"
+                "      (effects (font (size 1 1) (thickness 0.15))))\n"
+                "    (pad 1 smd rect (at -1 0) (size 1 1.2) (layers F.Cu F.Paste F.Mask) (net 1 GND))\n"
+                "    (pad 2 smd rect (at 1 0) (size 1 1.2) (layers F.Cu F.Paste F.Mask)\n"
+                "      (net 2 \"Net-(R1-Pad2)\"))\n"
+                "  )\n";
+
+        if( ii == aCount / 2 )
+            text += aBadItem;
+
+        text += "  (segment (start " + x + " 20) (end " + x + " 30) (width 0.25) (layer F.Cu) (net 1))\n"
+                "  (via (at " + x + " 30) (size 0.8) (drill 0.4) (layers F.Cu B.Cu) (net 1))\n";
+    }
+
+    text += "  (zone (net 1) (net_name GND) (layer B.Cu) (tstamp 0) (hatch edge 0.508)\n"
+            "    (connect_pads (clearance 0.508))\n"
+            "    (min_thickness 0.254)\n"
+            "    (fill (arc_segments 32) (thermal_gap 0.508) (thermal_bridge_width 0.508))\n"
+            "    (polygon (pts (xy 0 0) (xy 200 0) (xy 200 50) (xy 0 50)))\n"
+            "  )\n"
+            ")\n";
+
+    return text;
+}
+
+
+static std::unique_ptr<BOARD> parseSerial( const std::string& aText )
+{
+    STRING_LINE_READER reader( aText, "test" );
+    PCB_PARSER         parser( &reader );
+
+    return std::unique_ptr<BOARD>( dynamic_cast<BOARD*>( parser.Parse() ) );
+}
+
+
+static std::unique_ptr<BOARD> parseChunked( const std::string& aText )
+{
+    PCB_PARSER parser;
+
+    return std::unique_ptr<BOARD>(
+            parser.ParseBoard( aText.data(), aText.data() + aText.size(), "test" ) );
+}
+
+
+static std::string makeTokens( const std::string& aText )
+{
+    STRING_LINE_READER reader( aText, "test" );
+    PCB_LEXER          lexer( &reader );
+    std::string        tokens;
+
+    lexer.WriteTokens( tokens );
+    return tokens;
+}
+
+
+static std::unique_ptr<BOARD> parseTokens( const std::string& aTokens )
+{
+    PCB_PARSER parser;
+
+    return std::unique_ptr<BOARD>(
+            parser.ParseBoardTokens( aTokens.data(), aTokens.data() + aTokens.size(), "test" ) );
+}
+
+
+static std::string formatBoard( BOARD* aBoard )
+{
+    PCB_IO io;
+
+    io.Format( aBoard );
+    return io.GetStringOutput( true );
+}
+
+
+BOOST_AUTO_TEST_SUITE( PcbParser )
+
+
+/**
+ * The boards must be identical, item order included
+ */
+BOOST_AUTO_TEST_CASE( ChunkedMatchesSerial )
+{
+    for( int count : { 0, 1, 50 } )
+    {
+        BOOST_TEST_CONTEXT( "Footprints: " << count )
+        {
+            std::string text = makeBoardText( count );
+
+            std::unique_ptr<BOARD> serial = parseSerial( text );
+            std::unique_ptr<BOARD> chunked = parseChunked( text );
+
+            BOOST_REQUIRE( serial && chunked );
+            BOOST_CHECK_EQUAL( (int) chunked->m_Modules.GetCount(), count );
+            BOOST_CHECK_EQUAL( formatBoard( chunked.get() ), formatBoard( serial.get() ) );
+        }
+    }
+}
+
+
+/**
+ * A syntax error in an item is reported at the same place
+ */
+BOOST_AUTO_TEST_CASE( ChunkedErrorLocation )
+{
+    std::string text = makeBoardText( 50, "  (segment (start 0 0) (end 1 1) (bogus 1))\n" );
+
+    PARSE_ERROR serialError;
+    PARSE_ERROR chunkedError;
+
+    try
+    {
+        parseSerial( text );
+    }
+    catch( const PARSE_ERROR& e )
+    {
+        serialError = e;
+    }
+
+    try
+    {
+        parseChunked( text );
+    }
+    catch( const PARSE_ERROR& e )
+    {
+        chunkedError = e;
+    }
+
+    BOOST_CHECK_GT( serialError.lineNumber, 0 );
+    BOOST_CHECK_EQUAL( chunkedError.lineNumber, serialError.lineNumber );
+    BOOST_CHECK_EQUAL( chunkedError.byteIndex, serialError.byteIndex );
+}
+
+
+/**
+ * Boards parsed from a token stream must be identical too
+ */
+BOOST_AUTO_TEST_CASE( TokensMatchSerial )
+{
+    for( int count : { 0, 1, 50 } )
+    {
+        BOOST_TEST_CONTEXT( "Footprints: " << count )
+        {
+            std::string text = makeBoardText( count );
+
+            std::unique_ptr<BOARD> serial = parseSerial( text );
+            std::unique_ptr<BOARD> tokens = parseTokens( makeTokens( text ) );
+
+            BOOST_REQUIRE( serial && tokens );
+            BOOST_CHECK_EQUAL( formatBoard( tokens.get() ), formatBoard( serial.get() ) );
+        }
+    }
+}
+
+
+/**
+ * A damaged token stream is reported, not loaded
+ */
+BOOST_AUTO_TEST_CASE( TruncatedTokens )
+{
+    std::string tokens = makeTokens( makeBoardText( 10 ) );
+
+    for( size_t size : { tokens.size() / 3, tokens.size() - 1 } )
+    {
+        BOOST_TEST_CONTEXT( "Size: " << size )
+        {
+            BOOST_CHECK_THROW( parseTokens( tokens.substr( 0, size ) ), PARSE_ERROR );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
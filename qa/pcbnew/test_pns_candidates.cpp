@@ -0,0 +1,289 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the router finds the same walkaround and shove results whether
+ * its candidates are evaluated in parallel or one after another
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <class_board.h>
+#include <convert_to_biu.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <router/pns_debug_decorator.h>
+#include <router/pns_kicad_iface.h>
+#include <router/pns_line.h>
+#include <router/pns_node.h>
+#include <router/pns_router.h>
+#include <router/pns_segment.h>
+#include <router/pns_via.h>
+
+// Code under test
+#include <router/pns_shove.h>
+#include <router/pns_walkaround.h>
+
+
+/**
+ * Router interface which displays nothing and leaves the board alone
+ */
+class TEST_PNS_IFACE : public PNS_KICAD_IFACE
+{
+public:
+    void EraseView() override {}
+    void HideItem( PNS::ITEM* aItem ) override {}
+    void DisplayItem( const PNS::ITEM* aItem, int aColor, int aClearance, bool aEdit ) override {}
+    void AddItem( PNS::ITEM* aItem ) override {}
+    void RemoveItem( PNS::ITEM* aItem ) override {}
+    void Commit() override {}
+
+    PNS::DEBUG_DECORATOR* GetDebugDecorator() override
+    {
+        return &m_decorator;
+    }
+
+private:
+    PNS::DEBUG_DECORATOR m_decorator;
+};
+
+
+/**
+ * Tracks of net B on F.Cu: two walls to walk around, and a zigzag of 10 segments to shove,
+ * long enough for the shove to try its hull traversals in parallel
+ */
+static std::unique_ptr<BOARD> makeBoard()
+{
+    std::string text =
+        "  (segment (start 10 5) (end 10 15) (width 0.25) (layer F.Cu) (net 2))\n"
+        "  (segment (start 20 8) (end 20 20) (width 0.25) (layer F.Cu) (net 2))\n";
+
+    for( int ii = 0; ii < 10; ++ii )
+    {
+        text += "  (segment (start " + std::to_string( 5 + 3 * ii ) + " "
+                + std::to_string( 30 + ii % 2 ) + ") (end " + std::to_string( 8 + 3 * ii ) + " "
+                + std::to_string( 31 - ii % 2 ) + ") (width 0.25) (layer F.Cu) (net 2))\n";
+    }
+
+    return KI_TEST::MakeTwoLayerBoard( { "A", "B" }, text );
+}
+
+
+/**
+ * A router for aBoard, with its world synchronised, and which does not display anything
+ */
+struct PNS_CANDIDATES_FIXTURE
+{
+    PNS_CANDIDATES_FIXTURE() :
+            m_board( makeBoard() )
+    {
+        m_iface.SetBoard( m_board.get() );
+
+        m_router.SetInterface( &m_iface );
+        m_router.SetMode( PNS::PNS_MODE_ROUTE_SINGLE );
+        m_router.ClearWorld();
+        m_router.SyncWorld();
+    }
+
+    /**
+     * A line of net A on F.Cu, through the given points in mm
+     */
+    PNS::LINE makeLine( const std::vector<std::pair<double, double>>& aPoints ) const
+    {
+        SHAPE_LINE_CHAIN chain;
+
+        for( const std::pair<double, double>& pt : aPoints )
+            chain.Append( Millimeter2iu( pt.first ), Millimeter2iu( pt.second ) );
+
+        PNS::LINE line;
+
+        line.SetShape( chain );
+        line.SetWidth( Millimeter2iu( 0.25 ) );
+        line.SetNet( 1 );
+        line.SetLayer( F_Cu );
+
+        return line;
+    }
+
+    std::unique_ptr<BOARD> m_board;
+    TEST_PNS_IFACE         m_iface;
+    PNS::ROUTER            m_router;
+};
+
+
+/**
+ * The points of aLine, to compare paths and report them
+ */
+static std::string formatLine( const PNS::LINE& aLine )
+{
+    std::ostringstream out;
+
+    for( int ii = 0; ii < aLine.PointCount(); ++ii )
+        out << " " << aLine.CPoint( ii ).x << "," << aLine.CPoint( ii ).y;
+
+    return out.str();
+}
+
+
+/**
+ * The segments and vias added to aNode and the items removed from its root, as sorted
+ * strings
+ */
+static std::vector<std::string> formatChanges( PNS::NODE* aNode )
+{
+    PNS::NODE::ITEM_VECTOR   removed, added;
+    std::vector<std::string> changes;
+
+    aNode->GetUpdatedItems( removed, added );
+
+    auto format =
+            []( const char* aPrefix, const PNS::ITEM* aItem )
+            {
+                std::ostringstream out;
+
+                out << aPrefix << " net " << aItem->Net();
+
+                if( aItem->OfKind( PNS::ITEM::SEGMENT_T ) )
+                {
+                    const SEG& seg = static_cast<const PNS::SEGMENT*>( aItem )->Seg();
+
+                    out << " seg " << seg.A.x << "," << seg.A.y << " " << seg.B.x << ","
+                        << seg.B.y;
+                }
+                else if( aItem->OfKind( PNS::ITEM::VIA_T ) )
+                {
+                    const VECTOR2I& pos = static_cast<const PNS::VIA*>( aItem )->Pos();
+
+                    out << " via " << pos.x << "," << pos.y;
+                }
+
+                return out.str();
+            };
+
+    for( const PNS::ITEM* item : removed )
+        changes.push_back( format( "-", item ) );
+
+    for( const PNS::ITEM* item : added )
+        changes.push_back( format( "+", item ) );
+
+    std::sort( changes.begin(), changes.end() );
+
+    return changes;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsCandidates, PNS_CANDIDATES_FIXTURE )
+
+
+/**
+ * Walking around the walls gives the same path and status with both evaluations
+ */
+BOOST_AUTO_TEST_CASE( WalkaroundSerialMatchesParallel )
+{
+    const std::vector<std::vector<std::pair<double, double>>> cases = {
+        { { 0, 10 }, { 30, 10 } },
+        { { 0, 12 }, { 25, 14 } },
+        { { 5, 18 }, { 25, 2 } },
+        { { 2, 6 }, { 15, 10 }, { 28, 16 } },
+    };
+
+    for( size_t ii = 0; ii < cases.size(); ++ii )
+    {
+        PNS::LINE                          initial = makeLine( cases[ii] );
+        PNS::LINE                          paths[2];
+        PNS::WALKAROUND::WALKAROUND_STATUS statuses[2];
+
+        for( int parallel = 0; parallel < 2; ++parallel )
+        {
+            m_router.Settings().SetParallelCandidates( parallel );
+
+            PNS::WALKAROUND walkaround( m_router.GetWorld(), &m_router );
+
+            walkaround.SetIterationLimit( 50 );
+            statuses[parallel] = walkaround.Route( initial, paths[parallel] );
+        }
+
+        BOOST_TEST_CONTEXT( "Case " << ii )
+        {
+            BOOST_CHECK_EQUAL( statuses[0], statuses[1] );
+            BOOST_CHECK_EQUAL( formatLine( paths[0] ), formatLine( paths[1] ) );
+        }
+    }
+}
+
+
+/**
+ * Shoving the zigzag gives the same status, head and shoved lines with both evaluations
+ */
+BOOST_AUTO_TEST_CASE( ShoveSerialMatchesParallel )
+{
+    const std::vector<std::vector<std::pair<double, double>>> cases = {
+        { { 6, 30.5 }, { 10, 30.5 }, { 14, 30.5 }, { 18, 30.5 }, { 22, 30.5 }, { 26, 30.5 },
+          { 30, 30.5 }, { 34, 30.5 } },
+        { { 3, 28 }, { 7, 29 }, { 11, 29.5 }, { 15, 30 }, { 19, 30.5 }, { 23, 31 },
+          { 27, 31.5 }, { 31, 32 }, { 35, 33 } },
+        { { 4, 32 }, { 9, 30.2 }, { 14, 32 }, { 19, 30.2 }, { 24, 32 }, { 29, 30.2 },
+          { 34, 32 } },
+    };
+
+    for( size_t ii = 0; ii < cases.size(); ++ii )
+    {
+        PNS::LINE                head = makeLine( cases[ii] );
+        PNS::SHOVE::SHOVE_STATUS statuses[2];
+        std::string              heads[2];
+        std::vector<std::string> changes[2];
+
+        for( int parallel = 0; parallel < 2; ++parallel )
+        {
+            m_router.Settings().SetParallelCandidates( parallel );
+
+            {
+                PNS::SHOVE shove( m_router.GetWorld()->Branch(), &m_router );
+
+                statuses[parallel] = shove.ShoveLines( head );
+                changes[parallel] = formatChanges( shove.CurrentNode() );
+
+                if( statuses[parallel] == PNS::SHOVE::SH_HEAD_MODIFIED )
+                    heads[parallel] = formatLine( shove.NewHead() );
+            }
+
+            m_router.GetWorld()->KillChildren();
+        }
+
+        BOOST_TEST_CONTEXT( "Case " << ii )
+        {
+            BOOST_CHECK_EQUAL( statuses[0], statuses[1] );
+            BOOST_CHECK_EQUAL( heads[0], heads[1] );
+            BOOST_CHECK_EQUAL_COLLECTIONS( changes[0].begin(), changes[0].end(),
+                                           changes[1].begin(), changes[1].end() );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,183 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the branches of a router node, which look the items and joints
+ * of their parents up instead of copying them, show the items they should
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <map>
+#include <random>
+#include <set>
+
+#include <layers_id_colors_and_visibility.h>
+
+#include <router/pns_joint.h>
+#include <router/pns_segment.h>
+
+// Code under test
+#include <router/pns_node.h>
+
+
+using SEG_KEY = std::pair<std::pair<int, int>, std::pair<int, int>>;
+
+
+static SEG_KEY segKey( const SEG& aSeg )
+{
+    std::pair<int, int> a( aSeg.A.x, aSeg.A.y );
+    std::pair<int, int> b( aSeg.B.x, aSeg.B.y );
+
+    if( b < a )
+        std::swap( a, b );
+
+    return SEG_KEY( a, b );
+}
+
+
+/**
+ * The segments of net 1 seen from aNode, which must match aExpected, and the number of
+ * segments ending at each point, which must be the link count of the joint there
+ */
+static void checkNode( PNS::NODE* aNode, const std::set<SEG_KEY>& aExpected )
+{
+    std::set<PNS::ITEM*> items;
+    std::set<SEG_KEY>    found;
+
+    aNode->AllItemsInNet( 1, items );
+
+    for( PNS::ITEM* item : items )
+        found.insert( segKey( static_cast<PNS::SEGMENT*>( item )->Seg() ) );
+
+    BOOST_CHECK_EQUAL( items.size(), found.size() );
+    BOOST_CHECK( found == aExpected );
+
+    std::map<std::pair<int, int>, int> ends;
+
+    for( const SEG_KEY& key : aExpected )
+    {
+        ends[key.first]++;
+        ends[key.second]++;
+    }
+
+    for( const auto& end : ends )
+    {
+        PNS::JOINT* joint = aNode->FindJoint( VECTOR2I( end.first.first, end.first.second ),
+                                              F_Cu, 1 );
+
+        BOOST_REQUIRE( joint );
+        BOOST_CHECK_EQUAL( joint->LinkCount(), end.second );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE( PnsNode )
+
+
+/**
+ * Random additions, removals, branches, branch deletions and commits on a stack of branches
+ * give the same items and joints as a plain set of segments kept for each branch
+ */
+BOOST_AUTO_TEST_CASE( BranchesMatchModel )
+{
+    std::mt19937                       rng( 1 );
+    std::uniform_int_distribution<int> coord( 0, 7 );
+
+    PNS::NODE                      root;
+    std::vector<PNS::NODE*>        nodes = { &root };
+    std::vector<std::set<SEG_KEY>> models( 1 );
+
+    for( int step = 0; step < 2000; ++step )
+    {
+        PNS::NODE*         node = nodes.back();
+        std::set<SEG_KEY>& model = models.back();
+        int                op = rng() % 20;
+
+        if( op < 9 )
+        {
+            // Segments between the points of a small grid, so that they share joints
+            SEG seg( VECTOR2I( coord( rng ), coord( rng ) ) * 100000,
+                     VECTOR2I( coord( rng ), coord( rng ) ) * 100000 );
+
+            std::unique_ptr<PNS::SEGMENT> item( new PNS::SEGMENT( seg, 1 ) );
+            item->SetLayer( F_Cu );
+
+            if( node->Add( std::move( item ) ) )
+                model.insert( segKey( seg ) );
+        }
+        else if( op < 15 )
+        {
+            std::set<PNS::ITEM*> items;
+            node->AllItemsInNet( 1, items );
+
+            if( !items.empty() )
+            {
+                auto it = items.begin();
+                std::advance( it, rng() % items.size() );
+
+                model.erase( segKey( static_cast<PNS::SEGMENT*>( *it )->Seg() ) );
+                node->Remove( *it );
+            }
+        }
+        else if( op < 17 )
+        {
+            if( nodes.size() < 6 )
+            {
+                nodes.push_back( node->Branch() );
+                models.push_back( model );
+            }
+        }
+        else if( op < 19 )
+        {
+            if( nodes.size() > 1 )
+            {
+                delete node;
+                nodes.pop_back();
+                models.pop_back();
+            }
+        }
+        else if( nodes.size() > 1 )
+        {
+            std::set<SEG_KEY> committed = model;
+
+            root.Commit( node );
+
+            nodes.resize( 1 );
+            models.assign( 1, committed );
+        }
+
+        BOOST_TEST_CONTEXT( "Step " << step << ", depth " << nodes.size() - 1 )
+        {
+            // The parents of the current branch are unchanged and still show their items
+            for( size_t ii = 0; ii < nodes.size(); ++ii )
+                checkNode( nodes[ii], models[ii] );
+        }
+    }
+
+    root.KillChildren();
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,256 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the ratsnest of a net updated from its previous triangulation is
+ * the ratsnest computed from scratch
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <memory>
+#include <random>
+#include <set>
+
+#include <connectivity/connectivity_items.h>
+
+// Code under test
+#include <ratsnest_data.h>
+
+
+/**
+ * A net whose anchors are set directly, each one in its own cluster
+ */
+class TEST_RN_NET : public RN_NET
+{
+public:
+    void SetAnchors( const std::vector<CN_ANCHOR_PTR>& aAnchors )
+    {
+        Clear();
+        m_nodes = aAnchors;
+    }
+
+    using RN_NET::triangulationBuildCount;
+    using RN_NET::dropTriangulationNode;
+};
+
+
+/**
+ * Anchors at random positions, owned by items without a board item
+ */
+class RANDOM_ANCHORS
+{
+public:
+    RANDOM_ANCHORS( int aCount ) :
+        m_rng( 1 )
+    {
+        for( int ii = 0; ii < aCount; ++ii )
+            Add();
+    }
+
+    void Add()
+    {
+        std::uniform_int_distribution<int> coord( 0, 100000000 );
+
+        m_items.emplace_back( new CN_ITEM( nullptr, false, 1 ) );
+        m_items.back()->AddAnchor( VECTOR2I( coord( m_rng ), coord( m_rng ) ) );
+
+        CN_ANCHOR_PTR anchor = m_items.back()->Anchors()[0];
+
+        anchor->SetCluster( std::make_shared<CN_CLUSTER>() );
+        m_anchors.push_back( anchor );
+    }
+
+    void Remove( int aIndex )
+    {
+        m_anchors.erase( m_anchors.begin() + aIndex );
+    }
+
+    ///> Moves an anchor: it is replaced by an anchor at a new position, like the anchors of
+    ///> a moved pad
+    void Move( int aIndex )
+    {
+        Remove( aIndex );
+        Add();
+    }
+
+    /**
+     * Applies aCount random moves, removals and additions, keeping at least aMinCount
+     * anchors
+     */
+    void Shuffle( int aCount, unsigned aMinCount )
+    {
+        for( int ii = 0; ii < aCount; ++ii )
+        {
+            int index = m_rng() % m_anchors.size();
+
+            switch( m_rng() % 3 )
+            {
+            case 0:
+                Move( index );
+                break;
+
+            case 1:
+                if( m_anchors.size() > aMinCount )
+                    Remove( index );
+
+                break;
+
+            default:
+                Add();
+                break;
+            }
+        }
+    }
+
+    const std::vector<CN_ANCHOR_PTR>& Anchors() const
+    {
+        return m_anchors;
+    }
+
+    int RandomIndex()
+    {
+        return m_rng() % m_anchors.size();
+    }
+
+private:
+    std::mt19937 m_rng;
+
+    std::vector<std::unique_ptr<CN_ITEM>> m_items;
+    std::vector<CN_ANCHOR_PTR>            m_anchors;
+};
+
+
+using RN_EDGE_SET = std::set<std::pair<std::pair<int, int>, std::pair<int, int>>>;
+
+
+/**
+ * The ratsnest lines of aNet, by the positions of their ends
+ */
+static RN_EDGE_SET ratsnestEdges( const RN_NET& aNet )
+{
+    RN_EDGE_SET edges;
+
+    for( const CN_EDGE& edge : aNet.GetUnconnected() )
+    {
+        const VECTOR2I& src = edge.GetSourceNode()->Pos();
+        const VECTOR2I& dst = edge.GetTargetNode()->Pos();
+
+        std::pair<int, int> a( src.x, src.y );
+        std::pair<int, int> b( dst.x, dst.y );
+
+        if( b < a )
+            std::swap( a, b );
+
+        edges.emplace( a, b );
+    }
+
+    return edges;
+}
+
+
+/**
+ * The ratsnest of aAnchors computed by a new net
+ */
+static RN_EDGE_SET referenceEdges( const std::vector<CN_ANCHOR_PTR>& aAnchors )
+{
+    TEST_RN_NET net;
+
+    net.SetAnchors( aAnchors );
+    net.Update();
+
+    return ratsnestEdges( net );
+}
+
+
+BOOST_AUTO_TEST_SUITE( Ratsnest )
+
+
+/**
+ * Random moves, removals and additions on nets of hundreds of anchors are applied to the
+ * kept triangulation, and give the minimum spanning tree of a new triangulation
+ */
+BOOST_AUTO_TEST_CASE( IncrementalMatchesRebuild )
+{
+    for( int netIdx = 0; netIdx < 5; ++netIdx )
+    {
+        RANDOM_ANCHORS anchors( 300 + 100 * netIdx );
+        TEST_RN_NET    net;
+
+        net.SetAnchors( anchors.Anchors() );
+        net.Update();
+
+        for( int step = 0; step < 50; ++step )
+        {
+            anchors.Shuffle( 1 + step % 10, 200 );
+
+            net.SetAnchors( anchors.Anchors() );
+            net.Update();
+
+            BOOST_TEST_CONTEXT( "Net " << netIdx << ", step " << step )
+            {
+                RN_EDGE_SET edges = ratsnestEdges( net );
+
+                BOOST_CHECK_EQUAL( edges.size(), anchors.Anchors().size() - 1 );
+                BOOST_CHECK( edges == referenceEdges( anchors.Anchors() ) );
+            }
+        }
+
+        // Only the first update triangulated the whole net
+        BOOST_CHECK_EQUAL( net.triangulationBuildCount(), 1 );
+    }
+}
+
+
+/**
+ * A node which can not be removed from the kept triangulation makes the update triangulate
+ * the net again
+ */
+BOOST_AUTO_TEST_CASE( RemovalFailureRebuilds )
+{
+    RANDOM_ANCHORS anchors( 300 );
+    TEST_RN_NET    net;
+
+    net.SetAnchors( anchors.Anchors() );
+    net.Update();
+
+    anchors.Move( anchors.RandomIndex() );
+    net.SetAnchors( anchors.Anchors() );
+    net.Update();
+
+    BOOST_REQUIRE_EQUAL( net.triangulationBuildCount(), 1 );
+
+    int index = anchors.RandomIndex();
+
+    net.dropTriangulationNode( anchors.Anchors()[index]->Pos() );
+    anchors.Move( index );
+    net.SetAnchors( anchors.Anchors() );
+    net.Update();
+
+    BOOST_CHECK_EQUAL( net.triangulationBuildCount(), 2 );
+    BOOST_CHECK( ratsnestEdges( net ) == referenceEdges( anchors.Anchors() ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,253 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite checking that the zone filler refills the zones around the items which
+ * changed since the previous fill
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <cmath>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_zone.h>
+#include <convert_to_biu.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+// Code under test
+#include <zone_filler.h>
+
+
+/**
+ * A zone of net A covering the board on F.Cu, and a footprint with a pad of net B at 2 mm
+ * above its anchor, so that moving or rotating the footprint moves the pad.  A pad of net A
+ * keeps the zone from being removed as an insulated island.  A zone without net covers the
+ * board on B.Cu, where nothing changes.
+ */
+static std::unique_ptr<BOARD> makeBoard()
+{
+    std::string text =
+        "  (module R (layer F.Cu) (tedit 0) (tstamp 0)\n"
+        "    (at 10 10)\n"
+        "    (pad 1 smd rect (at 0 -2) (size 1 1) (layers F.Cu) (net 2 B))\n"
+        "  )\n"
+        "  (module G (layer F.Cu) (tedit 0) (tstamp 0)\n"
+        "    (at 3 17)\n"
+        "    (pad 1 smd rect (at 0 0) (size 1 1) (layers F.Cu) (net 1 A))\n"
+        "  )\n"
+        "  (zone (net 1) (net_name A) (layer F.Cu) (tstamp 0) (hatch edge 0.508)\n"
+        "    (connect_pads (clearance 0.5))\n"
+        "    (min_thickness 0.25)\n"
+        "    (fill yes (arc_segments 32) (thermal_gap 0.5) (thermal_bridge_width 0.5))\n"
+        "    (polygon (pts (xy 0 0) (xy 20 0) (xy 20 20) (xy 0 20)))\n"
+        "  )\n"
+        "  (zone (net 0) (net_name \"\") (layer B.Cu) (tstamp 0) (hatch edge 0.508)\n"
+        "    (connect_pads (clearance 0.5))\n"
+        "    (min_thickness 0.25)\n"
+        "    (fill yes (arc_segments 32) (thermal_gap 0.5) (thermal_bridge_width 0.5))\n"
+        "    (polygon (pts (xy 0 0) (xy 20 0) (xy 20 20) (xy 0 20)))\n"
+        "  )\n";
+
+    return KI_TEST::MakeTwoLayerBoard( { "A", "B" }, text );
+}
+
+
+static ZONE_CONTAINER* zoneOn( BOARD& aBoard, PCB_LAYER_ID aLayer )
+{
+    for( ZONE_CONTAINER* zone : aBoard.Zones() )
+    {
+        if( zone->GetLayer() == aLayer )
+            return zone;
+    }
+
+    return nullptr;
+}
+
+
+static bool isFilled( BOARD& aBoard, double aX, double aY, PCB_LAYER_ID aLayer = F_Cu )
+{
+    const ZONE_CONTAINER* zone = zoneOn( aBoard, aLayer );
+
+    return zone->GetFilledPolysList().Contains(
+            VECTOR2I( Millimeter2iu( aX ), Millimeter2iu( aY ) ) );
+}
+
+
+static double area( const SHAPE_POLY_SET& aSet )
+{
+    double area = 0.0;
+
+    for( int ii = 0; ii < aSet.OutlineCount(); ++ii )
+    {
+        area += std::abs( aSet.COutline( ii ).Area() );
+
+        for( int jj = 0; jj < aSet.HoleCount( ii ); ++jj )
+            area -= std::abs( aSet.CHole( ii, jj ).Area() );
+    }
+
+    return area;
+}
+
+
+/**
+ * The area covered by only one of the two sets, in square millimeters
+ */
+static double differenceArea( const SHAPE_POLY_SET& aFirst, const SHAPE_POLY_SET& aSecond )
+{
+    SHAPE_POLY_SET firstOnly = aFirst;
+    SHAPE_POLY_SET secondOnly = aSecond;
+
+    firstOnly.BooleanSubtract( aSecond, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+    secondOnly.BooleanSubtract( aFirst, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+
+    double iuPerMm = Millimeter2iu( 1 );
+
+    return ( area( firstOnly ) + area( secondOnly ) ) / ( iuPerMm * iuPerMm );
+}
+
+
+BOOST_AUTO_TEST_SUITE( ZoneFiller )
+
+
+/**
+ * Moving a footprint moves the knock-out of its pad
+ */
+BOOST_AUTO_TEST_CASE( MovedFootprint )
+{
+    std::unique_ptr<BOARD> board = makeBoard();
+    ZONE_FILLER            filler( board.get() );
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+    BOOST_CHECK( !isFilled( *board, 10, 8 ) );
+    BOOST_CHECK( isFilled( *board, 15, 8 ) );
+
+    board->m_Modules.GetFirst()->Move( wxPoint( Millimeter2iu( 5 ), 0 ) );
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+    BOOST_CHECK( isFilled( *board, 10, 8 ) );
+    BOOST_CHECK( !isFilled( *board, 15, 8 ) );
+}
+
+
+/**
+ * Rotating a footprint around its anchor moves the knock-out of its pad
+ */
+BOOST_AUTO_TEST_CASE( RotatedFootprint )
+{
+    std::unique_ptr<BOARD> board = makeBoard();
+    ZONE_FILLER            filler( board.get() );
+    MODULE*                module = board->m_Modules.GetFirst();
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+    BOOST_CHECK( !isFilled( *board, 10, 8 ) );
+    BOOST_CHECK( isFilled( *board, 8, 10 ) );
+    BOOST_CHECK( isFilled( *board, 12, 10 ) );
+
+    // The pad at (0, -2) from the anchor goes to (-2, 0)
+    module->Rotate( module->GetPosition(), 900 );
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+    BOOST_CHECK( isFilled( *board, 10, 8 ) );
+    BOOST_CHECK( !isFilled( *board, 8, 10 ) );
+    BOOST_CHECK( isFilled( *board, 12, 10 ) );
+}
+
+
+/**
+ * Refilling only around a moved footprint gives the fill of a board filled from scratch
+ */
+BOOST_AUTO_TEST_CASE( PartialRefillMatchesFullFill )
+{
+    const wxPoint moves[] = { { Millimeter2iu( 5 ), 0 },
+                              { 0, Millimeter2iu( 4 ) },
+                              { -Millimeter2iu( 7 ), -Millimeter2iu( 1 ) } };
+
+    std::unique_ptr<BOARD> board = makeBoard();
+    ZONE_FILLER            filler( board.get() );
+    wxPoint                totalMove;
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+
+    for( const wxPoint& move : moves )
+    {
+        board->m_Modules.GetFirst()->Move( move );
+        totalMove += move;
+
+        BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+
+        std::unique_ptr<BOARD> reference = makeBoard();
+        ZONE_FILLER            referenceFiller( reference.get() );
+
+        reference->m_Modules.GetFirst()->Move( totalMove );
+        BOOST_REQUIRE( referenceFiller.Fill( reference->Zones() ) );
+
+        // Allow for the rounding of the polygon operations along the border of the
+        // refilled area
+        BOOST_CHECK_SMALL( differenceArea( zoneOn( *board, F_Cu )->GetFilledPolysList(),
+                                           zoneOn( *reference, F_Cu )->GetFilledPolysList() ),
+                           0.001 );
+    }
+}
+
+
+/**
+ * A zone whose inputs did not change keeps its raw filled areas instead of being refilled
+ */
+BOOST_AUTO_TEST_CASE( UnchangedZoneReused )
+{
+    std::unique_ptr<BOARD> board = makeBoard();
+    ZONE_FILLER            filler( board.get() );
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+    BOOST_CHECK( isFilled( *board, 15, 15, B_Cu ) );
+
+    // Replace the raw filled areas of the B.Cu zone by a small square: they are only
+    // kept if the zone is not filled again
+    SHAPE_POLY_SET square;
+
+    square.NewOutline();
+    square.Append( Millimeter2iu( 2 ), Millimeter2iu( 2 ) );
+    square.Append( Millimeter2iu( 4 ), Millimeter2iu( 2 ) );
+    square.Append( Millimeter2iu( 4 ), Millimeter2iu( 4 ) );
+    square.Append( Millimeter2iu( 2 ), Millimeter2iu( 4 ) );
+
+    zoneOn( *board, B_Cu )->SetRawPolysList( square );
+
+    // The F.Cu footprint is not an input of the B.Cu zone
+    board->m_Modules.GetFirst()->Move( wxPoint( Millimeter2iu( 5 ), 0 ) );
+
+    BOOST_REQUIRE( filler.Fill( board->Zones() ) );
+    BOOST_CHECK( isFilled( *board, 3, 3, B_Cu ) );
+    BOOST_CHECK( !isFilled( *board, 15, 15, B_Cu ) );
+
+    // The F.Cu zone was refilled
+    BOOST_CHECK( isFilled( *board, 10, 8 ) );
+    BOOST_CHECK( !isFilled( *board, 15, 8 ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,8 +25,11 @@
 
 #include "tools/drc_tool/drc_tool.h"
 #include "tools/pcb_parser/pcb_parser_tool.h"
+#include "tools/pns_autoroute/pns_autoroute.h"
+#include "tools/pns_replay/pns_replay.h"
 #include "tools/polygon_generator/polygon_generator.h"
 #include "tools/polygon_triangulation/polygon_triangulation.h"
+#include "tools/zone_fill_bench/zone_fill_bench.h"
 
 /**
  * List of registered tools.
@@ -37,8 +40,11 @@
 const static std::vector<KI_TEST::UTILITY_PROGRAM*> known_tools = {
     &drc_tool,
     &pcb_parser_tool,
+    &pns_autoroute_tool,
+    &pns_replay_tool,
     &polygon_generator_tool,
     &polygon_triangulation_tool,
+    &zone_fill_bench_tool,
 };
 
 
@@ -24,15 +24,27 @@
 #include "drc_tool.h"
 
 #include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include <common.h>
 
 #include <wx/cmdline.h>
+#include <wx/tokenzr.h>
 
 #include <pcbnew_utils/board_file_utils.h>
 
+#include <board_connected_item.h>
+#include <class_marker_pcb.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <class_zone.h>
+
 // DRC
+#include <drc.h>
 #include <drc/courtyard_overlap.h>
 #include <drc/drc_marker_factory.h>
 
@@ -208,6 +220,310 @@ private:
 };
 
 
+/**
+ * Restricts a DRC report to the violations involving some layers or nets.
+ *
+ * The DRC still runs on the whole board, because an item on a selected layer or net
+ * can be in violation with any other item.
+ */
+struct DRC_ITEM_FILTER
+{
+    /// Selected layers. If empty, all layers are selected
+    LSET m_layers;
+
+    /// Selected net names. If empty, all nets are selected
+    std::set<wxString> m_nets;
+
+    bool IsEmpty() const
+    {
+        return m_layers.none() && m_nets.empty();
+    }
+
+    bool Matches( const BOARD_ITEM* aItem ) const
+    {
+        if( m_layers.any() && ( aItem->GetLayerSet() & m_layers ).none() )
+            return false;
+
+        if( !m_nets.empty() )
+        {
+            if( !aItem->IsConnected() )
+                return false;
+
+            const auto conn = static_cast<const BOARD_CONNECTED_ITEM*>( aItem );
+
+            if( !m_nets.count( conn->GetNetname() ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Record which items of aBoard are selected, so that matching the DRC items does not
+     * search the board for their items.  To be called before Matches( const DRC_ITEM& ).
+     */
+    void SelectItems( BOARD& aBoard )
+    {
+        m_selected.clear();
+
+        auto select = [&]( const BOARD_ITEM* aItem )
+        {
+            m_selected[ aItem ] = Matches( aItem );
+        };
+
+        for( TRACK* track : aBoard.Tracks() )
+            select( track );
+
+        for( MODULE* module : aBoard.Modules() )
+        {
+            select( module );
+            select( &module->Reference() );
+            select( &module->Value() );
+
+            for( D_PAD* pad : module->Pads() )
+                select( pad );
+
+            for( BOARD_ITEM* drawing : module->GraphicalItems() )
+                select( drawing );
+        }
+
+        for( ZONE_CONTAINER* zone : aBoard.Zones() )
+            select( zone );
+
+        for( BOARD_ITEM* drawing : aBoard.Drawings() )
+            select( drawing );
+    }
+
+    /**
+     * @return true if one of the items of aDrcItem is selected. Violations not related
+     * to a board item (e.g. an invalid outline) are always selected.
+     */
+    bool Matches( const DRC_ITEM& aDrcItem ) const
+    {
+        if( IsEmpty() )
+            return true;
+
+        auto main = m_selected.find( aDrcItem.GetMainItemRef() );
+
+        if( main == m_selected.end() || main->second )
+            return true;
+
+        if( !aDrcItem.HasSecondItem() )
+            return false;
+
+        auto aux = m_selected.find( aDrcItem.GetAuxiliaryItemRef() );
+
+        return aux != m_selected.end() && aux->second;
+    }
+
+    /// Whether each item of the board is selected, by address
+    std::unordered_map<const void*, bool> m_selected;
+};
+
+
+/**
+ * Runs all the test passes of the #DRC class, as the DRC dialog does, but without
+ * user interface.  The violations and the time spent in each pass can be written
+ * as JSON, for use in continuous integration.
+ */
+class DRC_BATCH_RUNNER
+{
+public:
+    /// Results of one DRC test pass
+    struct PASS_INFO
+    {
+        std::string m_name;
+        double      m_msecs;
+        int         m_violations;   ///< number of violations found by the pass
+    };
+
+    DRC_BATCH_RUNNER( const DRC_RUNNER::EXECUTION_CONTEXT& aExecCtx,
+                      const DRC_ITEM_FILTER& aFilter ) :
+            m_exec_context( aExecCtx ),
+            m_filter( aFilter )
+    {
+    }
+
+    /**
+     * Run the DRC on aBoard.
+     * @return the number of violations found (markers and unconnected items).
+     */
+    int Execute( BOARD& aBoard )
+    {
+        if( m_exec_context.m_verbose )
+            std::cout << "Running DRC check: all passes" << std::endl;
+
+        aBoard.BuildConnectivity();
+        m_filter.SelectItems( aBoard );
+
+        auto marker_handler = [&]( MARKER_PCB* aMarker ) {
+            std::unique_ptr<MARKER_PCB> marker( aMarker );
+
+            if( m_filter.Matches( marker->GetReporter() ) )
+                m_markers.push_back( std::move( marker ) );
+        };
+
+        size_t lastCount = 0;
+
+        auto pass_handler = [&]( const wxString& aPassName, double aMsecs ) {
+            size_t count = m_markers.size();
+
+            m_passes.push_back( { aPassName.ToStdString(), aMsecs, int( count - lastCount ) } );
+            lastCount = count;
+        };
+
+        DRC drc( &aBoard, EDA_UNITS_T::MILLIMETRES, marker_handler );
+        drc.RunBatchTests( pass_handler );
+
+        // Unconnected items are not markers, count them in their own pass
+        for( const DRC_ITEM* item : drc.GetUnconnectedItems() )
+        {
+            if( m_filter.Matches( *item ) )
+                m_unconnected.push_back( *item );
+        }
+
+        for( PASS_INFO& pass : m_passes )
+        {
+            if( pass.m_name == "unconnected" )
+                pass.m_violations = m_unconnected.size();
+        }
+
+        if( m_exec_context.m_print_times )
+            reportPasses();
+
+        if( m_exec_context.m_print_markers )
+            reportMarkers();
+
+        return m_markers.size() + m_unconnected.size();
+    }
+
+    /**
+     * Write the results of the last run, as a JSON object.
+     */
+    void WriteJson( std::ostream& aStream ) const
+    {
+        aStream << "{\n";
+        aStream << "  \"passes\": [";
+
+        for( size_t ii = 0; ii < m_passes.size(); ++ii )
+        {
+            const PASS_INFO& pass = m_passes[ii];
+
+            aStream << ( ii ? ",\n" : "\n" );
+            aStream << "    { \"name\": " << jsonString( pass.m_name )
+                    << ", \"time_ms\": " << pass.m_msecs
+                    << ", \"violations\": " << pass.m_violations << " }";
+        }
+
+        aStream << "\n  ],\n";
+        aStream << "  \"markers\": [";
+
+        for( size_t ii = 0; ii < m_markers.size(); ++ii )
+        {
+            aStream << ( ii ? ",\n" : "\n" );
+            writeJsonItem( aStream, m_markers[ii]->GetReporter() );
+        }
+
+        aStream << "\n  ],\n";
+        aStream << "  \"unconnected\": [";
+
+        for( size_t ii = 0; ii < m_unconnected.size(); ++ii )
+        {
+            aStream << ( ii ? ",\n" : "\n" );
+            writeJsonItem( aStream, m_unconnected[ii] );
+        }
+
+        aStream << "\n  ]\n";
+        aStream << "}\n";
+    }
+
+private:
+    static std::string jsonString( const wxString& aText )
+    {
+        std::string out = "\"";
+
+        for( char c : std::string( aText.ToUTF8() ) )
+        {
+            switch( c )
+            {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if( (unsigned char) c < 0x20 )
+                {
+                    char buf[8];
+                    snprintf( buf, sizeof( buf ), "\\u%04x", c );
+                    out += buf;
+                }
+                else
+                    out += c;
+            }
+        }
+
+        return out + "\"";
+    }
+
+    static std::string jsonPoint( const wxPoint& aPoint )
+    {
+        std::ostringstream os;
+        os << "{ \"x\": " << aPoint.x / IU_PER_MM << ", \"y\": " << aPoint.y / IU_PER_MM << " }";
+        return os.str();
+    }
+
+    static void writeJsonItem( std::ostream& aStream, const DRC_ITEM& aItem )
+    {
+        aStream << "    { \"code\": " << aItem.GetErrorCode()
+                << ", \"description\": " << jsonString( aItem.GetErrorText() )
+                << ", \"main_item\": " << jsonString( aItem.GetMainText() )
+                << ", \"main_pos\": " << jsonPoint( aItem.GetPointA() );
+
+        if( aItem.HasSecondItem() )
+        {
+            aStream << ", \"aux_item\": " << jsonString( aItem.GetAuxiliaryText() )
+                    << ", \"aux_pos\": " << jsonPoint( aItem.GetPointB() );
+        }
+
+        aStream << " }";
+    }
+
+    void reportPasses() const
+    {
+        for( const PASS_INFO& pass : m_passes )
+        {
+            std::cout << pass.m_name << ": " << pass.m_msecs << "ms, " << pass.m_violations
+                      << " violations" << std::endl;
+        }
+    }
+
+    void reportMarkers() const
+    {
+        std::cout << "DRC markers: " << m_markers.size() << std::endl;
+
+        int index = 0;
+        for( const auto& m : m_markers )
+        {
+            std::cout << index++ << ": " << m->GetReporter().ShowReport( EDA_UNITS_T::MILLIMETRES );
+        }
+
+        std::cout << "Unconnected items: " << m_unconnected.size() << std::endl;
+
+        index = 0;
+        for( const DRC_ITEM& item : m_unconnected )
+        {
+            std::cout << index++ << ": " << item.ShowReport( EDA_UNITS_T::MILLIMETRES );
+        }
+    }
+
+    const DRC_RUNNER::EXECUTION_CONTEXT      m_exec_context;
+    DRC_ITEM_FILTER                          m_filter;
+    std::vector<PASS_INFO>                   m_passes;
+    std::vector<std::unique_ptr<MARKER_PCB>> m_markers;
+    std::vector<DRC_ITEM>                    m_unconnected;
+};
+
+
 static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
     {
             wxCMD_LINE_SWITCH,
@@ -253,6 +569,36 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
             "courtyard-missing",
             _( "perform courtyard-missing checking" ).mb_str(),
     },
+    {
+            wxCMD_LINE_SWITCH,
+            "F",
+            "full",
+            _( "run all the DRC test passes, as the DRC dialog does" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "j",
+            "json",
+            _( "write the full DRC results as JSON to the given file ('-' for stdout)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "l",
+            "layers",
+            _( "only report full DRC violations on these layers (comma separated)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "n",
+            "nets",
+            _( "only report full DRC violations on these nets (comma separated)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
     {
             wxCMD_LINE_PARAM,
             nullptr,
@@ -270,6 +616,8 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
 enum PARSER_RET_CODES
 {
     PARSE_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    DRC_VIOLATIONS,     ///< the full DRC found violations
+    WRITE_FAILED,       ///< the JSON report could not be written
 };
 
 
@@ -328,6 +676,65 @@ int drc_main_func( int argc, char** argv )
         runner.Execute( *board );
     }
 
+    wxString json_file;
+    const bool json = cl_parser.Found( "json", &json_file );
+
+    if( json || cl_parser.Found( "full" ) )
+    {
+        DRC_ITEM_FILTER filter;
+        wxString        list;
+
+        if( cl_parser.Found( "layers", &list ) )
+        {
+            wxStringTokenizer tokenizer( list, "," );
+
+            while( tokenizer.HasMoreTokens() )
+            {
+                wxString     name = tokenizer.GetNextToken().Trim().Trim( false );
+                PCB_LAYER_ID layer = board->GetLayerID( name );
+
+                if( layer == UNDEFINED_LAYER )
+                {
+                    std::cerr << "Unknown layer: " << name << std::endl;
+                    return KI_TEST::RET_CODES::BAD_CMDLINE;
+                }
+
+                filter.m_layers.set( layer );
+            }
+        }
+
+        if( cl_parser.Found( "nets", &list ) )
+        {
+            wxStringTokenizer tokenizer( list, "," );
+
+            while( tokenizer.HasMoreTokens() )
+                filter.m_nets.insert( tokenizer.GetNextToken().Trim().Trim( false ) );
+        }
+
+        DRC_BATCH_RUNNER runner( exec_context, filter );
+        int              violations = runner.Execute( *board );
+
+        if( json && json_file == "-" )
+        {
+            runner.WriteJson( std::cout );
+        }
+        else if( json )
+        {
+            std::ofstream out( json_file.ToStdString() );
+
+            if( !out.is_open() )
+            {
+                std::cerr << "Cannot write the JSON report to " << json_file << std::endl;
+                return PARSER_RET_CODES::WRITE_FAILED;
+            }
+
+            runner.WriteJson( out );
+        }
+
+        if( violations )
+            return PARSER_RET_CODES::DRC_VIOLATIONS;
+    }
+
     return KI_TEST::RET_CODES::OK;
 }
 
@@ -0,0 +1,165 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "pns_autoroute.h"
+
+#include <iostream>
+
+#include <common.h>
+#include <profile.h>
+#include <wx/cmdline.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <class_board.h>
+#include <connectivity/connectivity_data.h>
+
+#include <router/pns_batch_router.h>
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "s",
+            "serial",
+            _( "route all the connections one after the other" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "o",
+            "output",
+            _( "save the routed board to this file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "board file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+/**
+ * Tool-specific return codes
+ */
+enum AUTOROUTE_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+static int pns_autoroute_main_func( int argc, char** argv )
+{
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "Routes the unconnected items of the ratsnest of a board with "
+                               "the push and shove router, and reports the time taken." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    const std::string filename = cl_parser.GetParamCount() ? cl_parser.GetParam( 0 ).ToStdString()
+                                                           : "";
+
+    std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+    if( !board )
+        return AUTOROUTE_RET_CODES::LOAD_FAILED;
+
+    board->BuildConnectivity();
+    board->GetConnectivity()->RecalculateRatsnest();
+
+    PNS_BATCH_ROUTER batchRouter( board.get() );
+    PROF_COUNTER     counter;
+
+    batchRouter.SetParallel( !cl_parser.Found( "serial" ) );
+    batchRouter.Route();
+
+    counter.Stop();
+
+    std::vector<BOARD_CONNECTED_ITEM*> added, removed;
+
+    batchRouter.GetChanges( added, removed );
+
+    for( BOARD_CONNECTED_ITEM* item : removed )
+    {
+        board->Remove( item );
+        delete item;
+    }
+
+    for( BOARD_CONNECTED_ITEM* item : added )
+        board->Add( item );
+
+    board->BuildConnectivity();
+    board->GetConnectivity()->RecalculateRatsnest();
+
+    const PNS_BATCH_ROUTER::STATS& stats = batchRouter.Stats();
+
+    std::cout << "Connections:        " << stats.m_connections << std::endl;
+    std::cout << "Routed:             " << stats.m_routed << std::endl;
+    std::cout << "  in parallel:      " << stats.m_routedInParallel << " in "
+              << stats.m_tiles << " tiles, " << stats.m_conflicts << " rejected by the merge"
+              << std::endl;
+    std::cout << "Failed:             " << stats.m_failed << std::endl;
+    std::cout << "Tracks and vias:    " << added.size() << " added, " << removed.size()
+              << " removed" << std::endl;
+    std::cout << "Still unconnected:  " << board->GetConnectivity()->GetUnconnectedCount()
+              << std::endl;
+    std::cout << wxString::Format( "Time:               %.1f ms (parallel %.1f ms, serial %.1f ms)",
+                                   counter.msecs(), stats.m_parallelMsecs, stats.m_serialMsecs )
+              << std::endl;
+
+    wxString output;
+
+    if( cl_parser.Found( "output", &output ) )
+        KI_TEST::DumpBoardToFile( *board, output.ToStdString() );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM pns_autoroute_tool = {
+    "pns_autoroute",
+    "Route the ratsnest of a board with the push and shove router",
+    pns_autoroute_main_func,
+};
@@ -0,0 +1,361 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "pns_replay.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+#include <common.h>
+#include <profile.h>
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <class_board.h>
+
+#include <router/pns_debug_decorator.h>
+#include <router/pns_kicad_iface.h>
+#include <router/pns_node.h>
+#include <router/pns_pool.h>
+#include <router/pns_router.h>
+#include <router/pns_session_log.h>
+
+
+using PNS::SESSION_LOG;
+
+
+/**
+ * Router interface without view and without commits: the replayed routes only change the
+ * world of the router, the board stays as loaded.
+ */
+class PNS_REPLAY_IFACE : public PNS_KICAD_IFACE
+{
+public:
+    void EraseView() override {}
+    void HideItem( PNS::ITEM* aItem ) override {}
+    void DisplayItem( const PNS::ITEM* aItem, int aColor, int aClearance, bool aEdit ) override {}
+    void AddItem( PNS::ITEM* aItem ) override {}
+    void RemoveItem( PNS::ITEM* aItem ) override {}
+    void Commit() override {}
+
+    PNS::DEBUG_DECORATOR* GetDebugDecorator() override
+    {
+        return &m_decorator;
+    }
+
+private:
+    PNS::DEBUG_DECORATOR m_decorator;
+};
+
+
+/**
+ * What happened to one event of the log, over the repetitions of the replay
+ */
+struct EVENT_RESULT
+{
+    double m_msecs = DBL_MAX;   ///< best replay time
+    size_t m_branches = 0;      ///< nodes created by the event
+    size_t m_nodes = 0;         ///< nodes alive after the event
+    bool   m_itemFound = true;  ///< false if the item of the event was not found
+};
+
+
+static double percentile( std::vector<double> aValues, double aRank )
+{
+    if( aValues.empty() )
+        return 0.0;
+
+    std::sort( aValues.begin(), aValues.end() );
+
+    size_t index = (size_t) std::ceil( aRank * aValues.size() );
+
+    return aValues[std::max<size_t>( index, 1 ) - 1];
+}
+
+
+static void replay( PNS::ROUTER& aRouter, const SESSION_LOG& aLog,
+                    std::vector<EVENT_RESULT>& aResults )
+{
+    PNS::OBJECT_POOL<PNS::NODE>& nodePool = PNS::OBJECT_POOL<PNS::NODE>::Instance();
+
+    aRouter.ClearWorld();
+    aRouter.SyncWorld();
+
+    for( size_t ii = 0; ii < aLog.Events().size(); ++ii )
+    {
+        const SESSION_LOG::EVENT& evt = aLog.Events()[ii];
+        EVENT_RESULT&             result = aResults[ii];
+
+        if( evt.m_item.m_kind && !SESSION_LOG::FindItem( &aRouter, evt.m_item ) )
+            result.m_itemFound = false;
+
+        size_t       allocations = nodePool.Allocations();
+        PROF_COUNTER counter;
+
+        SESSION_LOG::Replay( &aRouter, evt );
+
+        counter.Stop();
+
+        result.m_msecs = std::min( result.m_msecs, counter.msecs() );
+        result.m_branches = nodePool.Allocations() - allocations;
+        result.m_nodes = nodePool.Used();
+    }
+
+    aRouter.StopRouting();
+}
+
+
+static void reportEvents( const SESSION_LOG& aLog, const std::vector<EVENT_RESULT>& aResults )
+{
+    std::cout << "Event                      Replay ms  Recorded ms  Branches  Nodes" << std::endl;
+
+    for( size_t ii = 0; ii < aLog.Events().size(); ++ii )
+    {
+        const SESSION_LOG::EVENT& evt = aLog.Events()[ii];
+        const EVENT_RESULT&       result = aResults[ii];
+
+        std::cout << wxString::Format( "%5d %-20s %9.3f  %11.3f  %8d  %5d%s", (int) ii,
+                                       SESSION_LOG::TypeName( evt.m_type ), result.m_msecs,
+                                       evt.m_msecs, (int) result.m_branches,
+                                       (int) result.m_nodes,
+                                       result.m_itemFound ? "" : "  (item not found)" )
+                  << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+
+/**
+ * Prints the latency percentiles and node counts of each type of event.
+ * @return the worst replay latency.
+ */
+static double reportSummary( const SESSION_LOG& aLog, const std::vector<EVENT_RESULT>& aResults )
+{
+    double worst = 0.0;
+    int    missing = 0;
+
+    std::cout << "Event            Count   p50 ms   p90 ms   p99 ms   max ms  rec. max  "
+                 "Branches  max  Nodes" << std::endl;
+
+    // The mode and settings events take no time, only the routing actions are timed
+    for( int type = SESSION_LOG::EVT_START_ROUTE; type <= SESSION_LOG::EVT_LAST; type++ )
+    {
+        std::vector<double> msecs;
+        double              recordedMax = 0.0;
+        size_t              branches = 0;
+        size_t              maxBranches = 0;
+        size_t              maxNodes = 0;
+
+        for( size_t ii = 0; ii < aLog.Events().size(); ++ii )
+        {
+            const SESSION_LOG::EVENT& evt = aLog.Events()[ii];
+            const EVENT_RESULT&       result = aResults[ii];
+
+            // EVT_LAST stands for all the routing actions
+            if( evt.m_type < SESSION_LOG::EVT_START_ROUTE
+                    || ( type != SESSION_LOG::EVT_LAST && evt.m_type != type ) )
+            {
+                continue;
+            }
+
+            msecs.push_back( result.m_msecs );
+            recordedMax = std::max( recordedMax, evt.m_msecs );
+            branches += result.m_branches;
+            maxBranches = std::max( maxBranches, result.m_branches );
+            maxNodes = std::max( maxNodes, result.m_nodes );
+
+            if( type == SESSION_LOG::EVT_LAST && !result.m_itemFound )
+                missing++;
+        }
+
+        if( msecs.empty() )
+            continue;
+
+        double maxMsecs = percentile( msecs, 1.0 );
+
+        if( type == SESSION_LOG::EVT_LAST )
+        {
+            worst = maxMsecs;
+            std::cout << std::endl;
+        }
+
+        std::cout << wxString::Format( "%-15s %6d %8.3f %8.3f %8.3f %8.3f %9.3f %9.1f %4d %6d",
+                                       type == SESSION_LOG::EVT_LAST ? "all" :
+                                            SESSION_LOG::TypeName( (SESSION_LOG::EVENT_TYPE) type ),
+                                       (int) msecs.size(), percentile( msecs, 0.5 ),
+                                       percentile( msecs, 0.9 ), percentile( msecs, 0.99 ),
+                                       maxMsecs, recordedMax, (double) branches / msecs.size(),
+                                       (int) maxBranches, (int) maxNodes )
+                  << std::endl;
+    }
+
+    if( missing )
+    {
+        std::cout << std::endl << missing << " events did not find their item: the replay "
+                  << "differs from the recorded session" << std::endl;
+    }
+
+    return worst;
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "v",
+            "verbose",
+            _( "print the time and node counts of each event" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "reps",
+            _( "number of repetitions, the best time of each event is kept" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "m",
+            "max-latency",
+            _( "fail if an event takes longer than this (ms)" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "session log file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+/**
+ * Tool-specific return codes
+ */
+enum REPLAY_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    TOO_SLOW,   ///< an event took longer than --max-latency
+};
+
+
+static int pns_replay_main_func( int argc, char** argv )
+{
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "Replays an interactive router session recorded with the RouterSessionLogDir "
+               "advanced setting, and reports the time taken by each routing action." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    if( !cl_parser.GetParamCount() )
+    {
+        std::cerr << "No session log given" << std::endl;
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long reps = 1;
+    cl_parser.Found( "reps", &reps );
+
+    const wxFileName logFile( cl_parser.GetParam( 0 ) );
+    SESSION_LOG      log;
+
+    if( !log.Load( logFile.GetFullPath().ToStdString() ) )
+    {
+        std::cerr << "Cannot read the session log " << logFile.GetFullPath() << std::endl;
+        return REPLAY_RET_CODES::LOAD_FAILED;
+    }
+
+    // The board snapshot is next to the log
+    wxFileName boardFile( logFile.GetPath(), log.BoardFileName() );
+
+    std::unique_ptr<BOARD> board =
+            KI_TEST::ReadBoardFromFileOrStream( boardFile.GetFullPath().ToStdString() );
+
+    if( !board )
+        return REPLAY_RET_CODES::LOAD_FAILED;
+
+    PNS_REPLAY_IFACE iface;
+    PNS::ROUTER      router;
+
+    iface.SetBoard( board.get() );
+    router.SetInterface( &iface );
+
+    std::vector<EVENT_RESULT> results( log.Events().size() );
+
+    for( long rep = 0; rep < std::max( 1L, reps ); ++rep )
+        replay( router, log, results );
+
+    std::cout << "Router session " << logFile.GetFullName() << ": " << log.Events().size()
+              << " events on " << boardFile.GetFullName() << ", " << std::max( 1L, reps )
+              << " repetitions" << std::endl << std::endl;
+
+    if( cl_parser.Found( "verbose" ) )
+        reportEvents( log, results );
+
+    double worst = reportSummary( log, results );
+    double maxLatency = 0.0;
+
+    if( cl_parser.Found( "max-latency", &maxLatency ) && worst > maxLatency )
+    {
+        std::cout << std::endl << "The slowest event took " << worst << " ms, more than "
+                  << maxLatency << " ms" << std::endl;
+        return REPLAY_RET_CODES::TOO_SLOW;
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM pns_replay_tool = {
+    "pns_replay",
+    "Replay and time a recorded interactive router session",
+    pns_replay_main_func,
+};
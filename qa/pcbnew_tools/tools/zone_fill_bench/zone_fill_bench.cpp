@@ -0,0 +1,294 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "zone_fill_bench.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+#include <common.h>
+#include <profile.h>
+#include <wx/cmdline.h>
+
+#include <geometry/rectilinear_boolean.h>
+#include <geometry/shape_poly_set.h>
+#include <geometry/shape_poly_set_cache.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_zone.h>
+#include <zone_filler.h>
+
+
+// The holes of boolean operation results have a negative area
+static double totalArea( const SHAPE_POLY_SET& aSet )
+{
+    double area = 0.0;
+
+    for( int i = 0; i < aSet.OutlineCount(); i++ )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : aSet.CPolygon( i ) )
+            area += chain.Area();
+    }
+
+    return area;
+}
+
+
+/**
+ * Builds the knock-outs of the rectangular pads of other nets in a zone, with the zone
+ * clearance and square corners: the rectilinear part of a power plane fill.
+ * @return the number of pads of other nets which are not rectilinear and were skipped.
+ */
+static int buildRectangularKnockouts( BOARD* aBoard, const ZONE_CONTAINER* aZone,
+                                      SHAPE_POLY_SET& aKnockouts )
+{
+    int skipped = 0;
+
+    for( MODULE* module : aBoard->Modules() )
+    {
+        for( D_PAD* pad : module->Pads() )
+        {
+            if( !pad->IsOnLayer( aZone->GetLayer() ) || pad->GetNetCode() == aZone->GetNetCode() )
+                continue;
+
+            if( pad->GetShape() != PAD_SHAPE_RECT || fmod( pad->GetOrientation(), 900.0 ) != 0.0 )
+            {
+                skipped++;
+                continue;
+            }
+
+            int     clearance = std::max( aZone->GetZoneClearance(), pad->GetClearance() );
+            wxPoint corners[4];
+
+            pad->BuildPadPolygon( corners, wxSize( clearance, clearance ), pad->GetOrientation() );
+
+            aKnockouts.NewOutline();
+
+            for( const wxPoint& corner : corners )
+                aKnockouts.Append( corner.x + pad->ShapePos().x, corner.y + pad->ShapePos().y );
+        }
+    }
+
+    return skipped;
+}
+
+
+/**
+ * Subtracts the rectangular pads from the rectilinear zone outlines, with Clipper and with
+ * the rectilinear engine.
+ */
+static void benchKnockouts( BOARD* aBoard, int aReps )
+{
+    std::cout << "Rectangular pad knock-outs of rectilinear zones" << std::endl;
+    std::cout << "Zone       Layer  Pads  Skipped  Clipper ms  Rectilinear ms  Speedup" << std::endl;
+
+    for( ZONE_CONTAINER* zone : aBoard->Zones() )
+    {
+        if( zone->GetIsKeepout() || !IsCopperLayer( zone->GetLayer() )
+                || !RECTILINEAR_BOOLEAN::IsRectilinear( *zone->Outline() ) )
+        {
+            continue;
+        }
+
+        SHAPE_POLY_SET knockouts;
+        int            skipped = buildRectangularKnockouts( aBoard, zone, knockouts );
+        double         msecs[2] = { DBL_MAX, DBL_MAX };
+        double         area[2] = { 0.0, 0.0 };
+
+        if( !knockouts.OutlineCount() )
+            continue;
+
+        for( int engine = 0; engine < 2; engine++ )
+        {
+            RECTILINEAR_BOOLEAN::SetEnabled( engine == 1 );
+
+            for( int rep = 0; rep < aReps; rep++ )
+            {
+                SHAPE_POLY_SET result;
+                PROF_COUNTER   counter;
+
+                result.BooleanSubtract( *zone->Outline(), knockouts, SHAPE_POLY_SET::PM_FAST );
+
+                counter.Stop();
+                msecs[engine] = std::min( msecs[engine], counter.msecs() );
+                area[engine] = totalArea( result );
+            }
+        }
+
+        RECTILINEAR_BOOLEAN::SetEnabled( true );
+
+        std::cout << wxString::Format( "%-10s %5s %5d %8d %11.3f %15.3f %7.2fx%s",
+                                       zone->GetNetname().Left( 10 ),
+                                       aBoard->GetLayerName( zone->GetLayer() ).Left( 5 ),
+                                       knockouts.OutlineCount(), skipped, msecs[0], msecs[1],
+                                       msecs[0] / std::max( msecs[1], 1e-6 ),
+                                       std::abs( area[0] - area[1] ) <= 1e-9 * std::abs( area[0] )
+                                               ? "" : "  (areas differ)" )
+                  << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+
+/**
+ * Fills all the zones from scratch with and without the rectilinear engine.
+ */
+static void benchFill( BOARD* aBoard, int aReps )
+{
+    std::vector<ZONE_CONTAINER*> zones( aBoard->Zones().begin(), aBoard->Zones().end() );
+
+    std::cout << "Zone fill of " << zones.size() << " zones" << std::endl;
+    std::cout << "Engine        Fill ms  Rectilinear ops  Clipper ops" << std::endl;
+
+    for( int engine = 0; engine < 2; engine++ )
+    {
+        double                     msecs = DBL_MAX;
+        RECTILINEAR_BOOLEAN::STATS stats;
+
+        RECTILINEAR_BOOLEAN::SetEnabled( engine == 1 );
+
+        for( int rep = 0; rep < aReps; rep++ )
+        {
+            // Make sure nothing is reused from the previous fill
+            for( ZONE_CONTAINER* zone : zones )
+                zone->SetFillInputs( ZONE_FILL_INPUTS() );
+
+            SHAPE_POLY_SET_CACHE::Instance().Clear();
+            RECTILINEAR_BOOLEAN::ResetStats();
+
+            ZONE_FILLER  filler( aBoard );
+            PROF_COUNTER counter;
+
+            filler.Fill( zones );
+
+            counter.Stop();
+            msecs = std::min( msecs, counter.msecs() );
+            stats = RECTILINEAR_BOOLEAN::GetStats();
+        }
+
+        std::cout << wxString::Format( "%-12s %8.1f %16d %12d",
+                                       engine ? "rectilinear" : "clipper", msecs,
+                                       (int) stats.m_calls, (int) stats.m_fallbacks )
+                  << std::endl;
+    }
+
+    RECTILINEAR_BOOLEAN::SetEnabled( true );
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "reps",
+            _( "number of repetitions, the best time is kept" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "k",
+            "knockouts-only",
+            _( "only time the pad knock-outs, not the full zone fill" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "board file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+/**
+ * Tool-specific return codes
+ */
+enum ZONE_FILL_BENCH_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+static int zone_fill_bench_main_func( int argc, char** argv )
+{
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "Times the boolean operations of the zone fills of a board, with "
+                               "Clipper and with the rectilinear boolean engine." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long reps = 3;
+    cl_parser.Found( "reps", &reps );
+    reps = std::max( 1L, reps );
+
+    const std::string filename = cl_parser.GetParamCount() ? cl_parser.GetParam( 0 ).ToStdString()
+                                                           : "";
+
+    std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+    if( !board )
+        return ZONE_FILL_BENCH_RET_CODES::LOAD_FAILED;
+
+    board->BuildConnectivity();
+
+    benchKnockouts( board.get(), reps );
+
+    if( !cl_parser.Found( "knockouts-only" ) )
+        benchFill( board.get(), reps );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM zone_fill_bench_tool = {
+    "zone_fill_bench",
+    "Time the boolean operations of the zone fills of a board",
+    zone_fill_bench_main_func,
+};
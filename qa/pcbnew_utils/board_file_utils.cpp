@@ -98,4 +98,31 @@ std::unique_ptr<BOARD> ReadBoardFromFileOrStream(
     return ReadItemFromStream<BOARD>( *in_stream );
 }
 
+
+std::unique_ptr<BOARD> MakeTwoLayerBoard( const std::vector<std::string>& aNetNames,
+                                          const std::string&              aItems )
+{
+    std::string text =
+        "(kicad_pcb (version 20171130) (host pcbnew 5.1.0)\n"
+        "  (general (thickness 1.6))\n"
+        "  (layers\n"
+        "    (0 F.Cu signal)\n"
+        "    (31 B.Cu signal)\n"
+        "  )\n"
+        "  (net 0 \"\")\n";
+
+    for( size_t ii = 0; ii < aNetNames.size(); ++ii )
+        text += "  (net " + std::to_string( ii + 1 ) + " " + aNetNames[ii] + ")\n";
+
+    text += aItems + ")\n";
+
+    STRING_LINE_READER reader( text, "test" );
+    PCB_PARSER         parser( &reader );
+
+    std::unique_ptr<BOARD> board( dynamic_cast<BOARD*>( parser.Parse() ) );
+    board->BuildConnectivity();
+
+    return board;
+}
+
 } // namespace KI_TEST
\ No newline at end of file
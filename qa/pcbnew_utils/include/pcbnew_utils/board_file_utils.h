@@ -28,6 +28,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 class BOARD;
 class BOARD_ITEM;
@@ -95,6 +96,17 @@ template <typename ITEM> std::unique_ptr<ITEM> ReadItemFromStream( std::istream&
 std::unique_ptr<BOARD> ReadBoardFromFileOrStream(
         const std::string& aFilename, std::istream& aFallback = std::cin );
 
+/**
+ * Make a board with the F.Cu and B.Cu copper layers from the text of its items, and build
+ * its connectivity.
+ *
+ * @param aNetNames the names of the nets 1, 2, ... of the board
+ * @param aItems the s-expressions of the footprints, tracks and zones of the board
+ * @return the new #BOARD
+ */
+std::unique_ptr<BOARD> MakeTwoLayerBoard( const std::vector<std::string>& aNetNames,
+                                          const std::string&              aItems );
+
 } // namespace KI_TEST
 
 #endif // QA_PCBNEW_UTILS_BOARD_FILE_UTILS__H
\ No newline at end of file